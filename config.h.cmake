@@ -12,6 +12,12 @@
 /* root solver allocation takes only one argument */
 #cmakedefine GSL_ROOT_FSLOVER_ALLOC_WITH_ONE_ARG
 
+/* highest log level compiled into the library */
+#cmakedefine GHMM_LOG_COMPILE_LEVEL_SET
+#ifdef GHMM_LOG_COMPILE_LEVEL_SET
+#define GHMM_LOG_COMPILE_LEVEL @GHMM_LOG_COMPILE_LEVEL@
+#endif
+
 /* Define to 1 if you have the <dlfcn.h> header file. */
 #cmakedefine HAVE_DLFCN_H
 
@@ -27,6 +33,15 @@
 /* Define to 1 if you have the `pthread' library (-lpthread). */
 #cmakedefine HAVE_LIBPTHREAD
 
+/* Define to 1 if you have the `madvise' function. */
+#cmakedefine HAVE_MADVISE
+
+/* Define to 1 if you have the `mmap' function. */
+#cmakedefine HAVE_MMAP
+
+/* Define to 1 if MPI is used by distbw. */
+#cmakedefine HAVE_MPI
+
 /* Define to 1 if you have the <memory.h> header file. */
 #cmakedefine HAVE_MEMORY_H
 
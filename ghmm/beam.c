@@ -0,0 +1,664 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/beam.c
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "ghmm.h"
+#include "mes.h"
+#include "model.h"
+#include "smodel.h"
+#include "beam.h"
+#include "ghmm_internals.h"
+
+/* initial number of traceback entries */
+#define BEAM_INITIAL_TRACEBACK 1024
+
+typedef struct beam_t beam_t;
+
+struct beam_t {
+  /** number of states **/
+  int N;
+  /** number of transition classes **/
+  int cos;
+  /** 1: log scores (Viterbi), 0: scaled probabilities (forward) **/
+  int viterbi;
+  /** transition classes of the sequence or NULL **/
+  int *classes;
+  int *out_states;
+  int **out_id;
+  /** a[class][state][out-edge], Viterbi: log(a), -DBL_MAX for a = 0 **/
+  double ***a;
+  double *pi;
+  /** emission probability of state j at time t **/
+  double (*b) (beam_t *, int, int);
+  ghmm_dmodel *mo;
+  const int *o;
+  ghmm_cmodel *smo;
+  const double *O;
+  /** scores of the active states and of the states reached in the next step **/
+  double *score;
+  double *next;
+  /** predecessor of a reached state as position in active **/
+  int *bp;
+  /** mark[j] == t if j was reached in step t **/
+  int *mark;
+  int *active;
+  int n_active;
+  int *touched;
+  /** traceback: the active states of step t are the entries
+      tb_start[t] .. tb_start[t + 1] - 1 in the order of active **/
+  int *tb_state;
+  int *tb_bp;
+  int tb_capacity;
+  int *tb_start;
+};
+
+/*----------------------------------------------------------------------------*/
+static void beam_free (beam_t * bt)
+{
+#define CUR_PROC "beam_free"
+  int c, i;
+  if (bt->a) {
+    for (c = 0; c < bt->cos; c++) {
+      if (bt->a[c] && bt->viterbi)
+        for (i = 0; i < bt->N; i++)
+          if (bt->a[c][i])
+            m_free (bt->a[c][i]);
+      if (bt->a[c])
+        m_free (bt->a[c]);
+    }
+    m_free (bt->a);
+  }
+  if (bt->classes)
+    m_free (bt->classes);
+  if (bt->out_states)
+    m_free (bt->out_states);
+  if (bt->out_id)
+    m_free (bt->out_id);
+  if (bt->pi)
+    m_free (bt->pi);
+  if (bt->score)
+    m_free (bt->score);
+  if (bt->next)
+    m_free (bt->next);
+  if (bt->bp)
+    m_free (bt->bp);
+  if (bt->mark)
+    m_free (bt->mark);
+  if (bt->active)
+    m_free (bt->active);
+  if (bt->touched)
+    m_free (bt->touched);
+  if (bt->tb_state)
+    m_free (bt->tb_state);
+  if (bt->tb_bp)
+    m_free (bt->tb_bp);
+  if (bt->tb_start)
+    m_free (bt->tb_start);
+#undef CUR_PROC
+}                               /* beam_free */
+
+/*----------------------------------------------------------------------------*/
+/* allocates everything that does not depend on the kind of model, the
+   transitions, pi and the emission function have to be set by the caller */
+static int beam_alloc (beam_t * bt, int N, int cos, int T, int viterbi)
+{
+#define CUR_PROC "beam_alloc"
+  int c, j;
+
+  bt->N = N;
+  bt->cos = cos;
+  bt->viterbi = viterbi;
+  ARRAY_CALLOC (bt->out_states, N);
+  ARRAY_CALLOC (bt->out_id, N);
+  ARRAY_CALLOC (bt->a, cos);
+  for (c = 0; c < cos; c++)
+    ARRAY_CALLOC (bt->a[c], N);
+  ARRAY_MALLOC (bt->pi, N);
+  ARRAY_MALLOC (bt->score, N);
+  ARRAY_MALLOC (bt->next, N);
+  ARRAY_MALLOC (bt->bp, N);
+  ARRAY_MALLOC (bt->mark, N);
+  for (j = 0; j < N; j++)
+    bt->mark[j] = -1;
+  ARRAY_MALLOC (bt->active, N);
+  ARRAY_MALLOC (bt->touched, N);
+  if (viterbi) {
+    ARRAY_MALLOC (bt->tb_start, T + 1);
+    bt->tb_capacity = BEAM_INITIAL_TRACEBACK;
+    ARRAY_MALLOC (bt->tb_state, bt->tb_capacity);
+    ARRAY_MALLOC (bt->tb_bp, bt->tb_capacity);
+  }
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return -1;
+#undef CUR_PROC
+}                               /* beam_alloc */
+
+/*----------------------------------------------------------------------------*/
+/* sets the out-edges of state i in class c */
+static int beam_set_transitions (beam_t * bt, int c, int i, double *a)
+{
+#define CUR_PROC "beam_set_transitions"
+  int k;
+
+  if (!bt->viterbi) {
+    bt->a[c][i] = a;
+    return 0;
+  }
+  ARRAY_MALLOC (bt->a[c][i], bt->out_states[i] > 0 ? bt->out_states[i] : 1);
+  for (k = 0; k < bt->out_states[i]; k++)
+    bt->a[c][i][k] = a[k] > 0.0 ? log (a[k]) : -DBL_MAX;
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return -1;
+#undef CUR_PROC
+}                               /* beam_set_transitions */
+
+/*----------------------------------------------------------------------------*/
+static double beam_dmodel_b (beam_t * bt, int j, int t)
+{
+  return bt->mo->s[j].b[bt->o[t]];
+}
+
+static double beam_cmodel_b (beam_t * bt, int j, int t)
+{
+  return ghmm_cmodel_calc_b (bt->smo->s + j, bt->O + t * bt->smo->dim);
+}
+
+/*----------------------------------------------------------------------------*/
+static int beam_dmodel_init (beam_t * bt, ghmm_dmodel * mo, const int *o,
+                             int len, int viterbi)
+{
+#define CUR_PROC "beam_dmodel_init"
+  int i, t;
+
+  if (mo->model_type & (GHMM_kSilentStates | GHMM_kHigherOrderEmissions)) {
+    GHMM_LOG (LERROR, "beam search does not support silent states or higher "
+              "order emissions");
+    return -1;
+  }
+  if (len <= 0) {
+    GHMM_LOG (LERROR, "empty sequence");
+    return -1;
+  }
+  for (t = 0; t < len; t++)
+    if (o[t] < 0 || o[t] >= mo->M) {
+      GHMM_LOG_PRINTF (LERROR, LOC, "symbol %d at position %d is not in the "
+                       "alphabet of size %d", o[t], t, mo->M);
+      return -1;
+    }
+  if (beam_alloc (bt, mo->N, 1, len, viterbi) == -1)
+    return -1;
+  bt->mo = mo;
+  bt->o = o;
+  bt->b = beam_dmodel_b;
+  for (i = 0; i < mo->N; i++) {
+    bt->pi[i] = mo->s[i].pi;
+    bt->out_states[i] = mo->s[i].out_states;
+    bt->out_id[i] = mo->s[i].out_id;
+    if (beam_set_transitions (bt, 0, i, mo->s[i].out_a) == -1)
+      return -1;
+  }
+  return 0;
+#undef CUR_PROC
+}                               /* beam_dmodel_init */
+
+/*----------------------------------------------------------------------------*/
+static int beam_cmodel_init (beam_t * bt, ghmm_cmodel * smo, const double *O,
+                             int T, int viterbi)
+{
+#define CUR_PROC "beam_cmodel_init"
+  int c, i;
+
+  if (T <= 0) {
+    GHMM_LOG (LERROR, "empty sequence");
+    return -1;
+  }
+  if (beam_alloc (bt, smo->N, smo->cos, T, viterbi) == -1)
+    return -1;
+  bt->smo = smo;
+  bt->O = O;
+  bt->b = beam_cmodel_b;
+  if (smo->cos > 1) {
+    ARRAY_MALLOC (bt->classes, T > 1 ? T - 1 : 1);
+    if (ghmm_cmodel_get_class_sequence (smo, O, smo->class_change ?
+                                        smo->class_change->k : -1, T,
+                                        bt->classes) == -1)
+      return -1;
+  }
+  for (i = 0; i < smo->N; i++) {
+    bt->pi[i] = smo->s[i].pi;
+    bt->out_states[i] = smo->s[i].out_states;
+    bt->out_id[i] = smo->s[i].out_id;
+    for (c = 0; c < smo->cos; c++)
+      if (beam_set_transitions (bt, c, i, smo->s[i].out_a[c]) == -1)
+        return -1;
+  }
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return -1;
+#undef CUR_PROC
+}                               /* beam_cmodel_init */
+
+/*----------------------------------------------------------------------------*/
+/* moves the k states with the largest scores to the front (quickselect) */
+static void beam_select (int *states, int n, int k, const double *score)
+{
+  int lo = 0, hi = n - 1, i, j, tmp;
+  double pivot;
+
+  while (lo < hi) {
+    pivot = score[states[(lo + hi) / 2]];
+    i = lo;
+    j = hi;
+    while (i <= j) {
+      while (score[states[i]] > pivot)
+        i++;
+      while (score[states[j]] < pivot)
+        j--;
+      if (i <= j) {
+        tmp = states[i];
+        states[i++] = states[j];
+        states[j--] = tmp;
+      }
+    }
+    /* lo..j >= pivot, i..hi <= pivot */
+    if (k - 1 <= j)
+      hi = j;
+    else if (k - 1 >= i)
+      lo = i;
+    else
+      break;
+  }
+}                               /* beam_select */
+
+/*----------------------------------------------------------------------------*/
+/* prunes the n reached states in touched (scores in next), the survivors
+   are moved to the front of touched. Returns their number, the pruned
+   fraction of the total score (forward) is stored in lost_fraction */
+static int beam_prune (beam_t * bt, int n, double beam, int max_active,
+                       double *lost_fraction, ghmm_beam_stats * stats)
+{
+  int i, kept, last, tmp;
+  double best, limit, total = 0.0, lost = 0.0, s, gap;
+
+  best = bt->viterbi ? -DBL_MAX : 0.0;
+  for (i = 0; i < n; i++) {
+    s = bt->next[bt->touched[i]];
+    if (s > best)
+      best = s;
+    total += s;
+  }
+
+  /* histogram beam */
+  kept = n;
+  if (max_active > 0 && n > max_active) {
+    beam_select (bt->touched, n, max_active, bt->next);
+    kept = max_active;
+  }
+  /* threshold beam */
+  if (beam > 0.0) {
+    limit = bt->viterbi ? best - beam : best * exp (-beam);
+    last = kept;
+    for (i = 0, kept = 0; i < last; i++)
+      if (bt->next[bt->touched[i]] >= limit) {
+        tmp = bt->touched[kept];
+        bt->touched[kept++] = bt->touched[i];
+        bt->touched[i] = tmp;
+      }
+  }
+
+  /* touched[kept .. n - 1] are pruned */
+  for (i = kept; i < n; i++) {
+    s = bt->next[bt->touched[i]];
+    gap = bt->viterbi ? best - s : log (best / s);
+    if (gap < stats->min_pruned_gap)
+      stats->min_pruned_gap = gap;
+    lost += s;
+  }
+  if (lost_fraction)
+    *lost_fraction = total > 0.0 ? lost / total : 0.0;
+  stats->steps++;
+  stats->active += kept;
+  stats->pruned += n - kept;
+  if (kept > stats->max_active)
+    stats->max_active = kept;
+  return kept;
+}                               /* beam_prune */
+
+/*----------------------------------------------------------------------------*/
+static void beam_stats_init (ghmm_beam_stats * stats)
+{
+  memset (stats, 0, sizeof (*stats));
+  stats->min_pruned_gap = DBL_MAX;
+}
+
+/*----------------------------------------------------------------------------*/
+/* the n states in touched become the active states of step t, bp and
+   next are taken over for them */
+static int beam_activate (beam_t * bt, int t, int n)
+{
+#define CUR_PROC "beam_activate"
+  int a, j, start, *tmp;
+  double *swap;
+
+  if (bt->viterbi) {
+    start = t ? bt->tb_start[t] : 0;
+    bt->tb_start[t] = start;
+    if (start + n > bt->tb_capacity) {
+      while (start + n > bt->tb_capacity)
+        bt->tb_capacity *= 2;
+      ARRAY_REALLOC (bt->tb_state, bt->tb_capacity);
+      ARRAY_REALLOC (bt->tb_bp, bt->tb_capacity);
+    }
+    for (a = 0; a < n; a++) {
+      j = bt->touched[a];
+      bt->tb_state[start + a] = j;
+      bt->tb_bp[start + a] = t ? bt->bp[j] : -1;
+    }
+    bt->tb_start[t + 1] = start + n;
+  }
+  swap = bt->score;
+  bt->score = bt->next;
+  bt->next = swap;
+  tmp = bt->active;
+  bt->active = bt->touched;
+  bt->touched = tmp;
+  bt->n_active = n;
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return -1;
+#undef CUR_PROC
+}                               /* beam_activate */
+
+/*----------------------------------------------------------------------------*/
+/* expands the active states along their out-edges into step t and
+   multiplies with the emissions. Returns the number of reached states */
+static int beam_expand (beam_t * bt, int t)
+{
+  int a, i, j, k, n = 0, osc;
+  double s, v, e, *a_i;
+
+  osc = bt->classes ? bt->classes[t - 1] : 0;
+  for (a = 0; a < bt->n_active; a++) {
+    i = bt->active[a];
+    s = bt->score[i];
+    a_i = bt->a[osc][i];
+    for (k = 0; k < bt->out_states[i]; k++) {
+      j = bt->out_id[i][k];
+      if (bt->viterbi) {
+        if (a_i[k] == -DBL_MAX)
+          continue;
+        v = s + a_i[k];
+        if (bt->mark[j] != t) {
+          bt->mark[j] = t;
+          bt->next[j] = v;
+          bt->bp[j] = a;
+          bt->touched[n++] = j;
+        }
+        else if (v > bt->next[j]) {
+          bt->next[j] = v;
+          bt->bp[j] = a;
+        }
+      }
+      else {
+        if (a_i[k] <= 0.0)
+          continue;
+        if (bt->mark[j] != t) {
+          bt->mark[j] = t;
+          bt->next[j] = 0.0;
+          bt->touched[n++] = j;
+        }
+        bt->next[j] += s * a_i[k];
+      }
+    }
+  }
+
+  /* emissions, only for the reached states */
+  for (a = 0, k = 0; a < n; a++) {
+    j = bt->touched[a];
+    e = bt->b (bt, j, t);
+    if (e <= 0.0)
+      continue;
+    if (bt->viterbi)
+      bt->next[j] += log (e);
+    else
+      bt->next[j] *= e;
+    bt->touched[k++] = j;
+  }
+  return k;
+}                               /* beam_expand */
+
+/*----------------------------------------------------------------------------*/
+/* reached states of step 0 */
+static int beam_start (beam_t * bt)
+{
+  int j, n = 0;
+  double e;
+
+  for (j = 0; j < bt->N; j++) {
+    if (bt->pi[j] <= 0.0)
+      continue;
+    e = bt->b (bt, j, 0);
+    if (e <= 0.0)
+      continue;
+    bt->next[j] = bt->viterbi ? log (bt->pi[j]) + log (e) : bt->pi[j] * e;
+    bt->touched[n++] = j;
+  }
+  return n;
+}                               /* beam_start */
+
+/*----------------------------------------------------------------------------*/
+static int *beam_viterbi (beam_t * bt, int T, double beam, int max_active,
+                          double *log_p, ghmm_beam_stats * stats)
+{
+#define CUR_PROC "beam_viterbi"
+  int *path = NULL;
+  int t, a, n, best_a, idx;
+  double best;
+
+  n = beam_start (bt);
+  for (t = 0;;) {
+    if (n == 0) {
+      GHMM_LOG_PRINTF (LERROR, LOC, "no path survived at position %d", t);
+      goto STOP;
+    }
+    n = beam_prune (bt, n, beam, max_active, NULL, stats);
+    if (beam_activate (bt, t, n) == -1)
+      goto STOP;
+    if (++t == T)
+      break;
+    n = beam_expand (bt, t);
+  }
+
+  /* termination and traceback */
+  best = -DBL_MAX;
+  best_a = 0;
+  for (a = 0; a < bt->n_active; a++)
+    if (bt->score[bt->active[a]] > best) {
+      best = bt->score[bt->active[a]];
+      best_a = a;
+    }
+  ARRAY_MALLOC (path, T);
+  for (t = T - 1, a = best_a; t >= 0; t--) {
+    idx = bt->tb_start[t] + a;
+    path[t] = bt->tb_state[idx];
+    a = bt->tb_bp[idx];
+  }
+  *log_p = best;
+  return path;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return NULL;
+#undef CUR_PROC
+}                               /* beam_viterbi */
+
+/*----------------------------------------------------------------------------*/
+static int beam_forward (beam_t * bt, int T, double beam, int max_active,
+                         double *log_p, ghmm_beam_stats * stats)
+{
+#define CUR_PROC "beam_forward"
+  int t, a, n;
+  double scale, lost;
+
+  *log_p = 0.0;
+  n = beam_start (bt);
+  for (t = 0;;) {
+    scale = 0.0;
+    for (a = 0; a < n; a++)
+      scale += bt->next[bt->touched[a]];
+    if (n == 0 || scale <= DBL_MIN) {
+      GHMM_LOG_PRINTF (LERROR, LOC, "no path survived at position %d", t);
+      return -1;
+    }
+    *log_p += log (scale);
+    for (a = 0; a < n; a++)
+      bt->next[bt->touched[a]] /= scale;
+
+    n = beam_prune (bt, n, beam, max_active, &lost, stats);
+    if (lost > 0.0)
+      stats->pruned_mass -= log (1.0 - lost);
+    beam_activate (bt, t, n);
+    if (++t == T)
+      break;
+    n = beam_expand (bt, t);
+  }
+  return 0;
+#undef CUR_PROC
+}                               /* beam_forward */
+
+/*============================================================================*/
+int *ghmm_dmodel_viterbi_beam (ghmm_dmodel * mo, const int *o, int len,
+                               double beam, int max_active, double *log_p,
+                               ghmm_beam_stats * stats)
+{
+#define CUR_PROC "ghmm_dmodel_viterbi_beam"
+  beam_t bt;
+  ghmm_beam_stats st;
+  int *path = NULL;
+
+  memset (&bt, 0, sizeof (bt));
+  beam_stats_init (stats ? stats : &st);
+  *log_p = +1;
+  if (beam_dmodel_init (&bt, mo, o, len, 1) == 0)
+    path = beam_viterbi (&bt, len, beam, max_active, log_p, stats ? stats : &st);
+  beam_free (&bt);
+  if (!path) {
+    *log_p = +1;
+    GHMM_LOG_QUEUED (LCONVERTED);
+  }
+  return path;
+#undef CUR_PROC
+}                               /* ghmm_dmodel_viterbi_beam */
+
+/*============================================================================*/
+int ghmm_dmodel_forward_beam (ghmm_dmodel * mo, const int *o, int len,
+                              double beam, int max_active, double *log_p,
+                              ghmm_beam_stats * stats)
+{
+#define CUR_PROC "ghmm_dmodel_forward_beam"
+  beam_t bt;
+  ghmm_beam_stats st;
+  int res = -1;
+
+  memset (&bt, 0, sizeof (bt));
+  beam_stats_init (stats ? stats : &st);
+  if (beam_dmodel_init (&bt, mo, o, len, 0) == 0)
+    res = beam_forward (&bt, len, beam, max_active, log_p, stats ? stats : &st);
+  beam_free (&bt);
+  if (res) {
+    *log_p = +1;
+    GHMM_LOG_QUEUED (LCONVERTED);
+  }
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_dmodel_forward_beam */
+
+/*============================================================================*/
+int *ghmm_cmodel_viterbi_beam (ghmm_cmodel * smo, const double *O, int T,
+                               double beam, int max_active, double *log_p,
+                               ghmm_beam_stats * stats)
+{
+#define CUR_PROC "ghmm_cmodel_viterbi_beam"
+  beam_t bt;
+  ghmm_beam_stats st;
+  int *path = NULL;
+
+  /* T is length of sequence; divide by dimension to represent the number of time points */
+  T /= smo->dim;
+  memset (&bt, 0, sizeof (bt));
+  beam_stats_init (stats ? stats : &st);
+  if (beam_cmodel_init (&bt, smo, O, T, 1) == 0)
+    path = beam_viterbi (&bt, T, beam, max_active, log_p, stats ? stats : &st);
+  beam_free (&bt);
+  if (!path) {
+    *log_p = +1;
+    GHMM_LOG_QUEUED (LCONVERTED);
+  }
+  return path;
+#undef CUR_PROC
+}                               /* ghmm_cmodel_viterbi_beam */
+
+/*============================================================================*/
+int ghmm_cmodel_forward_beam (ghmm_cmodel * smo, const double *O, int T,
+                              double beam, int max_active, double *log_p,
+                              ghmm_beam_stats * stats)
+{
+#define CUR_PROC "ghmm_cmodel_forward_beam"
+  beam_t bt;
+  ghmm_beam_stats st;
+  int res = -1;
+
+  /* T is length of sequence; divide by dimension to represent the number of time points */
+  T /= smo->dim;
+  memset (&bt, 0, sizeof (bt));
+  beam_stats_init (stats ? stats : &st);
+  if (beam_cmodel_init (&bt, smo, O, T, 0) == 0)
+    res = beam_forward (&bt, T, beam, max_active, log_p, stats ? stats : &st);
+  beam_free (&bt);
+  if (res) {
+    *log_p = +1;
+    GHMM_LOG_QUEUED (LCONVERTED);
+  }
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_cmodel_forward_beam */
@@ -0,0 +1,156 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/beam.h
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+#ifndef GHMM_BEAM_H
+#define GHMM_BEAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+
+/**@name Beam search */
+/*@{ (Doc++-Group: beam) */
+
+/**
+  Beam-pruned Viterbi and forward algorithms for models with many states.
+  Only the active states of a time step are expanded along their outgoing
+  transitions and only the states reached this way are evaluated. After
+  each time step the active states are pruned:
+  - threshold beam: states whose log score is more than beam below the
+    best score of the time step are dropped
+  - histogram beam: only the max_active best states are kept
+
+  Pruning may lose the optimal path (Viterbi) or probability mass
+  (forward). The search statistics report how much was pruned, the exact
+  search error is the difference to ghmm_dmodel_viterbi / ghmm_dmodel_logp
+  (resp. the ghmm_cmodel functions).
+
+  If no path survives, all four functions set log_p to +1, the library's
+  value for log(0).
+  */
+  typedef struct ghmm_beam_stats {
+    /** number of time steps */
+    int steps;
+    /** number of active states summed over all time steps */
+    long active;
+    /** largest number of active states in a time step */
+    int max_active;
+    /** number of pruned states summed over all time steps */
+    long pruned;
+    /** smallest log score difference between the best state and a pruned
+        state of the same time step, DBL_MAX if nothing was pruned. For the
+        threshold beam alone it is larger than beam */
+    double min_pruned_gap;
+    /** forward only: sum over the time steps of -log(1 - f_t), where f_t is
+        the fraction of the forward mass pruned in step t. Estimates the
+        search error log P(O) - log_p; it is 0 if nothing was pruned */
+    double pruned_mass;
+  } ghmm_beam_stats;
+
+/**
+  Beam-pruned Viterbi algorithm for discrete models without silent states
+  and with emissions of order 0.
+  @return Viterbi path of len states, NULL on error or if no path survived
+  @param mo          model
+  @param o           sequence
+  @param len         length of the sequence
+  @param beam        threshold beam (log), <= 0: no threshold pruning
+  @param max_active  histogram beam, <= 0: no histogram pruning
+  @param log_p       log probability of the path, +1 if there is none
+  @param stats       search statistics, may be NULL
+  */
+  int *ghmm_dmodel_viterbi_beam (ghmm_dmodel * mo, const int *o, int len,
+                                 double beam, int max_active, double *log_p,
+                                 ghmm_beam_stats * stats);
+
+/**
+  Beam-pruned forward algorithm for discrete models without silent states
+  and with emissions of order 0. Computes the probability of all paths
+  that survive the pruning.
+  @return 0 for success, -1 for error or if no path survived
+  @param mo          model
+  @param o           sequence
+  @param len         length of the sequence
+  @param beam        threshold beam (log), <= 0: no threshold pruning
+  @param max_active  histogram beam, <= 0: no histogram pruning
+  @param log_p       log probability of the surviving paths, +1 if none
+                     survived
+  @param stats       search statistics, may be NULL
+  */
+  int ghmm_dmodel_forward_beam (ghmm_dmodel * mo, const int *o, int len,
+                                double beam, int max_active, double *log_p,
+                                ghmm_beam_stats * stats);
+
+/**
+  Beam-pruned Viterbi algorithm for continuous models.
+  @return Viterbi path of T / smo->dim states, NULL on error or if no path
+          survived
+  @param smo         model
+  @param O           sequence
+  @param T           length of the sequence (number of values)
+  @param beam        threshold beam (log), <= 0: no threshold pruning
+  @param max_active  histogram beam, <= 0: no histogram pruning
+  @param log_p       log probability of the path, +1 if there is none
+  @param stats       search statistics, may be NULL
+  */
+  int *ghmm_cmodel_viterbi_beam (ghmm_cmodel * smo, const double *O, int T,
+                                 double beam, int max_active, double *log_p,
+                                 ghmm_beam_stats * stats);
+
+/**
+  Beam-pruned forward algorithm for continuous models.
+  @return 0 for success, -1 for error or if no path survived
+  @param smo         model
+  @param O           sequence
+  @param T           length of the sequence (number of values)
+  @param beam        threshold beam (log), <= 0: no threshold pruning
+  @param max_active  histogram beam, <= 0: no histogram pruning
+  @param log_p       log probability of the surviving paths, +1 if none
+                     survived
+  @param stats       search statistics, may be NULL
+  */
+  int ghmm_cmodel_forward_beam (ghmm_cmodel * smo, const double *O, int T,
+                                double beam, int max_active, double *log_p,
+                                ghmm_beam_stats * stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+/*@} (Doc++-Group: beam) */
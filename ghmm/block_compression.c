@@ -18,7 +18,7 @@ STOP:
 int small_enough_gap(ghmm_cseq* seq, double size, int start, int end){
     if(end-start < 2)
         return 0; 
-    double max = seq->seq[0][0];
+    double max = seq->seq[0][start];
     double min = max;
     int i;
     for(i = start; i < end; i++){
@@ -70,96 +70,174 @@ double get_moment2(ghmm_cseq* seq, int start, int end){
     return moment;
 }
 
-//comparation for get_median
-int comp(const void* p1, const void*p2){
-    double f = *((double*)p1);
-    double s = *((double*)p2);
-    return (f>s)-(f<s);
-}
-
-double get_median(double *x, int start, int end){
-    int len = end-start;
-    double tmp[len];
+//single pass over [start, end): range of the values and the index i of
+//the largest gap between x[i] and x[i+1], same index as get_largest_gap
+static double scan_block(const double *x, int start, int end, int *gap){
+    double min = x[start], max = x[start], largest = -1, d;
     int i;
-    int j = 0;
-    for(i = start; i < end; i++){
-        tmp[j] = x[i];
-        j++;
-    }
-    qsort(tmp, sizeof(tmp)/sizeof(*tmp), sizeof(*tmp), comp);
-    if(len % 2 == 0){
-        return tmp[len/2];
-    }
-    else{
-        return (tmp[len/2] + tmp[len/2+1])/2;
+    *gap = start;
+    for(i = start+1; i < end; i++){
+        if(max < x[i])
+            max = x[i];
+        if(min > x[i])
+            min = x[i];
+        d = fabs(x[i-1] - x[i]);
+        if(largest < d){
+            largest = d;
+            *gap = i-1;
+        }
     }
+    return max - min;
 }
 
-void compress_observations_helper(ghmm_cseq* seq, double width, double delta, 
-        int level, int dimension, block_stats *stats, int start, int end){
-
-    if(end-start == 1 || small_enough_gap(seq, width/pow(delta, level), start, end)){
-        stats->moment1[stats->total] = get_moment1(seq, start, end);
-        stats->moment2[stats->total] = get_moment2(seq, start, end);
-        stats->length[stats->total] = end-start;
-        stats->total++;
-        return;
-    }
-    if(dimension == 1){
-        int cur_start = start, cur_end = start+1;
-        double median = get_median(seq->seq[0], start, end);
-        while(cur_end < end){
-            if(cur_end < end && seq->seq[0][cur_end] <= median){
-                while(cur_end < end && seq->seq[0][cur_end] <= median ){
-                    cur_end++;
-                }
-                compress_observations_helper(seq, width, delta, level+1, 0,
-                        stats, cur_start, cur_end);
-            }
-            else{
-                while(cur_end < end && seq->seq[0][cur_end] >= median){
-                    cur_end++;
-                }
-                compress_observations_helper(seq, width, delta, level+1, 0, 
-                        stats, cur_start, cur_end);
+//k-th smallest of x[0..len), reorders x; quickselect with median of three
+static double select_kth(double *x, int len, int k){
+    int lo = 0, hi = len-1, i, j, mid;
+    double pivot, tmp;
+    while(lo < hi){
+        mid = lo + (hi-lo)/2;
+        if(x[mid] < x[lo]){ tmp = x[mid]; x[mid] = x[lo]; x[lo] = tmp; }
+        if(x[hi] < x[lo]){ tmp = x[hi]; x[hi] = x[lo]; x[lo] = tmp; }
+        if(x[hi] < x[mid]){ tmp = x[hi]; x[hi] = x[mid]; x[mid] = tmp; }
+        pivot = x[mid];
+        i = lo;
+        j = hi;
+        while(i <= j){
+            while(x[i] < pivot)
+                i++;
+            while(pivot < x[j])
+                j--;
+            if(i <= j){
+                tmp = x[i]; x[i] = x[j]; x[j] = tmp;
+                i++;
+                j--;
             }
-            cur_start = cur_end;
-            cur_end++;
         }
-        if(cur_start < end){
-            if(cur_end < end && seq->seq[0][cur_end] <= median){
-                compress_observations_helper(seq, width, delta, level+1, 0,
-                        stats, cur_start, cur_end);
-            }
-            else{
-                compress_observations_helper(seq, width, delta, level+1, 0, 
-                                stats, cur_start, cur_end);
-            }
-        }
-    }
-    else{
-        int end_index = get_largest_gap(seq, start, end);
-        compress_observations_helper(seq, width, delta, level, 1,  
-                    stats, start, end_index+1);
-        compress_observations_helper(seq, width, delta, level, 1,  
-                    stats, end_index+1, end);
+        if(k <= j)
+            hi = j;
+        else if(k >= i)
+            lo = i;
+        else
+            break;
     }
+    return x[k];
+}
+
+//median of x[start..end) in linear expected time, scratch holds end-start values
+static double block_median(const double *x, int start, int end, double *scratch){
+    int len = end-start, i;
+    double upper, lower;
+    for(i = 0; i < len; i++)
+        scratch[i] = x[start+i];
+    upper = select_kth(scratch, len, len/2);
+    if(len % 2)
+        return upper;
+    //scratch[0..len/2) holds the smaller half now
+    lower = scratch[0];
+    for(i = 1; i < len/2; i++)
+        if(lower < scratch[i])
+            lower = scratch[i];
+    return (lower + upper)/2;
+}
+
+//pending range of the compression, dimension 1 splits at the median,
+//dimension 0 at the largest gap
+typedef struct block_range{
+    int start, end, level, dimension;
+}block_range;
+
+static void emit_block(ghmm_cseq* seq, block_stats *stats, int start, int end){
+    stats->moment1[stats->total] = get_moment1(seq, start, end);
+    stats->moment2[stats->total] = get_moment2(seq, start, end);
+    stats->length[stats->total] = end-start;
+    stats->total++;
 }
 
+//ranges are processed depth first from an explicit stack, the children are
+//pushed in reverse so the blocks come out in sequence order. The pending
+//ranges are disjoint, so the stack never holds more than len entries and
+//every level of the recursion costs linear time.
 block_stats *compress_observations(ghmm_cseq* seq, double width, double delta){
 #define CUR_PROC "compress_observations"
-    block_stats *stats;
-    ARRAY_MALLOC(stats, 1);
-    ARRAY_MALLOC(stats->moment1, seq->seq_len[0]);
-    ARRAY_MALLOC(stats->moment2, seq->seq_len[0]);
-    ARRAY_MALLOC(stats->length, seq->seq_len[0]);
+    block_stats *stats = NULL;
+    block_range *stack = NULL, cur, tmp;
+    double *x = seq->seq[0], *scratch = NULL, median;
+    int len = seq->seq_len[0], top = 0, first, gap, low, i, j;
+
+    ARRAY_CALLOC(stats, 1);
+    ARRAY_MALLOC(stats->moment1, len > 0 ? len : 1);
+    ARRAY_MALLOC(stats->moment2, len > 0 ? len : 1);
+    ARRAY_MALLOC(stats->length, len > 0 ? len : 1);
+    ARRAY_MALLOC(scratch, len > 0 ? len : 1);
+    ARRAY_MALLOC(stack, len > 0 ? len : 1);
     stats->total = 0;
 
-    compress_observations_helper(seq, width, delta, 1, 1,  
-            stats, 0, seq->seq_len[0]);
+    if(len > 0){
+        stack[top].start = 0;
+        stack[top].end = len;
+        stack[top].level = 1;
+        stack[top].dimension = 1;
+        top++;
+    }
+    while(top > 0){
+        cur = stack[--top];
+        if(cur.end-cur.start == 1
+                || scan_block(x, cur.start, cur.end, &gap) < width/pow(delta, cur.level)){
+            emit_block(seq, stats, cur.start, cur.end);
+            continue;
+        }
+        if(cur.dimension == 1){
+            //runs on one side of the median, decided by their first value
+            median = block_median(x, cur.start, cur.end, scratch);
+            first = top;
+            i = cur.start;
+            while(i < cur.end){
+                low = x[i] <= median;
+                for(j = i+1; j < cur.end && (low ? x[j] <= median : x[j] >= median); j++);
+                stack[top].start = i;
+                stack[top].end = j;
+                stack[top].level = cur.level+1;
+                stack[top].dimension = 0;
+                top++;
+                i = j;
+            }
+            for(i = first, j = top-1; i < j; i++, j--){
+                tmp = stack[i];
+                stack[i] = stack[j];
+                stack[j] = tmp;
+            }
+        }
+        else{
+            stack[top].start = gap+1;
+            stack[top].end = cur.end;
+            stack[top].level = cur.level;
+            stack[top].dimension = 1;
+            top++;
+            stack[top].start = cur.start;
+            stack[top].end = gap+1;
+            stack[top].level = cur.level;
+            stack[top].dimension = 1;
+            top++;
+        }
+    }
+    m_free(stack);
+    m_free(scratch);
     return stats;
 
 STOP:
+    if(stack)
+        m_free(stack);
+    if(scratch)
+        m_free(scratch);
+    if(stats){
+        if(stats->moment1)
+            m_free(stats->moment1);
+        if(stats->moment2)
+            m_free(stats->moment2);
+        if(stats->length)
+            m_free(stats->length);
+        m_free(stats);
+    }
     return NULL;
 #undef CUR_PROC 
 }
@@ -171,7 +249,9 @@ block_stats *merge_observations(ghmm_cseq* seq, double width,
 
     block_stats *merged_stats;
 
-    ARRAY_MALLOC(merged_stats, stats->total);
+    if(!stats || stats->total < 1)
+        return stats;
+    ARRAY_CALLOC(merged_stats, 1);
     ARRAY_MALLOC(merged_stats->moment1, stats->total);
     ARRAY_MALLOC(merged_stats->moment2, stats->total);
     ARRAY_MALLOC(merged_stats->length, stats->total);
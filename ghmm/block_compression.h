@@ -44,9 +44,11 @@ typedef struct block_stats{
     int total;
 }block_stats;
 
+void free_block_stats(block_stats **stats);
 block_stats *merge_observations(ghmm_cseq* seq, double width,
         int max_len_permitted, block_stats *stats);
-/* compresses the observation sequence into blocks
+/* compresses the observation sequence into blocks, iterative and linear
+ * time per level of the compression (quickselect medians, single pass gaps)
  * @param seq: the data sequence to be compressed
  * @params width: parameter that controls the size of the compression
  * @params delta: shrinking ratio
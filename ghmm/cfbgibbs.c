@@ -43,6 +43,8 @@
 #include "rng.h"
 #include "randvar.h"
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 #include "fbgibbs.h"
 
 #ifdef HAVE_CONFIG_H
@@ -207,61 +209,273 @@ void storepositionH(int R, int M, int order, int T, int *obs,
     }
 }
 
+/* 64 bit positions of the tuples of the compressed blocks, same layout as
+ * storeposition: storedpos[j] is the position of obs[j..e) where e is the
+ * end of the block containing j. The first block is [0, R), the others
+ * [R, 2R), [2R, 3R), ... and the last one ends at T.
+ * off: off[L] is the position of the first tuple of length L */
+void storeposition64(int R, int T, int *obs, int M, uint64_t *off,
+        uint64_t *storedpos){
+    int j, s, e;
+    uint64_t r;
+    for(s = 0, e = R < T ? R : T; s < T; s = e, e = e+R < T ? e+R : T){
+        r = 0;
+        for(j = e-1; j >= s; j--){
+            r = obs[j] + M*r;
+            storedpos[j] = off[e-j] + r;
+        }
+    }
+}
+
+/* off[L] for L = 0..R, see storeposition64.
+ * return: 0 or -1 if the positions of R tuples do not fit into 64 bits */
+int tupleoffsets(int R, int M, uint64_t *off){
+    int i;
+    uint64_t pw = 1;
+    off[0] = off[1] = 0;
+    for(i = 1; i <= R; i++){
+        if(pw > UINT64_MAX/M)
+            return -1;
+        pw *= M;//M^i tuples of length i follow off[i]
+        if(off[i] > UINT64_MAX - pw)
+            return -1;
+        if(i < R)
+            off[i+1] = off[i] + pw;
+    }
+    return 0;
+}
+
 //=====================================================================
-//=================precomputating matrices ============================
+//=================lazily computed tuple matrices =====================
 //=====================================================================
-/* R: compression length
- * mo: model
- * mats: M^B(X)
- * rmats: cdfs of mats used for sampling B3
- */
-void precompute(int R, ghmm_dmodel *mo, double ***mats, double**** rmats){
-  int i, j, k;
-  int limit = (pow(mo->M, R+1)-1)/(mo->M-1) -1;  
-  double sum = 0;
-  //mats[i][j][k] i = obs; j,k indice of matrix   M(obs)_ik 
-  for(i = 0; i < mo->M; i++){
-    for(j = 0; j < mo->N; j++){
-      for(k = 0; k < mo->N; k++){
-        sum += mats[i][j][k] = ghmm_dmodel_get_transition(mo, j,k)*mo->s[k].b[i];
-        //printf("mats(%d, %d, %d) = %f \n",i,j,k, mats[i][j][k]);
-      }
-    } 
-    for(j = 0; j < mo->N; j++){
-      for(k = 0; k < mo->N; k++){
-          mats[i][j][k] /= sum;
-      }
-    } 
-    sum = 0;
-  }
-  
- int pos = mo->M;
- int fpos = 0;
- int y = 0;
- double x;
- while(pos < limit){ 
-     for(j = 0; j < mo->N; j++){
-         for(k = 0; k < mo->N; k++){
-             x = mats[y][j][0] * mats[fpos][0][k];
-             rmats[pos][j][k][0] = x;
-             //printf("rmats(%d, %d, %d, %d) = %f \n",pos,j,k,0, rmats[pos][j][k][0]);
-             for(i = 1; i < mo->N; i++){
-                 x += mats[y][j][i] * mats[fpos][i][k]; 
-                 rmats[pos][j][k][i] = x;
-                 //printf("rmats(%d, %d, %d, %d) = %f \n",pos,j,k,i, rmats[pos][j][k][i]);
-             }
-                 mats[pos][j][k] = x;
-	//printf("mats(%d, %d, %d) = %f \n",pos,j,k, mats[pos][j][k]);
-         }
-    }
-    pos++;
-    y++;
-    if(y == mo->M){
-        y = 0;
-        fpos = pos/mo->M - 1; 
-        //printf("fpos = %d\n", fpos); 
-    } 
-  }
+
+#ifndef GHMM_CFBGIBBS_CACHE_SIZE
+/* bytes used at most for the matrices of the tuples */
+#define GHMM_CFBGIBBS_CACHE_SIZE (64 << 20)
+#endif
+
+/* columns computed at once by tupleproduct */
+#define TUPLE_BLOCK 8
+
+/* M(X) = M(x_0) M(x_1) ... M(x_L-1) for a tuple X, M(x)_jk = a_jk b_k(x).
+ * Only the matrices of tuples occuring in the data are computed, when they
+ * are used first, and are kept in a hash table of at most capacity tuples;
+ * if it is full the least recently used tuple is replaced.
+ * Every matrix is scaled to sum 1, the scaling cancels in the forwards and
+ * in the sampling and keeps long tuples from underflowing. */
+typedef struct tuplecache{
+    int N, M;
+    int capacity, used;
+    int buckets;            // power of 2
+    int head, tail;         // most and least recently used entry
+    double *A;              // dense transition matrix N x N
+    double *single;         // M one symbol matrices
+    uint64_t *key;          // position of the tuple in each entry
+    int *bucket, *chain;    // hash table
+    int *prev, *next;       // lru list
+    double *mats;           // capacity N x N matrices
+    double *rmats;          // cdf of the intermediate state, N x N x N each
+}tuplecache;
+
+/* copies the transitions of mo to the dense N x N matrix A */
+static void densetransitions(ghmm_dmodel *mo, double *A){
+    int i, j;
+    memset(A, 0, sizeof(double)*mo->N*mo->N);
+    for(i = 0; i < mo->N; i++)
+        for(j = 0; j < mo->s[i].out_states; j++)
+            A[i*mo->N + mo->s[i].out_id[j]] = mo->s[i].out_a[j];
+}
+
+static void tuplecache_free(tuplecache **tc){
+#define CUR_PROC "tuplecache_free"
+    if(!*tc)
+        return;
+    if((*tc)->A) m_free((*tc)->A);
+    if((*tc)->single) m_free((*tc)->single);
+    if((*tc)->key) m_free((*tc)->key);
+    if((*tc)->bucket) m_free((*tc)->bucket);
+    if((*tc)->chain) m_free((*tc)->chain);
+    if((*tc)->prev) m_free((*tc)->prev);
+    if((*tc)->next) m_free((*tc)->next);
+    if((*tc)->mats) m_free((*tc)->mats);
+    if((*tc)->rmats) m_free((*tc)->rmats);
+    m_free(*tc);
+#undef CUR_PROC
+}
+
+/* N: number of states
+ * M: alphabet size
+ * maxtuples: number of different tuples, the cache is not larger
+ * return: cache or NULL on error or if GHMM_CFBGIBBS_CACHE_SIZE does not
+ *         hold the 2 tuples needed at least */
+static tuplecache *tuplecache_alloc(int N, int M, long maxtuples){
+#define CUR_PROC "tuplecache_alloc"
+    tuplecache *tc = NULL;
+    long capacity = GHMM_CFBGIBBS_CACHE_SIZE / (sizeof(double)*(N*N + N*N*N)
+            + sizeof(uint64_t) + 6*sizeof(int));
+    if(capacity < 2){//the suffix of a new entry has to stay
+        GHMM_LOG_PRINTF(LERROR, LOC, "%d states need more than "
+                "GHMM_CFBGIBBS_CACHE_SIZE = %ld bytes for 2 tuples", N,
+                (long) GHMM_CFBGIBBS_CACHE_SIZE);
+        return NULL;
+    }
+    if(capacity > maxtuples)
+        capacity = maxtuples < 2 ? 2 : maxtuples;
+    ARRAY_CALLOC(tc, 1);
+    tc->N = N;
+    tc->M = M;
+    tc->capacity = capacity;
+    tc->buckets = 1;
+    while(tc->buckets < capacity)
+        tc->buckets *= 2;
+    ARRAY_MALLOC(tc->A, N*N);
+    ARRAY_MALLOC(tc->single, M*N*N);
+    ARRAY_MALLOC(tc->key, capacity);
+    ARRAY_MALLOC(tc->bucket, tc->buckets);
+    ARRAY_MALLOC(tc->chain, capacity);
+    ARRAY_MALLOC(tc->prev, capacity);
+    ARRAY_MALLOC(tc->next, capacity);
+    ARRAY_MALLOC(tc->mats, (size_t) capacity*N*N);
+    ARRAY_MALLOC(tc->rmats, (size_t) capacity*N*N*N);
+    return tc;
+STOP:
+    tuplecache_free(&tc);
+    return NULL;
+#undef CUR_PROC
+}
+
+/* drops all tuples and computes the one symbol matrices of the current
+ * parameters of mo, needed whenever mo changed */
+static void tuplecache_reset(tuplecache *tc, ghmm_dmodel *mo){
+    int i, j, k, N = tc->N;
+    double sum, *m;
+    densetransitions(mo, tc->A);
+    //mats[i][j][k] i = obs; j,k indice of matrix   M(obs)_jk
+    for(i = 0; i < tc->M; i++){
+        m = tc->single + i*N*N;
+        sum = 0;
+        for(j = 0; j < N; j++)
+            for(k = 0; k < N; k++)
+                sum += m[j*N + k] = tc->A[j*N + k]*mo->s[k].b[i];
+        if(sum > 0)
+            for(j = 0; j < N*N; j++)
+                m[j] /= sum;
+    }
+    for(i = 0; i < tc->buckets; i++)
+        tc->bucket[i] = -1;
+    tc->used = 0;
+    tc->head = tc->tail = -1;
+}
+
+/* c = a b / sum(a b) and the cdfs over the intermediate state
+ * cdf[(j*N + k)*N + i] = sum_{l <= i} a_jl b_lk / sum(a b).
+ * Columns are taken TUPLE_BLOCK at a time so the inner loop runs over
+ * contiguous rows of b and every cdf row is written front to back. */
+static void tupleproduct(const double *a, const double *b, double *c,
+        double *cdf, int N){
+    int i, j, k, kk, kn;
+    double acc[TUPLE_BLOCK], rowsum[N], sum = 0, aji;
+    //sum(a b) = sum_i (sum_j a_ji) (sum_k b_ik), known before the product
+    for(i = 0; i < N; i++){
+        rowsum[i] = 0;
+        for(k = 0; k < N; k++)
+            rowsum[i] += b[i*N + k];
+    }
+    for(j = 0; j < N; j++)
+        for(i = 0; i < N; i++)
+            sum += a[j*N + i]*rowsum[i];
+    sum = sum > 0 ? 1/sum : 1;
+    for(j = 0; j < N; j++){
+        for(k = 0; k < N; k += TUPLE_BLOCK){
+            kn = N-k < TUPLE_BLOCK ? N-k : TUPLE_BLOCK;
+            for(kk = 0; kk < kn; kk++)
+                acc[kk] = 0;
+            for(i = 0; i < N; i++){
+                aji = a[j*N + i]*sum;
+                for(kk = 0; kk < kn; kk++){
+                    acc[kk] += aji*b[i*N + k + kk];
+                    cdf[(j*N + k + kk)*N + i] = acc[kk];
+                }
+            }
+            for(kk = 0; kk < kn; kk++)
+                c[j*N + k + kk] = acc[kk];
+        }
+    }
+}
+
+/* moves entry e to the front of the lru list */
+static void tuplecache_touch(tuplecache *tc, int e){
+    if(tc->head == e)
+        return;
+    if(tc->prev[e] != -1 || tc->tail == e){//already in the list
+        tc->next[tc->prev[e]] = tc->next[e];
+        if(tc->next[e] != -1)
+            tc->prev[tc->next[e]] = tc->prev[e];
+        else
+            tc->tail = tc->prev[e];
+    }
+    tc->prev[e] = -1;
+    tc->next[e] = tc->head;
+    if(tc->head != -1)
+        tc->prev[tc->head] = e;
+    tc->head = e;
+    if(tc->tail == -1)
+        tc->tail = e;
+}
+
+static int tuplehash(tuplecache *tc, uint64_t pos){
+    return (int)((pos*UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (tc->buckets-1);
+}
+
+/* entry of the tuple at position pos (at least of length 2), computed
+ * from the one symbol matrix of its first symbol and its suffix if needed */
+static int tuplecache_entry(tuplecache *tc, uint64_t pos){
+    int h = tuplehash(tc, pos), e, *link;
+    int N = tc->N;
+    uint64_t suffix = pos/tc->M - 1;
+    double *b;
+
+    for(e = tc->bucket[h]; e != -1; e = tc->chain[e])
+        if(tc->key[e] == pos){
+            tuplecache_touch(tc, e);
+            return e;
+        }
+    //suffix first, it is the most recently used entry then and is not reused
+    if(suffix < (uint64_t) tc->M)
+        b = tc->single + suffix*N*N;
+    else
+        b = tc->mats + (size_t) tuplecache_entry(tc, suffix)*N*N;
+
+    if(tc->used < tc->capacity){
+        e = tc->used++;
+        tc->prev[e] = tc->next[e] = -1;
+    }
+    else{//reuse the least recently used entry
+        e = tc->tail;
+        for(link = &tc->bucket[tuplehash(tc, tc->key[e])]; *link != e;
+                link = &tc->chain[*link]);
+        *link = tc->chain[e];
+    }
+    tc->key[e] = pos;
+    tc->chain[e] = tc->bucket[h];
+    tc->bucket[h] = e;
+    tuplecache_touch(tc, e);
+    tupleproduct(tc->single + (pos % tc->M)*N*N, b, tc->mats + (size_t) e*N*N,
+            tc->rmats + (size_t) e*N*N*N, N);
+    return e;
+}
+
+/* M(X) of the tuple at position pos, valid until the next call */
+static double *tuplecache_mats(tuplecache *tc, uint64_t pos){
+    if(pos < (uint64_t) tc->M)
+        return tc->single + pos*tc->N*tc->N;
+    return tc->mats + (size_t) tuplecache_entry(tc, pos)*tc->N*tc->N;
+}
+
+/* cdfs of the intermediate state of the tuple at position pos (of length
+ * at least 2), N x N x N, valid until the next call */
+static double *tuplecache_rmats(tuplecache *tc, uint64_t pos){
+    return tc->rmats + (size_t) tuplecache_entry(tc, pos)*tc->N*tc->N*tc->N;
 }
 
 //-----------------------HO-----------------------------------------
@@ -343,6 +557,8 @@ void precomputedmatsH(int totalobs, int *obs, int R,
     int *tmp2 = write;
     int *tmp3;
     double sum=0;
+    double A[mo->N*mo->N];
+    densetransitions(mo, A);
     for(i=0; i<size; i++) 
         for(j=0;j<dsize;j++)
             mflag[i][j] = 0;
@@ -387,7 +603,7 @@ void precomputedmatsH(int totalobs, int *obs, int R,
                             else
                             {
                                 sum += mats[pos][fpos][j][k] =
-                                    ghmm_dmodel_get_transition(mo, j,k)*mo->s[k].b[e];
+                                    A[j*mo->N + k]*mo->s[k].b[e];
                             }
                         }
                         //printf("mats %d, %d, %d, %d, = %f\n", pos, fpos, j, k, 
@@ -459,19 +675,18 @@ int samplebinsearch(int seed, double *distribution, int N){
  * obs: observeration sequence
  * fwds: forward variable
  * R: length of compression
- * mats: matrix form of foward algorithm used for compression
- * rmats: cdf of  mats used for sampling
+ * tc: matrices of the tuples and their cdfs used for sampling
  * states: states
  * storedpos: get matrix for observation
  * sneak: delta in pavels paper, cdfs of forwards
  * N: number of states 
  */
 void csamplestatepath(int T, int *obs,
-        double **fwds, int R,
-        double ***mats, double ****rmats,
-        int *states, int* storedpos, double ***sneak, int N){
+        double **fwds, int R, tuplecache *tc,
+        int *states, uint64_t* storedpos, double ***sneak, int N){
     double *distribution;
-    int pos, cs, js, je;
+    uint64_t pos;
+    int cs, js, je;
     int p, s, e;
     int md = T%R ;
     
@@ -512,7 +727,7 @@ void csamplestatepath(int T, int *obs,
         je = md + s -2;
         
         for (;js<je;js++){
-            distribution = rmats[pos][states[js]][cs];
+            distribution = tuplecache_rmats(tc, pos) + (states[js]*N + cs)*N;
             states[js+1] = samplebinsearch(0, distribution, N);
             pos = storedpos[js+2];
             //printf("state %d = %d\n",js+1, states[js+1]);
@@ -598,16 +813,17 @@ void csamplestatepathH(int T, int *obs,
  * obs: observation sequence
  * R: compression length
  * fwds: forward variables
- * mats: matrix of forward varibles used for compression
+ * tc: matrices of the tuples used for compression
  * storedpos: gets matrix for observation
  * sneak: cdf of mats columns */
 void cforwards(int totalobs, int* obs, ghmm_dmodel *mo, int R, double **fwds, 
-               double ***mats, int *storedpos, double ***sneak){
+               tuplecache *tc, uint64_t *storedpos, double ***sneak){
 #define CUR_PROC "cforwards"
     int i,j,k;
     double sum = 0, tv;
-    int s, e ;
-    int pos;
+    int s;
+    double *mats;
+    int N = mo->N;
     for (j=0;j<mo->N;j++){
         fwds[0][j] = mo->s[j].pi*mo->s[j].b[obs[0]];
         sum += fwds[0][j];
@@ -620,16 +836,16 @@ void cforwards(int totalobs, int* obs, ghmm_dmodel *mo, int R, double **fwds,
     }
 
     i = 1; 
-    pos = storedpos[1];
+    mats = tuplecache_mats(tc, storedpos[1]);
     
 
     for (j=0;j<mo->N;j++){
-        tv = fwds[0][0]*mats[pos][0][j];
+        tv = fwds[0][0]*mats[j];
 
         sneak[i][j][0] = tv;
 
         for (k=1;k<mo->N;k++){
-            tv += fwds[0][k]*mats[pos][k][j];
+            tv += fwds[0][k]*mats[k*N + j];
             sneak[i][j][k] = tv;
         }
         fwds[i][j] = tv;
@@ -642,17 +858,16 @@ void cforwards(int totalobs, int* obs, ghmm_dmodel *mo, int R, double **fwds,
 
     i = 2;
     s = R;
-    e = 2*R;
     
-    while (1){
+    while (s < totalobs){
 
-        pos = storedpos[s];
+        mats = tuplecache_mats(tc, storedpos[s]);
         sum = 0;
         for (j=0;j<mo->N;j++){
-            tv = fwds[i-1][0]*mats[pos][0][j];
+            tv = fwds[i-1][0]*mats[j];
             sneak[i][j][0] = tv;
             for (k=1;k<mo->N;k++){
-                tv += fwds[i-1][k]*mats[pos][k][j];
+                tv += fwds[i-1][k]*mats[k*N + j];
                 sneak[i][j][k] = tv;
             }
             fwds[i][j] = tv;
@@ -665,8 +880,6 @@ void cforwards(int totalobs, int* obs, ghmm_dmodel *mo, int R, double **fwds,
             
         i++;
         s += R;
-        if ( s >= totalobs )
-            break;
     }        
 #undef CUR_PROC
 }
@@ -779,15 +992,14 @@ void cforwardsH(int T, int *obs, ghmm_dmodel *mo,
  * pB: prior for B
  * pPi: prior for pi
  * Q: states
- * R: length of compression */
+ * R: length of compression
+ * tc: tuple matrices, reset with tuplecache_reset after changing mo */
 void ghmm_dmodel_cfbgibbstep(ghmm_dmodel *mo, int *obs, int totalobs,
         double **pA, double **pB, double *pPi, int* Q, int R, double**fwds,
-        double ***sneak, double ***mats, double ****rmats, int *storedpos){
-        precompute(R, mo, mats, rmats);
-
-        cforwards(totalobs, obs, mo, R, fwds, mats, storedpos, sneak);
+        double ***sneak, tuplecache *tc, uint64_t *storedpos){
+        cforwards(totalobs, obs, mo, R, fwds, tc, storedpos, sneak);
         
-        csamplestatepath(totalobs, obs, fwds, R, mats, rmats, Q,
+        csamplestatepath(totalobs, obs, fwds, R, tc, Q,
                 storedpos, sneak, mo->N);
         
 }
@@ -808,22 +1020,26 @@ int** ghmm_dmodel_cfbgibbs(ghmm_dmodel* mo, ghmm_dseq* seq, double **pA, double
 #ifdef DO_WITH_GSL
 #define CUR_PROC "ghmm_dmodel_cfbgibbs"
     GHMM_RNG_SET (RNG, seed);
-    int **Q;
-    ARRAY_CALLOC (Q ,seq->seq_number);     
+    int **Q = NULL;
     double **transitions, **obsinstatealpha;
     double *obsinstate;
+    double **fwds = NULL, ***sneak = NULL;
+    uint64_t **positions = NULL;
     int i;
-    int len = 0;
+    int len = 0, shtsize = 0;
+    ARRAY_CALLOC (Q ,seq->seq_number);     
     for(i = 0; i < seq->seq_number; i++){
         ARRAY_CALLOC (Q[i] ,seq->seq_len[i]);     
         if(len < seq->seq_len[i])
             len = seq->seq_len[i];
     }
+    //forwards
+    shtsize = len/R+2;
+    fwds = ighmm_cmatrix_alloc(shtsize, mo->N);
+    sneak = ighmm_cmatrix_3d_alloc(shtsize, mo->N, mo->N);
+    if(!fwds || !sneak)
+        goto STOP;
     if(mo->model_type & GHMM_kHigherOrderEmissions){//higher order
-        //forwards
-        int shtsize = len/R+2;
-        double **fwds = ighmm_cmatrix_alloc(shtsize, mo->N);
-        double ***sneak = ighmm_cmatrix_3d_alloc(shtsize, mo->N, mo->N);
         double ****mats;
         double *****rmats;
         int j;
@@ -870,10 +1086,8 @@ int** ghmm_dmodel_cfbgibbs(ghmm_dmodel* mo, ghmm_dseq* seq, double **pA, double
         }
         //clean up
         freeCountsH(mo, &transitions, &obsinstate, &obsinstatealpha);
-        ighmm_cmatrix_3d_free(&sneak, shtsize, mo->N);
         ighmm_dmatrix_free(&preposition, R);
         ighmm_dmatrix_free(&prepositionH, mo->maxorder);
-        ighmm_cmatrix_free(&fwds, shtsize);
         for( i = 0 ; i < limit+1; i++){
            ighmm_cmatrix_3d_free(&mats[i],d, mo->N);
            for(j =0; j < d; j++)
@@ -883,52 +1097,62 @@ int** ghmm_dmodel_cfbgibbs(ghmm_dmodel* mo, ghmm_dseq* seq, double **pA, double
         m_free(mats);
     }
     else{//not higher order
-        //forwards
-        int shtsize = len/R+2;
-        double **fwds = ighmm_cmatrix_alloc(shtsize, mo->N);
-        double ***sneak = ighmm_cmatrix_3d_alloc(shtsize, mo->N, mo->N);
-        double ***mats;
-        double ****rmats;
-        int i;
-        int limit = (pow(mo->M, R+1)-1)/(mo->M-1) -1;  
-  	mats = ighmm_cmatrix_3d_alloc(limit, mo->N, mo->N);
-  	ARRAY_MALLOC (rmats, limit);
-  	for(i = 0; i < limit; i++)
-    	    rmats[i] = ighmm_cmatrix_3d_alloc(mo->N, mo->N, mo->N);
-        int tupleSize[R+1];
-        int **preposition = ighmm_dmatrix_alloc(R, mo->M);
-        int storedpos[seq->seq_number][len+1];//XXX dif every seq
+        tuplecache *tc;
+        uint64_t off[R+1];
+        long total = 0;
 
         //position
-        precomputeposition(R, mo->M, tupleSize, preposition, 1);
+        if(tupleoffsets(R, mo->M, off)){
+            GHMM_LOG_PRINTF(LERROR, LOC, "R = %d is too large for %d symbols", R, mo->M);
+            goto STOP;
+        }
+        ARRAY_CALLOC(positions, seq->seq_number);
         for(i = 0; i < seq->seq_number; i++){
-            storeposition(R, seq->seq_len[i], seq->seq[i], storedpos[i], mo->M, tupleSize, preposition);
+            ARRAY_MALLOC(positions[i], seq->seq_len[i]+1);
+            storeposition64(R, seq->seq_len[i], seq->seq[i], mo->M, off, positions[i]);
+            total += seq->seq_len[i];
         }
+        //at most one new tuple per observation
+        tc = tuplecache_alloc(mo->N, mo->M, total);
+        if(!tc)
+            goto STOP;
         //counts
         allocCounts(mo, &transitions, &obsinstate, &obsinstatealpha);
         for(;burnIn > 0; burnIn--){
             if(burnIn % 100==0) printf("iter %d", burnIn);
             initCounts(mo, transitions, obsinstate, obsinstatealpha, pA, pB, pPi);
+            tuplecache_reset(tc, mo);
             for(i = 0; i < seq->seq_number;i++){
                 ghmm_dmodel_cfbgibbstep(mo, seq->seq[i], seq->seq_len[i], pA, pB, pPi, Q[i], R, 
-                      fwds, sneak, mats, rmats, storedpos[i]);
+                      fwds, sneak, tc, positions[i]);
                 getCounts(Q[i], seq->seq[i], seq->seq_len[i], transitions, obsinstate, obsinstatealpha);
             }
             update(mo, transitions, obsinstate, obsinstatealpha);
         }
         //clean up
         freeCounts(mo, &transitions, &obsinstate, &obsinstatealpha);
-        ighmm_cmatrix_3d_free(&sneak, shtsize, mo->N);
-        ighmm_dmatrix_free(&preposition, R);
-        ighmm_cmatrix_free(&fwds, shtsize);
-        ighmm_cmatrix_3d_free(&mats,limit, mo->N);
-        for( i = 0 ; i < limit; i++)
-           ighmm_cmatrix_3d_free(&(rmats[i]), mo->N, mo->N);
-        m_free(rmats);
+        tuplecache_free(&tc);
+        for(i = 0; i < seq->seq_number; i++)
+            m_free(positions[i]);
+        m_free(positions);
     }
+    ighmm_cmatrix_3d_free(&sneak, shtsize, mo->N);
+    ighmm_cmatrix_free(&fwds, shtsize);
     return Q;
 STOP:
-   return NULL; 
+    if(positions){
+        for(i = 0; i < seq->seq_number; i++)
+            if(positions[i]) m_free(positions[i]);
+        m_free(positions);
+    }
+    ighmm_cmatrix_3d_free(&sneak, shtsize, mo->N);
+    ighmm_cmatrix_free(&fwds, shtsize);
+    if(Q){
+        for(i = 0; i < seq->seq_number; i++)
+            if(Q[i]) m_free(Q[i]);
+        m_free(Q);
+    }
+    return NULL;
 #undef CUR_PROC
 #else
    printf("cfbgibbs uses gsl for dirichlete distrubutions, compile with gsl\n");
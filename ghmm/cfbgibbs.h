@@ -59,6 +59,8 @@ extern "C" {
  * pB: prior count for B
  * pPi: prior count for pi
  * R: Must be greater than 0. Length of compression see paper for optimal length
+ *    The tuple matrices are computed for the tuples in seq only and kept
+ *    in a bounded cache, R is limited by M^R fitting into 64 bits
  * burnIn: number of times to run forward backward gibbs 
  * seed: seed 
  * return int* state path
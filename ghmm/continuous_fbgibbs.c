@@ -111,9 +111,18 @@ int ghmm_cmodel_forwardgibbs (ghmm_cmodel * smo, double *O, int T, double ***b,
   int i, t = 0, osc = 0;
   double c_t;
   int pos;
+  int *classes = NULL;
 
   /* T is length of sequence; divide by dimension to represent the number of time points */
   T /= smo->dim;
+  /* transition classes of the whole sequence */
+  if (smo->cos > 1) {
+    ARRAY_MALLOC (classes, T > 1 ? T - 1 : 1);
+    if (ghmm_cmodel_get_class_sequence (smo, O, smo->class_change ?
+                                        smo->class_change->k : -1, T,
+                                        classes) == -1)
+      goto STOP;
+  }
   /* calculate alpha and scale for t = 0 */
   if (b == NULL)
     sfoba_initforward(smo, alpha[0], O, scale, NULL);
@@ -127,25 +136,10 @@ int ghmm_cmodel_forwardgibbs (ghmm_cmodel * smo, double *O, int T, double ***b,
   else {
     *log_p = -log (1 / scale[0]);
 
-    if (smo->cos == 1) {
-      osc = 0;
-    }
-    else {
-      if (!smo->class_change->get_class) {
-        printf ("ERROR: get_class not initialized\n");
-        return (-1);
-      }
-      /* printf("1: cos = %d, k = %d, t = %d\n",smo->cos,smo->class_change->k,t); */
-      osc = smo->class_change->get_class (smo, O, smo->class_change->k, t);
-      if (osc >= smo->cos){
-        printf("ERROR: get_class returned index %d but model has only %d classes !\n",osc,smo->cos);
-        goto STOP;
-      }
-
-    }
-
-
     for (t = 1; t < T; t++) {
+      /* class of the transition from t-1 to t */
+      if (classes)
+        osc = classes[t - 1];
       scale[t] = 0.0;
       pos = t * smo->dim;
       /* b not calculated yet */
@@ -175,23 +169,6 @@ int ghmm_cmodel_forwardgibbs (ghmm_cmodel * smo, double *O, int T, double ***b,
         alpha[t][i] *= c_t;
       /* summation of log(c[t]) for calculation of log( P(O|lambda) ) */
       *log_p -= log (c_t);
-
-      if (smo->cos == 1) {
-        osc = 0;
-      }
-      else {
-        if (!smo->class_change->get_class) {
-          printf ("ERROR: get_class not initialized\n");
-          return (-1);
-        }
-        /* printf("1: cos = %d, k = %d, t = %d\n",smo->cos,smo->class_change->k,t); */
-        osc = smo->class_change->get_class (smo, O, smo->class_change->k, t);
-        if (osc >= smo->cos){
-          printf("ERROR: get_class returned index %d but model has only %d classes !\n",osc,smo->cos);
-          goto STOP;
-        }		
-      }
-
     }
   }
   /* log_p should not be smaller than value used for seqs. that 
@@ -199,9 +176,13 @@ int ghmm_cmodel_forwardgibbs (ghmm_cmodel * smo, double *O, int T, double ***b,
      if (*log_p < (double)PENALTY_LOGP)
      *log_p = (double)PENALTY_LOGP;
    */
+  if (classes)
+    m_free (classes);
   return 0;
 STOP:
   *log_p = (double) -DBL_MAX;
+  if (classes)
+    m_free (classes);
   return (res);
 #undef CUR_PROC
 }                               /* ghmm_cmodel_forward */
@@ -210,66 +191,55 @@ STOP:
 //====================================================================================
 
 /* XXX mixture */
-//[state][power]
 //assumes normal dist
-void precompute_blocks(ghmm_cmodel *mo, double ** mean, double **std,
-        double **transition, int max_block_len){
-    int i, j;
-    for(i=0; i < mo->N; i++){
-        mean[i][0] = 1;
-        mean[i][1] = (mo->s+i)->e->mean.val * (mo->s+i)->e->mean.val;
-        std[i][0] = sqrt( (mo->s+i)->e->variance.val);
-        std[i][1] = std[i][0] * sqrt( 2 * M_PI  );
-        //printf("std %e\n",  std[i][0]);
-        transition[i][0] = 1;
-        transition[i][1] = (mo->s+i)->out_a[0][i];
-
-        //printf("transition %d %d %e\n", i, 0, transition[i][0]);
-        //printf("transition %d %d %e\n", i, 1, transition[i][1]);
-        for(j = 2; j < max_block_len; j++){
-            std[i][j] = std[i][j-1] * std[i][1];
-            transition[i][j] = transition[i][j-1]*transition[i][1];
-            mean[i][j] = mean[i][j-1]+mean[i][1];
-            //printf("transition %d %d %e\n", i, j, std[i][j]);
-        }
+//precomputes b for forward algo: a block of len observations in state i
+//stays len-1 times in i, so in closed form through the block moments
+//  b[t][i] = a_ii^(len-1) * prod N(x | mu_i, var_i)
+//          = a_ii^(len-1) * exp(-(m2 - 2 m1 mu + len mu^2) / (2 var))
+//            / (2 pi var)^(len/2)
+//computed in log space and divided by the largest state of the block; the
+//forward rescales every step anyway, so the sampled path is unchanged and
+//long blocks neither underflow nor overflow. Costs O(N) per block.
+//returns 0 or -1 on error
+int precompute_block_emission(ghmm_cmodel *mo, block_stats *stats, double ***b){
+#define CUR_PROC "precompute_block_emission"
+    int t, i, len;
+    double mu, var, self, max, sqrs;
+    double *log_self = NULL, *log_norm = NULL;
+
+    ARRAY_MALLOC(log_self, mo->N);
+    ARRAY_MALLOC(log_norm, mo->N);
+    for(i = 0; i < mo->N; i++){
+        var = (mo->s+i)->e->variance.val;
+        log_norm[i] = 0.5*log(2*M_PI*var);
+        self = ghmm_cmodel_get_transition(mo, i, i, 0);
+        log_self[i] = self > 0 ? log(self) : -HUGE_VAL;
     }
-}
-
-//assumes normal dist
-//precomputes b for forward algo
-void precompute_block_emission(ghmm_cmodel *mo, block_stats *stats, 
-        int max_block_len, double ***b){
-#define CUR_PROC "precalculate_block_emission"
-    //precompute intermediate values
-    double **mean2, **std, **transition;
-    mean2 = ighmm_cmatrix_alloc(mo->N, max_block_len+1);
-    std = ighmm_cmatrix_alloc(mo->N, max_block_len+1);
-    transition = ighmm_cmatrix_alloc(mo->N, max_block_len+1);
-    precompute_blocks(mo, mean2, std, transition, max_block_len+1);
-
-
-    int t, i;
-    double exponent;
     for(t = 0; t < stats->total; t++){
-        for(i = 0; i < mo->N; i++){//flip order
-            //printf("sumsqrs %e\n", stats->moment2[t]);
-            //printf("transition %e\n", transition[i][stats->length[t]]);
-            exponent = -1 * ( stats->moment2[t] - 2*stats->moment1[t] *
-                    (mo->s+i)->e->mean.val + mean2[i][stats->length[t]] ) /
-                    (2 * (mo->s+i)->e->variance.val);
-                    
-            b[t][i][1] = transition[i][stats->length[t]] * exp( exponent ) / 
-                std[i][stats->length[t]];
-            //printf("exp = %e\n", exponent);
-            //printf("b %d %d = %e\n", t, i, b[t][i][1]);
+        len = stats->length[t];
+        max = -HUGE_VAL;
+        for(i = 0; i < mo->N; i++){
+            mu = (mo->s+i)->e->mean.val;
+            var = (mo->s+i)->e->variance.val;
+            sqrs = stats->moment2[t] - 2*stats->moment1[t]*mu + len*mu*mu;
+            if(sqrs < 0)//rounding
+                sqrs = 0;
+            b[t][i][1] = -sqrs/(2*var) - len*log_norm[i];
+            if(len > 1)
+                b[t][i][1] += (len-1)*log_self[i];
+            if(max < b[t][i][1])
+                max = b[t][i][1];
         }
+        for(i = 0; i < mo->N; i++)
+            b[t][i][1] = max > -HUGE_VAL ? exp(b[t][i][1] - max) : 0;
     }
-    ighmm_cmatrix_free(&mean2, mo->N);
-    ighmm_cmatrix_free(&std, mo->N);
-    ighmm_cmatrix_free(&transition, mo->N);
+    m_free(log_self);
+    m_free(log_norm);
+    return 0;
 STOP:
-    //XXX ERROR
-    return;
+    if(log_self)
+        m_free(log_self);
+    return -1;
 #undef CUR_PROC
 }
 
@@ -379,23 +349,46 @@ void ghmm_get_sample_data(ghmm_sample_data *data, ghmm_bayes_hmm *bayes,int *Q,
     }
 }
 
-//gets data from blocks 
+//first pass of a whole block of length observations with sum moment1
+void ghmm_get_emission_data_first_pass_block(sample_emission_data *data,
+        ghmm_density_t type, double moment1, int length){
+    switch(type){
+        case(normal):
+            data->mean.val += moment1;
+            data->emitted += length;
+        default://not supported
+            return;
+    }
+}
+
+//second pass of a whole block, sum of squared deviations from the moments
+void ghmm_get_emission_data_second_pass_block(sample_emission_data *data,
+        ghmm_density_t type, double moment1, double moment2, int length){
+    double tmp;
+    switch(type){
+        case(normal)://divide by emitted before 2 pass
+            tmp = moment2 - 2*data->mean.val*moment1
+                + length*data->mean.val*data->mean.val;
+            data->variance.val += tmp > 0 ? tmp : 0;
+        default://not supported
+            return;
+    }
+}
+
+//gets data from blocks, only the block moments are used so this is linear
+//in the number of blocks T
 void ghmm_get_sample_data_compressed(ghmm_sample_data *data, ghmm_bayes_hmm *bayes,
-        int *Q, double *O, int T, block_stats *stats){
-    int i,j,index;
+        int *Q, int T, block_stats *stats){
+    int i;
     for(i=0; i<T-1; i++){
         data->transition[Q[i]][Q[i+1]]++;
-        data->transition[Q[i]][Q[i]] += stats->length[i];
+        data->transition[Q[i]][Q[i]] += stats->length[i]-1;
     }
-    data->transition[Q[T-1]][Q[T-1]] += stats->length[T-1];
+    data->transition[Q[T-1]][Q[T-1]] += stats->length[T-1]-1;
 
-    index = 0;
     for(i=0; i<T; i++){
-        for(j = 0; j < stats->length[i]; j++){
-            ghmm_get_emission_data_first_pass(&(data->state_data[Q[i]][0]),
-                    bayes->params[Q[i]][0].type, O+index);
-            index++;
-        }
+        ghmm_get_emission_data_first_pass_block(&(data->state_data[Q[i]][0]),
+                bayes->params[Q[i]][0].type, stats->moment1[i], stats->length[i]);
     }
 
     for(i=0; i<bayes->N; i++){
@@ -403,13 +396,10 @@ void ghmm_get_sample_data_compressed(ghmm_sample_data *data, ghmm_bayes_hmm *bay
             data->state_data[i][0].mean.val /= data->state_data[i][0].emitted;
     }
 
-    index = 0;
     for(i=0;i<T;i++){
-        for(j = 0; j < stats->length[i]; j++){
-            ghmm_get_emission_data_second_pass(&data->state_data[Q[i]][0],
-                    bayes->params[Q[i]][0].type, O+index);
-            index++;
-        }
+        ghmm_get_emission_data_second_pass_block(&data->state_data[Q[i]][0],
+                bayes->params[Q[i]][0].type, stats->moment1[i], stats->moment2[i],
+                stats->length[i]);
     }
 }
    
@@ -526,41 +516,45 @@ int* ghmm_bayes_hmm_fbgibbs_compressed(ghmm_bayes_hmm *bayes, ghmm_cmodel *mo, g
 #define CUR_PROC "ghmm_cmodel_fbgibbs"
     //XXX seed
     GHMM_RNG_SET (RNG, seed);
+    double ***b = NULL, **alpha = NULL, ***pmats = NULL;
+    int *Q = NULL;
 
     block_stats *stats = compress_observations(seq, width*delta, delta);
     stats = merge_observations(seq, width, max_len_permitted, stats);
+    if(!stats)
+        goto STOP;
     print_stats(stats, seq->seq_len[0]);
-    //get max_block_len
-    int max_block_len = stats->length[0];
-    int i;
-    for(i = 1; i < stats->total; i++){
-        if(max_block_len < stats->length[i])
-            max_block_len = stats->length[i];
-    }
-    //printf("max b len %d\n", max_block_len);
-    double ***b = ighmm_cmatrix_3d_alloc(stats->total, mo->N, 2);
-    double **alpha = ighmm_cmatrix_alloc(seq->seq_len[0],mo->N);
-    double ***pmats = ighmm_cmatrix_3d_alloc(seq->seq_len[0], mo->N, mo->N);
-    int *Q; 
+    //the sampler only works on blocks, T is not needed after compression
+    b = ighmm_cmatrix_3d_alloc(stats->total, mo->N, 2);
+    alpha = ighmm_cmatrix_alloc(stats->total, mo->N);
+    pmats = ighmm_cmatrix_3d_alloc(stats->total, mo->N, mo->N);
     ARRAY_CALLOC(Q, seq->seq_len[0]);//XXX extra length for compressed
     ghmm_sample_data data;
     ghmm_alloc_sample_data(bayes, &data);
     ghmm_clear_sample_data(&data, bayes);//XXX swap parameter 
     for(; burnIn > 0; burnIn--){
         //XXX only using seq 0
-        precompute_block_emission(mo, stats, max_block_len, b);//XXX maxlen
+        if(precompute_block_emission(mo, stats, b))
+            goto STOP;
         ghmm_cmodel_fbgibbstep(mo,seq->seq[0], stats->total, Q, alpha, pmats, b);
-        ghmm_get_sample_data_compressed(&data, bayes, Q, seq->seq[0], 
-                stats->total, stats); 
+        ghmm_get_sample_data_compressed(&data, bayes, Q, stats->total, stats); 
         ghmm_update_model(mo, bayes, &data);
         ghmm_clear_sample_data(&data, bayes);
     }
-    ighmm_cmatrix_free(&alpha, seq->seq_len[0]);
-    ighmm_cmatrix_3d_free(&pmats, seq->seq_len[0],mo->N);
+    ighmm_cmatrix_free(&alpha, stats->total);
+    ighmm_cmatrix_3d_free(&pmats, stats->total, mo->N);
     ighmm_cmatrix_3d_free(&b, stats->total, mo->N);
     free_block_stats(&stats);
     return Q;
 STOP:
+    if(stats){
+        ighmm_cmatrix_free(&alpha, stats->total);
+        ighmm_cmatrix_3d_free(&pmats, stats->total, mo->N);
+        ighmm_cmatrix_3d_free(&b, stats->total, mo->N);
+        free_block_stats(&stats);
+    }
+    if(Q)
+        m_free(Q);
     return NULL; //XXX error handle
 #undef CUR_PROC
 }
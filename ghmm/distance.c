@@ -0,0 +1,634 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/distance.c
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include "ghmm.h"
+#include "mes.h"
+#include "matrix.h"
+#include "model.h"
+#include "smodel.h"
+#include "sequence.h"
+#include "foba.h"
+#include "sfoba.h"
+#include "distance.h"
+#include "ghmm_internals.h"
+
+/* log likelihood of a chunk that can not be generated by a model */
+#define DISTANCE_IMPOSSIBLE (-DBL_MAX)
+
+typedef struct distance_run {
+  int n;
+  ghmm_dmodel **mo;
+  ghmm_cmodel **smo;
+  const ghmm_distance_options *opt;
+  int threads;
+  /* per thread: chunk buffer, forward matrix and scaling factors */
+  int **O;
+  double ***alpha;
+  double **scale;
+  /* per thread > 0: copies of the models with silent states, the forward
+     algorithm rewrites their topological order */
+  ghmm_dmodel ***copy;
+  /* per chunk of the current batch: length and log likelihoods */
+  int *len;
+  double **ll;
+  /* models that can not generate an earlier sample of the current row are
+     not scored any more */
+  const int *skip;
+} distance_run;
+
+
+/*----------------------------------------------------------------------------*/
+/* splitmix64, used both to derive the streams and as stream generator */
+static uint64_t distance_next (uint64_t * x)
+{
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/* independent stream of chunk k of model i */
+static uint64_t distance_stream (unsigned long seed, int i, long k)
+{
+  uint64_t x = seed;
+  x = distance_next (&x) ^ (uint64_t) i;
+  x = distance_next (&x) ^ (uint64_t) k;
+  return distance_next (&x);
+}
+
+/* uniform in [0, 1) */
+static double distance_uniform (uint64_t * x)
+{
+  return (distance_next (x) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*----------------------------------------------------------------------------*/
+/* draws a chunk of at most max_len symbols from a discrete model, same
+   semantics as ghmm_dmodel_generate_sequences but without the global
+   random number generator and the emission history of the model */
+static int distance_sample (const ghmm_dmodel * mo, uint64_t * rng, int *O,
+                            int max_len)
+{
+  int higher = mo->model_type & GHMM_kHigherOrderEmissions;
+  int silent = mo->model_type & GHMM_kSilentStates;
+  int state, last, j, j_id, m, e, pos = 0, hist = 0;
+  double p, sum, max_sum;
+
+  p = distance_uniform (rng);
+  sum = 0.0;
+  last = -1;
+  for (state = 0; state < mo->N; state++) {
+    if (mo->s[state].pi > 0.0)
+      last = state;
+    sum += mo->s[state].pi;
+    if (sum >= p)
+      break;
+  }
+  if (state == mo->N)           /* rounding error */
+    state = last;
+  if (state < 0)
+    return 0;
+
+  while (pos < max_len) {
+    if (!silent || !mo->silent[state]) {
+      e = higher ? (hist * mo->M) % mo->pow_lookup[mo->order[state] + 1] : 0;
+      p = distance_uniform (rng);
+      sum = 0.0;
+      last = 0;
+      for (m = 0; m < mo->M; m++) {
+        if (mo->s[state].b[e + m] > 0.0)
+          last = m;
+        sum += mo->s[state].b[e + m];
+        if (sum >= p)
+          break;
+      }
+      if (m == mo->M)
+        m = last;
+      O[pos++] = m;
+      if (higher && mo->maxorder > 0)
+        hist = (hist * mo->M + m) % mo->pow_lookup[mo->maxorder];
+    }
+
+    /* successors of order > pos can not emit yet */
+    p = distance_uniform (rng);
+    if (higher && pos < mo->maxorder) {
+      max_sum = 0.0;
+      for (j = 0; j < mo->s[state].out_states; j++)
+        if (mo->order[mo->s[state].out_id[j]] <= pos)
+          max_sum += mo->s[state].out_a[j];
+      p *= max_sum;
+    }
+    sum = 0.0;
+    last = -1;
+    for (j = 0; j < mo->s[state].out_states; j++) {
+      j_id = mo->s[state].out_id[j];
+      if (higher && mo->order[j_id] > pos)
+        continue;
+      if (mo->s[state].out_a[j] > 0.0)
+        last = j_id;
+      sum += mo->s[state].out_a[j];
+      if (sum >= p)
+        break;
+    }
+    if (last < 0)               /* final state */
+      break;
+    state = (j < mo->s[state].out_states) ? j_id : last;
+  }
+  return pos;
+}
+
+/*----------------------------------------------------------------------------*/
+static void distance_run_free (distance_run * r)
+{
+#define CUR_PROC "distance_run_free"
+  int t, j;
+
+  for (t = 0; t < r->threads; t++) {
+    if (r->O && r->O[t])
+      m_free (r->O[t]);
+    if (r->alpha)
+      ighmm_cmatrix_stat_free (&r->alpha[t]);
+    if (r->scale && r->scale[t])
+      m_free (r->scale[t]);
+    if (r->copy && r->copy[t]) {
+      for (j = 0; j < r->n; j++)
+        if (r->copy[t][j])
+          ghmm_dmodel_free (&r->copy[t][j]);
+      m_free (r->copy[t]);
+    }
+  }
+  if (r->O)
+    m_free (r->O);
+  if (r->alpha)
+    m_free (r->alpha);
+  if (r->scale)
+    m_free (r->scale);
+  if (r->copy)
+    m_free (r->copy);
+  if (r->len)
+    m_free (r->len);
+  ighmm_cmatrix_stat_free (&r->ll);
+#undef CUR_PROC
+}
+
+/*----------------------------------------------------------------------------*/
+static int distance_run_alloc (distance_run * r, int n, ghmm_dmodel ** mo,
+                               ghmm_cmodel ** smo,
+                               const ghmm_distance_options * opt)
+{
+#define CUR_PROC "distance_run_alloc"
+  int t, j, max_N = 0;
+
+  memset (r, 0, sizeof (*r));
+  r->n = n;
+  r->mo = mo;
+  r->smo = smo;
+  r->opt = opt;
+#ifdef _OPENMP
+  r->threads = omp_get_max_threads ();
+#else
+  r->threads = 1;
+#endif
+
+  if (n < 1 || opt->chunk_len < 1 || opt->batch < 1 || opt->max_symbols < 1) {
+    GHMM_LOG(LERROR, "invalid number of models or distance options");
+    return -1;
+  }
+  for (j = 0; j < n; j++) {
+    if (mo) {
+      if (mo[j]->M != mo[0]->M) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "model %d has a different alphabet", j);
+        return -1;
+      }
+      if (mo[j]->N > max_N)
+        max_N = mo[j]->N;
+    }
+    else {
+      if (smo[j]->dim != smo[0]->dim) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "model %d has a different dimension", j);
+        return -1;
+      }
+      if (smo[j]->N > max_N)
+        max_N = smo[j]->N;
+    }
+  }
+
+  ARRAY_CALLOC (r->alpha, r->threads);
+  ARRAY_CALLOC (r->scale, r->threads);
+  if (mo) {
+    ARRAY_CALLOC (r->O, r->threads);
+    ARRAY_CALLOC (r->copy, r->threads);
+  }
+  for (t = 0; t < r->threads; t++) {
+    r->alpha[t] = ighmm_cmatrix_stat_alloc (opt->chunk_len, max_N);
+    if (!r->alpha[t]) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
+    ARRAY_CALLOC (r->scale[t], opt->chunk_len);
+    if (!mo)
+      continue;
+    ARRAY_CALLOC (r->O[t], opt->chunk_len);
+    if (t == 0)
+      continue;
+    ARRAY_CALLOC (r->copy[t], n);
+    for (j = 0; j < n; j++)
+      if (mo[j]->model_type & GHMM_kSilentStates) {
+        r->copy[t][j] = ghmm_dmodel_copy (mo[j]);
+        if (!r->copy[t][j]) {
+          GHMM_LOG_QUEUED(LCONVERTED);
+          goto STOP;
+        }
+      }
+  }
+  ARRAY_CALLOC (r->len, opt->batch);
+  r->ll = ighmm_cmatrix_stat_alloc (opt->batch, n);
+  if (!r->ll) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  distance_run_free (r);
+  return -1;
+#undef CUR_PROC
+}
+
+/*----------------------------------------------------------------------------*/
+/* draws and scores chunks first .. first + batch - 1 of discrete model i */
+static int distance_dbatch (distance_run * r, int i, long first)
+{
+  int k;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (k = 0; k < r->opt->batch; k++) {
+    int j, th = 0;
+    uint64_t rng = distance_stream (r->opt->seed, i, first + k);
+    ghmm_dmodel *mo;
+#ifdef _OPENMP
+    th = omp_get_thread_num ();
+#endif
+    r->len[k] = distance_sample (r->mo[i], &rng, r->O[th], r->opt->chunk_len);
+    for (j = 0; j < r->n && r->len[k] > 0; j++) {
+      if (r->skip[j])
+        continue;
+      mo = (th > 0 && r->copy[th][j]) ? r->copy[th][j] : r->mo[j];
+      if (ghmm_dmodel_forward (mo, r->O[th], r->len[k], r->alpha[th],
+                               r->scale[th], &r->ll[k][j]) == -1)
+        r->ll[k][j] = DISTANCE_IMPOSSIBLE;
+    }
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* generates (serially, the continuous generator uses the global random
+   number generator) and scores a batch of continuous model i */
+static int distance_cbatch (distance_run * r, int i, long first)
+{
+#define CUR_PROC "distance_cbatch"
+  ghmm_cseq *sq;
+  uint64_t stream = distance_stream (r->opt->seed, i, first);
+  int k;
+
+  sq = ghmm_cmodel_generate_sequences (r->smo[i], (int) (stream % 2147483646) + 1,
+                                       r->opt->chunk_len, r->opt->batch,
+                                       r->opt->chunk_len);
+  if (!sq) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return -1;
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (k = 0; k < r->opt->batch; k++) {
+    int j, th = 0;
+#ifdef _OPENMP
+    th = omp_get_thread_num ();
+#endif
+    r->len[k] = (k < sq->seq_number && sq->seq[k]) ? sq->seq_len[k] / r->smo[i]->dim : 0;
+    for (j = 0; j < r->n && r->len[k] > 0; j++)
+      if (!r->skip[j]
+          && ghmm_cmodel_forward (r->smo[j], sq->seq[k], sq->seq_len[k], NULL,
+                               r->alpha[th], r->scale[th], &r->ll[k][j]) == -1)
+        r->ll[k][j] = DISTANCE_IMPOSSIBLE;
+  }
+
+  ghmm_cseq_free (&sq);
+  return 0;
+#undef CUR_PROC
+}
+
+/*----------------------------------------------------------------------------*/
+/* z standard errors of the ratio sum d_k / sum l_k over m chunks */
+static double distance_half_width (double z, int m, double sd, double sdd,
+                                   double sdl, double sl, double sll)
+{
+  double r, ss;
+
+  if (m < 2)
+    return DBL_MAX;
+  r = sd / sl;
+  ss = sdd - 2.0 * r * sdl + r * r * sll;
+  if (ss < 0.0)
+    ss = 0.0;
+  return z * sqrt (ss / (m * (m - 1.0))) / (sl / m);
+}
+
+/*----------------------------------------------------------------------------*/
+/* distances d(i, .) from samples of model i; the chunks are reduced in
+   their order, so the result does not depend on the scheduling */
+static int distance_row (distance_run * r, int i, double *d, double *hw,
+                         long *symbols, int *chunks)
+{
+#define CUR_PROC "distance_row"
+  const ghmm_distance_options *opt = r->opt;
+  double *sd = NULL, *sdd = NULL, *sdl = NULL;
+  int *impossible = NULL;
+  double sl = 0.0, sll = 0.0, diff;
+  long drawn = 0;
+  int j, k, m = 0, done, res = -1;
+
+  ARRAY_CALLOC (sd, r->n);
+  ARRAY_CALLOC (sdd, r->n);
+  ARRAY_CALLOC (sdl, r->n);
+  ARRAY_CALLOC (impossible, r->n);
+  r->skip = impossible;
+
+  for (;;) {
+    if ((r->mo ? distance_dbatch (r, i, drawn)
+         : distance_cbatch (r, i, drawn)) == -1) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
+    drawn += opt->batch;
+
+    for (k = 0; k < opt->batch; k++) {
+      if (r->len[k] == 0 || r->ll[k][i] == DISTANCE_IMPOSSIBLE)
+        continue;
+      m++;
+      sl += r->len[k];
+      sll += (double) r->len[k] * r->len[k];
+      *symbols += r->len[k];
+      for (j = 0; j < r->n; j++) {
+        if (j == i || impossible[j])
+          continue;
+        if (r->ll[k][j] == DISTANCE_IMPOSSIBLE) {
+          impossible[j] = 1;
+          continue;
+        }
+        diff = r->ll[k][i] - r->ll[k][j];
+        sd[j] += diff;
+        sdd[j] += diff * diff;
+        sdl[j] += diff * r->len[k];
+      }
+    }
+
+    /* every chunk counts with at least one symbol against the budget, so
+       models producing empty chunks terminate as well */
+    if (sl >= opt->max_symbols || drawn >= opt->max_symbols)
+      break;
+    if (opt->tolerance > 0.0 && m >= opt->min_chunks) {
+      done = 1;
+      for (j = 0; j < r->n && done; j++)
+        if (j != i && !impossible[j]
+            && distance_half_width (opt->z, m, sd[j], sdd[j], sdl[j], sl, sll)
+            > opt->tolerance)
+          done = 0;
+      if (done)
+        break;
+    }
+  }
+
+  if (m == 0) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "model %d generated no usable sample", i);
+    goto STOP;
+  }
+  for (j = 0; j < r->n; j++) {
+    if (j == i)
+      d[j] = hw[j] = 0.0;
+    else if (impossible[j]) {
+      d[j] = DBL_MAX;
+      hw[j] = 0.0;
+    }
+    else {
+      d[j] = sd[j] / sl;
+      hw[j] = distance_half_width (opt->z, m, sd[j], sdd[j], sdl[j], sl, sll);
+    }
+  }
+  *chunks += m;
+  res = 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (sd)
+    m_free (sd);
+  if (sdd)
+    m_free (sdd);
+  if (sdl)
+    m_free (sdl);
+  if (impossible)
+    m_free (impossible);
+  return res;
+#undef CUR_PROC
+}
+
+/*----------------------------------------------------------------------------*/
+static void distance_symmetrise (double *d_ij, double *d_ji, double *hw_ij,
+                                 double *hw_ji)
+{
+  double d, hw;
+
+  if (*d_ij == DBL_MAX || *d_ji == DBL_MAX) {
+    d = DBL_MAX;
+    hw = 0.0;
+  }
+  else {
+    d = 0.5 * (*d_ij + *d_ji);
+    hw = 0.5 * sqrt (*hw_ij * *hw_ij + *hw_ji * *hw_ji);
+  }
+  *d_ij = *d_ji = d;
+  *hw_ij = *hw_ji = hw;
+}
+
+/*----------------------------------------------------------------------------*/
+static int distance_matrix (int n, ghmm_dmodel ** mo, ghmm_cmodel ** smo,
+                            const ghmm_distance_options * opt, double **d,
+                            double **half_width)
+{
+#define CUR_PROC "distance_matrix"
+  ghmm_distance_options defaults;
+  distance_run r;
+  double **hw = half_width;
+  long symbols = 0;
+  int i, j, chunks = 0, res = -1;
+
+  if (!opt) {
+    ghmm_distance_options_init (&defaults);
+    opt = &defaults;
+  }
+  if (distance_run_alloc (&r, n, mo, smo, opt) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return -1;
+  }
+  if (!hw) {
+    hw = ighmm_cmatrix_stat_alloc (n, n);
+    if (!hw) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
+  }
+
+  for (i = 0; i < n; i++)
+    if (distance_row (&r, i, d[i], hw[i], &symbols, &chunks) == -1) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
+  if (opt->symmetric)
+    for (i = 0; i < n; i++)
+      for (j = i + 1; j < n; j++)
+        distance_symmetrise (&d[i][j], &d[j][i], &hw[i][j], &hw[j][i]);
+  res = 0;
+STOP:
+  if (hw != half_width)
+    ighmm_cmatrix_stat_free (&hw);
+  distance_run_free (&r);
+  return res;
+#undef CUR_PROC
+}
+
+/*----------------------------------------------------------------------------*/
+static int distance_pair (ghmm_dmodel * m0, ghmm_dmodel * m, ghmm_cmodel * cm0,
+                          ghmm_cmodel * cm, const ghmm_distance_options * opt,
+                          ghmm_distance_estimate * est)
+{
+#define CUR_PROC "distance_pair"
+  ghmm_distance_options defaults;
+  ghmm_dmodel *mo[2];
+  ghmm_cmodel *smo[2];
+  distance_run r;
+  double d[2][2], hw[2][2];
+  int res = -1;
+
+  if (!opt) {
+    ghmm_distance_options_init (&defaults);
+    opt = &defaults;
+  }
+  mo[0] = m0;
+  mo[1] = m;
+  smo[0] = cm0;
+  smo[1] = cm;
+  if (distance_run_alloc (&r, 2, m0 ? mo : NULL, m0 ? NULL : smo, opt) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return -1;
+  }
+
+  est->symbols = 0;
+  est->chunks = 0;
+  if (distance_row (&r, 0, d[0], hw[0], &est->symbols, &est->chunks) == -1
+      || (opt->symmetric
+          && distance_row (&r, 1, d[1], hw[1], &est->symbols, &est->chunks) == -1)) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (opt->symmetric)
+    distance_symmetrise (&d[0][1], &d[1][0], &hw[0][1], &hw[1][0]);
+  est->distance = d[0][1];
+  est->half_width = hw[0][1];
+  res = 0;
+STOP:
+  distance_run_free (&r);
+  return res;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+void ghmm_distance_options_init (ghmm_distance_options * opt)
+{
+  opt->chunk_len = 1000;
+  opt->batch = 16;
+  opt->min_chunks = 8;
+  opt->max_symbols = 10000000;
+  opt->tolerance = 0.001;
+  opt->z = 1.96;
+  opt->seed = 4711;
+  opt->symmetric = 0;
+}
+
+/*============================================================================*/
+int ghmm_dmodel_distance_mc (ghmm_dmodel * m0, ghmm_dmodel * m,
+                             const ghmm_distance_options * opt,
+                             ghmm_distance_estimate * est)
+{
+  return distance_pair (m0, m, NULL, NULL, opt, est);
+}
+
+/*============================================================================*/
+int ghmm_dmodel_distance_matrix (ghmm_dmodel ** mo, int n,
+                                 const ghmm_distance_options * opt,
+                                 double **d, double **half_width)
+{
+  return distance_matrix (n, mo, NULL, opt, d, half_width);
+}
+
+/*============================================================================*/
+int ghmm_cmodel_distance_mc (ghmm_cmodel * cm0, ghmm_cmodel * cm,
+                             const ghmm_distance_options * opt,
+                             ghmm_distance_estimate * est)
+{
+  return distance_pair (NULL, NULL, cm0, cm, opt, est);
+}
+
+/*============================================================================*/
+int ghmm_cmodel_distance_matrix (ghmm_cmodel ** smo, int n,
+                                 const ghmm_distance_options * opt,
+                                 double **d, double **half_width)
+{
+  return distance_matrix (n, NULL, smo, opt, d, half_width);
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/distance.h
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+#ifndef GHMM_DISTANCE_H
+#define GHMM_DISTANCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+
+/**@name Monte-Carlo model distance */
+/*@{ (Doc++-Group: distance) */
+
+/**
+  Options of the Monte-Carlo distance estimators. The distance of model j
+  from model i is estimated from sample sequences of model i as
+
+    d(i, j) = sum_k (log P(O_k | i) - log P(O_k | j)) / sum_k len(O_k),
+
+  i.e. the Kullback-Leibler divergence rate used by
+  ghmm_dmodel_prob_distance. The samples are drawn in chunks of at most
+  chunk_len symbols, every chunk from its own random stream, so the result
+  only depends on seed and not on the number of threads. Chunks are drawn
+  in batches; after each batch the half width of the confidence interval
+  (z standard errors of the ratio estimator) is checked and sampling stops
+  as soon as it is below tolerance for all compared models.
+  */
+  typedef struct ghmm_distance_options {
+    /** maximal length of one sample chunk (a chunk ends early when the
+        model reaches a final state) **/
+    int chunk_len;
+    /** number of chunks drawn (and scored in parallel) between two checks
+        of the stopping criterion **/
+    int batch;
+    /** least number of chunks before stopping early **/
+    int min_chunks;
+    /** largest number of symbols drawn from one model **/
+    long max_symbols;
+    /** target half width of the confidence intervals, 0 disables early
+        stopping **/
+    double tolerance;
+    /** quantile of the normal distribution, 1.96 for 95% intervals **/
+    double z;
+    /** seed of the random streams **/
+    unsigned long seed;
+    /** estimate 0.5 * (d(i, j) + d(j, i)) **/
+    int symmetric;
+  } ghmm_distance_options;
+
+/**
+  Result of a pairwise estimation.
+  */
+  typedef struct ghmm_distance_estimate {
+    /** estimated distance, DBL_MAX if a sample can not be generated by the
+        compared model **/
+    double distance;
+    /** half width of the confidence interval **/
+    double half_width;
+    /** number of symbols and chunks drawn **/
+    long symbols;
+    int chunks;
+  } ghmm_distance_estimate;
+
+/**
+  Sets the default options: chunks of 1000 symbols, batches of 16 chunks,
+  at least 8 chunks, at most 10^7 symbols, 95% intervals of half width
+  0.001, seed 4711, not symmetric.
+  @param opt  options to initialise
+  */
+  void ghmm_distance_options_init (ghmm_distance_options * opt);
+
+/**
+  Estimates the distance of m from m0 from samples of m0 (and of m from
+  m0 from samples of m if opt->symmetric). The chunks are scored in
+  parallel if the library is built with OpenMP.
+  @return 0 for success, -1 for error
+  @param m0   reference model
+  @param m    compared model
+  @param opt  options, NULL for the defaults
+  @param est  result
+  */
+  int ghmm_dmodel_distance_mc (ghmm_dmodel * m0, ghmm_dmodel * m,
+                               const ghmm_distance_options * opt,
+                               ghmm_distance_estimate * est);
+
+/**
+  Estimates the distances of all pairs of models. Every sample chunk of
+  model i is scored under all n models, so the samples are shared by the
+  n - 1 distances d(i, .) and the number of generated symbols grows
+  linearly in n. Sampling from model i stops when the intervals of all
+  d(i, j) are narrow enough.
+  @return 0 for success, -1 for error
+  @param mo          models, all with the same alphabet
+  @param n           number of models
+  @param opt         options, NULL for the defaults
+  @param d           n x n matrix for the distances d[i][j], symmetrised if
+                     opt->symmetric
+  @param half_width  n x n matrix for the half widths of the intervals or
+                     NULL
+  */
+  int ghmm_dmodel_distance_matrix (ghmm_dmodel ** mo, int n,
+                                   const ghmm_distance_options * opt,
+                                   double **d, double **half_width);
+
+/**
+  Continuous version of ghmm_dmodel_distance_mc. The chunks are generated
+  by ghmm_cmodel_generate_sequences, which uses the global random number
+  generator: the generation is serial and reseeds the global generator.
+  Class change functions have to be reentrant.
+  @return 0 for success, -1 for error
+  @param cm0  reference model
+  @param cm   compared model
+  @param opt  options, NULL for the defaults
+  @param est  result
+  */
+  int ghmm_cmodel_distance_mc (ghmm_cmodel * cm0, ghmm_cmodel * cm,
+                               const ghmm_distance_options * opt,
+                               ghmm_distance_estimate * est);
+
+/**
+  Continuous version of ghmm_dmodel_distance_matrix.
+  @return 0 for success, -1 for error
+  @param smo         models, all with the same dimension
+  @param n           number of models
+  @param opt         options, NULL for the defaults
+  @param d           n x n matrix for the distances
+  @param half_width  n x n matrix for the half widths or NULL
+  */
+  int ghmm_cmodel_distance_matrix (ghmm_cmodel ** smo, int n,
+                                   const ghmm_distance_options * opt,
+                                   double **d, double **half_width);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+/*@} (Doc++-Group: distance) */
@@ -49,6 +49,155 @@
 #include "foba.h"
 #include "ghmm_internals.h"
 
+/*
+  Specialized kernels: the forward and backward recursions for one time
+  step are instantiated once per combination of silent states (SILENT) and
+  higher order emissions (HIGHER). Both are compile time constants in the
+  instances, so the model_type tests vanish from the inner loops. The
+  kernel is selected once per call by foba_forward_kernel and
+  foba_backward_kernel. Higher order instances look up the emission
+  indices in the context indices ctx of the sequence
+  (ghmm_dmodel_emission_context_alloc).
+*/
+
+/* NAME (mo, O, ctx, t, alpha_last, alpha_t): unscaled alpha_t from the
+   scaled alpha_last, returns the sum of alpha_t */
+#define FOBA_FORWARD_COLUMN(NAME, SILENT, HIGHER)                              \
+static double NAME (ghmm_dmodel * mo, const int *O, int **ctx, int t,          \
+                    const double *alpha_last, double *alpha_t)                 \
+{                                                                              \
+  int i, k, id, e_index;                                                       \
+  double value, b_symb, sum = 0.0;                                             \
+  ghmm_dstate *s;                                                              \
+                                                                               \
+  /* non-silent states */                                                      \
+  for (i = 0; i < mo->N; i++) {                                                \
+    if (SILENT && mo->silent[i])                                               \
+      continue;                                                                \
+    e_index = HIGHER ? ctx[mo->order[i]][t] : O[t];                            \
+    if (HIGHER && e_index == -1) {                                             \
+      alpha_t[i] = 0;                                                          \
+      continue;                                                                \
+    }                                                                          \
+    s = mo->s + i;                                                             \
+    b_symb = s->b[e_index];                                                    \
+    value = 0.0;                                                               \
+    if (b_symb >= GHMM_EPS_PREC) {                                             \
+      for (k = 0; k < s->in_states; k++)                                       \
+        value += s->in_a[k] * alpha_last[s->in_id[k]];                         \
+      value *= b_symb;                                                         \
+    }                                                                          \
+    alpha_t[i] = value;                                                        \
+    sum += value;                                                              \
+  }                                                                            \
+                                                                               \
+  /* silent states in topological order */                                     \
+  if (SILENT)                                                                  \
+    for (i = 0; i < mo->topo_order_length; i++) {                              \
+      id = mo->topo_order[i];                                                  \
+      s = mo->s + id;                                                          \
+      value = 0.0;                                                             \
+      for (k = 0; k < s->in_states; k++)                                       \
+        value += s->in_a[k] * alpha_t[s->in_id[k]];                            \
+      alpha_t[id] = value;                                                     \
+      sum += value;                                                            \
+    }                                                                          \
+  return sum;                                                                  \
+}
+
+FOBA_FORWARD_COLUMN (foba_forward_column, 0, 0)
+FOBA_FORWARD_COLUMN (foba_forward_column_silent, 1, 0)
+FOBA_FORWARD_COLUMN (foba_forward_column_higher, 0, 1)
+FOBA_FORWARD_COLUMN (foba_forward_column_silent_higher, 1, 1)
+
+typedef double (*foba_forward_column_t) (ghmm_dmodel *, const int *, int **,
+                                         int, const double *, double *);
+
+static foba_forward_column_t foba_forward_kernel (const ghmm_dmodel * mo)
+{
+  int silent = mo->model_type & GHMM_kSilentStates;
+  if (mo->model_type & GHMM_kHigherOrderEmissions)
+    return silent ? foba_forward_column_silent_higher
+      : foba_forward_column_higher;
+  return silent ? foba_forward_column_silent : foba_forward_column;
+}
+
+/* NAME (mo, O, ctx, t, scale_next, beta_next, beta_t, beta_tmp): scaled
+   beta_t from beta_next; beta_tmp holds the unscaled betas of silent states */
+#define FOBA_BACKWARD_COLUMN(NAME, SILENT, HIGHER)                             \
+static void NAME (ghmm_dmodel * mo, const int *O, int **ctx, int t,            \
+                  double scale_next, const double *beta_next, double *beta_t,  \
+                  double *beta_tmp)                                            \
+{                                                                              \
+  int i, j, k, j_id, id, e_index;                                              \
+  double sum, emission;                                                        \
+  ghmm_dstate *s;                                                              \
+                                                                               \
+  /* silent states in reverse topological order */                             \
+  if (SILENT)                                                                  \
+    for (k = mo->topo_order_length - 1; k >= 0; k--) {                        \
+      id = mo->topo_order[k];                                                  \
+      s = mo->s + id;                                                          \
+      sum = 0.0;                                                               \
+      for (j = 0; j < s->out_states; j++) {                                    \
+        j_id = s->out_id[j];                                                   \
+        if (!mo->silent[j_id]) {                                               \
+          e_index = HIGHER ? ctx[mo->order[j_id]][t + 1] : O[t + 1];           \
+          if (!HIGHER || e_index != -1)                                        \
+            sum += s->out_a[j] * mo->s[j_id].b[e_index] * beta_next[j_id];     \
+        }                                                                      \
+        else                                                                   \
+          sum += s->out_a[j] * beta_tmp[j_id];                                 \
+      }                                                                        \
+      beta_tmp[id] = sum;                                                      \
+    }                                                                          \
+                                                                               \
+  /* non-silent states */                                                      \
+  for (i = 0; i < mo->N; i++) {                                                \
+    if (SILENT && mo->silent[i])                                               \
+      continue;                                                                \
+    s = mo->s + i;                                                             \
+    sum = 0.0;                                                                 \
+    for (j = 0; j < s->out_states; j++) {                                      \
+      j_id = s->out_id[j];                                                     \
+      if (SILENT && mo->silent[j_id]) {                                        \
+        sum += s->out_a[j] * beta_tmp[j_id];                                   \
+        continue;                                                              \
+      }                                                                        \
+      e_index = HIGHER ? ctx[mo->order[j_id]][t + 1] : O[t + 1];               \
+      emission = !HIGHER || e_index != -1 ? mo->s[j_id].b[e_index] : 0;        \
+      sum += s->out_a[j] * emission * beta_next[j_id];                         \
+    }                                                                          \
+    beta_t[i] = sum / scale_next;                                              \
+  }                                                                            \
+                                                                               \
+  /* scale the silent states and reset beta_tmp */                             \
+  if (SILENT)                                                                  \
+    for (i = 0; i < mo->N; i++)                                                \
+      if (mo->silent[i]) {                                                     \
+        beta_t[i] = beta_tmp[i] / scale_next;                                  \
+        beta_tmp[i] = 0.0;                                                     \
+      }                                                                        \
+}
+
+FOBA_BACKWARD_COLUMN (foba_backward_column, 0, 0)
+FOBA_BACKWARD_COLUMN (foba_backward_column_silent, 1, 0)
+FOBA_BACKWARD_COLUMN (foba_backward_column_higher, 0, 1)
+FOBA_BACKWARD_COLUMN (foba_backward_column_silent_higher, 1, 1)
+
+typedef void (*foba_backward_column_t) (ghmm_dmodel *, const int *, int **,
+                                        int, double, const double *, double *,
+                                        double *);
+
+static foba_backward_column_t foba_backward_kernel (const ghmm_dmodel * mo)
+{
+  int silent = mo->model_type & GHMM_kSilentStates;
+  if (mo->model_type & GHMM_kHigherOrderEmissions)
+    return silent ? foba_backward_column_silent_higher
+      : foba_backward_column_higher;
+  return silent ? foba_backward_column_silent : foba_backward_column;
+}
+
 int ghmm_dmodel_forward_init (ghmm_dmodel * mo, double *alpha_1, int symb, double *scale)
 {
 # define CUR_PROC "ghmm_dmodel_forward_init"
@@ -138,17 +287,26 @@ int ghmm_dmodel_forward (ghmm_dmodel * mo, const int *O, int len, double **alpha
 # define CUR_PROC "ghmm_dmodel_forward"
   char * str;
   int res = -1;
-  int i, t, id;
-  int e_index;
+  int i, t;
   double c_t;
   double log_scale_sum = 0.0;
   double non_silent_salpha_sum = 0.0;
   double salpha_log = 0.0;
+  foba_forward_column_t forward_column = foba_forward_kernel (mo);
+  int **ctx = NULL;
 
 
   if (mo->model_type & GHMM_kSilentStates)
     ghmm_dmodel_order_topological(mo);
 
+  if (mo->model_type & GHMM_kHigherOrderEmissions) {
+    ctx = ghmm_dmodel_emission_context_alloc (mo, O, len);
+    if (!ctx) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      return -1;
+    }
+  }
+
   ghmm_dmodel_forward_init (mo, alpha[0], O[0], scale);
 
   if (scale[0] < GHMM_EPS_PREC) {
@@ -160,38 +318,8 @@ int ghmm_dmodel_forward (ghmm_dmodel * mo, const int *O, int len, double **alpha
     *log_p = -log (1 / scale[0]);
     for (t = 1; t < len; t++) {
 
-      scale[t] = 0.0;
-      update_emission_history (mo, O[t - 1]);
-
-      /* printf("\n\nStep t=%i mit len=%i, O[i]=%i\n",t,len,O[t]);
-         printf("iterate over non-silent state\n"); */
-      /* iterate over non-silent states */
-      for (i = 0; i < mo->N; i++) {
-        if (!(mo->model_type & GHMM_kSilentStates) || !(mo->silent[i])) {
-          e_index = get_emission_index (mo, i, O[t], t);
-          if (e_index != -1) {
-            alpha[t][i] =
-              ghmm_dmodel_forward_step (&mo->s[i], alpha[t - 1], mo->s[i].b[e_index]);
-            scale[t] += alpha[t][i];
-          }
-          else {
-            alpha[t][i] = 0;
-          }
-        }
-      }
-      /* iterate over silent states */
-      /* printf("iterate over silent state\n"); */
-      if (mo->model_type & GHMM_kSilentStates) {
-        for (i = 0; i < mo->topo_order_length; i++) {
-          /*printf("\nget id\n");*/
-          id = mo->topo_order[i];
-          /*printf("  akt_ state %d\n",id);*/
-          /*printf("\nin stepforward\n");*/
-          alpha[t][id] = ghmm_dmodel_forward_step (&mo->s[id], alpha[t], 1);
-          /*printf("\nnach stepforward\n");*/
-          scale[t] += alpha[t][id];
-        }
-      }
+      /* non-silent states, then silent states in topological order */
+      scale[t] = forward_column (mo, O, ctx, t, alpha[t - 1], alpha[t]);
 
       if (scale[t] < GHMM_EPS_PREC) {
         /* O-string  can't be generated by hmm */
@@ -238,6 +366,7 @@ int ghmm_dmodel_forward (ghmm_dmodel * mo, const int *O, int len, double **alpha
     res = 0;
   }
 
+  ghmm_dmodel_emission_context_free (&ctx, mo);
   return res;
 # undef CUR_PROC
 }                               /* ghmm_dmodel_forward */
@@ -276,10 +405,10 @@ int ghmm_dmodel_backward (ghmm_dmodel * mo, const int *O, int len, double **beta
 # define CUR_PROC "ghmm_dmodel_backward"
   /* beta_tmp holds beta-variables for silent states */
   double *beta_tmp=NULL;
-  double sum, emission;
-  int i, j, j_id, t, k, id;
+  int i, t;
   int res = -1;
-  int e_index;
+  foba_backward_column_t backward_column = foba_backward_kernel (mo);
+  int **ctx = NULL;
 
 
   for (t = 0; t < len; t++)
@@ -300,9 +429,12 @@ int ghmm_dmodel_backward (ghmm_dmodel * mo, const int *O, int len, double **beta
   if (!(mo->model_type & GHMM_kHigherOrderEmissions)) {
     mo->maxorder = 0;
   }
-  /* initialize emission history */
-  for (t = len - (mo->maxorder); t < len; t++) {
-    update_emission_history (mo, O[t]);
+  else {
+    ctx = ghmm_dmodel_emission_context_alloc (mo, O, len);
+    if (!ctx) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
   }
   
   /* Backward Step for t = T-1, ..., 0 */
@@ -310,85 +442,14 @@ int ghmm_dmodel_backward (ghmm_dmodel * mo, const int *O, int len, double **beta
   for (t = len - 2; t >= 0; t--) {
     /* printf(" ----------- *** t = %d ***  ---------- \n",t); */
     /* printf("\n*** O(%d) = %d\n",t+1,O[t+1]); */
-
-    /* updating of emission_history with O[t] such that emission_history memorizes
-       O[t - maxorder ... t] */
-    if (0 <= t - mo->maxorder + 1)
-      update_emission_history_front (mo, O[t - mo->maxorder + 1]);
-
-    /* iterating over the the silent states and filling beta_tmp */
-    if (mo->model_type & GHMM_kSilentStates) {
-      for (k = mo->topo_order_length - 1; k >= 0; k--) {
-        id = mo->topo_order[k];
-        /* printf("  silent[%d] = %d\n",id,mo->silent[id]); */
-        assert (mo->silent[id] == 1);
-
-        sum = 0.0;
-        for (j = 0; j < mo->s[id].out_states; j++) {
-          j_id = mo->s[id].out_id[j];
-
-	  /* out_state is not silent */
-	  if (!mo->silent[j_id]) {
-	    e_index = get_emission_index (mo, j_id, O[t + 1], t + 1);
-	    if (e_index != -1) {
-	      sum += mo->s[id].out_a[j] * mo->s[j_id].b[e_index] * beta[t+1][j_id];
-	    }
-	  }
-	  /* out_state is silent, beta_tmp[j_id] is useful since we go through
-	     the silent states in reversed topological order */
-	  else {
-	    sum += mo->s[id].out_a[j] * beta_tmp[j_id];
-	  }
-	}
-	/* setting beta_tmp for the silent state
-	   don't scale the betas for silent states now 
-	   wait until the betas for non-silent states are complete to avoid
-	   multiple scaling with the same scalingfactor in one term */
-        beta_tmp[id] = sum;
-      }
-    }
-
-    /* iterating over the the non-silent states */
-    for (i = 0; i < mo->N; i++) {
-      if (!(mo->model_type & GHMM_kSilentStates) || !(mo->silent[i])) {
-        sum = 0.0;
-	
-        for (j = 0; j < mo->s[i].out_states; j++) {
-	  j_id = mo->s[i].out_id[j];
-        
-	  /* out_state is not silent: get the emission probability
-	     and use beta[t+1]*/
-	  if (!(mo->model_type & GHMM_kSilentStates) || !(mo->silent[j_id])) {
-            e_index = get_emission_index (mo, j_id, O[t + 1], t + 1);
-            if (e_index != -1)
-              emission = mo->s[j_id].b[e_index];
-            else
-              emission = 0;
-	    sum += mo->s[i].out_a[j] * emission * beta[t+1][j_id];
-          }
-	  /* out_state is silent: use beta_tmp */
-          else {
-            sum += mo->s[i].out_a[j] * beta_tmp[j_id];
-          }
-        }
-	/* updating beta[t] for non-silent state */
-        beta[t][i] = sum / scale[t+1];
-      }
-    }
-    /* updating beta[t] for silent states, finally scale them
-       and resetting beta_tmp */
-    if (mo->model_type & GHMM_kSilentStates)
-      for (i=0; i<mo->N; i++) {
-	if (mo->silent[i]) {
-	  beta[t][i] = beta_tmp[i] / scale[t+1];
-	  beta_tmp[i] = 0.0;
-	}
-      }
+    backward_column (mo, O, ctx, t, scale[t + 1], beta[t + 1], beta[t],
+                     beta_tmp);
   }
 
   res = 0;
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   if (mo->model_type & GHMM_kSilentStates) m_free (beta_tmp);
+  ghmm_dmodel_emission_context_free (&ctx, mo);
   return (res);
 # undef CUR_PROC
 }                               /* ghmm_dmodel_backward */
@@ -550,7 +611,7 @@ int ghmm_dmodel_forward_lean (ghmm_dmodel * mo, const int *O, int len, double *l
 {
 # define CUR_PROC "ghmm_dmodel_forward_lean"
   int res = -1;
-  int i, t, id, e_index;
+  int i, t;
   double c_t;
   double log_scale_sum = 0.0;
   double non_silent_salpha_sum = 0.0;
@@ -560,11 +621,20 @@ int ghmm_dmodel_forward_lean (ghmm_dmodel * mo, const int *O, int len, double *l
   double *alpha_curr_col=NULL;
   double *switching_tmp;
   double *scale=NULL;
+  foba_forward_column_t forward_column = foba_forward_kernel (mo);
+  int **ctx = NULL;
 
   /* Allocating */
   ARRAY_CALLOC (alpha_last_col, mo->N);
   ARRAY_CALLOC (alpha_curr_col, mo->N);
   ARRAY_CALLOC (scale, len);
+  if (mo->model_type & GHMM_kHigherOrderEmissions) {
+    ctx = ghmm_dmodel_emission_context_alloc (mo, O, len);
+    if (!ctx) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
+  }
 
   if (mo->model_type & GHMM_kSilentStates)
     ghmm_dmodel_order_topological(mo);
@@ -578,30 +648,8 @@ int ghmm_dmodel_forward_lean (ghmm_dmodel * mo, const int *O, int len, double *l
     *log_p = -log (1 / scale[0]);
 
     for (t = 1; t < len; t++) {
-      scale[t] = 0.0;
-      update_emission_history (mo, O[t - 1]);
-
-      /* iterate over non-silent states */
-      for (i = 0; i < mo->N; i++) {
-        if (!(mo->model_type & GHMM_kSilentStates) || !(mo->silent[i])) {
-          e_index = get_emission_index (mo, i, O[t], t);
-          if (e_index != -1) {
-            alpha_curr_col[i] = ghmm_dmodel_forward_step (&mo->s[i], alpha_last_col,
-                                                  mo->s[i].b[e_index]);
-            scale[t] += alpha_curr_col[i];
-          }
-          else
-            alpha_curr_col[i] = 0;
-        }
-      }
-      /* iterate over silent states  */
-      if (mo->model_type & GHMM_kSilentStates) {
-        for (i = 0; i < mo->topo_order_length; i++) {
-          id = mo->topo_order[i];
-          alpha_curr_col[id] = ghmm_dmodel_forward_step (&mo->s[id], alpha_curr_col, 1);
-          scale[t] += alpha_curr_col[id];
-        }
-      }
+      /* non-silent states, then silent states in topological order */
+      scale[t] = forward_column (mo, O, ctx, t, alpha_last_col, alpha_curr_col);
 
       if (scale[t] < GHMM_EPS_PREC) {
         GHMM_LOG(LCONVERTED, "scale smaller than epsilon\n");
@@ -654,6 +702,7 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   m_free (alpha_last_col);
   m_free (alpha_curr_col);
   m_free (scale);
+  ghmm_dmodel_emission_context_free (&ctx, mo);
   return res;
 #undef CUR_PROC
 }                               /* ghmm_dmodel_forward_lean */
@@ -711,6 +760,15 @@ int ghmm_dmodel_label_forward (ghmm_dmodel * mo, const int *O, const int *label,
   int e_index;
   double c_t;
   char *str;
+  int **ctx = NULL;
+
+  if (mo->model_type & GHMM_kHigherOrderEmissions) {
+    ctx = ghmm_dmodel_emission_context_alloc (mo, O, len);
+    if (!ctx) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      return -1;
+    }
+  }
 
   foba_label_initforward (mo, alpha[0], O[0], label[0], scale);
   if (scale[0] < GHMM_EPS_PREC) {
@@ -722,7 +780,6 @@ int ghmm_dmodel_label_forward (ghmm_dmodel * mo, const int *O, const int *label,
 
     for (t = 1; t < len; t++) {
 
-      update_emission_history (mo, O[t - 1]);
       scale[t] = 0.0;
 
       /* printf("\n\nStep t=%i mit len=%i, O[i]=%i\n",t,len,O[t]); */
@@ -732,7 +789,7 @@ int ghmm_dmodel_label_forward (ghmm_dmodel * mo, const int *O, const int *label,
           if (mo->label[i] == label[t]) {
 	    /*printf("%d: akt_ state %d, label: %d \t current Label: %d\n",
 	      t, i, mo->label[i], label[t]);*/
-            e_index = get_emission_index (mo, i, O[t], t);
+            e_index = ghmm_emission_context_index (mo, ctx, i, O[t], t);
             if (-1 != e_index) {
               alpha[t][i] = ghmm_dmodel_forward_step(&mo->s[i], alpha[t-1], mo->s[i].b[e_index]);
               /*if (alpha[t][i] < GHMM_EPS_PREC) {
@@ -796,6 +853,7 @@ int ghmm_dmodel_label_forward (ghmm_dmodel * mo, const int *O, const int *label,
     res = 0;
   }
 
+  ghmm_dmodel_emission_context_free (&ctx, mo);
   return res;
 # undef CUR_PROC
 }                               /* ghmm_dmodel_forward */
@@ -842,6 +900,7 @@ int ghmm_dmodel_label_backward (ghmm_dmodel * mo, const int *O, const int *label
   int e_index;
   /* int beta_out=0; */
   double emission;
+  int **ctx = NULL;
 
   ARRAY_CALLOC (beta_tmp, mo->N);
   for (t = 0; t < len; t++)
@@ -864,11 +923,15 @@ int ghmm_dmodel_label_backward (ghmm_dmodel * mo, const int *O, const int *label
     beta_tmp[i] = beta[len - 1][i] / scale[len - 1];
   }
 
-  /* initialize emission history */
+  /* precompute the emission indices */
   if (!(mo->model_type & GHMM_kHigherOrderEmissions))
     mo->maxorder = 0;
-  for (t = len - (mo->maxorder); t < len; t++) {
-    update_emission_history (mo, O[t]);
+  else {
+    ctx = ghmm_dmodel_emission_context_alloc (mo, O, len);
+    if (!ctx) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
   }
 
   /* Backward Step for t = T-1, ..., 0
@@ -876,18 +939,14 @@ int ghmm_dmodel_label_backward (ghmm_dmodel * mo, const int *O, const int *label
      loop over reverse topological ordering of silent states, non-silent states */
   for (t = len - 2; t >= 0; t--) {
 
-    /* updating of emission_history with O[t] such that emission_history
-       memorizes O[t - maxorder ... t] */
-    if (0 <= t - mo->maxorder + 1)
-      update_emission_history_front (mo, O[t - mo->maxorder + 1]);
-
     for (i = 0; i < mo->N; i++) {
       sum = 0.0;
       for (j = 0; j < mo->s[i].out_states; j++) {
         j_id = mo->s[i].out_id[j];
         /* The state has only a emission with probability > 0, if the label matches */
         if (label[t] == mo->label[i]) {
-          e_index = get_emission_index (mo, j_id, O[t + 1], t + 1);
+          e_index = ghmm_emission_context_index (mo, ctx, j_id, O[t + 1],
+                                                 t + 1);
           if (e_index != -1)
             emission = mo->s[j_id].b[e_index];
           else
@@ -911,6 +970,7 @@ int ghmm_dmodel_label_backward (ghmm_dmodel * mo, const int *O, const int *label
   res = 0;
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   m_free (beta_tmp);
+  ghmm_dmodel_emission_context_free (&ctx, mo);
   return (res);
 # undef CUR_PROC
 }
@@ -1032,3 +1092,181 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   return res;
 #undef CUR_PROC
 }                               /* foba_forward_label_lean */
+
+
+/*============================================================================*/
+/* posterior of all states, post holds the forward variables first */
+static int foba_posterior_matrix (ghmm_dmodel * mo, const int *O, int len,
+                                  double **post, double *log_p)
+{
+#define CUR_PROC "foba_posterior_matrix"
+  int res = -1;
+  int i, j, k, id, t;
+  double **beta = NULL, *scale = NULL, norm;
+  int silent = mo->model_type & GHMM_kSilentStates;
+
+  ARRAY_CALLOC (scale, len);
+  beta = ighmm_cmatrix_stat_alloc (len, mo->N);
+  if (!beta) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (ghmm_dmodel_forward (mo, O, len, post, scale, log_p) == -1) {
+    GHMM_LOG(LERROR, "sequence can't be generated by the model");
+    goto STOP;
+  }
+  if (ghmm_dmodel_backward (mo, O, len, beta, scale) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+
+  /* the forward variables of silent states at t = 0 include the paths
+     starting in them before the first emission, keep only the paths that
+     reach them after the first emission (topological order is set) */
+  if (silent) {
+    for (k = 0; k < mo->topo_order_length; k++) {
+      id = mo->topo_order[k];
+      post[0][id] = 0.0;
+      for (j = 0; j < mo->s[id].in_states; j++)
+        post[0][id] += mo->s[id].in_a[j] * post[0][mo->s[id].in_id[j]];
+    }
+  }
+
+  /* every path passes exactly one emitting state at time t, silent states
+     are normalised by the same sum */
+  for (t = 0; t < len; t++) {
+    norm = 0.0;
+    for (i = 0; i < mo->N; i++) {
+      post[t][i] *= beta[t][i];
+      if (!silent || !mo->silent[i])
+        norm += post[t][i];
+    }
+    if (norm <= 0.0) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "posterior undefined at position %d", t);
+      goto STOP;
+    }
+    for (i = 0; i < mo->N; i++)
+      post[t][i] /= norm;
+  }
+  /* paths end in emitting states */
+  if (silent)
+    for (i = 0; i < mo->N; i++)
+      if (mo->silent[i])
+        post[len - 1][i] = 0.0;
+
+  res = 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (res)
+    *log_p = +1;
+  ighmm_cmatrix_stat_free (&beta);
+  m_free (scale);
+  return res;
+#undef CUR_PROC
+}                               /* foba_posterior_matrix */
+
+/*============================================================================*/
+int ghmm_dmodel_posterior (ghmm_dmodel * mo, const int *O, int len,
+                           double **post, double *log_p)
+{
+#define CUR_PROC "ghmm_dmodel_posterior"
+  if (len < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return -1;
+  }
+  return foba_posterior_matrix (mo, O, len, post, log_p);
+#undef CUR_PROC
+}                               /* ghmm_dmodel_posterior */
+
+/*============================================================================*/
+int ghmm_dmodel_posterior_sparse (ghmm_dmodel * mo, const int *O, int len,
+                                  double threshold, int *row_start, int *state,
+                                  double *prob, int max_entries, double *log_p)
+{
+#define CUR_PROC "ghmm_dmodel_posterior_sparse"
+  int res = -1;
+  double **post = NULL;
+
+  if (len < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return -1;
+  }
+  post = ighmm_cmatrix_stat_alloc (len, mo->N);
+  if (!post) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (foba_posterior_matrix (mo, O, len, post, log_p))
+    goto STOP;
+  res = ighmm_posterior_sparse (post, len, mo->N, threshold, row_start, state,
+                                prob, max_entries);
+STOP:
+  ighmm_cmatrix_stat_free (&post);
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_dmodel_posterior_sparse */
+
+/*============================================================================*/
+int ghmm_dmodel_posterior_decoding (ghmm_dmodel * mo, const int *O, int len,
+                                    int *path, double *log_p)
+{
+#define CUR_PROC "ghmm_dmodel_posterior_decoding"
+  int res = -1;
+  double **post = NULL;
+
+  if (len < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return -1;
+  }
+  post = ighmm_cmatrix_stat_alloc (len, mo->N);
+  if (!post) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (foba_posterior_matrix (mo, O, len, post, log_p))
+    goto STOP;
+  ighmm_posterior_decoding (post, len, mo->N,
+                            (mo->model_type & GHMM_kSilentStates) ? mo->silent
+                            : NULL, path);
+  res = 0;
+STOP:
+  ighmm_cmatrix_stat_free (&post);
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_dmodel_posterior_decoding */
+
+/*============================================================================*/
+int ighmm_posterior_sparse (double **post, int len, int N, double threshold,
+                            int *row_start, int *state, double *prob,
+                            int max_entries)
+{
+  int i, t, n = 0;
+
+  for (t = 0; t < len; t++) {
+    row_start[t] = n;
+    for (i = 0; i < N; i++)
+      if (post[t][i] > threshold) {
+        if (n < max_entries) {
+          state[n] = i;
+          prob[n] = post[t][i];
+        }
+        n++;
+      }
+  }
+  row_start[len] = n;
+  return n;
+}                               /* ighmm_posterior_sparse */
+
+/*============================================================================*/
+void ighmm_posterior_decoding (double **post, int len, int N, const int *silent,
+                               int *path)
+{
+  int i, t;
+
+  for (t = 0; t < len; t++) {
+    path[t] = -1;
+    for (i = 0; i < N; i++)
+      if ((!silent || !silent[i])
+          && (path[t] == -1 || post[t][i] > post[t][path[t]]))
+        path[t] = i;
+  }
+}                               /* ighmm_posterior_decoding */
@@ -142,6 +142,56 @@ extern "C" {
   int ghmm_dmodel_forward_lean (ghmm_dmodel * mo, const int *O, int len, double *log_p);
 
 
+/**
+  Posterior probabilities of the states. post[t][i] is the probability
+  that state i emits O[t]; for a silent state it is the probability that
+  the state is passed between O[t] and O[t + 1] (silent states passed
+  before O[0] are not counted).
+  @param mo       model
+  @param O        sequence
+  @param len      length of sequence
+  @param post     caller allocated len x N matrix for the posteriors
+  @param log_p    log likelihood log( P(O|lambda) )
+  @return 0 for success, -1 for error
+  */
+  int ghmm_dmodel_posterior (ghmm_dmodel * mo, const int *O, int len,
+                             double **post, double *log_p);
+
+/**
+  Posterior probabilities above a threshold in compressed row format: the
+  entries of position t are state[k], prob[k] for
+  row_start[t] <= k < row_start[t + 1].
+  @param mo           model
+  @param O            sequence
+  @param len          length of sequence
+  @param threshold    only posteriors larger than threshold are returned
+  @param row_start    caller allocated array of len + 1 entries
+  @param state        caller allocated array of max_entries states
+  @param prob         caller allocated array of max_entries posteriors
+  @param max_entries  size of state and prob
+  @param log_p        log likelihood log( P(O|lambda) )
+  @return number of entries (only the first max_entries are written if it
+  is larger), -1 for error
+  */
+  int ghmm_dmodel_posterior_sparse (ghmm_dmodel * mo, const int *O, int len,
+                                    double threshold, int *row_start,
+                                    int *state, double *prob, int max_entries,
+                                    double *log_p);
+
+/**
+  Posterior decoding: path[t] is the emitting state with the largest
+  posterior probability for O[t].
+  @param mo       model
+  @param O        sequence
+  @param len      length of sequence
+  @param path     caller allocated array of len states
+  @param log_p    log likelihood log( P(O|lambda) )
+  @return 0 for success, -1 for error
+  */
+  int ghmm_dmodel_posterior_decoding (ghmm_dmodel * mo, const int *O, int len,
+                                      int *path, double *log_p);
+
+
 /* Labeled HMMs */
 
   int ghmm_dmodel_label_forward (ghmm_dmodel * mo, const int *O, const int *label, int len,
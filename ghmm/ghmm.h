@@ -122,6 +122,10 @@ extern "C" {
 
 #define GHMM_kMultivariate (1 << 11)
 
+/** Model has an index for constant time transition lookups
+    (see ghmm_dmodel_transition_index_build) */
+#define GHMM_kTransitionIndex (1 << 12)
+
 
 /*@} (Doc++-Group: GHMM-Globals) */
 
@@ -177,7 +181,15 @@ extern "C" {
 
 
 /*@{ (Doc++-Group: Logging) */
-void ghmm_set_logfunc(void (* fptr)(int, const char *, void *), void * clientdata);
+/**
+   Sets an external logging function, NULL restores logging to stderr. The
+   function is called from the thread that logs, possibly from several
+   threads at once, and has to be reentrant. The message is only valid
+   during the call. Replaced functions may still be running in other
+   threads, so only 16 functions can be registered in total.
+   @return 0 on success, -1 if 16 functions were registered already
+*/
+int ghmm_set_logfunc(void (* fptr)(int, const char *, void *), void * clientdata);
 
 void ghmm_set_loglevel(int level);
 /*@} (Doc++-Group: Logging) */
@@ -48,72 +48,105 @@
 #include "mprintf.h"
 
 
-static char * qmessage;
+/* queued message of the current thread */
+static GHMM_THREAD_LOCAL char * qmessage;
+
+/* every message is formatted into a ring of buffers of the current thread,
+   so logging neither allocates nor shares state between threads; the ring
+   allows an external logging function to log itself */
+#define LOG_LEN  1024
+#define LOG_RING 4
+static GHMM_THREAD_LOCAL char log_ring[LOG_RING][LOG_LEN];
+static GHMM_THREAD_LOCAL unsigned int log_pos;
+
+/* loads and stores of the settings below are atomic, they may change while
+   other threads log */
+#if defined(__GNUC__)
+#  define LOG_LOAD(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#  define LOG_STORE(x, v)  __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#  define LOG_NEXT(x)      __atomic_add_fetch(&(x), 1, __ATOMIC_RELAXED)
+#else
+#  define LOG_LOAD(x)      (x)
+#  define LOG_STORE(x, v)  ((x) = (v))
+#  define LOG_NEXT(x)      (++(x))
+#endif
 
 static int maxlevel = 3;
 
-static void (*logfunc)(int level, const char *message, void *clientdata);
-
-static void *logfunc_data;
-
-static void process_external_log(int level, const char *proc, const char *error_str) {
+/* external logging function and its client data; a new registration goes
+   to the next slot and is published with one pointer store, so a thread
+   never calls a function with the client data of another registration.
+   A thread may still call a replaced handler, so slots are never reused
+   and at most LOG_HANDLERS functions can be registered */
+typedef struct {
+  void (*func)(int level, const char *message, void *clientdata);
+  void *data;
+} log_handler;
+
+#define LOG_HANDLERS 16
+static log_handler handlers[LOG_HANDLERS];
+static unsigned int handler_count;
+static log_handler *handler;
+
+static const char *log_prefix(int level) {
+  switch (level) {
+  case LDEBUG:
+    return "DEBUG: ";
+  case LINFO:
+    return "INFO: ";
+  case LWARN:
+    return "WARNING: ";
+  case LERROR:
+    return "ERROR: ";
+  case LCRITIC:
+    return "CRITICAL: ";
+  default:
+    return "";
+  }
+}
 
-  char *message;
+/* formats prefix, proc and message into the next buffer of the thread */
+static const char *log_format(const char *prefix, const char *proc,
+                              const char *format, va_list args) {
+  char *line = log_ring[log_pos++ % LOG_RING];
+  int len;
+
+  len = snprintf(line, LOG_LEN, "%s%s", prefix, proc);
+  if (len < 0)
+    len = 0;
+  if (len < LOG_LEN - 1)
+    vsnprintf(line + len, LOG_LEN - len, format, args);
+  return line;
+}
 
-  int proc_len = strlen(proc);
-  int slen = strlen(error_str);
-  message = malloc(sizeof(char) * (proc_len+slen+1));
-  if (message)
-  {
-      message = strncpy(message, proc, proc_len+1);
-      message = strncat(message, error_str, slen);
-      logfunc(level, message, logfunc_data);
-      free(message);
-  }
+static void log_write(int level, const log_handler *h, const char *line) {
+  /* if defined use external logging function */
+  if (h)
+    h->func(level, line, h->data);
+  /* otherwise simple logging to stderr, one line at once so that lines of
+     different threads do not interleave */
   else {
-      logfunc(level, proc, logfunc_data);
-      logfunc(level, error_str, logfunc_data);
+    fputs(line, stderr);
+    fputc('\n', stderr);
   }
 }
 
-static void ighmm_log_out(int level, const char *proc, char *message) {
+static void ighmm_log_out(int level, const char *proc, const char *message) {
+  const log_handler *h = LOG_LOAD(handler);
+  char *line;
 
-  /* if defined use external logging function */
-  if (logfunc) {
-    process_external_log(level, proc, message);
+  if (h || level < LOG_LOAD(maxlevel)) {
+    line = log_ring[log_pos++ % LOG_RING];
+    snprintf(line, LOG_LEN, "%s%s%s", h ? "" : log_prefix(level), proc,
+             message);
+    log_write(level, h, line);
   }
-  /* otherwise simple logging to stderr */
-  else 
-    if (level < maxlevel) {
-      switch (level) {
-      case LDEBUG:
-	fputs("DEBUG: ", stderr);
-	break;
-      case LINFO:
-	fputs("INFO: ", stderr);
-	break;
-      case LWARN:
-	fputs("WARNING: ", stderr);
-	break;
-      case LERROR:
-	fputs("ERROR: ", stderr);
-	break;
-      case LCRITIC:
-	fputs("CRITICAL: ", stderr);
-	break;
-      default:
-	break;
-      }
-      fputs(proc, stderr);
-      fputs(message, stderr);
-      fputc('\n', stderr);
-    }
 }
 
 
-void GHMM_LOG_PRINTF(int level, const char* proc, const char* error_str, ...) {
+void (GHMM_LOG_PRINTF)(int level, const char* proc, const char* error_str, ...) {
   va_list args;
-  char* message = NULL;
+  const log_handler *h;
 
   /* process queued message if any */
   if (qmessage) {
@@ -122,16 +155,14 @@ void GHMM_LOG_PRINTF(int level, const char* proc, const char* error_str, ...) {
     qmessage = NULL;
   }
   if (error_str) {
-    message = malloc(256);
-    if (message) {
-        va_start(args, error_str);
-        vsnprintf(message, 256, error_str, args);
-        va_end(args);
-        ighmm_log_out(level, proc, message);
-        free(message);
-    }
-    else
-        ighmm_log_out(level, proc, "Could allocate memory in GHMM_LOG_PRINTF()");
+    h = LOG_LOAD(handler);
+    /* disabled levels return before formatting */
+    if (!h && level >= LOG_LOAD(maxlevel))
+      return;
+    va_start(args, error_str);
+    log_write(level, h, log_format(h ? "" : log_prefix(level), proc,
+                                   error_str, args));
+    va_end(args);
   }
 }
 
@@ -147,15 +178,30 @@ void ighmm_queue_mes(char *text) {
 #undef CUR_PROC
 }
 
-void ghmm_set_logfunc(void (* fptr)(int, const char *, void *), void * clientdata) {
-
-  logfunc = fptr;
-  logfunc_data = clientdata;
-
+int ghmm_set_logfunc(void (* fptr)(int, const char *, void *), void * clientdata) {
+#define CUR_PROC "ghmm_set_logfunc"
+  log_handler *h = NULL;
+  unsigned int n;
+
+  if (fptr) {
+    /* the count stops growing once it passed the limit */
+    if (LOG_LOAD(handler_count) >= LOG_HANDLERS
+        || (n = LOG_NEXT(handler_count)) > LOG_HANDLERS) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "all %d slots for logging functions are used",
+                      LOG_HANDLERS);
+      return -1;
+    }
+    h = &handlers[n - 1];
+    h->func = fptr;
+    h->data = clientdata;
+  }
+  LOG_STORE(handler, h);
+  return 0;
+#undef CUR_PROC
 }
 
 void ghmm_set_loglevel(int level) {
 
-  maxlevel = level;
+  LOG_STORE(maxlevel, level);
 
 }
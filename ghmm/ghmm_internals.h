@@ -46,24 +46,40 @@ extern "C" {
 
 /*==============  Memory allocation macros for mes-functions  ===============*/
 #ifndef ARRAY_MALLOC
-#define ARRAY_MALLOC(ptr, entries) { if (!((ptr) = ighmm_malloc(sizeof(*(ptr)) * (entries)))) \
-                                         {GHMM_LOG_QUEUED(LERROR); goto STOP;}                \
+#define ARRAY_MALLOC(ptr, entries) { if (!((ptr) = ighmm_malloc(ighmm_array_bytes((entries), sizeof(*(ptr)))))) \
+                                         {GHMM_LOG_QUEUED(LERROR); goto STOP;}                                 \
                                    }
 #endif
 
 #ifndef ARRAY_CALLOC
-#define ARRAY_CALLOC(ptr, entries) { if (!((ptr) = ighmm_calloc(sizeof(*(ptr)) * (entries)))) \
-                                         {GHMM_LOG_QUEUED(LERROR); goto STOP;}                \
+#define ARRAY_CALLOC(ptr, entries) { if (!((ptr) = ighmm_calloc(ighmm_array_bytes((entries), sizeof(*(ptr)))))) \
+                                         {GHMM_LOG_QUEUED(LERROR); goto STOP;}                                 \
                                    }
 #endif
 
 #ifndef ARRAY_REALLOC
-#define ARRAY_REALLOC(ptr, entries) { if (ighmm_realloc((void**)&(ptr), sizeof(*(ptr))*(entries))) \
-                                          {GHMM_LOG_QUEUED(LERROR); goto STOP;}                    \
+#define ARRAY_REALLOC(ptr, entries) { if (ighmm_realloc((void**)&(ptr), ighmm_array_bytes((entries), sizeof(*(ptr))))) \
+                                          {GHMM_LOG_QUEUED(LERROR); goto STOP;}                                     \
                                     }
 #endif
 
 
+/*==============  per thread storage  ======================================*/
+/* storage class of library state that has to be private to each thread, so
+   that distinct models can be used concurrently */
+#ifndef GHMM_THREAD_LOCAL
+#  if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#    define GHMM_THREAD_LOCAL _Thread_local
+#  elif defined(__GNUC__)
+#    define GHMM_THREAD_LOCAL __thread
+#  elif defined(_MSC_VER)
+#    define GHMM_THREAD_LOCAL __declspec(thread)
+#  else
+#    define GHMM_THREAD_LOCAL
+#  endif
+#endif
+
+
 /*==============  declarations for root_finder.c  ===========================*/
 /**
    brent root finding algorithm.
@@ -109,6 +125,24 @@ double ighmm_gtail_pmue_interpol(double mue, double A, double B, double eps);
 double ighmm_cvector_log_sum(double *a, int N);
 
 
+/*==============  posterior decoding  ========================================*/
+/**
+   Extracts the entries of a posterior matrix above threshold in compressed
+   row format, see ghmm_dmodel_posterior_sparse.
+   @return number of entries, only the first max_entries are written
+*/
+int ighmm_posterior_sparse(double **post, int len, int N, double threshold,
+                           int *row_start, int *state, double *prob,
+                           int max_entries);
+
+/**
+   Writes the state with the largest posterior for every position to path,
+   states with silent[i] set are skipped (silent may be NULL).
+*/
+void ighmm_posterior_decoding(double **post, int len, int N, const int *silent,
+                              int *path);
+
+
 /*==============  linked list  ===============================================*/
 /**
    integer element
@@ -198,10 +232,21 @@ int ghmm_dmodel_label_gradient_expectations(ghmm_dmodel *mo, double **alpha, dou
 #define TOSTRING(x)  STRINGIFY(x)
 #define STRINGIFY(x) # x
 
+/* messages of levels above GHMM_LOG_COMPILE_LEVEL are removed at compile
+   time, including the evaluation of their arguments; e.g. LWARN drops the
+   info and debug messages from the inner loops */
+#ifndef GHMM_LOG_COMPILE_LEVEL
+#define GHMM_LOG_COMPILE_LEVEL LDEBUG
+#endif
+
 #define GHMM_LOG(level, estr)       GHMM_LOG_PRINTF(level, LOC, estr)
 #define GHMM_LOG_QUEUED(level)      GHMM_LOG_PRINTF(level, LOC, NULL)
 
+/* formats into a buffer of the calling thread, may be called concurrently */
 void GHMM_LOG_PRINTF(int level, const char* loc, const char* str, ...);
+#define GHMM_LOG_PRINTF(level, loc, ...)                          \
+  do { if ((level) <= GHMM_LOG_COMPILE_LEVEL)                     \
+      (GHMM_LOG_PRINTF)(level, loc, __VA_ARGS__); } while (0)
 
 void ighmm_queue_mes(char * text);
 
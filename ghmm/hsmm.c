@@ -0,0 +1,603 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/hsmm.c
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <float.h>
+#include <math.h>
+
+#include "ghmm.h"
+#include "mes.h"
+#include "matrix.h"
+#include "model.h"
+#include "sequence.h"
+#include "hsmm.h"
+#include "ghmm_internals.h"
+
+/*
+  Scaling: c_t = e_t * g_t, where e_t is the largest emission probability of
+  O[t] and g_t the sum of the probabilities of segments ending at t (or 1 if
+  no segment can end at t). q[t][j] = b_j(O[t]) / c_t, so the emissions of
+  a segment are a product of q factors and the scaled forward and backward
+  variables of different times can be combined directly.
+
+  F[t][j]   segment of state j ends at t, scaled by c_0 ... c_t
+  S[t][j]   segment of state j starts at t, scaled by c_0 ... c_t-1
+  Bk[t][j]  observations after t given a segment of j ended at t,
+            scaled by c_t+1 ... c_T-1
+  Bs[t][j]  observations from t on given a segment of j starts at t,
+            scaled by c_t ... c_T-1
+*/
+
+/*----------------------------------------------------------------------------*/
+static int hsmm_forward (ghmm_dhsmm * h, const int *O, int T, double **F,
+                         double **S, double **q, double *log_p)
+{
+#define CUR_PROC "hsmm_forward"
+  ghmm_dmodel *mo = h->mo;
+  int t, s, u, umax, i, j, e;
+  double max_b, g, w, sum;
+
+  *log_p = 0.0;
+  for (t = 0; t < T; t++) {
+    if (O[t] < 0 || O[t] >= mo->M) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "symbol %d at position %d out of range",
+                      O[t], t);
+      return -1;
+    }
+
+    /* segments starting at t */
+    max_b = 0.0;
+    for (j = 0; j < mo->N; j++) {
+      if (t == 0)
+        S[t][j] = mo->s[j].pi;
+      else {
+        sum = 0.0;
+        for (e = 0; e < mo->s[j].in_states; e++) {
+          i = mo->s[j].in_id[e];
+          if (i != j)
+            sum += F[t - 1][i] * mo->s[j].in_a[e];
+        }
+        S[t][j] = sum;
+      }
+      if (mo->s[j].b[O[t]] > max_b)
+        max_b = mo->s[j].b[O[t]];
+    }
+    if (max_b <= 0.0) {
+      *log_p = +1;
+      return 0;
+    }
+
+    /* segments ending at t, the emissions of a segment grow by one
+       q factor per additional step */
+    umax = t + 1 < h->D ? t + 1 : h->D;
+    g = 0.0;
+    for (j = 0; j < mo->N; j++) {
+      w = mo->s[j].b[O[t]] / max_b;
+      sum = 0.0;
+      for (u = 1; u <= umax && w > 0.0; u++) {
+        s = t - u + 1;
+        sum += S[s][j] * h->d[j][u - 1] * w;
+        if (s > 0)
+          w *= q[s - 1][j];
+      }
+      F[t][j] = sum;
+      g += sum;
+    }
+    if (g <= 0.0) {
+      if (t == T - 1) {
+        *log_p = +1;
+        return 0;
+      }
+      g = 1.0;
+    }
+    for (j = 0; j < mo->N; j++) {
+      F[t][j] /= g;
+      q[t][j] = mo->s[j].b[O[t]] / max_b / g;
+    }
+    *log_p += log (max_b) + log (g);
+  }
+  return 0;
+#undef CUR_PROC
+}                               /* hsmm_forward */
+
+/*----------------------------------------------------------------------------*/
+/* backward algorithm accumulating the expected counts of one sequence
+   weighted by weight; start and end are scratch matrices */
+static void hsmm_expect (ghmm_dhsmm * h, const int *O, int T, double weight,
+                         double **F, double **S, double **q, double **Bk,
+                         double **Bs, double **start, double **end,
+                         double *pi_num, double **a_num, double **b_num,
+                         double **d_num)
+{
+  ghmm_dmodel *mo = h->mo;
+  int t, tau, u, umax, i, j, k, e;
+  double w, sum, term, eta, gamma;
+
+  for (t = 0; t < T; t++)
+    for (j = 0; j < mo->N; j++)
+      start[t][j] = end[t][j] = 0.0;
+
+  for (t = T - 1; t >= 0; t--) {
+    for (j = 0; j < mo->N; j++) {
+      if (t == T - 1)
+        Bk[t][j] = 1.0;
+      else {
+        sum = 0.0;
+        for (e = 0; e < mo->s[j].out_states; e++) {
+          k = mo->s[j].out_id[e];
+          if (k != j)
+            sum += mo->s[j].out_a[e] * Bs[t + 1][k];
+        }
+        Bk[t][j] = sum;
+      }
+    }
+
+    /* segments of j from t to tau = t + u - 1 */
+    umax = T - t < h->D ? T - t : h->D;
+    for (j = 0; j < mo->N; j++) {
+      w = 1.0;
+      sum = 0.0;
+      for (u = 1; u <= umax; u++) {
+        tau = t + u - 1;
+        w *= q[tau][j];
+        if (w <= 0.0)
+          break;
+        term = h->d[j][u - 1] * w * Bk[tau][j];
+        sum += term;
+        eta = S[t][j] * term;
+        if (eta > 0.0) {
+          d_num[j][u - 1] += weight * eta;
+          start[t][j] += eta;
+          end[tau][j] += eta;
+        }
+      }
+      Bs[t][j] = sum;
+    }
+
+    /* transitions between segments ending at t - 1 and starting at t */
+    if (t > 0)
+      for (i = 0; i < mo->N; i++)
+        for (e = 0; e < mo->s[i].out_states; e++) {
+          k = mo->s[i].out_id[e];
+          if (k != i)
+            a_num[i][e] += weight * F[t - 1][i] * mo->s[i].out_a[e] * Bs[t][k];
+        }
+  }
+
+  for (j = 0; j < mo->N; j++) {
+    pi_num[j] += weight * mo->s[j].pi * Bs[0][j];
+    /* state occupancy: segments started minus segments ended before */
+    gamma = 0.0;
+    for (t = 0; t < T; t++) {
+      gamma += start[t][j];
+      if (t > 0)
+        gamma -= end[t - 1][j];
+      if (gamma > 0.0)
+        b_num[j][O[t]] += weight * gamma;
+    }
+  }
+}                               /* hsmm_expect */
+
+/*============================================================================*/
+ghmm_dhsmm *ghmm_dhsmm_from_dmodel (const ghmm_dmodel * mo, int D)
+{
+#define CUR_PROC "ghmm_dhsmm_from_dmodel"
+  ghmm_dhsmm *h = NULL;
+  ghmm_dstate *s;
+  int i, e, u;
+  double self, rest, leave, sum;
+
+  if (D < 1) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "maximal duration %d < 1", D);
+    return NULL;
+  }
+  if (mo->model_type & (GHMM_kSilentStates | GHMM_kHigherOrderEmissions)) {
+    GHMM_LOG(LERROR, "HSMMs do not support silent states or higher order "
+             "emissions");
+    return NULL;
+  }
+
+  ARRAY_CALLOC (h, 1);
+  h->D = D;
+  h->mo = ghmm_dmodel_copy (mo);
+  if (!h->mo) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  h->d = ighmm_cmatrix_alloc (mo->N, D);
+  if (!h->d) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+
+  for (i = 0; i < mo->N; i++) {
+    s = h->mo->s + i;
+    self = rest = 0.0;
+    for (e = 0; e < s->out_states; e++)
+      if (s->out_id[e] == i)
+        self += s->out_a[e];
+      else
+        rest += s->out_a[e];
+
+    if (rest > 0.0) {
+      /* geometric duration truncated at D */
+      leave = rest / (self + rest);
+      sum = 0.0;
+      for (u = 0; u < D; u++) {
+        h->d[i][u] = leave * pow (1.0 - leave, u);
+        sum += h->d[i][u];
+      }
+      for (u = 0; u < D; u++)
+        h->d[i][u] /= sum;
+    }
+    else
+      for (u = 0; u < D; u++)
+        h->d[i][u] = 1.0 / D;
+
+    for (e = 0; e < s->out_states; e++)
+      ghmm_dmodel_set_transition (h->mo, i, s->out_id[e],
+                                  s->out_id[e] == i || rest <= 0.0
+                                  ? 0.0 : s->out_a[e] / rest);
+  }
+  return h;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ghmm_dhsmm_free (&h);
+  return NULL;
+#undef CUR_PROC
+}                               /* ghmm_dhsmm_from_dmodel */
+
+/*============================================================================*/
+int ghmm_dhsmm_free (ghmm_dhsmm ** h)
+{
+#define CUR_PROC "ghmm_dhsmm_free"
+  mes_check_ptr (h, return (-1));
+  if (!*h)
+    return (0);
+  if ((*h)->d)
+    ighmm_cmatrix_free (&(*h)->d, (*h)->mo->N);
+  if ((*h)->mo)
+    ghmm_dmodel_free (&(*h)->mo);
+  m_free (*h);
+  return (0);
+#undef CUR_PROC
+}                               /* ghmm_dhsmm_free */
+
+/*============================================================================*/
+int ghmm_dhsmm_logp (ghmm_dhsmm * h, const int *O, int len, double *log_p)
+{
+#define CUR_PROC "ghmm_dhsmm_logp"
+  double **F = NULL, **S = NULL, **q = NULL;
+  int res = -1;
+
+  if (len < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return -1;
+  }
+  F = ighmm_cmatrix_stat_alloc (len, h->mo->N);
+  S = ighmm_cmatrix_stat_alloc (len, h->mo->N);
+  q = ighmm_cmatrix_stat_alloc (len, h->mo->N);
+  if (!F || !S || !q) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (hsmm_forward (h, O, len, F, S, q, log_p) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  res = 0;
+STOP:
+  ighmm_cmatrix_stat_free (&F);
+  ighmm_cmatrix_stat_free (&S);
+  ighmm_cmatrix_stat_free (&q);
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_dhsmm_logp */
+
+/*============================================================================*/
+int *ghmm_dhsmm_viterbi (ghmm_dhsmm * h, const int *O, int len, double *log_p)
+{
+#define CUR_PROC "ghmm_dhsmm_viterbi"
+  ghmm_dmodel *mo = h->mo;
+  double **delta = NULL, **enter = NULL, **log_b = NULL, **log_d = NULL;
+  int **dur = NULL, **pred = NULL, *path = NULL;
+  int t, s, u, umax, i, j, e, best_u;
+  double v, best, lw;
+
+  *log_p = +1;
+  if (len < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return NULL;
+  }
+  delta = ighmm_cmatrix_stat_alloc (len, mo->N);
+  enter = ighmm_cmatrix_stat_alloc (len, mo->N);
+  log_b = ighmm_cmatrix_stat_alloc (len, mo->N);
+  log_d = ighmm_cmatrix_stat_alloc (mo->N, h->D);
+  dur = ighmm_dmatrix_stat_alloc (len, mo->N);
+  pred = ighmm_dmatrix_stat_alloc (len, mo->N);
+  if (!delta || !enter || !log_b || !log_d || !dur || !pred) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+
+  for (j = 0; j < mo->N; j++)
+    for (u = 0; u < h->D; u++)
+      log_d[j][u] = h->d[j][u] > 0.0 ? log (h->d[j][u]) : -DBL_MAX;
+  for (t = 0; t < len; t++) {
+    if (O[t] < 0 || O[t] >= mo->M) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "symbol %d at position %d out of range",
+                      O[t], t);
+      goto STOP;
+    }
+    for (j = 0; j < mo->N; j++)
+      log_b[t][j] = mo->s[j].b[O[t]] > 0.0 ? log (mo->s[j].b[O[t]]) : -DBL_MAX;
+  }
+
+  for (t = 0; t < len; t++) {
+    /* best entry into j at t */
+    for (j = 0; j < mo->N; j++) {
+      best = -DBL_MAX;
+      pred[t][j] = -1;
+      if (t == 0) {
+        if (mo->s[j].pi > 0.0)
+          best = log (mo->s[j].pi);
+      }
+      else
+        for (e = 0; e < mo->s[j].in_states; e++) {
+          i = mo->s[j].in_id[e];
+          if (i == j || delta[t - 1][i] == -DBL_MAX || mo->s[j].in_a[e] <= 0.0)
+            continue;
+          v = delta[t - 1][i] + log (mo->s[j].in_a[e]);
+          if (v > best) {
+            best = v;
+            pred[t][j] = i;
+          }
+        }
+      enter[t][j] = best;
+    }
+
+    /* best segment of j ending at t */
+    umax = t + 1 < h->D ? t + 1 : h->D;
+    for (j = 0; j < mo->N; j++) {
+      best = -DBL_MAX;
+      best_u = 0;
+      lw = 0.0;
+      for (u = 1; u <= umax; u++) {
+        s = t - u + 1;
+        if (log_b[s][j] == -DBL_MAX)
+          break;
+        lw += log_b[s][j];
+        if (enter[s][j] == -DBL_MAX || log_d[j][u - 1] == -DBL_MAX)
+          continue;
+        v = enter[s][j] + log_d[j][u - 1] + lw;
+        if (v > best) {
+          best = v;
+          best_u = u;
+        }
+      }
+      delta[t][j] = best;
+      dur[t][j] = best_u;
+    }
+  }
+
+  best = -DBL_MAX;
+  j = -1;
+  for (i = 0; i < mo->N; i++)
+    if (delta[len - 1][i] > best) {
+      best = delta[len - 1][i];
+      j = i;
+    }
+  if (j == -1)
+    goto STOP;
+
+  /* traceback over the segments */
+  ARRAY_MALLOC (path, len);
+  t = len - 1;
+  while (t >= 0) {
+    s = t - dur[t][j] + 1;
+    for (u = s; u <= t; u++)
+      path[u] = j;
+    j = pred[s][j];
+    t = s - 1;
+  }
+  *log_p = best;
+
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ighmm_cmatrix_stat_free (&delta);
+  ighmm_cmatrix_stat_free (&enter);
+  ighmm_cmatrix_stat_free (&log_b);
+  ighmm_cmatrix_stat_free (&log_d);
+  ighmm_dmatrix_stat_free (&dur);
+  ighmm_dmatrix_stat_free (&pred);
+  return path;
+#undef CUR_PROC
+}                               /* ghmm_dhsmm_viterbi */
+
+/*============================================================================*/
+int ghmm_dhsmm_baum_welch (ghmm_dhsmm * h, ghmm_dseq * sq, int max_step,
+                           double likelihood_delta)
+{
+#define CUR_PROC "ghmm_dhsmm_baum_welch"
+  ghmm_dmodel *mo = h->mo;
+  double **F = NULL, **S = NULL, **q = NULL, **Bk = NULL, **Bs = NULL;
+  double **start = NULL, **end = NULL;
+  double *pi_num = NULL, **a_num = NULL, **b_num = NULL, **d_num = NULL;
+  double log_p, log_p_old, log_p_k, sum;
+  int i, j, k, e, u, n, T_max, valid, res = -1;
+
+  T_max = 0;
+  for (k = 0; k < sq->seq_number; k++)
+    if (sq->seq_len[k] > T_max)
+      T_max = sq->seq_len[k];
+  if (T_max < 1) {
+    GHMM_LOG(LERROR, "no training sequences");
+    return -1;
+  }
+
+  F = ighmm_cmatrix_stat_alloc (T_max, mo->N);
+  S = ighmm_cmatrix_stat_alloc (T_max, mo->N);
+  q = ighmm_cmatrix_stat_alloc (T_max, mo->N);
+  Bk = ighmm_cmatrix_stat_alloc (T_max, mo->N);
+  Bs = ighmm_cmatrix_stat_alloc (T_max, mo->N);
+  start = ighmm_cmatrix_stat_alloc (T_max, mo->N);
+  end = ighmm_cmatrix_stat_alloc (T_max, mo->N);
+  b_num = ighmm_cmatrix_stat_alloc (mo->N, mo->M);
+  d_num = ighmm_cmatrix_stat_alloc (mo->N, h->D);
+  if (!F || !S || !q || !Bk || !Bs || !start || !end || !b_num || !d_num) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  ARRAY_CALLOC (pi_num, mo->N);
+  ARRAY_CALLOC (a_num, mo->N);
+  for (i = 0; i < mo->N; i++)
+    ARRAY_CALLOC (a_num[i], mo->s[i].out_states + 1);
+
+  log_p_old = -DBL_MAX;
+  for (n = 1; n <= max_step; n++) {
+    for (i = 0; i < mo->N; i++) {
+      pi_num[i] = 0.0;
+      for (e = 0; e < mo->s[i].out_states; e++)
+        a_num[i][e] = 0.0;
+      for (k = 0; k < mo->M; k++)
+        b_num[i][k] = 0.0;
+      for (u = 0; u < h->D; u++)
+        d_num[i][u] = 0.0;
+    }
+
+    /* E-step */
+    log_p = 0.0;
+    valid = 0;
+    for (k = 0; k < sq->seq_number; k++) {
+      if (sq->seq_len[k] < 1)
+        continue;
+      if (hsmm_forward (h, sq->seq[k], sq->seq_len[k], F, S, q, &log_p_k)
+          == -1) {
+        GHMM_LOG_QUEUED(LCONVERTED);
+        goto STOP;
+      }
+      if (log_p_k == +1)
+        continue;
+      log_p += log_p_k;
+      valid = 1;
+      hsmm_expect (h, sq->seq[k], sq->seq_len[k], sq->seq_w[k], F, S, q, Bk,
+                   Bs, start, end, pi_num, a_num, b_num, d_num);
+    }
+    if (!valid) {
+      GHMM_LOG(LERROR, "Reestimate stopped: No sequence can be built "
+               "from the HSMM!");
+      goto STOP;
+    }
+
+    /* M-step */
+    sum = 0.0;
+    for (i = 0; i < mo->N; i++)
+      sum += pi_num[i];
+    for (i = 0; i < mo->N && sum > 0.0; i++)
+      mo->s[i].pi = pi_num[i] / sum;
+
+    for (i = 0; i < mo->N; i++) {
+      sum = 0.0;
+      for (e = 0; e < mo->s[i].out_states; e++)
+        sum += a_num[i][e];
+      if (sum > 0.0)
+        for (e = 0; e < mo->s[i].out_states; e++)
+          ghmm_dmodel_set_transition (mo, i, mo->s[i].out_id[e],
+                                      a_num[i][e] / sum);
+
+      sum = 0.0;
+      for (u = 0; u < h->D; u++)
+        sum += d_num[i][u];
+      if (sum > 0.0)
+        for (u = 0; u < h->D; u++)
+          h->d[i][u] = d_num[i][u] / sum;
+    }
+
+    /* emissions of a tie group are estimated from the pooled counts */
+    if (mo->model_type & GHMM_kTiedEmissions)
+      for (i = 0; i < mo->N; i++)
+        if (mo->tied_to[i] != GHMM_kUntied && mo->tied_to[i] != i)
+          for (k = 0; k < mo->M; k++)
+            b_num[mo->tied_to[i]][k] += b_num[i][k];
+    for (i = 0; i < mo->N; i++) {
+      if (mo->s[i].fix)
+        continue;
+      j = (mo->model_type & GHMM_kTiedEmissions)
+        && mo->tied_to[i] != GHMM_kUntied ? mo->tied_to[i] : i;
+      sum = 0.0;
+      for (k = 0; k < mo->M; k++)
+        sum += b_num[j][k];
+      if (sum > 0.0)
+        for (k = 0; k < mo->M; k++)
+          mo->s[i].b[k] = b_num[j][k] / sum;
+    }
+
+    GHMM_LOG_PRINTF(LINFO, LOC, "step %d: log P = %f", n, log_p);
+    if (log_p - log_p_old < -GHMM_EPS_PREC) {
+      GHMM_LOG_PRINTF(LCONVERTED, LOC, "No convergence: log P < log P-old! (n=%d)\n", n);
+      goto STOP;
+    }
+    if (log_p - log_p_old < fabs (likelihood_delta * log_p)) {
+      GHMM_LOG_PRINTF(LINFO, LOC, "Convergence after %d steps", n);
+      break;
+    }
+    log_p_old = log_p;
+  }
+  res = 0;
+
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ighmm_cmatrix_stat_free (&F);
+  ighmm_cmatrix_stat_free (&S);
+  ighmm_cmatrix_stat_free (&q);
+  ighmm_cmatrix_stat_free (&Bk);
+  ighmm_cmatrix_stat_free (&Bs);
+  ighmm_cmatrix_stat_free (&start);
+  ighmm_cmatrix_stat_free (&end);
+  ighmm_cmatrix_stat_free (&b_num);
+  ighmm_cmatrix_stat_free (&d_num);
+  if (pi_num)
+    m_free (pi_num);
+  if (a_num) {
+    for (i = 0; i < mo->N; i++)
+      if (a_num[i])
+        m_free (a_num[i]);
+    m_free (a_num);
+  }
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_dhsmm_baum_welch */
@@ -0,0 +1,139 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/hsmm.h
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+#ifndef GHMM_HSMM_H
+#define GHMM_HSMM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ghmm/model.h>
+#include <ghmm/sequence.h>
+
+/**@name Explicit duration HMM */
+/*@{ (Doc++-Group: hsmm) */
+
+/**
+  Hidden semi-Markov model with explicit state durations. A state i is
+  entered, stays for u = 1 .. D steps with probability d[i][u - 1] and emits
+  one symbol per step from its emission distribution, then the embedded
+  model moves on to a different state. Self transitions of the embedded
+  model are ignored.
+
+  Compared to expanding every state into a chain of D copies
+  (ghmm_dmodel_duration_apply) the number of states stays N. The forward
+  and Viterbi recursions cost O(T * (N * D + E)) for T observations and E
+  transitions. The emissions of a segment are accumulated incrementally
+  while its duration grows, so each (t, state, duration) term is O(1).
+
+  The sequence has to end with a complete segment, i.e. the last state
+  leaves after the last observation.
+  */
+  typedef struct ghmm_dhsmm {
+    /** embedded model: initial, emission and transition probabilities,
+        owned by the HSMM **/
+    ghmm_dmodel *mo;
+    /** maximal duration **/
+    int D;
+    /** duration distributions: d[i][u - 1] = P(state i lasts u steps) **/
+    double **d;
+  } ghmm_dhsmm;
+
+/**
+  Builds an HSMM from a discrete model without silent states and without
+  higher order emissions. The model is copied. The self transition a_ii
+  of a state becomes a geometric duration distribution truncated at D,
+  the other outgoing transitions are divided by 1 - a_ii. States without
+  any other outgoing transition get a uniform duration distribution.
+  @return HSMM or NULL on error
+  @param mo  model
+  @param D   maximal duration
+  */
+  ghmm_dhsmm *ghmm_dhsmm_from_dmodel (const ghmm_dmodel * mo, int D);
+
+/**
+  Frees an HSMM and its copy of the model.
+  @return 0 for succes; -1 for error
+  @param h  HSMM to free
+  */
+  int ghmm_dhsmm_free (ghmm_dhsmm ** h);
+
+/**
+  Forward algorithm with scaling.
+  @return 0 for success, -1 for error
+  @param h      HSMM
+  @param O      sequence
+  @param len    length of the sequence
+  @param log_p  log likelihood of the sequence, +1 if the sequence can not
+                be generated by the model
+  */
+  int ghmm_dhsmm_logp (ghmm_dhsmm * h, const int *O, int len, double *log_p);
+
+/**
+  Viterbi algorithm over segmentations: finds the most probable sequence
+  of states and durations.
+  @return state of every observation (len entries, to be freed by the
+          caller) or NULL on error or if there is no path
+  @param h      HSMM
+  @param O      sequence
+  @param len    length of the sequence
+  @param log_p  log probability of the path (states and durations), +1 if
+                the sequence can not be generated by the model
+  */
+  int *ghmm_dhsmm_viterbi (ghmm_dhsmm * h, const int *O, int len,
+                           double *log_p);
+
+/**
+  Baum-Welch algorithm for HSMMs. Reestimates the initial, the transition
+  (between different states), the emission (unless the state is fixed)
+  and the duration probabilities. Tied emissions are pooled over the tie
+  group. Sequences that can not be generated by the model are skipped.
+  @return 0 for success, -1 for error
+  @param h                 HSMM
+  @param sq                training sequences, weighted by sq->seq_w
+  @param max_step          maximal number of iterations
+  @param likelihood_delta  stops if the relative change of the log
+                           likelihood falls below this value
+  */
+  int ghmm_dhsmm_baum_welch (ghmm_dhsmm * h, ghmm_dseq * sq, int max_step,
+                             double likelihood_delta);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+/*@} (Doc++-Group: hsmm) */
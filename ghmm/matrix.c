@@ -141,18 +141,30 @@ int ighmm_dmatrix_read (scanner_t * s, int **matrix, int max_zeile, int max_spal
 
 /*============================================================================*/
 
+/* size of n row pointers followed by n * m entries, the largest size_t
+   if the dimensions are negative or the size overflows */
+static size_t matrix_stat_bytes (int n, int m, size_t size)
+{
+  size_t rows, data;
+
+  if (n < 0 || m < 0)
+    return (size_t) -1;
+  rows = ighmm_array_bytes (n, sizeof (void *));
+  data = ighmm_array_bytes (ighmm_array_bytes (n, m), size);
+  if (data > ((size_t) -1) - rows)
+    return (size_t) -1;
+  return rows + data;
+}
+
 /* allocation of matrices with fixed dimensions  */
 double **ighmm_cmatrix_stat_alloc (int n, int m)
 {
 #define CUR_PROC "ighmm_cmatrix_stat_alloc"
   int i;
-  double **A;
+  double **A = NULL;
   double *tmp;
- 
-  /* if (!(A = ighmm_calloc (n * sizeof (*A) + n * m * sizeof (**A)))) { */
 
-
-  if (!(A = ighmm_calloc (n * sizeof (double*) + n * m * sizeof (double)))) {
+  if (!(A = ighmm_calloc (matrix_stat_bytes (n, m, sizeof (double))))) {
     GHMM_LOG_QUEUED(LCONVERTED);
     goto STOP;
   }
@@ -188,9 +200,10 @@ int **ighmm_dmatrix_stat_alloc(int n, int m)
 {
 #define CUR_PROC "ighmm_dmatrix_stat_alloc"
   int i;
-  int **A;
+  int **A = NULL;
   int *tmp;
-  if (!(A = ighmm_calloc (n * sizeof(int*) + n * m * sizeof (int)))) {
+
+  if (!(A = ighmm_calloc (matrix_stat_bytes (n, m, sizeof (int))))) {
     GHMM_LOG_QUEUED(LCONVERTED);
     goto STOP;
   }
@@ -220,6 +233,80 @@ int ighmm_dmatrix_stat_free (int ***matrix)
 }
 
 
+/*============================================================================*/
+ighmm_psi_matrix *ighmm_psi_alloc (int n, int m, int max_in_states)
+{
+#define CUR_PROC "ighmm_psi_alloc"
+  ighmm_psi_matrix *psi = NULL;
+
+  ARRAY_CALLOC (psi, 1);
+  if (max_in_states < 255)
+    psi->width = sizeof (unsigned char);
+  else if (max_in_states < 65535)
+    psi->width = sizeof (unsigned short);
+  else
+    psi->width = sizeof (int);
+  psi->n = n;
+  psi->m = m;
+  if (n > 0 && m > 0
+      && !(psi->data = ighmm_calloc (ighmm_array_bytes (ighmm_array_bytes (n, m),
+                                                        psi->width)))) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  return psi;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ighmm_psi_free (&psi);
+  return NULL;
+#undef CUR_PROC
+}
+
+
+int ighmm_psi_free (ighmm_psi_matrix ** psi)
+{
+#define CUR_PROC "ighmm_psi_free"
+  mes_check_ptr (psi, return (-1));
+  if (!*psi)
+    return (0);
+  m_free ((*psi)->data);
+  m_free (*psi);
+  return 0;
+#undef CUR_PROC
+}
+
+
+void ighmm_psi_set (ighmm_psi_matrix * psi, int i, int j, int in_index)
+{
+  size_t pos = (size_t) i * psi->m + j;
+
+  switch (psi->width) {
+  case sizeof (unsigned char):
+    ((unsigned char *) psi->data)[pos] = (unsigned char) (in_index + 1);
+    break;
+  case sizeof (unsigned short):
+    ((unsigned short *) psi->data)[pos] = (unsigned short) (in_index + 1);
+    break;
+  default:
+    ((int *) psi->data)[pos] = in_index + 1;
+  }
+}
+
+
+int ighmm_psi_get (const ighmm_psi_matrix * psi, int i, int j)
+{
+  size_t pos = (size_t) i * psi->m + j;
+
+  switch (psi->width) {
+  case sizeof (unsigned char):
+    return (int) ((unsigned char *) psi->data)[pos] - 1;
+  case sizeof (unsigned short):
+    return (int) ((unsigned short *) psi->data)[pos] - 1;
+  default:
+    return ((int *) psi->data)[pos] - 1;
+  }
+}
+
+
 /*============================================================================*/
 
 
@@ -132,6 +132,59 @@ int ighmm_dmatrix_3d_free(int **** matrix, int i, int j);
   */
   int ighmm_dmatrix_free (int ***matrix, long rows);
 
+/**
+  Compact traceback matrix of the Viterbi algorithms. An entry holds the
+  position of the predecessor in the in_id array of the state plus one
+  (0 means no predecessor). The entries are stored with 1, 2 or 4 bytes,
+  whatever suffices for the largest number of in-states of the model.
+  */
+  typedef struct ighmm_psi_matrix {
+    /** number of bytes of an entry */
+    int width;
+    /** number of rows */
+    int n;
+    /** number of columns */
+    int m;
+    /** n * m entries */
+    void *data;
+  } ighmm_psi_matrix;
+
+/**
+  Allocation of a compact traceback matrix, all entries are initialised
+  to no predecessor.
+  @return pointer to the matrix or NULL on error
+  @param n              number of rows
+  @param m              number of columns
+  @param max_in_states  largest number of in-states of a state
+  */
+  ighmm_psi_matrix *ighmm_psi_alloc (int n, int m, int max_in_states);
+
+/**
+  Free the memory of a compact traceback matrix.
+  @return 0 for succes; -1 for error
+  @param  psi: matrix to free
+  */
+  int ighmm_psi_free (ighmm_psi_matrix ** psi);
+
+/**
+  Sets an entry of a compact traceback matrix.
+  @param psi       traceback matrix
+  @param i         row
+  @param j         column
+  @param in_index  position of the predecessor in the in_id array of the
+                   state or -1 for none
+  */
+  void ighmm_psi_set (ighmm_psi_matrix * psi, int i, int j, int in_index);
+
+/**
+  Reads an entry of a compact traceback matrix.
+  @return position of the predecessor in the in_id array or -1 for none
+  @param psi       traceback matrix
+  @param i         row
+  @param j         column
+  */
+  int ighmm_psi_get (const ighmm_psi_matrix * psi, int i, int j);
+
 
 #ifdef __cplusplus
 }
@@ -46,6 +46,10 @@
 #  include <windows.h>
 #  include <io.h>
 #endif
+#ifdef HAVE_MADVISE
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
 
 #include "ghmmconfig.h"
 
@@ -671,43 +675,77 @@ int ighmm_mes_insert (FILE * fp, char src, int cnt)
 /******************************************************************************/
 
 /*============================================================================*/
-void *ighmm_malloc (int bytes)
+size_t ighmm_array_bytes (size_t entries, size_t size)
+{
+  if (size && entries > ((size_t) -1) / size)
+    return (size_t) -1;
+  return entries * size;
+}                               /* ighmm_array_bytes */
+
+/*============================================================================*/
+/* Asks for transparent huge pages for the not yet touched pages of a large
+   block, which saves TLB misses when a trellis is swept. Only the pages
+   lying completely inside the block are advised, so the advice never
+   reaches memory of other allocations. */
+static void mes_advise_huge (void *mem, size_t bytes)
+{
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+  static size_t page;
+  size_t start, end;
+
+  if (bytes < GHMM_HUGE_PAGE_MIN)
+    return;
+  if (!page)
+    page = (size_t) sysconf (_SC_PAGESIZE);
+  start = ((size_t) mem + page - 1) / page * page;
+  end = ((size_t) mem + bytes) / page * page;
+  if (end > start)
+    madvise ((void *) start, end - start, MADV_HUGEPAGE);
+#endif
+}                               /* mes_advise_huge */
+
+/*============================================================================*/
+void *ighmm_malloc (size_t bytes)
 {
   void *res;
 
-  if (bytes <= 0)
+  if (bytes == 0)
     bytes = 1;
   res = malloc (bytes);
-  if (res)
+  if (res) {
+    mes_advise_huge (res, bytes);
     return (res);
+  }
   else
-    mes_aux (MES_FLAG_TIME_WIN, "malloc: could not allocate %d bytes\n",
-             bytes);
+    mes_aux (MES_FLAG_TIME_WIN, "malloc: could not allocate %.0f bytes\n",
+             (double) bytes);
   return (NULL);
 }                               /* ighmm_malloc */
 
 /*============================================================================*/
-void *ighmm_calloc (int bytes)
+void *ighmm_calloc (size_t bytes)
 {
   void *res;
 
-  if (bytes <= 0)
+  if (bytes == 0)
     bytes = 1;
   res = calloc (1, bytes);
-  if (res)
+  if (res) {
+    mes_advise_huge (res, bytes);
     return (res);
+  }
   else
-    mes_aux (MES_FLAG_TIME_WIN, "calloc: could not allocate %d bytes\n",
-             bytes);
+    mes_aux (MES_FLAG_TIME_WIN, "calloc: could not allocate %.0f bytes\n",
+             (double) bytes);
   return (NULL);
 }                               /* ighmm_calloc */
 
 /*============================================================================*/
-int ighmm_realloc (void **mem, int bytes)
+int ighmm_realloc (void **mem, size_t bytes)
 {
   void *res;
 
-  if (bytes <= 0)
+  if (bytes == 0)
     bytes = 1;
   if (!mem)
     return (-1);
@@ -721,7 +759,7 @@ int ighmm_realloc (void **mem, int bytes)
   }
   else
     mes_aux (MES_FLAG_TIME_WIN,
-             "realloc: could not reallocate %d bytes\n", bytes);
+             "realloc: could not reallocate %.0f bytes\n", (double) bytes);
   return (-1);
 }                               /* ighmm_realloc */
 
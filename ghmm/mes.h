@@ -76,6 +76,11 @@ extern "C" {
 #define MES_PROT            MES_FLAG_FILE_WIN, __LINE__ ,MES_PROC_INFO, CUR_PROC
 #define MES_PROT_TIME       MES_FLAG_TIME_WIN, __LINE__ ,MES_PROC_INFO, CUR_PROC
 
+/* smallest allocation that is advised to use huge pages */
+#ifndef GHMM_HUGE_PAGE_MIN
+#define GHMM_HUGE_PAGE_MIN (4 << 20)
+#endif
+
 /* stuff from sys.h */
 
 #if defined(_WIN32)
@@ -272,17 +277,26 @@ extern "C" {
    */
   int ighmm_mes_win_ability (int on);
   /**
+     Size of an array in bytes.
+     @return entries * size or the largest size_t on overflow (the
+             allocation fails then)
+   */
+  size_t ighmm_array_bytes (size_t entries, size_t size);
+  /**
+     Allocates zeroed memory. Blocks of at least GHMM_HUGE_PAGE_MIN bytes
+     are advised to be backed by huge pages where madvise is available.
    */
-  void *ighmm_calloc (int bytes);
+  void *ighmm_calloc (size_t bytes);
   /**
    */
   FILE *ighmm_mes_fopen (const char *filename, char *attribute_string);
   /**
+     Allocates memory, see ighmm_calloc.
    */
-  void *ighmm_malloc (int bytes);
+  void *ighmm_malloc (size_t bytes);
   /**
    */
-  int ighmm_realloc (void **mem, int bytes);
+  int ighmm_realloc (void **mem, size_t bytes);
 
 #ifdef __cplusplus
 }
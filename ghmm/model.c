@@ -56,6 +56,7 @@
 #include "ghmm_internals.h"
 #include "xmlreader.h"
 #include "xmlwriter.h"
+#include "snapshot.h"
 
 #include "obsolete.h"
 
@@ -79,9 +80,8 @@ int ghmm_ipow(const ghmm_dmodel * mo, int x, unsigned int n) {
 #define CUR_PROC "ghmm_ipow"
   int result=1;  
 
-  if ((mo->M == x) && (n <= mo->maxorder + 1)) {
-    if (mo->pow_lookup)
-      result = mo->pow_lookup[n];
+  if ((mo->M == x) && (n <= mo->maxorder + 1) && mo->pow_lookup) {
+    result = mo->pow_lookup[n];
   } else {
     while (n != 0) {
       if (n & 1)
@@ -130,7 +130,8 @@ ghmm_dmodel * ghmm_dmodel_calloc(int M, int N, int modeltype, int * inDegVec,
 
   mo->M = M;
   mo->N = N;
-  mo->model_type = modeltype;
+  /* the transition index is set up by ghmm_dmodel_transition_index_build */
+  mo->model_type = modeltype & ~GHMM_kTransitionIndex;
 
   ARRAY_CALLOC(mo->s, N);
   for (i=0; i<N; i++) {
@@ -633,8 +634,10 @@ int ghmm_dmodel_free(ghmm_dmodel ** mo) {
   m = *mo;
   mes_check_ptr (m, return (-1));
 
-  for (i=0; i < m->N && m->s; i++)
+  for (i=0; i < m->N && m->s && !m->snapshot; i++)
     ghmm_dstate_clean(&m->s[i]);
+  if (m->snapshot)
+    ghmm_snapshot_free(m->snapshot);
 
   if (m->s)
     m_free(m->s);
@@ -659,6 +662,7 @@ int ghmm_dmodel_free(ghmm_dmodel ** mo) {
     m_free(m->order);
   if (m->model_type & GHMM_kLabeledStates)
     m_free(m->label);
+  ghmm_dmodel_transition_index_free(m);
  
   m_free(m);
   return (0);
@@ -761,9 +765,12 @@ ghmm_dmodel *ghmm_dmodel_copy (const ghmm_dmodel * mo)
       m2->pow_lookup[i] = mo->pow_lookup[i];
   }  
 
-  m2->model_type = mo->model_type;
+  m2->model_type = mo->model_type & ~GHMM_kTransitionIndex;
   /* not necessary but the history is at least initialised */
   m2->emission_history = mo->emission_history;
+  if ((mo->model_type & GHMM_kTransitionIndex)
+      && ghmm_dmodel_transition_index_build (m2))
+    goto STOP;
   return (m2);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   ghmm_dmodel_free (&m2);
@@ -1062,7 +1069,7 @@ ghmm_dseq *ghmm_dmodel_generate_sequences(ghmm_dmodel* mo, int seed, int global_
     /* for silent models we have to allocate for the maximal possible number
        of lables and states */
     if (mo->model_type & GHMM_kSilentStates) {
-      ARRAY_CALLOC(sq->states[n], len * mo->N);
+      ARRAY_CALLOC(sq->states[n], (size_t) len * mo->N);
     }
     else {
       ARRAY_CALLOC(sq->states[n], len);
@@ -1192,12 +1199,193 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 # undef CUR_PROC
 }                               /* ghmm_dmodel_likelihood */
 
+/*============================================================================*/
+/* transition index: open addressing with linear probing on the pairs (i, j);
+   every slot holds the positions of the transition in s[i].out_id and in
+   s[j].in_id (-1 if it is missing there) */
+typedef struct {
+  int i, j;                     /* i == -1 marks an empty slot */
+  int out, in;
+} transition_slot;
+
+struct ghmm_transition_index {
+  int size;                     /* power of 2, at most half full */
+  int used;
+  transition_slot *slot;
+};
+
+static int transition_hash (const struct ghmm_transition_index *ix, int i, int j)
+{
+  unsigned int h = (unsigned int) i * 0x9E3779B1u + (unsigned int) j;
+  h ^= h >> 15;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return (int) (h & (unsigned int) (ix->size - 1));
+}
+
+static transition_slot *transition_index_find (const struct ghmm_transition_index *ix,
+                                               int i, int j)
+{
+  int k;
+  for (k = transition_hash (ix, i, j); ix->slot[k].i != -1;
+       k = (k + 1) & (ix->size - 1))
+    if (ix->slot[k].i == i && ix->slot[k].j == j)
+      return ix->slot + k;
+  return NULL;
+}
+
+/* rehashes all transitions into size slots */
+static int transition_index_resize (struct ghmm_transition_index *ix, int size)
+{
+#define CUR_PROC "transition_index_resize"
+  transition_slot *old = ix->slot;
+  int k, l, old_size = ix->size;
+
+  ARRAY_MALLOC (ix->slot, size);
+  ix->size = size;
+  for (k = 0; k < size; k++)
+    ix->slot[k].i = -1;
+  for (k = 0; old && k < old_size; k++)
+    if (old[k].i != -1) {
+      for (l = transition_hash (ix, old[k].i, old[k].j); ix->slot[l].i != -1;
+           l = (l + 1) & (size - 1));
+      ix->slot[l] = old[k];
+    }
+  if (old)
+    m_free (old);
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ix->slot = old;
+  return -1;
+#undef CUR_PROC
+}
+
+/* adds the transition i -> j unless it is in the index already */
+static int transition_index_insert (struct ghmm_transition_index *ix, int i,
+                                    int j, int out, int in)
+{
+  int k;
+  if (transition_index_find (ix, i, j))
+    return 0;
+  if (2 * (ix->used + 1) > ix->size
+      && transition_index_resize (ix, 2 * ix->size))
+    return -1;
+  for (k = transition_hash (ix, i, j); ix->slot[k].i != -1;
+       k = (k + 1) & (ix->size - 1));
+  ix->slot[k].i = i;
+  ix->slot[k].j = j;
+  ix->slot[k].out = out;
+  ix->slot[k].in = in;
+  ix->used++;
+  return 0;
+}
+
+/* removes the transition i -> j, moving the following slots of the probe
+   sequence back instead of leaving a tombstone */
+static void transition_index_remove (struct ghmm_transition_index *ix, int i, int j)
+{
+  transition_slot *e = transition_index_find (ix, i, j);
+  int k, l, h, mask = ix->size - 1;
+
+  if (!e)
+    return;
+  k = e - ix->slot;
+  for (l = (k + 1) & mask; ix->slot[l].i != -1; l = (l + 1) & mask) {
+    h = transition_hash (ix, ix->slot[l].i, ix->slot[l].j);
+    /* the hole k lies between the home slot h and l */
+    if (((l - h) & mask) >= ((l - k) & mask)) {
+      ix->slot[k] = ix->slot[l];
+      k = l;
+    }
+  }
+  ix->slot[k].i = -1;
+  ix->used--;
+}
+
+/* updates the positions stored for the transitions of state i after its
+   out_id changed from position out and its in_id from position in on */
+static void transition_index_renumber (ghmm_dmodel * mo, int i, int out, int in)
+{
+  transition_slot *e;
+  for (; out < mo->s[i].out_states; out++)
+    if ((e = transition_index_find (mo->transition_index, i, mo->s[i].out_id[out])))
+      e->out = out;
+  for (; in < mo->s[i].in_states; in++)
+    if ((e = transition_index_find (mo->transition_index, mo->s[i].in_id[in], i)))
+      e->in = in;
+}
+
+/*============================================================================*/
+int ghmm_dmodel_transition_index_build (ghmm_dmodel * mo)
+{
+#define CUR_PROC "ghmm_dmodel_transition_index_build"
+  struct ghmm_transition_index *ix = NULL;
+  transition_slot *e;
+  int i, k, size, n = 0;
+
+  ghmm_dmodel_transition_index_free (mo);
+  for (i = 0; i < mo->N; i++)
+    n += mo->s[i].out_states;
+  size = 16;
+  while (size < 2 * n)
+    size *= 2;
+
+  ARRAY_CALLOC (ix, 1);
+  if (transition_index_resize (ix, size))
+    goto STOP;
+  for (i = 0; i < mo->N; i++)
+    for (k = 0; k < mo->s[i].out_states; k++)
+      if (transition_index_insert (ix, i, mo->s[i].out_id[k], k, -1))
+        goto STOP;
+  for (i = 0; i < mo->N; i++)
+    for (k = 0; k < mo->s[i].in_states; k++) {
+      e = transition_index_find (ix, mo->s[i].in_id[k], i);
+      if (e && e->in == -1)
+        e->in = k;
+    }
+
+  mo->transition_index = ix;
+  mo->model_type |= GHMM_kTransitionIndex;
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (ix) {
+    if (ix->slot)
+      m_free (ix->slot);
+    m_free (ix);
+  }
+  return -1;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+int ghmm_dmodel_transition_index_free (ghmm_dmodel * mo)
+{
+#define CUR_PROC "ghmm_dmodel_transition_index_free"
+  if (!(mo->model_type & GHMM_kTransitionIndex))
+    return 0;
+  if (mo->transition_index) {
+    if (mo->transition_index->slot)
+      m_free (mo->transition_index->slot);
+    m_free (mo->transition_index);
+  }
+  mo->transition_index = NULL;
+  mo->model_type &= ~GHMM_kTransitionIndex;
+  return 0;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
 double ghmm_dmodel_get_transition(ghmm_dmodel* mo, int i, int j)
 {
 # define CUR_PROC "ghmm_dmodel_get_transition"
   int out;
+  transition_slot *e;
 
   if (mo->s && mo->s[i].out_a && mo->s[j].in_a) {
+    if (mo->model_type & GHMM_kTransitionIndex) {
+      e = transition_index_find (mo->transition_index, i, j);
+      return e ? mo->s[i].out_a[e->out] : 0.0;
+    }
     for (out=0; out < mo->s[i].out_states; out++) {
       if (mo->s[i].out_id[out] == j)
         return mo->s[i].out_a[out];
@@ -1213,6 +1401,8 @@ int ghmm_dmodel_check_transition(ghmm_dmodel* mo, int i, int j)
   int out;
 
   if (mo->s && mo->s[i].out_a && mo->s[j].in_a) {
+    if (mo->model_type & GHMM_kTransitionIndex)
+      return transition_index_find (mo->transition_index, i, j) != NULL;
     for (out=0; out < mo->s[i].out_states; out++) {
       if (mo->s[i].out_id[out] == j)
         return 1;
@@ -1226,8 +1416,17 @@ void ghmm_dmodel_set_transition (ghmm_dmodel * mo, int i, int j, double prob)
 {
 # define CUR_PROC "ghmm_dmodel_set_transition"
   int in, out;
+  transition_slot *e;
 
   if (mo->s && mo->s[i].out_a && mo->s[j].in_a) {
+    if (mo->model_type & GHMM_kTransitionIndex) {
+      if ((e = transition_index_find (mo->transition_index, i, j))) {
+        mo->s[i].out_a[e->out] = prob;
+        if (e->in != -1)
+          mo->s[j].in_a[e->in] = prob;
+      }
+      return;
+    }
     for (out = 0; out < mo->s[i].out_states; out++) {
       if (mo->s[i].out_id[out] == j) {
         mo->s[i].out_a[out] = prob;
@@ -1785,6 +1984,127 @@ void ghmm_dstate_clean (ghmm_dstate * my_state)
 #undef CUR_PROC
 }                               /* ghmm_dstate_clean */
 
+/*============================================================================*/
+ghmm_dsparse_emission *ghmm_dmodel_sparse_emission_alloc (ghmm_dmodel * mo)
+{
+#define CUR_PROC "ghmm_dmodel_sparse_emission_alloc"
+  ghmm_dsparse_emission *se = NULL;
+  int *fill = NULL;
+  int i, m, n;
+
+  if (mo->model_type & GHMM_kHigherOrderEmissions) {
+    GHMM_LOG(LERROR, "sparse emissions of higher order are not supported");
+    return NULL;
+  }
+
+  ARRAY_CALLOC (se, 1);
+  se->M = mo->M;
+  ARRAY_CALLOC (se->start, mo->M + 1);
+  ARRAY_MALLOC (fill, mo->M);
+
+  /* count the emitting states per symbol */
+  for (i = 0; i < mo->N; i++) {
+    if ((mo->model_type & GHMM_kSilentStates) && mo->silent[i])
+      continue;
+    for (m = 0; m < mo->M; m++)
+      if (mo->s[i].b[m] > 0.0)
+        se->start[m + 1]++;
+  }
+  for (m = 0; m < mo->M; m++) {
+    fill[m] = se->start[m];
+    se->start[m + 1] += se->start[m];
+  }
+  se->nonzero = n = se->start[mo->M];
+
+  ARRAY_MALLOC (se->state, n > 0 ? n : 1);
+  ARRAY_MALLOC (se->b, n > 0 ? n : 1);
+  for (i = 0; i < mo->N; i++) {
+    if ((mo->model_type & GHMM_kSilentStates) && mo->silent[i])
+      continue;
+    for (m = 0; m < mo->M; m++)
+      if (mo->s[i].b[m] > 0.0) {
+        se->state[fill[m]] = i;
+        se->b[fill[m]++] = mo->s[i].b[m];
+      }
+  }
+
+  m_free (fill);
+  return se;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (fill)
+    m_free (fill);
+  ghmm_dsparse_emission_free (&se);
+  return NULL;
+#undef CUR_PROC
+}                               /* ghmm_dmodel_sparse_emission_alloc */
+
+/*============================================================================*/
+int ghmm_dsparse_emission_free (ghmm_dsparse_emission ** se)
+{
+#define CUR_PROC "ghmm_dsparse_emission_free"
+  mes_check_ptr (se, return (-1));
+  if (!*se)
+    return (0);
+  if ((*se)->start)
+    m_free ((*se)->start);
+  if ((*se)->state)
+    m_free ((*se)->state);
+  if ((*se)->b)
+    m_free ((*se)->b);
+  m_free (*se);
+  return (0);
+#undef CUR_PROC
+}                               /* ghmm_dsparse_emission_free */
+
+/*============================================================================*/
+int **ghmm_dmodel_emission_context_alloc (const ghmm_dmodel * mo, const int *O,
+                                          int len)
+{
+#define CUR_PROC "ghmm_dmodel_emission_context_alloc"
+  int **ctx = NULL;
+  int i, k, t, h, size;
+
+  if (!(mo->model_type & GHMM_kHigherOrderEmissions)) {
+    GHMM_LOG(LERROR, "model has no higher order emissions");
+    return NULL;
+  }
+  ARRAY_CALLOC (ctx, mo->maxorder + 1);
+  for (i = 0; i < mo->N; i++) {
+    k = mo->order[i];
+    if (ctx[k])
+      continue;
+    ARRAY_MALLOC (ctx[k], len > 0 ? len : 1);
+    /* h encodes the last k + 1 symbols in base M */
+    size = ghmm_ipow (mo, mo->M, k + 1);
+    h = 0;
+    for (t = 0; t < len; t++) {
+      h = (h * mo->M) % size + O[t];
+      ctx[k][t] = t < k ? -1 : h;
+    }
+  }
+  return ctx;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ghmm_dmodel_emission_context_free (&ctx, mo);
+  return NULL;
+#undef CUR_PROC
+}                               /* ghmm_dmodel_emission_context_alloc */
+
+/*============================================================================*/
+int ghmm_dmodel_emission_context_free (int ***ctx, const ghmm_dmodel * mo)
+{
+#define CUR_PROC "ghmm_dmodel_emission_context_free"
+  int k;
+  mes_check_ptr (ctx, return (-1));
+  if (!*ctx)
+    return (0);
+  for (k = 0; k <= mo->maxorder; k++)
+    if ((*ctx)[k])
+      m_free ((*ctx)[k]);
+  m_free (*ctx);
+  return (0);
+#undef CUR_PROC
+}                               /* ghmm_dmodel_emission_context_free */
+
 
 
 /*==========================  Labeled HMMs  ================================*/
@@ -1834,8 +2154,8 @@ ghmm_dseq *ghmm_dmodel_label_generate_sequences(
     /* for silent models we have to allocate for the maximal possible number
        of lables and states */
     if (mo->model_type & GHMM_kSilentStates) {
-      ARRAY_CALLOC(sq->states[n], len * mo->N);
-      ARRAY_CALLOC(sq->state_labels[n], len * mo->N);
+      ARRAY_CALLOC(sq->states[n], (size_t) len * mo->N);
+      ARRAY_CALLOC(sq->state_labels[n], (size_t) len * mo->N);
     }
      else {
       ARRAY_CALLOC(sq->states[n], len);
@@ -2010,11 +2330,12 @@ int ghmm_dmodel_add_noise (ghmm_dmodel * mo, double level, int seed)
 }
 
 /*----------------------------------------------------------------------------*/
-static int ghmm_dstate_transition_add(ghmm_dstate * s, int start, int dest, double prob)
+static int ghmm_dstate_transition_add(ghmm_dmodel * mo, int start, int dest, double prob)
 {
 #define CUR_PROC "ghmm_dmodel_transition_add"
 
-  int i;
+  ghmm_dstate *s = mo->s;
+  int i, out = 0, in = 0;
 
   /* resize the arrays */
   ARRAY_REALLOC (s[dest].in_id, s[dest].in_states + 1);
@@ -2030,6 +2351,7 @@ static int ghmm_dstate_transition_add(ghmm_dstate * s, int start, int dest, doub
     if (i == 0 || dest > s[start].out_id[i - 1]) {
       s[start].out_id[i] = dest;
       s[start].out_a[i] = prob;
+      out = i;
       break;
     }
     else {
@@ -2043,6 +2365,7 @@ static int ghmm_dstate_transition_add(ghmm_dstate * s, int start, int dest, doub
     if (i == 0 || start > s[dest].in_id[i - 1]) {
       s[dest].in_id[i] = start;
       s[dest].in_a[i] = prob;
+      in = i;
       break;
     }
     else {
@@ -2050,6 +2373,12 @@ static int ghmm_dstate_transition_add(ghmm_dstate * s, int start, int dest, doub
       s[dest].in_a[i] = s[dest].in_a[i - 1];
     }
 
+  if (mo->model_type & GHMM_kTransitionIndex) {
+    transition_index_renumber (mo, start, out + 1, s[start].in_states);
+    transition_index_renumber (mo, dest, s[dest].out_states, in + 1);
+    if (transition_index_insert (mo->transition_index, start, dest, out, in))
+      goto STOP;
+  }
   return 0;
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   return -1;
@@ -2057,11 +2386,12 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 }
 
 /*----------------------------------------------------------------------------*/
-static int ghmm_dstate_transition_del(ghmm_dstate * s, int start, int dest)
+static int ghmm_dstate_transition_del(ghmm_dmodel * mo, int start, int dest)
 {
 #define CUR_PROC "ghmm_dmodel_transition_del"
 
-  int i, j;
+  ghmm_dstate *s = mo->s;
+  int i, j, out;
 
   /* search ... */
   for (j = 0; dest != s[start].out_id[j]; j++)
@@ -2069,6 +2399,7 @@ static int ghmm_dstate_transition_del(ghmm_dstate * s, int start, int dest)
       GHMM_LOG(LCONVERTED, "No such transition");
       return -1;
     }
+  out = j;
   /* ... and replace outgoing */
   for (i = j + 1; i < s[start].out_states; i++) {
     s[start].out_id[i - 1] = s[start].out_id[i];
@@ -2091,6 +2422,12 @@ static int ghmm_dstate_transition_del(ghmm_dstate * s, int start, int dest)
   s[dest].in_states -= 1;
   s[start].out_states -= 1;
 
+  if (mo->model_type & GHMM_kTransitionIndex) {
+    transition_index_remove (mo->transition_index, start, dest);
+    transition_index_renumber (mo, start, out, s[start].in_states);
+    transition_index_renumber (mo, dest, s[dest].out_states, j);
+  }
+
   /* free memory */
   ARRAY_REALLOC (s[dest].in_id, s[dest].in_states);
   ARRAY_REALLOC (s[dest].in_a, s[dest].in_states);
@@ -2124,6 +2461,10 @@ int ghmm_dmodel_duration_apply (ghmm_dmodel * mo, int cur, int times)
     GHMM_LOG(LCONVERTED, "Sorry, apply_duration doesn't support silent states yet\n");
     return -1;
   }
+  if (mo->snapshot) {
+    GHMM_LOG(LERROR, "can not add states to a model mapped from a snapshot");
+    return -1;
+  }
 
   last = mo->N;
   mo->N += times - 1;
@@ -2137,14 +2478,23 @@ int ghmm_dmodel_duration_apply (ghmm_dmodel * mo, int cur, int times)
     ARRAY_REALLOC (mo->tied_to, mo->N);
   if (mo->model_type & GHMM_kBackgroundDistributions)
     ARRAY_REALLOC (mo->background_id, mo->N);
+  if (mo->model_type & GHMM_kHigherOrderEmissions)
+    ARRAY_REALLOC (mo->order, mo->N);
+  if (mo->model_type & GHMM_kLabeledStates)
+    ARRAY_REALLOC (mo->label, mo->N);
 
-  size = ghmm_ipow (mo, mo->M, mo->order[cur] + 1);
+  if (mo->model_type & GHMM_kHigherOrderEmissions)
+    size = ghmm_ipow (mo, mo->M, mo->order[cur] + 1);
+  else
+    size = mo->M;
   for (i = last; i < mo->N; i++) {
     /* set the new state */
     mo->s[i].pi = 0.0;
-    mo->order[i] = mo->order[cur];
+    if (mo->model_type & GHMM_kHigherOrderEmissions)
+      mo->order[i] = mo->order[cur];
     mo->s[i].fix = mo->s[cur].fix;
-    mo->label[i] = mo->label[cur];
+    if (mo->model_type & GHMM_kLabeledStates)
+      mo->label[i] = mo->label[cur];
     mo->s[i].in_a = NULL;
     mo->s[i].in_id = NULL;
     mo->s[i].in_states = 0;
@@ -2174,20 +2524,20 @@ int ghmm_dmodel_duration_apply (ghmm_dmodel * mo, int cur, int times)
   /* move the outgoing transitions to the last state */
   while (mo->s[cur].out_states > 0) {
     if (mo->s[cur].out_id[0] == cur) {
-      ghmm_dstate_transition_add (mo->s, mo->N - 1, mo->N - 1, mo->s[cur].out_a[0]);
-      ghmm_dstate_transition_del (mo->s, cur, mo->s[cur].out_id[0]);
+      ghmm_dstate_transition_add (mo, mo->N - 1, mo->N - 1, mo->s[cur].out_a[0]);
+      ghmm_dstate_transition_del (mo, cur, mo->s[cur].out_id[0]);
     }
     else {
-      ghmm_dstate_transition_add (mo->s, mo->N - 1, mo->s[cur].out_id[0],
+      ghmm_dstate_transition_add (mo, mo->N - 1, mo->s[cur].out_id[0],
                             mo->s[cur].out_a[0]);
-      ghmm_dstate_transition_del (mo->s, cur, mo->s[cur].out_id[0]);
+      ghmm_dstate_transition_del (mo, cur, mo->s[cur].out_id[0]);
     }
   }
 
   /* set the linear transitions through all added states */
-  ghmm_dstate_transition_add (mo->s, cur, last, 1.0);
+  ghmm_dstate_transition_add (mo, cur, last, 1.0);
   for (i = last + 1; i < mo->N; i++) {
-    ghmm_dstate_transition_add (mo->s, i - 1, i, 1.0);
+    ghmm_dstate_transition_add (mo, i - 1, i, 1.0);
   }
 
   if (ghmm_dmodel_normalize (mo))
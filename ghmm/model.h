@@ -179,6 +179,17 @@ typedef struct {
   ghmm_alphabet* label_alphabet;
 
   ghmm_alphabet* alphabet;
+
+  /** Index of the transitions for constant time lookups of (i, j) pairs.
+
+      Note: transition_index != NULL iff (model_type & kTransitionIndex) != 0  */
+  struct ghmm_transition_index *transition_index;
+
+  /** Snapshot file the arrays of the states point into (see snapshot.h),
+      such a model can not change its number of states or transitions.
+
+      Note: snapshot == NULL for models allocated by the library  */
+  struct ghmm_snapshot *snapshot;
 } ghmm_dmodel;
 
 #ifdef __cplusplus
@@ -326,6 +337,27 @@ int ghmm_dmodel_check_compatibel_models (const ghmm_dmodel * mo, const ghmm_dmod
 */
   void ghmm_dmodel_set_transition (ghmm_dmodel * mo, int i, int j, double prob);
 
+/**
+    Builds an index of all transitions of the model, a hash table on the
+    pairs (i, j). ghmm_dmodel_get_transition, ghmm_dmodel_check_transition
+    and ghmm_dmodel_set_transition take constant time instead of scanning
+    out_id and in_id then. Sets kTransitionIndex; an existing index is
+    rebuilt.
+    The index is kept up to date by ghmm_dmodel_duration_apply and copied
+    by ghmm_dmodel_copy. It has to be rebuilt after changing out_id or in_id
+    directly.
+    @return 0 for success; -1 for error
+    @param mo model
+*/
+  int ghmm_dmodel_transition_index_build (ghmm_dmodel * mo);
+
+/**
+    Frees the transition index and clears kTransitionIndex.
+    @return 0 for success; -1 for error
+    @param mo model
+*/
+  int ghmm_dmodel_transition_index_free (ghmm_dmodel * mo);
+
 /**
    Writes a model in matrix format.
    @param file: output file
@@ -412,7 +444,9 @@ int ghmm_dmodel_check_compatibel_models (const ghmm_dmodel * mo, const ghmm_dmod
 */
   void ghmm_dmodel_states_print (FILE * file, ghmm_dmodel * mo);
 
-/** Computes probabilistic distance of two models
+/** Computes probabilistic distance of two models, serially from one
+    sample. ghmm_dmodel_distance_mc (distance.h) estimates it in parallel
+    with a confidence interval.
     @return the distance
     @param m0  model used for generating random output
     @param m  model to compare with
@@ -435,6 +469,66 @@ int ghmm_dmodel_check_compatibel_models (const ghmm_dmodel * mo, const ghmm_dmod
   void ghmm_dstate_clean (ghmm_dstate *state);
 
 
+/**
+   Sparse form of the emission probabilities of a discrete model, stored
+   by symbol. For models with a large alphabet in which each state emits
+   only a few symbols (e.g. word models) it lists for every symbol m the
+   emitting states with b[m] > 0:
+   state[start[m]], ..., state[start[m + 1] - 1] with probabilities
+   b[start[m]], ..., b[start[m + 1] - 1]. Silent states are not listed.
+   It is a copy, it has to be built again after the emissions changed.
+*/
+  typedef struct ghmm_dsparse_emission {
+    /** alphabet size */
+    int M;
+    /** number of nonzero emission probabilities */
+    int nonzero;
+    /** M + 1 offsets into state and b */
+    int *start;
+    /** emitting states in increasing order */
+    int *state;
+    /** emission probabilities */
+    double *b;
+  } ghmm_dsparse_emission;
+
+/**
+   Builds the sparse emission table of a model with emissions of order 0.
+   @return sparse emissions or NULL on error
+   @param mo  model
+*/
+  ghmm_dsparse_emission *ghmm_dmodel_sparse_emission_alloc (ghmm_dmodel * mo);
+
+/**
+   Frees a sparse emission table.
+   @return 0: success, -1: error
+   @param se  address of the sparse emissions
+*/
+  int ghmm_dsparse_emission_free (ghmm_dsparse_emission ** se);
+
+/**
+   Precomputes the emission context indices of a sequence for a model with
+   higher order emissions. For every order k used by a state, ctx[k][t] is
+   the index into b of a state of order k for the symbol O[t] and its k
+   predecessors, or -1 for t < k. Orders not used by any state are NULL.
+   This is what get_emission_index computes from the emission history, once
+   per sequence instead of once per state and time step.
+   @return context indices or NULL on error
+   @param mo   model with higher order emissions
+   @param O    sequence
+   @param len  length of the sequence
+*/
+  int **ghmm_dmodel_emission_context_alloc (const ghmm_dmodel * mo,
+                                            const int *O, int len);
+
+/**
+   Frees the context indices of ghmm_dmodel_emission_context_alloc.
+   @return 0 for succes; -1 for error
+   @param ctx  address of the context indices
+   @param mo   model they were computed for
+*/
+  int ghmm_dmodel_emission_context_free (int ***ctx, const ghmm_dmodel * mo);
+
+
   ghmm_dseq *ghmm_dmodel_label_generate_sequences (ghmm_dmodel * mo, int seed,
                                               int global_len, long seq_number,
                                               int Tmax);
@@ -454,6 +548,15 @@ int ghmm_dmodel_check_compatibel_models (const ghmm_dmodel * mo, const ghmm_dmod
                                               ghmm_ipow((MO), (MO)->M, (MO)->order[S]+1)+(O)) \
                                             : (O))
 
+/**
+    Index into the emission array b of state S for the observation O at
+    time T from precomputed context indices CTX
+    (ghmm_dmodel_emission_context_alloc); CTX is NULL for models without
+    higher order emissions, then the index is O
+*/
+#define ghmm_emission_context_index(MO, CTX, S, O, T)  ((CTX) ?                 \
+                                            (CTX)[(MO)->order[S]][T] : (O))
+
 /**
    Updates emission history of model mo, discarding the oldest and 'adding' the
    new observation by using modulo and multiplication
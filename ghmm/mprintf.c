@@ -48,6 +48,7 @@
 #endif
 
 #include "mprintf.h"
+#include "ghmm_internals.h"
 
 #define MPRINTF_FLAG_LEFT   1
 #define MPRINTF_FLAG_ZERO   2
@@ -333,7 +334,7 @@ static int mprintf_scan_int (char **src, va_list AP_POINTER)
 static char *mprintf_get_next (char **format, int *flen, int *dlen,
                                va_list AP_POINTER)
 {
-  static char tmp[MPRINTF_TMP_LEN];
+  static GHMM_THREAD_LOCAL char tmp[MPRINTF_TMP_LEN];
   char *res = NULL;
   int minwidth = -1;
   int maxwidth = MPRINTF_TMP_LEN - 1;
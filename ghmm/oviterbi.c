@@ -0,0 +1,503 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/oviterbi.c
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <float.h>
+#include <math.h>
+
+#include "ghmm.h"
+#include "mes.h"
+#include "matrix.h"
+#include "model.h"
+#include "smodel.h"
+#include "oviterbi.h"
+#include "ghmm_internals.h"
+
+/* initial number of observations in the traceback window if unbounded */
+#define OVITERBI_INITIAL_CAPACITY 64
+
+struct ghmm_oviterbi {
+  /** number of states **/
+  int N;
+  /** number of transition classes **/
+  int cos;
+  /** discrete model or NULL **/
+  ghmm_dmodel *mo;
+  /** continuous model or NULL **/
+  ghmm_cmodel *smo;
+  /** in_id arrays of the states **/
+  int **in_id;
+  /** in_states of the states **/
+  int *in_states;
+  /** log(pi), +1 for pi = 0 **/
+  double *log_pi;
+  /** log_in_a[class][state][in-edge], +1 for a = 0 **/
+  double ***log_in_a;
+  /** discrete models: log_b[state][symbol], +1 for b = 0 **/
+  double **log_b;
+  /** log emission probabilities of the current observation **/
+  double *log_b_t;
+  double *phi;
+  double *phi_new;
+  /** traceback of the times t_fixed .. t - 1, row tau % capacity **/
+  ighmm_psi_matrix *psi;
+  int max_in_states;
+  int capacity;
+  /** number of observations of the current sequence **/
+  int t;
+  /** number of states of the current sequence that are already fixed **/
+  int t_fixed;
+  int max_delay;
+  /** state sets for the coalescence test, mark[i] == stamp for members **/
+  int *set;
+  int *set_new;
+  int *mark;
+  int stamp;
+  /** states fixed by the last call **/
+  int *fixed;
+};
+
+/*----------------------------------------------------------------------------*/
+int ghmm_oviterbi_free (ghmm_oviterbi ** ov)
+{
+#define CUR_PROC "ghmm_oviterbi_free"
+  int c, j;
+  mes_check_ptr (ov, return (-1));
+  if (!*ov)
+    return (0);
+  if ((*ov)->log_in_a) {
+    for (c = 0; c < (*ov)->cos; c++) {
+      if ((*ov)->log_in_a[c]) {
+        for (j = 0; j < (*ov)->N; j++)
+          m_free ((*ov)->log_in_a[c][j]);
+        m_free ((*ov)->log_in_a[c]);
+      }
+    }
+    m_free ((*ov)->log_in_a);
+  }
+  if ((*ov)->log_b)
+    ighmm_cmatrix_stat_free (&((*ov)->log_b));
+  m_free ((*ov)->in_id);
+  m_free ((*ov)->in_states);
+  m_free ((*ov)->log_pi);
+  m_free ((*ov)->log_b_t);
+  m_free ((*ov)->phi);
+  m_free ((*ov)->phi_new);
+  ighmm_psi_free (&((*ov)->psi));
+  m_free ((*ov)->set);
+  m_free ((*ov)->set_new);
+  m_free ((*ov)->mark);
+  m_free ((*ov)->fixed);
+  m_free (*ov);
+  return (0);
+#undef CUR_PROC
+}                               /* ghmm_oviterbi_free */
+
+/*----------------------------------------------------------------------------*/
+/* allocates everything that does not depend on the kind of model, in_id,
+   in_states and log_pi have to be filled in by the caller */
+static ghmm_oviterbi *oviterbi_alloc (int N, int cos, int max_delay)
+{
+#define CUR_PROC "oviterbi_alloc"
+  ghmm_oviterbi *ov = NULL;
+  int c;
+
+  ARRAY_CALLOC (ov, 1);
+  ov->N = N;
+  ov->cos = cos;
+  ov->max_delay = max_delay;
+  ov->capacity = (max_delay > 0) ? max_delay + 1 : OVITERBI_INITIAL_CAPACITY;
+  ARRAY_CALLOC (ov->in_id, N);
+  ARRAY_CALLOC (ov->in_states, N);
+  ARRAY_CALLOC (ov->log_pi, N);
+  ARRAY_CALLOC (ov->log_in_a, cos);
+  for (c = 0; c < cos; c++)
+    ARRAY_CALLOC (ov->log_in_a[c], N);
+  ARRAY_CALLOC (ov->log_b_t, N);
+  ARRAY_CALLOC (ov->phi, N);
+  ARRAY_CALLOC (ov->phi_new, N);
+  ARRAY_CALLOC (ov->set, N);
+  ARRAY_CALLOC (ov->set_new, N);
+  ARRAY_CALLOC (ov->mark, N);
+  ARRAY_CALLOC (ov->fixed, ov->capacity);
+  return ov;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ghmm_oviterbi_free (&ov);
+  return NULL;
+#undef CUR_PROC
+}                               /* oviterbi_alloc */
+
+/*----------------------------------------------------------------------------*/
+static int oviterbi_alloc_psi (ghmm_oviterbi * ov)
+{
+#define CUR_PROC "oviterbi_alloc_psi"
+  int j;
+  for (j = 0; j < ov->N; j++)
+    if (ov->in_states[j] > ov->max_in_states)
+      ov->max_in_states = ov->in_states[j];
+  ov->psi = ighmm_psi_alloc (ov->capacity, ov->N, ov->max_in_states);
+  if (!ov->psi) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return -1;
+  }
+  return 0;
+#undef CUR_PROC
+}                               /* oviterbi_alloc_psi */
+
+/*============================================================================*/
+ghmm_oviterbi *ghmm_dmodel_oviterbi_alloc (ghmm_dmodel * mo, int max_delay)
+{
+#define CUR_PROC "ghmm_dmodel_oviterbi_alloc"
+  ghmm_oviterbi *ov = NULL;
+  int i, j, m;
+
+  if (mo->model_type & (GHMM_kSilentStates | GHMM_kHigherOrderEmissions)) {
+    GHMM_LOG(LERROR, "online Viterbi does not support silent states or "
+             "higher order emissions");
+    return NULL;
+  }
+  ov = oviterbi_alloc (mo->N, 1, max_delay);
+  if (!ov) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  ov->mo = mo;
+  ov->log_b = ighmm_cmatrix_stat_alloc (mo->N, mo->M);
+  if (!ov->log_b) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  for (j = 0; j < mo->N; j++) {
+    ov->in_id[j] = mo->s[j].in_id;
+    ov->in_states[j] = mo->s[j].in_states;
+    ov->log_pi[j] = (mo->s[j].pi == 0.0) ? +1 : log (mo->s[j].pi);
+    ARRAY_CALLOC (ov->log_in_a[0][j], mo->s[j].in_states);
+    for (i = 0; i < mo->s[j].in_states; i++)
+      ov->log_in_a[0][j][i] =
+        (mo->s[j].in_a[i] == 0.0) ? +1 : log (mo->s[j].in_a[i]);
+    for (m = 0; m < mo->M; m++)
+      ov->log_b[j][m] = (mo->s[j].b[m] == 0.0) ? +1 : log (mo->s[j].b[m]);
+  }
+  if (oviterbi_alloc_psi (ov))
+    goto STOP;
+  return ov;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ghmm_oviterbi_free (&ov);
+  return NULL;
+#undef CUR_PROC
+}                               /* ghmm_dmodel_oviterbi_alloc */
+
+/*============================================================================*/
+ghmm_oviterbi *ghmm_cmodel_oviterbi_alloc (ghmm_cmodel * smo, int max_delay)
+{
+#define CUR_PROC "ghmm_cmodel_oviterbi_alloc"
+  ghmm_oviterbi *ov = NULL;
+  int c, i, j;
+
+  ov = oviterbi_alloc (smo->N, smo->cos, max_delay);
+  if (!ov) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  ov->smo = smo;
+  for (j = 0; j < smo->N; j++) {
+    ov->in_id[j] = smo->s[j].in_id;
+    ov->in_states[j] = smo->s[j].in_states;
+    ov->log_pi[j] = (smo->s[j].pi == 0.0) ? +1 : log (smo->s[j].pi);
+    for (c = 0; c < smo->cos; c++) {
+      ARRAY_CALLOC (ov->log_in_a[c][j], smo->s[j].in_states);
+      for (i = 0; i < smo->s[j].in_states; i++)
+        ov->log_in_a[c][j][i] = (smo->s[j].in_a[c][i] == 0.0) ? +1
+          : log (smo->s[j].in_a[c][i]);
+    }
+  }
+  if (oviterbi_alloc_psi (ov))
+    goto STOP;
+  return ov;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ghmm_oviterbi_free (&ov);
+  return NULL;
+#undef CUR_PROC
+}                               /* ghmm_cmodel_oviterbi_alloc */
+
+/*----------------------------------------------------------------------------*/
+/* doubles the traceback window, the rows keep their times */
+static int oviterbi_grow (ghmm_oviterbi * ov)
+{
+#define CUR_PROC "oviterbi_grow"
+  ighmm_psi_matrix *psi;
+  int capacity = 2 * ov->capacity;
+  int tau, j;
+
+  psi = ighmm_psi_alloc (capacity, ov->N, ov->max_in_states);
+  if (!psi) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  for (tau = ov->t_fixed; tau < ov->t; tau++)
+    for (j = 0; j < ov->N; j++)
+      ighmm_psi_set (psi, tau % capacity, j,
+                     ighmm_psi_get (ov->psi, tau % ov->capacity, j));
+  ARRAY_REALLOC (ov->fixed, capacity);
+  ighmm_psi_free (&ov->psi);
+  ov->psi = psi;
+  ov->capacity = capacity;
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ighmm_psi_free (&psi);
+  return -1;
+#undef CUR_PROC
+}                               /* oviterbi_grow */
+
+/*----------------------------------------------------------------------------*/
+/* predecessor of state j at time tau */
+static int oviterbi_pred (ghmm_oviterbi * ov, int tau, int j)
+{
+  return ov->in_id[j][ighmm_psi_get (ov->psi, tau % ov->capacity, j)];
+}
+
+/*----------------------------------------------------------------------------*/
+/* writes the path ending in state j at time tau back to t_fixed into fixed,
+   returns the state at t_fixed */
+static int oviterbi_trace (ghmm_oviterbi * ov, int tau, int j, int *fixed)
+{
+  if (fixed)
+    fixed[tau - ov->t_fixed] = j;
+  for (; tau > ov->t_fixed; tau--) {
+    j = oviterbi_pred (ov, tau, j);
+    if (fixed)
+      fixed[tau - 1 - ov->t_fixed] = j;
+  }
+  return j;
+}
+
+/*----------------------------------------------------------------------------*/
+/* fixes the states all survivor paths agree on, forces a decision if the
+   window exceeds max_delay */
+static int oviterbi_coalesce (ghmm_oviterbi * ov)
+{
+#define CUR_PROC "oviterbi_coalesce"
+  int j, k, n, m, tau, best, count = 0;
+  int *tmp;
+  double max_value;
+
+  for (;;) {
+    /* survivors of the current time */
+    ov->stamp++;
+    n = 0;
+    best = -1;
+    max_value = -DBL_MAX;
+    for (j = 0; j < ov->N; j++)
+      if (ov->phi[j] != +1) {
+        ov->set[n++] = j;
+        if (ov->phi[j] > max_value) {
+          max_value = ov->phi[j];
+          best = j;
+        }
+      }
+    if (n == 0) {
+      GHMM_LOG(LERROR, "sequence can't be generated by the model");
+      return -1;
+    }
+
+    /* follow all survivors back until they merge */
+    tau = ov->t - 1;
+    while (n > 1 && tau > ov->t_fixed) {
+      ov->stamp++;
+      m = 0;
+      for (k = 0; k < n; k++) {
+        j = oviterbi_pred (ov, tau, ov->set[k]);
+        if (ov->mark[j] != ov->stamp) {
+          ov->mark[j] = ov->stamp;
+          ov->set_new[m++] = j;
+        }
+      }
+      tmp = ov->set; ov->set = ov->set_new; ov->set_new = tmp;
+      n = m;
+      tau--;
+    }
+    if (n == 1) {
+      oviterbi_trace (ov, tau, ov->set[0], ov->fixed + count);
+      count += tau - ov->t_fixed + 1;
+      ov->t_fixed = tau + 1;
+      return count;
+    }
+
+    if (ov->max_delay <= 0 || ov->t - ov->t_fixed <= ov->max_delay)
+      return count;
+
+    /* bounded latency: fix the oldest state of the best path and drop
+       the survivors that do not pass through it */
+    k = oviterbi_trace (ov, ov->t - 1, best, NULL);
+    for (j = 0; j < ov->N; j++)
+      if (ov->phi[j] != +1 && oviterbi_trace (ov, ov->t - 1, j, NULL) != k)
+        ov->phi[j] = +1;
+    ov->fixed[count++] = k;
+    ov->t_fixed++;
+  }
+#undef CUR_PROC
+}                               /* oviterbi_coalesce */
+
+/*----------------------------------------------------------------------------*/
+/* one Viterbi step with the emissions in log_b_t */
+static int oviterbi_step (ghmm_oviterbi * ov, int osc)
+{
+#define CUR_PROC "oviterbi_step"
+  int i, j, i_id, max_i, row;
+  double value, max_value, *tmp;
+
+  if (ov->t + 1 - ov->t_fixed > ov->capacity && oviterbi_grow (ov))
+    return -1;
+
+  if (ov->t == 0) {
+    for (j = 0; j < ov->N; j++) {
+      if (ov->log_pi[j] == +1 || ov->log_b_t[j] == +1)
+        ov->phi[j] = +1;
+      else
+        ov->phi[j] = ov->log_pi[j] + ov->log_b_t[j];
+    }
+  }
+  else {
+    row = ov->t % ov->capacity;
+    for (j = 0; j < ov->N; j++) {
+      max_value = -DBL_MAX;
+      max_i = -1;
+      for (i = 0; i < ov->in_states[j]; i++) {
+        i_id = ov->in_id[j][i];
+        if (ov->phi[i_id] != +1 && ov->log_in_a[osc][j][i] != +1) {
+          value = ov->phi[i_id] + ov->log_in_a[osc][j][i];
+          if (value > max_value) {
+            max_value = value;
+            max_i = i;
+          }
+        }
+      }
+      /* the row is reused, so always overwrite the predecessor */
+      ighmm_psi_set (ov->psi, row, j, max_i);
+      if (max_i < 0 || ov->log_b_t[j] == +1)
+        ov->phi_new[j] = +1;
+      else
+        ov->phi_new[j] = max_value + ov->log_b_t[j];
+    }
+    tmp = ov->phi; ov->phi = ov->phi_new; ov->phi_new = tmp;
+  }
+  ov->t++;
+  return oviterbi_coalesce (ov);
+#undef CUR_PROC
+}                               /* oviterbi_step */
+
+/*============================================================================*/
+int ghmm_dmodel_oviterbi_push (ghmm_oviterbi * ov, int o, int **fixed)
+{
+#define CUR_PROC "ghmm_dmodel_oviterbi_push"
+  int j;
+
+  if (!ov->mo) {
+    GHMM_LOG(LERROR, "decoder was not allocated for a discrete model");
+    return -1;
+  }
+  if (o < 0 || o >= ov->mo->M) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "symbol %d out of range", o);
+    return -1;
+  }
+  for (j = 0; j < ov->N; j++)
+    ov->log_b_t[j] = ov->log_b[j][o];
+  *fixed = ov->fixed;
+  return oviterbi_step (ov, 0);
+#undef CUR_PROC
+}                               /* ghmm_dmodel_oviterbi_push */
+
+/*============================================================================*/
+int ghmm_cmodel_oviterbi_push (ghmm_oviterbi * ov, const double *O, int osc,
+                               int **fixed)
+{
+#define CUR_PROC "ghmm_cmodel_oviterbi_push"
+  int j;
+  double cb;
+
+  if (!ov->smo) {
+    GHMM_LOG(LERROR, "decoder was not allocated for a continuous model");
+    return -1;
+  }
+  if (ov->cos == 1 || ov->t == 0)
+    osc = 0;
+  else if (osc < 0 || osc >= ov->cos) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "transition class %d, but model has only %d "
+                    "classes", osc, ov->cos);
+    return -1;
+  }
+  for (j = 0; j < ov->N; j++) {
+    cb = ghmm_cmodel_calc_b (ov->smo->s + j, O);
+    ov->log_b_t[j] = (cb == 0.0) ? +1 : log (cb);
+  }
+  *fixed = ov->fixed;
+  return oviterbi_step (ov, osc);
+#undef CUR_PROC
+}                               /* ghmm_cmodel_oviterbi_push */
+
+/*============================================================================*/
+int ghmm_oviterbi_finish (ghmm_oviterbi * ov, int **fixed, double *log_p)
+{
+#define CUR_PROC "ghmm_oviterbi_finish"
+  int j, best = -1, count;
+  double max_value = -DBL_MAX;
+
+  *fixed = ov->fixed;
+  *log_p = +1;
+  if (ov->t == 0)
+    return 0;
+  for (j = 0; j < ov->N; j++)
+    if (ov->phi[j] != +1 && ov->phi[j] > max_value) {
+      max_value = ov->phi[j];
+      best = j;
+    }
+  if (best < 0) {
+    GHMM_LOG(LERROR, "sequence can't be generated by the model");
+    ov->t = 0;
+    ov->t_fixed = 0;
+    return -1;
+  }
+  count = ov->t - ov->t_fixed;
+  if (count > 0)
+    oviterbi_trace (ov, ov->t - 1, best, ov->fixed);
+  *log_p = max_value;
+  ov->t = 0;
+  ov->t_fixed = 0;
+  return count;
+#undef CUR_PROC
+}                               /* ghmm_oviterbi_finish */
@@ -0,0 +1,123 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/oviterbi.h
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+#ifndef GHMM_OVITERBI_H
+#define GHMM_OVITERBI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+
+/**@name Online Viterbi-Algorithmus */
+/*@{ (Doc++-Group: oviterbi) */
+
+/**
+  Online Viterbi decoder. Observations are pushed one at a time. As soon
+  as all survivor paths pass through the same state (coalescence), the
+  state path up to this point is fixed and returned. Only the traceback
+  of the not yet fixed part is stored, so the memory is bounded by the
+  coalescence window (or by max_delay).
+  */
+  typedef struct ghmm_oviterbi ghmm_oviterbi;
+
+/**
+  Allocates an online Viterbi decoder for a discrete model without silent
+  states.
+  @return decoder or NULL on error
+  @param mo         model
+  @param max_delay  largest number of observations that are not fixed yet;
+                    if the window grows beyond, the oldest state of the best
+                    current path is fixed and all survivors disagreeing with
+                    it are discarded. 0 means unbounded (exact Viterbi path)
+  */
+  ghmm_oviterbi *ghmm_dmodel_oviterbi_alloc (ghmm_dmodel * mo, int max_delay);
+
+/**
+  Allocates an online Viterbi decoder for a continuous model.
+  @return decoder or NULL on error
+  @param smo        model
+  @param max_delay  see ghmm_dmodel_oviterbi_alloc
+  */
+  ghmm_oviterbi *ghmm_cmodel_oviterbi_alloc (ghmm_cmodel * smo, int max_delay);
+
+/**
+  Pushes the next symbol to a decoder of a discrete model.
+  @return number of newly fixed states, -1 on error or if the sequence can
+          not be generated by the model
+  @param ov     decoder
+  @param o      symbol
+  @param fixed  set to the newly fixed states, valid until the next call
+  */
+  int ghmm_dmodel_oviterbi_push (ghmm_oviterbi * ov, int o, int **fixed);
+
+/**
+  Pushes the next observation to a decoder of a continuous model.
+  @return number of newly fixed states, -1 on error or if the sequence can
+          not be generated by the model
+  @param ov     decoder
+  @param O      observation vector of smo->dim values
+  @param osc    transition class of the transition to this observation,
+                ignored for the first observation and for models with one
+                class
+  @param fixed  set to the newly fixed states, valid until the next call
+  */
+  int ghmm_cmodel_oviterbi_push (ghmm_oviterbi * ov, const double *O, int osc,
+                                 int **fixed);
+
+/**
+  Ends the sequence and fixes the remaining states by tracing back from
+  the best final state. The decoder starts a new sequence afterwards.
+  @return number of newly fixed states, -1 on error
+  @param ov     decoder
+  @param fixed  set to the newly fixed states, valid until the next call
+  @param log_p  log probability of the whole state path
+  */
+  int ghmm_oviterbi_finish (ghmm_oviterbi * ov, int **fixed, double *log_p);
+
+/**
+  Frees an online Viterbi decoder.
+  @return 0 for succes; -1 for error
+  @param ov  decoder to free
+  */
+  int ghmm_oviterbi_free (ghmm_oviterbi ** ov);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+/*@} (Doc++-Group: oviterbi) */
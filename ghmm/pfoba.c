@@ -0,0 +1,492 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/pfoba.c
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "ghmm.h"
+#include "mes.h"
+#include "matrix.h"
+#include "pmodel.h"
+#include "psequence.h"
+#include "pfoba.h"
+#include "ghmm_internals.h"
+
+/* log(1 + exp(-x)) is tabulated for 0 <= x < PFOBA_LOGSUM_MAX with
+   PFOBA_LOGSUM_SCALE entries per unit, beyond it is below 1e-13 */
+#define PFOBA_LOGSUM_MAX   30
+#define PFOBA_LOGSUM_SCALE 512
+
+/* minimal number of cells on an anti-diagonal to split it between threads */
+#define PFOBA_OMP_MIN_CELLS 64
+
+typedef struct pfoba_local_store_t {
+  /** precomputed log probabilities for transitions into the states 
+      for each transition class of the source state **/
+  double *** log_in_a;
+  /** precomputed log probabilities for each state for the emissions **/
+  double ** log_b;
+  /** table for the approximate log sum, NULL for the exact one **/
+  double * logsum_table;
+  /** for convinience store a pointer to the model **/
+  ghmm_dpmodel * mo;
+} pfoba_local_store_t;
+
+/* a forward or backward lattice, either the full matrix or a ring of the
+   last n_diag anti-diagonals */
+typedef struct pfoba_lattice_t {
+  double *** m;
+  /** number of anti-diagonals in the ring, 0 for the full matrix **/
+  int n_diag;
+  int len_x;
+  int len_y;
+  int max_offset_y;
+} pfoba_lattice_t;
+
+
+static int pfoba_free(pfoba_local_store_t ** pf);
+
+/*============================================================================*/
+static pfoba_local_store_t * pfoba_alloc(ghmm_dpmodel * mo, int fast_logsum) {
+#define CUR_PROC "pfoba_alloc"
+  pfoba_local_store_t * pf = NULL;
+  int i, j;
+
+  ARRAY_CALLOC (pf, 1);
+  pf->mo = mo;
+  ARRAY_CALLOC (pf->log_in_a, mo->N);
+  for (j = 0; j < mo->N; j++) {
+    ARRAY_CALLOC (pf->log_in_a[j], mo->s[j].in_states);
+    for (i = 0; i < mo->s[j].in_states; i++)
+      ARRAY_CALLOC (pf->log_in_a[j][i], mo->s[mo->s[j].in_id[i]].kclasses);
+  }
+  ARRAY_CALLOC (pf->log_b, mo->N);
+  for (j = 0; j < mo->N; j++)
+    ARRAY_CALLOC (pf->log_b[j], ghmm_dpmodel_emission_table_size(mo, j) + 1);
+  if (fast_logsum) {
+    ARRAY_MALLOC (pf->logsum_table, PFOBA_LOGSUM_MAX * PFOBA_LOGSUM_SCALE + 1);
+    for (i = 0; i <= PFOBA_LOGSUM_MAX * PFOBA_LOGSUM_SCALE; i++)
+      pf->logsum_table[i] = log1p(exp(-(double)i / PFOBA_LOGSUM_SCALE));
+  }
+  return pf;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  pfoba_free(&pf);
+  return NULL;
+#undef CUR_PROC
+} /* pfoba_alloc */
+
+/*============================================================================*/
+static int pfoba_free(pfoba_local_store_t ** pf) {
+#define CUR_PROC "pfoba_free"
+  int i, j;
+  ghmm_dpmodel * mo;
+  mes_check_ptr(pf, return(-1));
+  if (!*pf) return(0);
+  mo = (*pf)->mo;
+  if ((*pf)->log_in_a) {
+    for (j = 0; j < mo->N; j++) {
+      if (!(*pf)->log_in_a[j])
+	continue;
+      for (i = 0; i < mo->s[j].in_states; i++)
+	if ((*pf)->log_in_a[j][i])
+	  m_free((*pf)->log_in_a[j][i]);
+      m_free((*pf)->log_in_a[j]);
+    }
+    m_free((*pf)->log_in_a);
+  }
+  if ((*pf)->log_b) {
+    for (j = 0; j < mo->N; j++)
+      if ((*pf)->log_b[j])
+	m_free((*pf)->log_b[j]);
+    m_free((*pf)->log_b);
+  }
+  if ((*pf)->logsum_table)
+    m_free((*pf)->logsum_table);
+  m_free(*pf);
+  return(0);
+#undef CUR_PROC
+} /* pfoba_free */
+
+/*============================================================================*/
+static void pfoba_precompute(ghmm_dpmodel * mo, pfoba_local_store_t * pf) {
+  int i, j, emission, t_class;
+
+  for (j = 0; j < mo->N; j++)
+    for (i = 0; i < mo->s[j].in_states; i++)
+      for (t_class = 0; t_class < mo->s[mo->s[j].in_id[i]].kclasses; t_class++) {
+	if (mo->s[j].in_a[i][t_class] == 0.0)
+	  pf->log_in_a[j][i][t_class] = +1;
+	else
+	  pf->log_in_a[j][i][t_class] = log(mo->s[j].in_a[i][t_class]);
+      }
+
+  for (j = 0; j < mo->N; j++) {
+    for (emission = 0; emission < ghmm_dpmodel_emission_table_size(mo, j); emission++) {
+      if (mo->s[j].b[emission] == 0.0)
+	pf->log_b[j][emission] = +1;
+      else
+	pf->log_b[j][emission] = log(mo->s[j].b[emission]);
+    }
+    pf->log_b[j][emission] = +1; /* the last field is for invalid emissions */
+  }
+} /* pfoba_precompute */
+
+/*============================================================================*/
+/* log(exp(a) + exp(b)) where +1 is log(0) */
+static double pfoba_logsum(pfoba_local_store_t * pf, double a, double b) {
+  double x, frac;
+  int i;
+
+  if (a == +1)
+    return b;
+  if (b == +1)
+    return a;
+  if (a < b) {
+    x = a; a = b; b = x;
+  }
+  x = a - b;
+  if (!pf->logsum_table)
+    return a + log1p(exp(-x));
+  if (x >= PFOBA_LOGSUM_MAX)
+    return a;
+  x *= PFOBA_LOGSUM_SCALE;
+  i = (int)x;
+  frac = x - i;
+  return a + pf->logsum_table[i] + frac * (pf->logsum_table[i + 1] - pf->logsum_table[i]);
+}
+
+/*============================================================================*/
+static double pfoba_log_in_a(pfoba_local_store_t * pf, int i, int j,
+			     ghmm_dpseq * X, ghmm_dpseq * Y, int u, int v) {
+  /* determine the transition class for the source state */
+  int id = pf->mo->s[i].in_id[j];
+  int cl = pf->mo->s[id].class_change->get_class(pf->mo, X, Y, u, v,
+					pf->mo->s[id].class_change->user_data);
+  return pf->log_in_a[i][j][cl];
+}
+
+/*============================================================================*/
+static double pfoba_log_b(pfoba_local_store_t * pf, ghmm_dpseq * X,
+			  ghmm_dpseq * Y, int i, int u, int v) {
+  ghmm_dpmodel * mo = pf->mo;
+  return pf->log_b[i][ghmm_dpmodel_pair(ghmm_dpseq_get_char(X, mo->s[i].alphabet, u),
+				      ghmm_dpseq_get_char(Y, mo->s[i].alphabet, v),
+				      mo->size_of_alphabet[mo->s[i].alphabet],
+				      mo->s[i].offset_x, mo->s[i].offset_y)];
+}
+
+/*============================================================================*/
+/* the values of all states in cell (u, v), NULL outside of the lattice */
+static double * pfoba_cell(pfoba_lattice_t * lat, int u, int v) {
+  if (u < -1 || v < -lat->max_offset_y || u >= lat->len_x || v >= lat->len_y)
+    return NULL;
+  if (lat->n_diag)
+    return lat->m[(u + v + lat->max_offset_y + 1) % lat->n_diag][u + 1];
+  return lat->m[u + 1][v + lat->max_offset_y];
+}
+
+/*============================================================================*/
+static int pfoba_is_silent(ghmm_dpmodel * mo, int i) {
+  return (mo->model_type & GHMM_kSilentStates) && mo->silent[i];
+}
+
+/*============================================================================*/
+static void pfoba_forward_cell(pfoba_local_store_t * pf, pfoba_lattice_t * lat,
+			       ghmm_dpseq * X, ghmm_dpseq * Y, int u, int v) {
+  ghmm_dpmodel * mo = pf->mo;
+  double * alpha = pfoba_cell(lat, u, v);
+  double * prev;
+  double sum, log_b_i, log_in_a_ij;
+  int i, j;
+
+  for (i = 0; i < mo->N; i++) {
+    alpha[i] = +1;
+    if (pfoba_is_silent(mo, i))
+      continue;
+    log_b_i = pfoba_log_b(pf, X, Y, i, u, v);
+    if (log_b_i == +1)
+      continue;
+    sum = +1;
+    /* paths starting in state i */
+    if (mo->s[i].log_pi != +1 && mo->s[i].offset_x - 1 == u
+	&& mo->s[i].offset_y - 1 == v)
+      sum = mo->s[i].log_pi;
+    prev = pfoba_cell(lat, u - mo->s[i].offset_x, v - mo->s[i].offset_y);
+    if (prev) {
+      for (j = 0; j < mo->s[i].in_states; j++) {
+	if (prev[mo->s[i].in_id[j]] == +1)
+	  continue;
+	log_in_a_ij = pfoba_log_in_a(pf, i, j, X, Y, u, v);
+	if (log_in_a_ij != +1)
+	  sum = pfoba_logsum(pf, sum, prev[mo->s[i].in_id[j]] + log_in_a_ij);
+      }
+    }
+    if (sum != +1)
+      alpha[i] = sum + log_b_i;
+  }
+}
+
+/*============================================================================*/
+static void pfoba_backward_cell(pfoba_local_store_t * pf, pfoba_lattice_t * lat,
+				ghmm_dpseq * X, ghmm_dpseq * Y, int u, int v) {
+  ghmm_dpmodel * mo = pf->mo;
+  double * beta = pfoba_cell(lat, u, v);
+  double * next;
+  double log_b_i, log_in_a_ij, value;
+  int i, j, u_next, v_next;
+
+  if (u == lat->len_x - 1 && v == lat->len_y - 1) {
+    for (j = 0; j < mo->N; j++)
+      beta[j] = 0.0;
+    return;
+  }
+  for (j = 0; j < mo->N; j++)
+    beta[j] = +1;
+  /* all transitions j -> i leaving this cell end in the cell of state i */
+  for (i = 0; i < mo->N; i++) {
+    if (pfoba_is_silent(mo, i))
+      continue;
+    u_next = u + mo->s[i].offset_x;
+    v_next = v + mo->s[i].offset_y;
+    next = pfoba_cell(lat, u_next, v_next);
+    if (!next || next[i] == +1)
+      continue;
+    log_b_i = pfoba_log_b(pf, X, Y, i, u_next, v_next);
+    if (log_b_i == +1)
+      continue;
+    value = next[i] + log_b_i;
+    for (j = 0; j < mo->s[i].in_states; j++) {
+      log_in_a_ij = pfoba_log_in_a(pf, i, j, X, Y, u_next, v_next);
+      if (log_in_a_ij != +1)
+	beta[mo->s[i].in_id[j]] = pfoba_logsum(pf, beta[mo->s[i].in_id[j]],
+					       value + log_in_a_ij);
+    }
+  }
+}
+
+/*============================================================================*/
+/* sweeps the anti-diagonals forwards or backwards */
+static void pfoba_sweep(pfoba_local_store_t * pf, pfoba_lattice_t * lat,
+			ghmm_dpseq * X, ghmm_dpseq * Y, int backward) {
+  int d, d_first, d_last, u, u_first, u_last;
+
+  d_first = -1 - lat->max_offset_y;
+  d_last = lat->len_x + lat->len_y - 2;
+  for (d = backward ? d_last : d_first;
+       backward ? d >= d_first : d <= d_last; d += backward ? -1 : 1) {
+    u_first = m_max(-1, d - lat->len_y + 1);
+    u_last = m_min(lat->len_x - 1, d + lat->max_offset_y);
+#ifdef _OPENMP
+#pragma omp parallel for if (u_last - u_first >= PFOBA_OMP_MIN_CELLS)
+#endif
+    for (u = u_first; u <= u_last; u++) {
+      if (backward)
+	pfoba_backward_cell(pf, lat, X, Y, u, d - u);
+      else
+	pfoba_forward_cell(pf, lat, X, Y, u, d - u);
+    }
+  }
+}
+
+/*============================================================================*/
+static int pfoba_check(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y) {
+#define CUR_PROC "pfoba_check"
+  int i;
+  for (i = 0; i < mo->N; i++)
+    if (mo->s[i].offset_x + mo->s[i].offset_y == 0 && !pfoba_is_silent(mo, i)) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "state %d does not consume any character", i);
+      return -1;
+    }
+  if (X->length < 1 || Y->length < 1) {
+    GHMM_LOG(LERROR, "both sequences must not be empty");
+    return -1;
+  }
+  return 0;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+static double pfoba_termination(pfoba_local_store_t * pf, pfoba_lattice_t * lat) {
+  double * alpha = pfoba_cell(lat, lat->len_x - 1, lat->len_y - 1);
+  double log_p = +1;
+  int i;
+  for (i = 0; i < pf->mo->N; i++)
+    log_p = pfoba_logsum(pf, log_p, alpha[i]);
+  return log_p;
+}
+
+/*============================================================================*/
+double ***ghmm_dpmodel_foba_alloc(ghmm_dpmodel * mo, int len_x, int len_y) {
+  return ighmm_cmatrix_3d_alloc(len_x + 1, len_y + mo->max_offset_y, mo->N);
+}
+
+/*============================================================================*/
+int ghmm_dpmodel_foba_free(double ****lattice, ghmm_dpmodel * mo, int len_x,
+			   int len_y) {
+  return ighmm_cmatrix_3d_free(lattice, len_x + 1, len_y + mo->max_offset_y);
+}
+
+/*============================================================================*/
+int ghmm_dpmodel_forward(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y,
+			 double ***alpha, double *log_p, int fast_logsum) {
+#define CUR_PROC "ghmm_dpmodel_forward"
+  pfoba_local_store_t * pf;
+  pfoba_lattice_t lat;
+
+  if (pfoba_check(mo, X, Y))
+    return -1;
+  pf = pfoba_alloc(mo, fast_logsum);
+  if (!pf) {GHMM_LOG_QUEUED(LCONVERTED); return -1;}
+  pfoba_precompute(mo, pf);
+
+  lat.m = alpha;
+  lat.n_diag = 0;
+  lat.len_x = X->length;
+  lat.len_y = Y->length;
+  lat.max_offset_y = mo->max_offset_y;
+  pfoba_sweep(pf, &lat, X, Y, 0);
+  *log_p = pfoba_termination(pf, &lat);
+
+  pfoba_free(&pf);
+  return (*log_p == +1) ? -1 : 0;
+#undef CUR_PROC
+} /* ghmm_dpmodel_forward */
+
+/*============================================================================*/
+int ghmm_dpmodel_backward(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y,
+			  double ***beta, int fast_logsum) {
+#define CUR_PROC "ghmm_dpmodel_backward"
+  pfoba_local_store_t * pf;
+  pfoba_lattice_t lat;
+
+  if (pfoba_check(mo, X, Y))
+    return -1;
+  pf = pfoba_alloc(mo, fast_logsum);
+  if (!pf) {GHMM_LOG_QUEUED(LCONVERTED); return -1;}
+  pfoba_precompute(mo, pf);
+
+  lat.m = beta;
+  lat.n_diag = 0;
+  lat.len_x = X->length;
+  lat.len_y = Y->length;
+  lat.max_offset_y = mo->max_offset_y;
+  pfoba_sweep(pf, &lat, X, Y, 1);
+
+  pfoba_free(&pf);
+  return 0;
+#undef CUR_PROC
+} /* ghmm_dpmodel_backward */
+
+/*============================================================================*/
+int ghmm_dpmodel_forward_logp(ghmm_dpmodel * mo, ghmm_dpseq * X,
+			      ghmm_dpseq * Y, double *log_p, int fast_logsum) {
+#define CUR_PROC "ghmm_dpmodel_forward_logp"
+  pfoba_local_store_t * pf;
+  pfoba_lattice_t lat;
+  int res = -1;
+
+  if (pfoba_check(mo, X, Y))
+    return -1;
+  pf = pfoba_alloc(mo, fast_logsum);
+  if (!pf) {GHMM_LOG_QUEUED(LCONVERTED); return -1;}
+  pfoba_precompute(mo, pf);
+
+  lat.n_diag = mo->max_offset_x + mo->max_offset_y + 1;
+  lat.len_x = X->length;
+  lat.len_y = Y->length;
+  lat.max_offset_y = mo->max_offset_y;
+  lat.m = ighmm_cmatrix_3d_alloc(lat.n_diag, X->length + 1, mo->N);
+  if (!lat.m) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
+  pfoba_sweep(pf, &lat, X, Y, 0);
+  *log_p = pfoba_termination(pf, &lat);
+  res = (*log_p == +1) ? -1 : 0;
+
+STOP:
+  if (lat.m)
+    ighmm_cmatrix_3d_free(&lat.m, lat.n_diag, X->length + 1);
+  pfoba_free(&pf);
+  return res;
+#undef CUR_PROC
+} /* ghmm_dpmodel_forward_logp */
+
+/*============================================================================*/
+int ghmm_dpmodel_posterior_match(ghmm_dpmodel * mo, ghmm_dpseq * X,
+				 ghmm_dpseq * Y, double **post, double *log_p,
+				 int fast_logsum) {
+#define CUR_PROC "ghmm_dpmodel_posterior_match"
+  double ***alpha = NULL, ***beta = NULL;
+  int u, v, i, res = -1;
+
+  alpha = ghmm_dpmodel_foba_alloc(mo, X->length, Y->length);
+  if (!alpha) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
+  beta = ghmm_dpmodel_foba_alloc(mo, X->length, Y->length);
+  if (!beta) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
+
+  if (ghmm_dpmodel_forward(mo, X, Y, alpha, log_p, fast_logsum)) {
+    GHMM_LOG(LWARN, "sequences can not be generated by the model");
+    goto STOP;
+  }
+  if (ghmm_dpmodel_backward(mo, X, Y, beta, fast_logsum)) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+
+  for (u = 0; u < X->length; u++)
+    for (v = 0; v < Y->length; v++) {
+      post[u][v] = 0.0;
+      for (i = 0; i < mo->N; i++) {
+	if (mo->s[i].offset_x == 0 || mo->s[i].offset_y == 0
+	    || alpha[u + 1][v + mo->max_offset_y][i] == +1
+	    || beta[u + 1][v + mo->max_offset_y][i] == +1)
+	  continue;
+	post[u][v] += exp(alpha[u + 1][v + mo->max_offset_y][i]
+			  + beta[u + 1][v + mo->max_offset_y][i] - *log_p);
+      }
+    }
+  res = 0;
+
+STOP:
+  if (alpha)
+    ghmm_dpmodel_foba_free(&alpha, mo, X->length, Y->length);
+  if (beta)
+    ghmm_dpmodel_foba_free(&beta, mo, X->length, Y->length);
+  return res;
+#undef CUR_PROC
+} /* ghmm_dpmodel_posterior_match */
@@ -0,0 +1,136 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/pfoba.h
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+#ifndef GHMM_PFOBA_H
+#define GHMM_PFOBA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pmodel.h"
+#include "psequence.h"
+
+/**@name Forward-Backward-Algorithm for pair HMMs
+
+   All values are logarithms, +1 stands for log(0) as in the pair Viterbi.
+   The lattices are indexed by [u + 1][v + mo->max_offset_y][state] for the
+   positions u = -1, ..., len_x - 1 in X and v = -max_offset_y, ...,
+   len_y - 1 in Y, use ghmm_dpmodel_foba_alloc to allocate them.
+
+   The cells are computed by anti-diagonals u + v, the cells of one
+   anti-diagonal are computed in parallel if the library was compiled with
+   OpenMP (the class change functions must be reentrant then).
+
+   If fast_logsum is not zero log(exp(a) + exp(b)) is computed by table
+   lookup with linear interpolation (absolute error below 1e-6) instead of
+   calling exp and log1p.
+*/
+
+/*@{ (Doc++-Group: pfoba) */
+
+/**
+   Allocates a forward or backward lattice for the sequence lengths.
+   @return lattice or NULL on error
+   @param mo:     pair HMM
+   @param len_x:  length of sequence X
+   @param len_y:  length of sequence Y
+ */
+double ***ghmm_dpmodel_foba_alloc(ghmm_dpmodel * mo, int len_x, int len_y);
+
+/**
+   Frees a lattice allocated by ghmm_dpmodel_foba_alloc.
+   @return 0 for success, -1 for error
+ */
+int ghmm_dpmodel_foba_free(double ****lattice, ghmm_dpmodel * mo, int len_x,
+                           int len_y);
+
+/** Forward-Algorithm.
+   Calculates the log forward variables alpha and log( P(X, Y|lambda) ).
+   @return 0 for success, -1 for error or if the sequences can not be
+   generated by the model
+   @param mo:           pair HMM
+   @param X:            first sequence
+   @param Y:            second sequence
+   @param alpha:        log forward lattice (see ghmm_dpmodel_foba_alloc)
+   @param log_p:        log likelihood, +1 if zero
+   @param fast_logsum:  use the approximate log sum
+ */
+int ghmm_dpmodel_forward(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y,
+                         double ***alpha, double *log_p, int fast_logsum);
+
+/** Backward-Algorithm.
+   Calculates the log backward variables beta.
+   @return 0 for success, -1 for error
+   @param mo:           pair HMM
+   @param X:            first sequence
+   @param Y:            second sequence
+   @param beta:         log backward lattice (see ghmm_dpmodel_foba_alloc)
+   @param fast_logsum:  use the approximate log sum
+ */
+int ghmm_dpmodel_backward(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y,
+                          double ***beta, int fast_logsum);
+
+/**
+   Calculates log( P(X, Y|lambda) ) with the forward algorithm keeping only
+   the last max_offset_x + max_offset_y + 1 anti-diagonals in memory.
+   @return 0 for success, -1 for error or if the sequences can not be
+   generated by the model
+ */
+int ghmm_dpmodel_forward_logp(ghmm_dpmodel * mo, ghmm_dpseq * X,
+                              ghmm_dpseq * Y, double *log_p, int fast_logsum);
+
+/**
+   Posterior match probabilities. post[u][v] is the probability that X[u]
+   and Y[v] are emitted together by a state reading from both sequences.
+   @return 0 for success, -1 for error
+   @param mo:           pair HMM
+   @param X:            first sequence
+   @param Y:            second sequence
+   @param post:         len_x x len_y matrix allocated by the caller
+   @param log_p:        log likelihood, +1 if zero
+   @param fast_logsum:  use the approximate log sum
+ */
+int ghmm_dpmodel_posterior_match(ghmm_dpmodel * mo, ghmm_dpseq * X,
+                                 ghmm_dpseq * Y, double **post, double *log_p,
+                                 int fast_logsum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GHMM_PFOBA_H */
+
+/*@} (Doc++-Group: pfoba) */
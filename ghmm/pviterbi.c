@@ -65,8 +65,9 @@ typedef struct plocal_store_t {
   double *** phi;
   /** log probabilities for the current u, v and every state **/
   double *phi_new;
-  /** traceback matrix **/
-  int ***psi;
+  /** traceback matrix, rows are the cells (x, y), entries the position
+      of the predecessor in in_id **/
+  ighmm_psi_matrix *psi;
   /** for convinience store a pointer to the model **/
   ghmm_dpmodel * mo;
   /** for the debug mode store information of matrix sizes **/
@@ -84,7 +85,7 @@ typedef struct plocal_store_t {
 
   static plocal_store_t *pviterbi_alloc(ghmm_dpmodel *mo, int len_x, int len_y);
 
-  static int pviterbi_free(plocal_store_t **v, int n, int len_x, int len_y,
+  static int pviterbi_free(plocal_store_t **v, int n, int len_y,
 			   int max_offset_x, int max_offset_y);
 
   static void init_phi(plocal_store_t * pv, ghmm_dpseq * X, ghmm_dpseq * Y);
@@ -98,14 +99,14 @@ typedef struct plocal_store_t {
   static void push_back_phi(plocal_store_t * pv, int length_y);
 
   static void set_psi(plocal_store_t * pv, int x, int y, int ghmm_dstate,
-		      int from_state);
+		      int in_index);
 
 
 /*============================================================================*/
 static plocal_store_t *pviterbi_alloc(ghmm_dpmodel *mo, int len_x, int len_y) {
 #define CUR_PROC "pviterbi_alloc"
   plocal_store_t* v = NULL;
-  int i, j;
+  int i, j, max_in_states = 0;
   ARRAY_CALLOC (v, 1);
   v->mo = mo;
   v->len_y = len_y;
@@ -116,6 +117,8 @@ static plocal_store_t *pviterbi_alloc(ghmm_dpmodel *mo, int len_x, int len_y) {
   for (j = 0; j < mo->N; j++){ 
     /* second index: source state */
     ARRAY_CALLOC (v->log_in_a[j], mo->s[j].in_states);
+    if (mo->s[j].in_states > max_in_states)
+      max_in_states = mo->s[j].in_states;
     for (i=0; i<mo->s[j].in_states; i++) {
       /* third index: transition classes of source state */
       ARRAY_CALLOC (v->log_in_a[j][i], mo->s[mo->s[j].in_id[i]].kclasses);
@@ -129,7 +132,8 @@ static plocal_store_t *pviterbi_alloc(ghmm_dpmodel *mo, int len_x, int len_y) {
   v->phi = ighmm_cmatrix_3d_alloc(mo->max_offset_x + 1, len_y + mo->max_offset_y + 1, mo->N);
   if (!(v->phi)) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
   ARRAY_CALLOC (v->phi_new, mo->N);
-  v->psi = ighmm_dmatrix_3d_alloc(len_x + mo->max_offset_x + 1, len_y + mo->max_offset_y + 1, mo->N);
+  v->psi = ighmm_psi_alloc((len_x + mo->max_offset_x + 1)
+			   * (len_y + mo->max_offset_y + 1), mo->N, max_in_states);
   if (!(v->psi)) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
 
   v->topo_order_length = 0;
@@ -137,14 +141,14 @@ static plocal_store_t *pviterbi_alloc(ghmm_dpmodel *mo, int len_x, int len_y) {
 
   return(v);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-  pviterbi_free((&v), mo->N, len_x, len_y, mo->max_offset_x, mo->max_offset_y);
+  pviterbi_free((&v), mo->N, len_y, mo->max_offset_x, mo->max_offset_y);
   return(NULL);
 #undef CUR_PROC
 } /* viterbi_alloc */
 
 
 /*============================================================================*/
-static int pviterbi_free(plocal_store_t **v, int n, int len_x, int len_y,
+static int pviterbi_free(plocal_store_t **v, int n, int len_y,
 			 int max_offset_x, int max_offset_y) {
 #define CUR_PROC "pviterbi_free"
   int i, j;
@@ -162,7 +166,7 @@ static int pviterbi_free(plocal_store_t **v, int n, int len_x, int len_y,
   ighmm_cmatrix_3d_free( &((*v)->phi), max_offset_x + 1, 
 		   len_y + max_offset_y + 1);
   m_free((*v)->phi_new);
-  ighmm_dmatrix_3d_free( &((*v)->psi), len_x + max_offset_x + 1, len_y + max_offset_y + 1);
+  ighmm_psi_free(&((*v)->psi));
   m_free((*v)->topo_order);
   (*v)->mo = NULL;
   m_free(*v);
@@ -353,7 +357,7 @@ static void init_phi(plocal_store_t * pv, ghmm_dpseq * X, ghmm_dpseq * Y) {
 		value = previous_prob + log_in_a_ij;
 		if (value > max_value) {
 		  max_value = value;
-		  set_psi(pv, u, v, i, mo->s[i].in_id[j]);
+		  set_psi(pv, u, v, i, j);
 		}
 	      }
 	      else
@@ -480,20 +484,23 @@ static void push_back_phi(plocal_store_t * pv, int length_y){
 }
 
 /*============================================================================*/
-static void set_psi(plocal_store_t * pv, int x, int y, int state, int from_state){
+static void set_psi(plocal_store_t * pv, int x, int y, int state, int in_index){
   /* shift by max_offsets for negative indices */
 #ifdef DEBUG
   if (x > pv->len_x || y > pv->len_y || state > pv->mo->N || 
       x < - pv->mo->max_offset_x || y < - pv->mo->max_offset_y)
     fprintf(stderr, "set_psi: out of bounds %i %i %i %i\n", 
 	    x + pv->mo->max_offset_x, y + pv->mo->max_offset_y, 
-	    state, from_state);
+	    state, in_index);
 #endif
-  pv->psi[x + pv->mo->max_offset_x][y + pv->mo->max_offset_y][state] = from_state;
+  ighmm_psi_set(pv->psi, (x + pv->mo->max_offset_x)
+		* (pv->len_y + pv->mo->max_offset_y + 1)
+		+ y + pv->mo->max_offset_y, state, in_index);
 }
 
 /*============================================================================*/
 static int get_psi(plocal_store_t * pv, int x, int y, int state) {
+  int in_index;
   /* shift by max_offsets for negative indices*/
 #ifdef DEBUG
   if (x > pv->len_x || y > pv->len_y || state > pv->mo->N || 
@@ -502,7 +509,11 @@ static int get_psi(plocal_store_t * pv, int x, int y, int state) {
 	    x + pv->mo->max_offset_x, y + pv->mo->max_offset_y, 
 	    state);
 #endif
-  return pv->psi[x + pv->mo->max_offset_x][y + pv->mo->max_offset_y][state];
+  in_index = ighmm_psi_get(pv->psi, (x + pv->mo->max_offset_x)
+			   * (pv->len_y + pv->mo->max_offset_y + 1)
+			   + y + pv->mo->max_offset_y, state);
+  /* translate back to the id of the predecessor */
+  return (in_index < 0) ? -1 : pv->mo->s[state].in_id[in_index];
 }
 
 /*============================================================================*/
@@ -513,7 +524,7 @@ int *ghmm_dpmodel_viterbi_test(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
   /*ghmm_dpmodel_print(mo);*/
   pv = pviterbi_alloc(mo, X->length, Y->length);
   printf("try free within pviterbi_test\n");
-  pviterbi_free(&pv, mo->N, X->length, Y->length, mo->max_offset_x , 
+  pviterbi_free(&pv, mo->N, Y->length, mo->max_offset_x , 
 		mo->max_offset_y);
   printf("OK\n");
   return NULL;
@@ -587,7 +598,7 @@ int *ghmm_dpmodel_viterbi_variable_tb(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dps
 	      value = previous_prob + log_in_a_ij;
 	      if (value > max_value) {
 		max_value = value;
-		set_psi(pv, u, v, i, mo->s[i].in_id[j]);
+		set_psi(pv, u, v, i, j);
 	      }
 	    }
 	    else
@@ -711,8 +722,9 @@ int *ghmm_dpmodel_viterbi_variable_tb(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dps
 	 current_state_index, u, v, get_psi(pv, u, v, current_state_index)); */
       /* update the current state */
       current_state_index = get_psi(pv, u, v, current_state_index);
-      if (current_state_index != -1)
-	ighmm_list_insert(state_list, current_state_index);
+      if (current_state_index == -1)
+	break;
+      ighmm_list_insert(state_list, current_state_index);
       /* move in the alignment matrix */
       u -= off_x;
       v -= off_y; 
@@ -723,7 +735,7 @@ int *ghmm_dpmodel_viterbi_variable_tb(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dps
   }
   
   /* Free the memory space */
-  pviterbi_free(&pv, mo->N, X->length, Y->length, mo->max_offset_x , 
+  pviterbi_free(&pv, mo->N, Y->length, mo->max_offset_x , 
 		mo->max_offset_y);
   /* printf("After traceback: last state = %i\n", state_list->last->val); */
   state_seq = ighmm_list_to_array(state_list);
@@ -738,7 +750,7 @@ int *ghmm_dpmodel_viterbi_variable_tb(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dps
   return (state_seq);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   /* Free the memory space */
-  pviterbi_free(&pv, mo->N, X->length, Y->length, mo->max_offset_x, 
+  pviterbi_free(&pv, mo->N, Y->length, mo->max_offset_x, 
 		mo->max_offset_y);
   m_free(state_seq);
   ighmm_list_free(state_list);
@@ -747,6 +759,272 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 } /* viterbi */
   
   
+/*============================================================================*/
+/* Band constrained anti-diagonal (wavefront) traversal.
+
+   The value of state i in cell (u, v) only depends on the cell
+   (u - offset_x, v - offset_y) with offset_x + offset_y >= 1, that is on
+   cells of earlier anti-diagonals u + v. All cells of one anti-diagonal are
+   independent and are computed in one sweep (in parallel when compiled with
+   OpenMP), so phi only has to hold the last max_offset_x + max_offset_y + 1
+   anti-diagonals. The band restricts the lattice to |v - c(u)| <= band_width
+   where c is the line from (-1, -1) to (len_x - 1, len_y - 1); psi only
+   keeps the cells inside the band. */
+
+/* minimal number of cells on an anti-diagonal to split it between threads */
+#define PVITERBI_OMP_MIN_CELLS 64
+
+typedef struct pband_store_t {
+  /** precomputed log transitions and emissions **/
+  plocal_store_t * pv;
+  /** number of anti-diagonals held in phi **/
+  int n_diag;
+  /** ring of anti-diagonals: phi[(u + v + max_offset_y + 1) % n_diag][u + 1] **/
+  double *** phi;
+  /** first and last v inside the band for the row u, indexed by u + 1 **/
+  int * lo;
+  int * hi;
+  /** compact traceback matrix of the row u: psi[u + 1], row v - lo[u + 1] **/
+  ighmm_psi_matrix ** psi;
+  int len_x;
+  int len_y;
+} pband_store_t;
+
+static int pband_free(pband_store_t ** ps);
+
+/*============================================================================*/
+static pband_store_t * pband_alloc(ghmm_dpmodel * mo, int len_x, int len_y,
+				   int band_width) {
+#define CUR_PROC "pband_alloc"
+  pband_store_t * ps = NULL;
+  int u, c, j, max_in_states = 0;
+
+  ARRAY_CALLOC (ps, 1);
+  ps->len_x = len_x;
+  ps->len_y = len_y;
+  /* only the precomputed logarithms of the local store are used */
+  ps->pv = pviterbi_alloc(mo, 0, 0);
+  if (!ps->pv) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
+  ps->n_diag = mo->max_offset_x + mo->max_offset_y + 1;
+  ps->phi = ighmm_cmatrix_3d_alloc(ps->n_diag, len_x + 1, mo->N);
+  if (!ps->phi) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
+  ARRAY_CALLOC (ps->lo, len_x + 1);
+  ARRAY_CALLOC (ps->hi, len_x + 1);
+  ARRAY_CALLOC (ps->psi, len_x + 1);
+  for (j = 0; j < mo->N; j++)
+    if (mo->s[j].in_states > max_in_states)
+      max_in_states = mo->s[j].in_states;
+  for (u = -1; u < len_x; u++) {
+    if (band_width < 0) {
+      ps->lo[u + 1] = -mo->max_offset_y;
+      ps->hi[u + 1] = len_y - 1;
+    }
+    else {
+      c = (int)floor((double)(u + 1) * len_y / len_x) - 1;
+      ps->lo[u + 1] = m_max(-mo->max_offset_y, c - band_width);
+      ps->hi[u + 1] = m_min(len_y - 1, c + band_width);
+    }
+    ps->psi[u + 1] = ighmm_psi_alloc(ps->hi[u + 1] - ps->lo[u + 1] + 1,
+				     mo->N, max_in_states);
+    if (!ps->psi[u + 1]) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
+  }
+  return ps;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  pband_free(&ps);
+  return NULL;
+#undef CUR_PROC
+} /* pband_alloc */
+
+/*============================================================================*/
+static int pband_free(pband_store_t ** ps) {
+#define CUR_PROC "pband_free"
+  int u;
+  ghmm_dpmodel * mo;
+  mes_check_ptr(ps, return(-1));
+  if (!*ps) return(0);
+  if ((*ps)->pv) {
+    mo = (*ps)->pv->mo;
+    if ((*ps)->phi)
+      ighmm_cmatrix_3d_free(&((*ps)->phi), (*ps)->n_diag, (*ps)->len_x + 1);
+    pviterbi_free(&((*ps)->pv), mo->N, 0, mo->max_offset_x, mo->max_offset_y);
+  }
+  if ((*ps)->psi) {
+    for (u = 0; u < (*ps)->len_x + 1; u++)
+      ighmm_psi_free(&((*ps)->psi[u]));
+    m_free((*ps)->psi);
+  }
+  if ((*ps)->lo)
+    m_free((*ps)->lo);
+  if ((*ps)->hi)
+    m_free((*ps)->hi);
+  m_free(*ps);
+  return(0);
+#undef CUR_PROC
+} /* pband_free */
+
+/*============================================================================*/
+static int pband_contains(pband_store_t * ps, int u, int v) {
+  return (u >= -1 && u < ps->len_x
+	  && v >= ps->lo[u + 1] && v <= ps->hi[u + 1]);
+}
+
+/*============================================================================*/
+/* cells outside of the band (or the lattice) are never reached */
+static double pband_get_phi(pband_store_t * ps, int u, int v, int state) {
+  if (!pband_contains(ps, u, v))
+    return 1;
+  return ps->phi[(u + v + ps->pv->mo->max_offset_y + 1) % ps->n_diag][u + 1][state];
+}
+
+/*============================================================================*/
+static int pband_get_psi(pband_store_t * ps, int u, int v, int state) {
+  int in_index;
+  if (!pband_contains(ps, u, v))
+    return -1;
+  in_index = ighmm_psi_get(ps->psi[u + 1], v - ps->lo[u + 1], state);
+  return (in_index < 0) ? -1 : ps->pv->mo->s[state].in_id[in_index];
+}
+
+/*============================================================================*/
+/* computes all states of the cell (u, v), this is the recurrence of
+   init_phi and ghmm_dpmodel_viterbi_variable_tb for a single cell */
+static void pband_cell(pband_store_t * ps, ghmm_dpseq * X, ghmm_dpseq * Y,
+		       int u, int v) {
+  ghmm_dpmodel * mo = ps->pv->mo;
+  double * phi = ps->phi[(u + v + mo->max_offset_y + 1) % ps->n_diag][u + 1];
+  int i, j, max_j;
+  double value, max_value, previous_prob, log_in_a_ij, log_b_i;
+
+  /* psi is allocated without predecessors and every cell is visited once */
+  for (i = 0; i < mo->N; i++)
+    phi[i] = +1;
+  for (i = 0; i < mo->N; i++) {
+    if ((mo->model_type & GHMM_kSilentStates) && mo->silent[i])
+      continue;
+    max_value = -DBL_MAX;
+    max_j = -1;
+    for (j = 0; j < mo->s[i].in_states; j++) {
+      previous_prob = pband_get_phi(ps, u - mo->s[i].offset_x,
+				    v - mo->s[i].offset_y, mo->s[i].in_id[j]);
+      log_in_a_ij = sget_log_in_a(ps->pv, i, j, X, Y, u, v);
+      if (previous_prob != +1 && log_in_a_ij != +1) {
+	value = previous_prob + log_in_a_ij;
+	if (value > max_value) {
+	  max_value = value;
+	  max_j = j;
+	}
+      }
+    }
+    if (max_j >= 0)
+      ighmm_psi_set(ps->psi[u + 1], v - ps->lo[u + 1], i, max_j);
+    log_b_i = log_b(ps->pv, i, ghmm_dpmodel_pair(ghmm_dpseq_get_char(X, mo->s[i].alphabet, u), 
+					 ghmm_dpseq_get_char(Y, mo->s[i].alphabet, v),
+					 mo->size_of_alphabet[mo->s[i].alphabet],
+					 mo->s[i].offset_x, mo->s[i].offset_y));
+    if (log_b_i == +1)
+      continue;
+    /* initial states replace the maximum by their initial probability */
+    if (mo->s[i].log_pi != 1 && mo->s[i].offset_x - 1 == u
+	&& mo->s[i].offset_y - 1 == v)
+      phi[i] = mo->s[i].log_pi + log_b_i;
+    else if (max_value != -DBL_MAX)
+      phi[i] = max_value + log_b_i;
+  }
+}
+
+/*============================================================================*/
+int *ghmm_dpmodel_viterbi_banded(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
+				 double *log_p, int *path_length, int band_width) {
+#define CUR_PROC "ghmm_dpmodel_viterbi_banded"
+  int d, u, v, j, off_x, off_y, u_first, u_last, current_state_index;
+  double max_value;
+  pband_store_t *ps = NULL;
+  int *state_seq = NULL;
+  i_list * state_list = NULL;
+
+  for (j = 0; j < mo->N; j++)
+    if (mo->s[j].offset_x + mo->s[j].offset_y == 0
+	&& !((mo->model_type & GHMM_kSilentStates) && mo->silent[j])) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "state %d does not consume any character", j);
+      goto STOP;
+    }
+  if (X->length < 1 || Y->length < 1) {
+    GHMM_LOG(LERROR, "both sequences must not be empty");
+    goto STOP;
+  }
+
+  ps = pband_alloc(mo, X->length, Y->length, band_width);
+  if (!ps) {GHMM_LOG_QUEUED(LCONVERTED); goto STOP;}
+  pviterbi_precompute(mo, ps->pv);
+
+  /* sweep the anti-diagonals d = u + v, [u_first, u_last] is the part of
+     the diagonal inside of the band. u + lo(u) and u + hi(u) are strictly
+     increasing in u, so both bounds only move forward. */
+  u_first = -1;
+  u_last = -2;
+  for (d = -1 - mo->max_offset_y; d <= X->length + Y->length - 2; d++) {
+    while (u_last + 1 < X->length && u_last + 1 + ps->lo[u_last + 2] <= d)
+      u_last++;
+    while (u_first < X->length && u_first + ps->hi[u_first + 1] < d)
+      u_first++;
+#ifdef _OPENMP
+#pragma omp parallel for if (u_last - u_first >= PVITERBI_OMP_MIN_CELLS)
+#endif
+    for (u = u_first; u <= u_last; u++)
+      pband_cell(ps, X, Y, u, d - u);
+  }
+
+  /* Termination */
+  state_list = ighmm_list_init_list();
+  ighmm_list_append(state_list, -1);
+  max_value = -DBL_MAX;
+  u = X->length - 1;
+  v = Y->length - 1;
+  for (j = 0; j < mo->N; j++) {
+    if (pband_get_phi(ps, u, v, j) != +1 && pband_get_phi(ps, u, v, j) > max_value) {
+      max_value = pband_get_phi(ps, u, v, j);
+      state_list->last->val = j;
+    }
+  }
+  if (max_value == -DBL_MAX) {
+    /* Sequence can't be generated from the model (within the band)! */
+    *log_p = +1;
+  }
+  else {
+    *log_p = max_value;
+    current_state_index = state_list->first->val;
+    off_x = mo->s[current_state_index].offset_x;
+    off_y = mo->s[current_state_index].offset_y;
+    while (u - off_x >= -1 && v - off_y >= -1 && current_state_index != -1) {
+      current_state_index = pband_get_psi(ps, u, v, current_state_index);
+      if (current_state_index == -1)
+	break;
+      ighmm_list_insert(state_list, current_state_index);
+      u -= off_x;
+      v -= off_y;
+      off_x = mo->s[current_state_index].offset_x;
+      off_y = mo->s[current_state_index].offset_y;
+    }
+  }
+
+  pband_free(&ps);
+  state_seq = ighmm_list_to_array(state_list);
+  *path_length = state_list->length;
+  ighmm_list_free(state_list);
+  m_free(state_list);
+  return state_seq;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  pband_free(&ps);
+  return NULL;
+#undef CUR_PROC
+} /* ghmm_dpmodel_viterbi_banded */
+
+/*============================================================================*/
+int *ghmm_dpmodel_viterbi_wavefront(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
+				    double *log_p, int *path_length) {
+  return ghmm_dpmodel_viterbi_banded(mo, X, Y, log_p, path_length, -1);
+}
+
 /*============================================================================*/
 double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
 			    int *state_seq, int state_seq_len) {
@@ -768,7 +1046,7 @@ double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq *
     /* log_p += log(mo->s[i].pi); */
     log_p += mo->s[i].log_pi;
     if (log_p == 1.0) {
-      pviterbi_free(&pv, mo->N, 0, 0, mo->max_offset_x, mo->max_offset_y);
+      pviterbi_free(&pv, mo->N, 0, mo->max_offset_x, mo->max_offset_y);
       fprintf(stderr, "the initial probability of state %i is zero\n", i);
       return 1.0;/* the initial prob is zero */
     }
@@ -781,7 +1059,7 @@ double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq *
 				mo->size_of_alphabet[mo->s[i].alphabet],
 				mo->s[i].offset_x, mo->s[i].offset_y));
     if (log_b_i == 1.0) { /* chars cant be emitted */
-      pviterbi_free(&pv, mo->N, 0, 0, mo->max_offset_x, mo->max_offset_y);
+      pviterbi_free(&pv, mo->N, 0, mo->max_offset_x, mo->max_offset_y);
       fprintf(stderr, "characters (%i, %i) at position (%i, %i) cannot be emitted by state %i (t=%i)\n",
 	      ghmm_dpseq_get_char(X, mo->s[i].alphabet, u),
 	      ghmm_dpseq_get_char(Y, mo->s[i].alphabet, v), u, v, i, t);
@@ -790,7 +1068,7 @@ double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq *
     log_p += log_b_i;
   }
   else { /* there is no path.. */
-    pviterbi_free(&pv, mo->N, 0, 0, mo->max_offset_x, mo->max_offset_y);
+    pviterbi_free(&pv, mo->N, 0, mo->max_offset_x, mo->max_offset_y);
     fprintf(stderr, "No path given!\n");
     return 1.0;
   }
@@ -802,7 +1080,7 @@ double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq *
     u += mo->s[i].offset_x;
     v += mo->s[i].offset_y;
     if (u >= X->length || v >= Y->length) { /* path consumes too many chars */
-      pviterbi_free(&pv, mo->N, 0, 0, mo->max_offset_x, mo->max_offset_y);
+      pviterbi_free(&pv, mo->N, 0, mo->max_offset_x, mo->max_offset_y);
       fprintf(stderr, "path consumes too many chars\n");
       return 1.0;
     }
@@ -815,7 +1093,7 @@ double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq *
       }
     }
     if (log_in_a == 1.0) {
-      pviterbi_free(&pv, mo->N, 0, 0, mo->max_offset_x, mo->max_offset_y);
+      pviterbi_free(&pv, mo->N, 0, mo->max_offset_x, mo->max_offset_y);
       fprintf(stderr, "transition (%i -> %i) at t=%i not possible\n", j, i,t); 
       return 1.0; /* transition not possible */
     }
@@ -825,7 +1103,7 @@ double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq *
 				mo->size_of_alphabet[mo->s[i].alphabet],
 				mo->s[i].offset_x, mo->s[i].offset_y));
     if (log_b_i == 1.0) {
-      pviterbi_free(&pv, mo->N, 0, 0, mo->max_offset_x, mo->max_offset_y);
+      pviterbi_free(&pv, mo->N, 0, mo->max_offset_x, mo->max_offset_y);
       fprintf(stderr, "characters (%i, %i) at position (%i, %i) cannot be emitted by state %i (t=%i)\n",
 	      ghmm_dpseq_get_char(X, mo->s[i].alphabet, u),
 	      ghmm_dpseq_get_char(Y, mo->s[i].alphabet, v), u, v, i, t);
@@ -833,7 +1111,7 @@ double ghmm_dpmodel_viterbi_logp(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq *
     }
     log_p += log_in_a + log_b_i;
   }
-  pviterbi_free(&pv, mo->N, 0, 0, mo->max_offset_x, 
+  pviterbi_free(&pv, mo->N, 0, mo->max_offset_x, 
 		mo->max_offset_y);
   /* check if all of the sequences has been consumed */
   if (u != X->length - 1 && v != Y->length - 1) {
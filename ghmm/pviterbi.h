@@ -61,6 +61,36 @@ int *ghmm_dpmodel_viterbi_variable_tb(ghmm_dpmodel *mo, ghmm_dpseq * X,
                                       int *path_length,
                                       int start_traceback_with);
 
+/**
+  Band constrained Viterbi algorithm. Only the cells within band_width of
+  the diagonal from the start to the end of both sequences are computed,
+  which reduces time and memory from O(len_x * len_y * N) to
+  O(len_x * band_width * N). The lattice is traversed by anti-diagonals,
+  the cells of one anti-diagonal are computed in parallel if the library
+  was compiled with OpenMP (the class change functions must be reentrant
+  then). The result equals the one of ghmm_dpmodel_viterbi if the optimal
+  path lies inside the band.
+  @return the Viterbi path or NULL on error
+  @param mo           pair HMM
+  @param X            first sequence
+  @param Y            second sequence
+  @param log_p        log probability of the path (+1 if there is none)
+  @param path_length  length of the returned path
+  @param band_width   maximal distance of a cell to the diagonal, a negative
+                      value disables the band
+  */
+int *ghmm_dpmodel_viterbi_banded(ghmm_dpmodel *mo, ghmm_dpseq * X,
+                                 ghmm_dpseq * Y, double *log_p,
+                                 int *path_length, int band_width);
+
+/**
+  Viterbi algorithm traversing the full lattice by anti-diagonals
+  (wavefront). Same as ghmm_dpmodel_viterbi_banded without band.
+  */
+int *ghmm_dpmodel_viterbi_wavefront(ghmm_dpmodel *mo, ghmm_dpseq * X,
+                                    ghmm_dpseq * Y, double *log_p,
+                                    int *path_length);
+
 int *ghmm_dpmodel_viterbi_test(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
 			  double *log_p, int *path_length);
 
@@ -44,6 +44,7 @@
 #include <math.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ghmm.h"
 #include "mprintf.h"
@@ -124,7 +125,11 @@ static cell * pviterbi_propagate_step (ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dp
 static int * pviterbi_propagate_recursion(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
 				   double *log_p, int *path_length, cell *start,
 				   cell *stop, double max_size,
-				   plocal_propagate_store_t * pv);
+				   plocal_propagate_store_t * pv, int parallel);
+
+static int * pviterbi_propagate_task(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
+				     double *log_p, int *path_length, cell *start,
+				     cell *stop, double max_size);
 
 
 /*------------        Here comes the Propagate stuff          ------------- */
@@ -428,7 +433,7 @@ int * ghmm_dpmodel_viterbi_propagate (ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dps
      printf("step log for the whole sequence: %f\n", step_log); */
   return pviterbi_propagate_recursion(mo, X, Y, log_p, path_length, 
 				      NULL, NULL,
-				      max_size, pv);
+				      max_size, pv, 0);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   /* Free the memory space */
   pviterbi_propagate_free(&pv, mo->N, mo->max_offset_x, mo->max_offset_y, Y->length);
@@ -436,12 +441,65 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 #undef CUR_PROC
 }
 
+/*============================================================================*/
+int * ghmm_dpmodel_viterbi_propagate_parallel (ghmm_dpmodel *mo, ghmm_dpseq * X,
+					       ghmm_dpseq * Y, double *log_p,
+					       int *path_length, double max_size) {
+  int * path_seq = NULL;
+  /* the segments become tasks of the OpenMP runtime, idle threads take
+     them from the task queues of the others */
+#ifdef _OPENMP
+#pragma omp parallel
+#pragma omp single
+#endif
+  path_seq = pviterbi_propagate_task(mo, X, Y, log_p, path_length, NULL, NULL,
+				     max_size);
+  return path_seq;
+}
+
+/*============================================================================*/
+/* Solves the segment start -> stop on a private copy of the model and a
+   private local store. The recursion temporarily changes the initial
+   probabilities of the model, so concurrent segments must not share it. */
+static int * pviterbi_propagate_task (ghmm_dpmodel *mo, ghmm_dpseq * X,
+				      ghmm_dpseq * Y, double *log_p,
+				      int *path_length, cell *start,
+				      cell *stop, double max_size) {
+#define CUR_PROC "pviterbi_propagate_task"
+  ghmm_dpmodel * task_mo = NULL;
+  plocal_propagate_store_t * pv = NULL;
+  int * path_seq = NULL;
+
+  ARRAY_MALLOC (task_mo, 1);
+  *task_mo = *mo;
+  task_mo->s = NULL;
+  ARRAY_MALLOC (task_mo->s, mo->N);
+  m_memcpy (task_mo->s, mo->s, mo->N);
+
+  pv = pviterbi_propagate_alloc(task_mo, Y->length);
+  if (!pv) { GHMM_LOG_QUEUED(LCONVERTED); goto STOP; }
+  pviterbi_prop_precompute(task_mo, pv);
+
+  path_seq = pviterbi_propagate_recursion(task_mo, X, Y, log_p, path_length,
+					  start, stop, max_size, pv, 1);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  pviterbi_propagate_free(&pv, mo->N, mo->max_offset_x, mo->max_offset_y, Y->length);
+  if (task_mo) {
+    if (task_mo->s)
+      m_free(task_mo->s);
+    m_free(task_mo);
+  }
+  return path_seq;
+#undef CUR_PROC
+}
+
 /*============================================================================*/
 static int * pviterbi_propagate_recursion (ghmm_dpmodel *mo, ghmm_dpseq * X,
 					   ghmm_dpseq * Y, double *log_p,
 					   int *path_length, cell *start,
 					   cell *stop, double max_size,
-					   plocal_propagate_store_t * pv) {
+					   plocal_propagate_store_t * pv,
+					   int parallel) {
 #define CUR_PROC "pviterbi_propagate_recursion"
   /* Divide and conquer algorithm to reduce the memory requirement */
   
@@ -517,6 +575,8 @@ static int * pviterbi_propagate_recursion (ghmm_dpmodel *mo, ghmm_dpseq * X,
       fprintf(stderr, "Problem with slice x[%i:%i], y[%i:%i]\n", 
 	      start_x, stop_x, start_y, stop_y);
     }
+    ghmm_dpseq_free(tractable_X);
+    ghmm_dpseq_free(tractable_Y);
     return path_seq;
   }
   else {
@@ -570,16 +630,38 @@ static int * pviterbi_propagate_recursion (ghmm_dpmodel *mo, ghmm_dpseq * X,
        X[len/2+1:len] vs Y[m+1:len] */
     length1 = 0;
     log_p1 = 0;
-    path1 = pviterbi_propagate_recursion(mo, X, Y, &log_p1, &length1, 
-					       start, middle,
-					       max_size, pv);
     length2 = 0;
     log_p2 = 0;
-    path2 = pviterbi_propagate_recursion(mo, X, Y, &log_p2, &length2, 
-					       middle, stop,
-					       max_size, pv);
+    if (parallel) {
+      /* the two segments are independent, each one gets its own store */
+#ifdef _OPENMP
+#pragma omp task shared(path1, log_p1, length1)
+#endif
+      path1 = pviterbi_propagate_task(mo, X, Y, &log_p1, &length1,
+				      start, middle, max_size);
+#ifdef _OPENMP
+#pragma omp task shared(path2, log_p2, length2)
+#endif
+      path2 = pviterbi_propagate_task(mo, X, Y, &log_p2, &length2,
+				      middle, stop, max_size);
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+    }
+    else {
+      path1 = pviterbi_propagate_recursion(mo, X, Y, &log_p1, &length1, 
+					   start, middle,
+					   max_size, pv, 0);
+      path2 = pviterbi_propagate_recursion(mo, X, Y, &log_p2, &length2, 
+					   middle, stop,
+					   max_size, pv, 0);
+    }
     /* check the paths */
-    if (log_p1 == 1 || log_p2 == 1) {
+    if (!path1 || !path2 || log_p1 == 1 || log_p2 == 1) {
+      if (path1)
+	m_free(path1);
+      if (path2)
+	m_free(path2);
       ARRAY_CALLOC (path_seq, 1);
       path_seq[0] = -1;
       *path_length = 1;
@@ -624,6 +706,8 @@ static int * pviterbi_propagate_recursion (ghmm_dpmodel *mo, ghmm_dpseq * X,
       path_seq[i] = path1[i];
     for (i=0; i<length2; i++)
       path_seq[length1 + i] = path2[i];
+    m_free(path1);
+    m_free(path2);
     return path_seq;
   }
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
@@ -1046,7 +1130,7 @@ int * ghmm_dpmodel_viterbi_propagate_segment (ghmm_dpmodel *mo, ghmm_dpseq * X,
 
   /* Launch the recursion */
   path_seq = pviterbi_propagate_recursion (mo, X, Y, log_p, path_length,
-					   start, stop, max_size, pv);
+					   start, stop, max_size, pv, 0);
 
   pviterbi_propagate_free (&pv, mo->N, mo->max_offset_x, mo->max_offset_y, Y->length);
 
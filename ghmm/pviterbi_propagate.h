@@ -49,6 +49,17 @@ int * ghmm_dpmodel_viterbi_propagate(ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpse
 			 double *log_p, int *path_length, double max_size);
 
 
+/**
+   Same as ghmm_dpmodel_viterbi_propagate, but the two independent segments
+   of every split are solved as parallel tasks if the library was compiled
+   with OpenMP. Segments with less than max_size cells are solved by the
+   serial ghmm_dpmodel_viterbi. Every task works on a private copy of the
+   states, the class change functions must be reentrant.
+ */
+int * ghmm_dpmodel_viterbi_propagate_parallel(ghmm_dpmodel *mo, ghmm_dpseq * X,
+                                              ghmm_dpseq * Y, double *log_p,
+                                              int *path_length, double max_size);
+
 int * ghmm_dpmodel_viterbi_propagate_segment (ghmm_dpmodel *mo, ghmm_dpseq * X, ghmm_dpseq * Y,
 				  double *log_p, int *path_length,
 				  double max_size, int start_x, int start_y,
@@ -78,6 +78,12 @@ static double ighmm_erfc (double x);
 static double pdf_stdnormal[PDFLEN];
 static int pdf_stdnormal_exists = 0;
 
+#ifdef HAVE_LIBPTHREAD
+/* the tables are initialised lazily, once, from any thread */
+static pthread_once_t pdf_stdnormal_once = PTHREAD_ONCE_INIT;
+static pthread_once_t x_PHI_1_once = PTHREAD_ONCE_INIT;
+#endif /* HAVE_LIBPTHREAD */
+
 /* A list of already calulated values PHI of the Gauss distribution is
    read in, x in [-9.999, 0] */
 #define X_STEP_PHI 0.001        /* step size */
@@ -124,24 +130,31 @@ double ighmm_rand_get_PHI (double x)
 
 
 /*============================================================================*/
+static void randvar_init_xPHIless1 (void)
+{
+  double low = 0, up = 100, half;
+
+  while (up - low > 0.001) {
+    half = (low + up) / 2.0;
+    if (ighmm_rand_get_PHI (half) < 1.0)
+      low = half;
+    else
+      up = half;
+  }
+  x_PHI_1 = low;
+}
+
 /* When is PHI[x,0,1] == 1? */
 double ighmm_rand_get_xPHIless1 ()
 {
 # define CUR_PROC "ighmm_rand_get_xPHIless1"
 
-  if (x_PHI_1 == -1) {
-    double low, up, half;
-    low = 0;
-    up = 100;
-    while (up - low > 0.001) {
-      half = (low + up) / 2.0;
-      if (ighmm_rand_get_PHI (half) < 1.0)
-        low = half;
-      else
-        up = half;
-    }
-    x_PHI_1 = low;
-  }
+#ifdef HAVE_LIBPTHREAD
+  pthread_once (&x_PHI_1_once, randvar_init_xPHIless1);
+#else
+  if (x_PHI_1 == -1)
+    randvar_init_xPHIless1 ();
+#endif /* HAVE_LIBPTHREAD */
   return (x_PHI_1);
 
 # undef CUR_PROC
@@ -383,7 +396,7 @@ STOP:
 /* special ghmm_cmodel pdf need it: smo->density==normal_approx: */
 /* generates a table of of aequidistant samples of gaussian pdf */
 
-static int randvar_init_pdf_stdnormal ()
+static void randvar_init_pdf_stdnormal (void)
 {
 # define CUR_PROC "randvar_init_pdf_stdnormal"
   int i;
@@ -394,7 +407,6 @@ static int randvar_init_pdf_stdnormal ()
   }
   pdf_stdnormal_exists = 1;
   /* printf("pdf_stdnormal_exists = %d\n", pdf_stdnormal_exists); */
-  return (0);
 # undef CUR_PROC
 }                               /* randvar_init_pdf_stdnormal */
 
@@ -402,24 +414,19 @@ static int randvar_init_pdf_stdnormal ()
 double ighmm_rand_normal_density_approx (double x, double mean, double u)
 {
 # define CUR_PROC "ighmm_rand_normal_density_approx"
-#ifdef HAVE_LIBPTHREAD
-  static pthread_mutex_t lock;
-#endif /* HAVE_LIBPTHREAD */
   int i;
   double y, z, pdf_x;
   if (u <= 0.0) {
     GHMM_LOG(LCONVERTED, "u <= 0.0 not allowed\n");
     goto STOP;
   }
-  if (!pdf_stdnormal_exists) {
+  /* the clustering is parallel */
 #ifdef HAVE_LIBPTHREAD
-    pthread_mutex_lock (&lock); /* Put on a lock, because the clustering is parallel   */
-#endif /* HAVE_LIBPTHREAD */
+  pthread_once (&pdf_stdnormal_once, randvar_init_pdf_stdnormal);
+#else
+  if (!pdf_stdnormal_exists)
     randvar_init_pdf_stdnormal ();
-#ifdef HAVE_LIBPTHREAD
-    pthread_mutex_unlock (&lock);       /* Take the lock off */
 #endif /* HAVE_LIBPTHREAD */
-  }
   y = 1 / sqrt (u);
   z = fabs ((x - mean) * y);
   i = (int) (z * X_FAKT_PDF);
@@ -40,6 +40,8 @@
 
 #include <float.h>
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "ghmm.h"
 #include "mes.h"
@@ -50,14 +52,25 @@
 #include "foba.h"
 #include "ghmm_internals.h"
 
-typedef struct local_store_t {
-  double *pi_num;
+/* the Baum-Welch accumulators are the public sufficient statistics */
+typedef ghmm_dstats local_store_t;
+
+#define DSTATS_MAGIC      "GHMMDSTA"
+#define DSTATS_BYTE_ORDER 0x01020304u
+
+/* fixed part of a serialized ghmm_dstats, followed by out_states[N],
+   order[N] and data[size] */
+typedef struct {
+  char magic[8];
+  uint32_t byte_order;
+  int32_t N;
+  int32_t M;
+  int32_t valid;
+  int32_t size;
+  int32_t pad;
+  double log_p;
   double pi_denom;
-  double **a_num;
-  double *a_denom;
-  double **b_num;
-  double **b_denom;
-} local_store_t;
+} dstats_header;
 
 
 static double nologSum(double* vec, int len) {
@@ -72,35 +85,25 @@ static double nologSum(double* vec, int len) {
 
 
 /*----------------------------------------------------------------------------*/
-static int reestimate_free (local_store_t ** r, int N)
+static int reestimate_free (local_store_t ** r)
 {
 # define CUR_PROC "reestimate_free"
-  int i;
   mes_check_ptr (r, return (-1));
   if (!*r)
     return (0);
-  m_free ((*r)->pi_num);
-
-  if ((*r)->a_num){
-    for (i = 0; i < N; i++){
-      m_free ((*r)->a_num[i]);
-    }  
-  }  
-  m_free ((*r)->a_num);
-  m_free ((*r)->a_denom);
-
-  if ((*r)->b_num){
-    for (i = 0; i < N; i++){
-      m_free ((*r)->b_num[i]);
-    }
-  }
-  m_free ((*r)->b_num);
-  if ((*r)->b_denom){
-    for (i = 0; i < N; i++){
-      m_free ((*r)->b_denom[i]);
-    }  
-  }
-  m_free ((*r)->b_denom);
+  /* all accumulators live in data, the rest are row pointers */
+  if ((*r)->data)
+    m_free ((*r)->data);
+  if ((*r)->a_num)
+    m_free ((*r)->a_num);
+  if ((*r)->b_num)
+    m_free ((*r)->b_num);
+  if ((*r)->b_denom)
+    m_free ((*r)->b_denom);
+  if ((*r)->out_states)
+    m_free ((*r)->out_states);
+  if ((*r)->order)
+    m_free ((*r)->order);
 
   m_free (*r);
   return (0);
@@ -108,71 +111,144 @@ static int reestimate_free (local_store_t ** r, int N)
 }                               /* reestimate_free */
 
 /*----------------------------------------------------------------------------*/
-static local_store_t *reestimate_alloc (const ghmm_dmodel * mo)
+static int dstats_ipow (int x, int n)
 {
-# define CUR_PROC "reestimate_alloc"
+  int result = 1;
+  while (n-- > 0)
+    result *= x;
+  return result;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Allocates zeroed statistics for N states over M symbols. State i has
+   out_states[i] transitions and emissions of order order[i]. */
+static local_store_t *dstats_alloc (int N, int M, const int *out_states,
+                                    const int *order)
+{
+# define CUR_PROC "dstats_alloc"
   int i;
+  double *p;
   local_store_t *r = NULL;
-  ARRAY_CALLOC(r, 1);
 
-  ARRAY_CALLOC(r->pi_num, mo->N);
-  ARRAY_CALLOC(r->a_num, mo->N);
-  for (i=0; i<mo->N; i++)
-    ARRAY_CALLOC(r->a_num[i], mo->s[i].out_states);
-  ARRAY_CALLOC(r->a_denom, mo->N);
+  ARRAY_CALLOC (r, 1);
+  r->N = N;
+  r->M = M;
+  ARRAY_MALLOC (r->out_states, N);
+  ARRAY_MALLOC (r->order, N);
+  memcpy (r->out_states, out_states, N * sizeof (int));
+  memcpy (r->order, order, N * sizeof (int));
+
+  /* pi_num and a_denom, then per state a_num, b_num and b_denom */
+  r->size = 2 * N;
+  for (i = 0; i < N; i++)
+    r->size += out_states[i] + dstats_ipow (M, order[i] + 1)
+      + dstats_ipow (M, order[i]);
+
+  ARRAY_CALLOC (r->data, r->size);
+  ARRAY_MALLOC (r->a_num, N);
+  ARRAY_MALLOC (r->b_num, N);
+  ARRAY_MALLOC (r->b_denom, N);
+
+  p = r->data;
+  r->pi_num = p;
+  p += N;
+  r->a_denom = p;
+  p += N;
+  for (i = 0; i < N; i++) {
+    r->a_num[i] = p;
+    p += out_states[i];
+    r->b_num[i] = p;
+    p += dstats_ipow (M, order[i] + 1);
+    r->b_denom[i] = p;
+    p += dstats_ipow (M, order[i]);
+  }
 
-  ARRAY_MALLOC(r->b_num, mo->N);
-  ARRAY_MALLOC(r->b_denom, mo->N);
+  return (r);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  reestimate_free (&r);
+  return (NULL);
+# undef CUR_PROC
+}                               /* dstats_alloc */
 
-  if (mo->model_type & GHMM_kHigherOrderEmissions)
-    for (i=0; i<mo->N; i++) {
-      ARRAY_CALLOC(r->b_num[i], ghmm_ipow(mo, mo->M, mo->order[i] + 1));
-      ARRAY_CALLOC(r->b_denom[i], ghmm_ipow (mo, mo->M, mo->order[i]));
-    }
-  else
-    for (i=0; i<mo->N; i++) {
-      ARRAY_CALLOC(r->b_num[i], mo->M);
-      ARRAY_CALLOC(r->b_denom[i], 1);
+/*----------------------------------------------------------------------------*/
+/* checks the shape of serialized statistics before anything is allocated:
+   N states with out_states[i] transitions and emissions of order order[i]
+   over M symbols have to give exactly size accumulators */
+static int dstats_valid_shape (int N, int M, const int *out_states,
+                               const int *order, int size)
+{
+  int i, k;
+  size_t total = 2 * (size_t) N, b;
+
+  for (i = 0; i < N && total <= (size_t) size; i++) {
+    if (out_states[i] < 0 || out_states[i] > N || order[i] < 0
+        || order[i] > size)
+      return 0;
+    /* b = M^(order + 1), never larger than size */
+    for (b = 1, k = 0; k <= order[i]; k++) {
+      if (b > (size_t) size / M)
+        return 0;
+      b *= M;
     }
+    total += out_states[i] + b + b / M;
+  }
+  return total == (size_t) size;
+}
+
+/*----------------------------------------------------------------------------*/
+static local_store_t *reestimate_alloc (const ghmm_dmodel * mo)
+{
+# define CUR_PROC "reestimate_alloc"
+  int i;
+  int *out_states = NULL, *order = NULL;
+  local_store_t *r = NULL;
+
+  ARRAY_MALLOC (out_states, mo->N);
+  ARRAY_CALLOC (order, mo->N);
+  for (i = 0; i < mo->N; i++) {
+    out_states[i] = mo->s[i].out_states;
+    if (mo->model_type & GHMM_kHigherOrderEmissions)
+      order[i] = mo->order[i];
+  }
+  r = dstats_alloc (mo->N, mo->M, out_states, order);
 
-  return (r);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-  reestimate_free (&r, mo->N);
-  return (NULL);
+  if (out_states)
+    m_free (out_states);
+  if (order)
+    m_free (order);
+  return (r);
 # undef CUR_PROC
 }                               /* reestimate_alloc */
 
 /*----------------------------------------------------------------------------*/
-static int reestimate_init(local_store_t * r, const ghmm_dmodel * mo) {
+static int reestimate_init(local_store_t * r) {
 # define CUR_PROC "reestimate_init"
 
-  int i, j, m, size;
-
   r->pi_denom = 0.0;
-
-  for (i=0; i<mo->N; i++) {
-    r->pi_num[i] = 0.0;
-    r->a_denom[i] = 0.0;
-    for (j=0; j<mo->s[i].out_states; j++)
-      r->a_num[i][j] = 0.0;
-
-    if (mo->model_type & GHMM_kHigherOrderEmissions) {
-      size = ghmm_ipow(mo, mo->M, mo->order[i]);
-      for (m=0; m<size; m++)
-	r->b_denom[i][m] = 0.0;
-      size *= mo->M;
-      for (m=0; m<size; m++)
-	r->b_num[i][m] = 0.0;
-    } else {
-      r->b_denom[i][0] = 0.0;
-      for (m=0; m<mo->M; m++)
-	r->b_num[i][m] = 0.0;
-    }
-  }
+  r->log_p = 0.0;
+  r->valid = 0;
+  memset (r->data, 0, r->size * sizeof (double));
   return (0);
 # undef CUR_PROC
 }                               /* reestimate_init */
 
+/*----------------------------------------------------------------------------*/
+/* checks that the statistics have the shape of the model */
+static int dstats_matches (const local_store_t * r, const ghmm_dmodel * mo)
+{
+  int i, order;
+
+  if (r->N != mo->N || r->M != mo->M)
+    return 0;
+  for (i = 0; i < mo->N; i++) {
+    order = (mo->model_type & GHMM_kHigherOrderEmissions) ? mo->order[i] : 0;
+    if (r->out_states[i] != mo->s[i].out_states || r->order[i] != order)
+      return 0;
+  }
+  return 1;
+}
+
 /*----------------------------------------------------------------------------*/
 int ighmm_reestimate_alloc_matvek (double ***alpha, double ***beta, double **scale,
                              int T, int N)
@@ -423,21 +499,24 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 }                               /* reestimate_setlambda */
 
 /*----------------------------------------------------------------------------*/
-static int reestimate_one_step (ghmm_dmodel * mo, local_store_t * r, int seq_number,
-				int *seq_length, int **O, double *log_p,
-				double *seq_w)
+/* E-step: adds the expected counts of all sequences to r. Returns the number
+   of sequences the model can generate, their summed log likelihood in log_p,
+   or -1 on errors. */
+static int reestimate_accumulate (ghmm_dmodel * mo, local_store_t * r, int seq_number,
+                                  int *seq_length, int **O, double *log_p,
+                                  double *seq_w)
 {
-# define CUR_PROC "reestimate_one_step"
+# define CUR_PROC "reestimate_accumulate"
   int res = -1;
   int k, i, j, t, j_id, valid=0;
   int e_index;
-  int errors;
   double **alpha = NULL;
   double **beta = NULL;
   double *scale = NULL;
   int T_k=0;
   double gamma;
   double log_p_k;
+  int **ctx = NULL;
 
   /* first set maxorder to zero if model_type & kHigherOrderEmissions is FALSE 
 
@@ -465,13 +544,22 @@ static int reestimate_one_step (ghmm_dmodel * mo, local_store_t * r, int seq_num
 
     if (log_p_k != +1) {        /* O[k] can be generated */
       *log_p += log_p_k;
-      valid = 1;
+      valid++;
       
       if (ghmm_dmodel_backward (mo, O[k], T_k, beta, scale) == -1) {
         GHMM_LOG_QUEUED(LCONVERTED);
         goto FREE;
       }
 
+      /* emission indices of the sequence */
+      if (mo->model_type & GHMM_kHigherOrderEmissions) {
+        ctx = ghmm_dmodel_emission_context_alloc (mo, O[k], T_k);
+        if (!ctx) {
+          GHMM_LOG_QUEUED(LCONVERTED);
+          goto FREE;
+        }
+      }
+
       /* loop over all states */
       for (i = 0; i < mo->N; i++) {
         /* Pi */
@@ -481,20 +569,19 @@ static int reestimate_one_step (ghmm_dmodel * mo, local_store_t * r, int seq_num
         for (t=0; t < T_k-1; t++) {
           /* B */
           if (!mo->s[i].fix) {
-            e_index = get_emission_index(mo, i, O[k][t], t);
+            e_index = ghmm_emission_context_index(mo, ctx, i, O[k][t], t);
             if (e_index != -1) {
               gamma = seq_w[k] * alpha[t][i] * beta[t][i];
               r->b_num[i][e_index] += gamma;
               r->b_denom[i][e_index / (mo->M)] += gamma;
             }
           }
-          update_emission_history(mo, O[k][t]);
 
           /* A */
           r->a_denom[i] += (seq_w[k] * alpha[t][i] * beta[t][i]);
           for (j=0; j < mo->s[i].out_states; j++) {
             j_id = mo->s[i].out_id[j];
-            e_index = get_emission_index(mo, j_id, O[k][t+1], t+1);
+            e_index = ghmm_emission_context_index(mo, ctx, j_id, O[k][t+1], t+1);
             if (e_index != -1)
               r->a_num[i][j] += (seq_w[k] * alpha[t][i] * mo->s[i].out_a[j]
                                  * mo->s[j_id].b[e_index] * beta[t+1][j_id]
@@ -504,7 +591,7 @@ static int reestimate_one_step (ghmm_dmodel * mo, local_store_t * r, int seq_num
         /* B: last iteration for t==T_k-1 */
         t = T_k - 1;
         if (!mo->s[i].fix) {
-          e_index = get_emission_index (mo, i, O[k][t], t);
+          e_index = ghmm_emission_context_index(mo, ctx, i, O[k][t], t);
           if (e_index != -1) {
             gamma = seq_w[k] * alpha[t][i] * beta[t][i];
             r->b_num[i][e_index] += gamma;
@@ -517,9 +604,34 @@ static int reestimate_one_step (ghmm_dmodel * mo, local_store_t * r, int seq_num
       GHMM_LOG_PRINTF(LWARN, LOC, "O(%d) can't be built from model mo!\n", k);
     }
 
+    ghmm_dmodel_emission_context_free (&ctx, mo);
     ighmm_reestimate_free_matvek(alpha, beta, scale, T_k);
   }                             /* for (k = 0; k < seq_number; k++) */
 
+  return (valid);
+FREE:
+   ighmm_reestimate_free_matvek(alpha, beta, scale, T_k);
+   ghmm_dmodel_emission_context_free (&ctx, mo);
+   return (res);
+# undef CUR_PROC
+}                               /* reestimate_accumulate */
+
+/*----------------------------------------------------------------------------*/
+static int reestimate_one_step (ghmm_dmodel * mo, local_store_t * r, int seq_number,
+				int *seq_length, int **O, double *log_p,
+				double *seq_w)
+{
+# define CUR_PROC "reestimate_one_step"
+  int res = -1;
+  int valid;
+  int errors;
+
+  valid = reestimate_accumulate (mo, r, seq_number, seq_length, O, log_p, seq_w);
+  if (valid == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+
   if (valid) {
     /* new parameter lambda: set directly in model */
 
@@ -541,9 +653,6 @@ static int reestimate_one_step (ghmm_dmodel * mo, local_store_t * r, int seq_num
 
 STOP:
    return (res);
-FREE:
-   ighmm_reestimate_free_matvek(alpha, beta, scale, T_k);
-   return (res);
 # undef CUR_PROC
 }                               /* reestimate_one_step */
 
@@ -761,12 +870,12 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   /* deallocation */
   if (last_est)
     for (i=0; i<mo->N; i++)
-      reestimate_free(&(last_est[i]), mo->N);
+      reestimate_free(&(last_est[i]));
   m_free(last_est);
 
   if (curr_est)
     for (i=0; i<mo->N; i++)
-      reestimate_free(&(curr_est[i]), mo->N);
+      reestimate_free(&(curr_est[i]));
   m_free(curr_est);
 
   m_free(alpha_last_col);
@@ -856,7 +965,7 @@ int ghmm_dmodel_baum_welch_nstep (ghmm_dmodel * mo, ghmm_dseq * sq, int max_step
     else {
       /* for next iteration */
       log_p_old = log_p;
-      reestimate_init (r, mo);  /* sets all fields to zero */
+      reestimate_init (r);  /* sets all fields to zero */
       n++;
     }
   }                             /* while (n <= MAX_ITER) */
@@ -883,7 +992,7 @@ int ghmm_dmodel_baum_welch_nstep (ghmm_dmodel * mo, ghmm_dseq * sq, int max_step
   res = 0;
 
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-  reestimate_free (&r, mo->N);
+  reestimate_free (&r);
   return res;
 # undef CUR_PROC
 }                               /* ghmm_dmodel_baum_welch_nstep */
@@ -908,6 +1017,7 @@ static int reestimate_one_step_label(ghmm_dmodel *mo, local_store_t *r,
   double *scale = NULL;
   double gamma;
   double log_p_k;
+  int **ctx = NULL;
 
   /* first set maxorder to zero if model_type & kHigherOrderEmissions is FALSE 
 
@@ -946,6 +1056,15 @@ static int reestimate_one_step_label(ghmm_dmodel *mo, local_store_t *r,
         goto FREE;
       }
 
+      /* emission indices of the sequence */
+      if (mo->model_type & GHMM_kHigherOrderEmissions) {
+        ctx = ghmm_dmodel_emission_context_alloc (mo, O[k], T_k);
+        if (!ctx) {
+          GHMM_LOG_QUEUED(LCONVERTED);
+          goto FREE;
+        }
+      }
+
       /* loop over all states */
       for (i = 0; i < mo->N; i++) {
         /* Pi */
@@ -955,14 +1074,13 @@ static int reestimate_one_step_label(ghmm_dmodel *mo, local_store_t *r,
         for (t = 0; t < T_k - 1; t++) {
           /* B */
           if (!(mo->s[i].fix) && (mo->label[i] == label[k][t])) {
-            e_index = get_emission_index (mo, i, O[k][t], t);
+            e_index = ghmm_emission_context_index(mo, ctx, i, O[k][t], t);
             if (e_index != -1) {
               gamma = seq_w[k] * alpha[t][i] * beta[t][i];
               r->b_num[i][e_index] += gamma;
               r->b_denom[i][e_index / (mo->M)] += gamma;
             }
           }
-          update_emission_history (mo, O[k][t]);
 
           /* A */
           r->a_denom[i] += seq_w[k] * alpha[t][i] * beta[t][i];
@@ -970,7 +1088,7 @@ static int reestimate_one_step_label(ghmm_dmodel *mo, local_store_t *r,
             j_id = mo->s[i].out_id[j];
             if (label[k][t + 1] != mo->label[j_id])
               continue;
-            e_index = get_emission_index (mo, j_id, O[k][t + 1], t + 1);
+            e_index = ghmm_emission_context_index(mo, ctx, j_id, O[k][t + 1], t + 1);
             if (e_index != -1)
               r->a_num[i][j] += (seq_w[k] * alpha[t][i] * mo->s[i].out_a[j] *
                                  mo->s[j_id].b[e_index] * beta[t + 1][j_id] *
@@ -980,7 +1098,7 @@ static int reestimate_one_step_label(ghmm_dmodel *mo, local_store_t *r,
         /* B: last iteration for t==T_k-1 */
         t = T_k - 1;
         if (!(mo->s[i].fix) && (mo->label[i] == label[k][t])) {
-          e_index = get_emission_index (mo, i, O[k][t], t);
+          e_index = ghmm_emission_context_index(mo, ctx, i, O[k][t], t);
           if (e_index != -1) {
             gamma = seq_w[k] * alpha[t][i] * beta[t][i];
             r->b_num[i][e_index] += gamma;
@@ -993,6 +1111,7 @@ static int reestimate_one_step_label(ghmm_dmodel *mo, local_store_t *r,
       GHMM_LOG_PRINTF(LWARN, LOC, "warning: sequence %d can't be built from model", k);
     }
 
+    ghmm_dmodel_emission_context_free (&ctx, mo);
     ighmm_reestimate_free_matvek (alpha, beta, scale, T_k);
   }                             /* for (k = 0; k < seq_number; k++) */
 
@@ -1016,6 +1135,7 @@ static int reestimate_one_step_label(ghmm_dmodel *mo, local_store_t *r,
   return (0);
 FREE:
   ighmm_reestimate_free_matvek (alpha, beta, scale, T_k);
+  ghmm_dmodel_emission_context_free (&ctx, mo);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   return (-1);
 # undef CUR_PROC
@@ -1090,7 +1210,7 @@ int ghmm_dmodel_label_baum_welch_nstep (ghmm_dmodel * mo, ghmm_dseq * sq,
     else {
       /* for next iteration */
       log_p_old = log_p;
-      reestimate_init (r, mo);  /* sets all fields to zero */
+      reestimate_init (r);  /* sets all fields to zero */
       n++;
     }
   }                             /* while (n <= MAX_ITER) */
@@ -1120,7 +1240,206 @@ int ghmm_dmodel_label_baum_welch_nstep (ghmm_dmodel * mo, ghmm_dseq * sq,
   res = 0;
 
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-  reestimate_free (&r, mo->N);
+  reestimate_free (&r);
   return res;
 # undef CUR_PROC
 }                               /* ghmm_dl_baum_welch_nstep */
+
+
+/*============================================================================*/
+ghmm_dstats *ghmm_dstats_alloc (const ghmm_dmodel * mo)
+{
+# define CUR_PROC "ghmm_dstats_alloc"
+  ghmm_dstats *r = reestimate_alloc (mo);
+  if (!r)
+    GHMM_LOG_QUEUED(LCONVERTED);
+  return r;
+# undef CUR_PROC
+}                               /* ghmm_dstats_alloc */
+
+/*============================================================================*/
+int ghmm_dstats_free (ghmm_dstats ** r)
+{
+# define CUR_PROC "ghmm_dstats_free"
+  mes_check_ptr (r, return (-1));
+  if (!*r)
+    return (0);
+  return reestimate_free (r);
+# undef CUR_PROC
+}                               /* ghmm_dstats_free */
+
+/*============================================================================*/
+void ghmm_dstats_clear (ghmm_dstats * r)
+{
+  reestimate_init (r);
+}                               /* ghmm_dstats_clear */
+
+/*============================================================================*/
+int ghmm_dstats_accumulate (ghmm_dstats * r, ghmm_dmodel * mo, ghmm_dseq * sq)
+{
+# define CUR_PROC "ghmm_dstats_accumulate"
+  int valid;
+  double log_p;
+
+  if (!dstats_matches (r, mo)) {
+    GHMM_LOG(LERROR, "statistics do not match the model");
+    return (-1);
+  }
+  valid = reestimate_accumulate (mo, r, sq->seq_number, sq->seq_len, sq->seq,
+                                 &log_p, sq->seq_w);
+  if (valid == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return (-1);
+  }
+  r->valid += valid;
+  r->log_p += log_p;
+  return (0);
+# undef CUR_PROC
+}                               /* ghmm_dstats_accumulate */
+
+/*============================================================================*/
+int ghmm_dstats_merge (ghmm_dstats * r, const ghmm_dstats * other)
+{
+# define CUR_PROC "ghmm_dstats_merge"
+  int i;
+
+  if (r->N != other->N || r->M != other->M || r->size != other->size
+      || memcmp (r->out_states, other->out_states, r->N * sizeof (int))
+      || memcmp (r->order, other->order, r->N * sizeof (int))) {
+    GHMM_LOG(LERROR, "can not merge statistics of different models");
+    return (-1);
+  }
+  for (i = 0; i < r->size; i++)
+    r->data[i] += other->data[i];
+  r->pi_denom += other->pi_denom;
+  r->log_p += other->log_p;
+  r->valid += other->valid;
+  return (0);
+# undef CUR_PROC
+}                               /* ghmm_dstats_merge */
+
+/*============================================================================*/
+char *ghmm_dstats_serialize (const ghmm_dstats * r, size_t * size)
+{
+# define CUR_PROC "ghmm_dstats_serialize"
+  dstats_header header;
+  char *buf = NULL, *p;
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, DSTATS_MAGIC, sizeof (header.magic));
+  header.byte_order = DSTATS_BYTE_ORDER;
+  header.N = r->N;
+  header.M = r->M;
+  header.valid = r->valid;
+  header.size = r->size;
+  header.log_p = r->log_p;
+  header.pi_denom = r->pi_denom;
+
+  *size = sizeof (header) + 2 * r->N * sizeof (int)
+    + r->size * sizeof (double);
+  ARRAY_MALLOC (buf, *size);
+
+  p = buf;
+  memcpy (p, &header, sizeof (header));
+  p += sizeof (header);
+  memcpy (p, r->out_states, r->N * sizeof (int));
+  p += r->N * sizeof (int);
+  memcpy (p, r->order, r->N * sizeof (int));
+  p += r->N * sizeof (int);
+  memcpy (p, r->data, r->size * sizeof (double));
+
+  return buf;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  *size = 0;
+  return NULL;
+# undef CUR_PROC
+}                               /* ghmm_dstats_serialize */
+
+/*============================================================================*/
+ghmm_dstats *ghmm_dstats_deserialize (const char *buf, size_t size)
+{
+# define CUR_PROC "ghmm_dstats_deserialize"
+  dstats_header header;
+  size_t data;
+  int *shape = NULL;
+  ghmm_dstats *r = NULL;
+
+  if (size < sizeof (header)) {
+    GHMM_LOG(LERROR, "serialized statistics are truncated");
+    return NULL;
+  }
+  memcpy (&header, buf, sizeof (header));
+  if (memcmp (header.magic, DSTATS_MAGIC, sizeof (header.magic))) {
+    GHMM_LOG(LERROR, "not serialized statistics of a discrete model");
+    return NULL;
+  }
+  if (header.byte_order != DSTATS_BYTE_ORDER) {
+    GHMM_LOG(LERROR, "serialized statistics have a different byte order");
+    return NULL;
+  }
+  if (header.N <= 0 || header.M <= 0 || header.size < 0
+      || (size - sizeof (header)) / (2 * sizeof (int)) < (size_t) header.N) {
+    GHMM_LOG(LERROR, "serialized statistics are corrupt");
+    return NULL;
+  }
+  /* the header fixes the length of the buffer */
+  data = size - sizeof (header) - 2 * (size_t) header.N * sizeof (int);
+  if (data % sizeof (double) || data / sizeof (double) != (size_t) header.size) {
+    GHMM_LOG(LERROR, "size of serialized statistics does not match their shape");
+    return NULL;
+  }
+
+  ARRAY_MALLOC (shape, 2 * header.N);
+  memcpy (shape, buf + sizeof (header), 2 * header.N * sizeof (int));
+  if (!dstats_valid_shape (header.N, header.M, shape, shape + header.N,
+                           header.size)) {
+    GHMM_LOG(LERROR, "shape of serialized statistics is corrupt");
+    goto STOP;
+  }
+  r = dstats_alloc (header.N, header.M, shape, shape + header.N);
+  if (!r) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  memcpy (r->data, buf + sizeof (header) + 2 * header.N * sizeof (int),
+          r->size * sizeof (double));
+  r->pi_denom = header.pi_denom;
+  r->log_p = header.log_p;
+  r->valid = header.valid;
+
+  m_free (shape);
+  return r;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (shape)
+    m_free (shape);
+  reestimate_free (&r);
+  return NULL;
+# undef CUR_PROC
+}                               /* ghmm_dstats_deserialize */
+
+/*============================================================================*/
+int ghmm_dstats_apply (ghmm_dstats * r, ghmm_dmodel * mo)
+{
+# define CUR_PROC "ghmm_dstats_apply"
+  int errors;
+
+  if (!dstats_matches (r, mo)) {
+    GHMM_LOG(LERROR, "statistics do not match the model");
+    return (-1);
+  }
+  if (!r->valid) {
+    GHMM_LOG(LERROR, "no sequence can be built from the model");
+    return (-1);
+  }
+  if (reestimate_setlambda (r, mo) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return (-1);
+  }
+  if ((errors = ghmm_dmodel_check (mo))) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "Reestimated model is invalid, "
+                    "model_check found %d errors", -errors);
+    return (-1);
+  }
+  return (0);
+# undef CUR_PROC
+}                               /* ghmm_dstats_apply */
@@ -105,6 +105,89 @@ extern "C" {
 
 
 
+/**
+   Sufficient statistics of the Baum-Welch E-step for a discrete HMM.
+   Statistics of disjoint sets of sequences can be accumulated
+   independently, e.g. in different processes, merged and then applied to
+   the model they were computed with, which gives the same model as one
+   Baum-Welch step over all sequences.
+ */
+  typedef struct ghmm_dstats {
+  /** number of states and symbols */
+    int N;
+    int M;
+  /** number of outgoing transitions of each state */
+    int *out_states;
+  /** emission order of each state (0 without higher order emissions) */
+    int *order;
+  /** number of sequences the model can generate */
+    int valid;
+  /** summed log likelihood of these sequences */
+    double log_p;
+  /** denominator of the initial probabilities */
+    double pi_denom;
+  /** all accumulators below are rows of data, which holds size doubles */
+    double *data;
+    int size;
+    double *pi_num;
+    double **a_num;
+    double *a_denom;
+    double **b_num;
+    double **b_denom;
+  } ghmm_dstats;
+
+/** Allocates zeroed statistics shaped like the model.
+  @return            statistics or NULL on error
+  @param mo          model
+  */
+  ghmm_dstats *ghmm_dstats_alloc (const ghmm_dmodel * mo);
+
+/** Frees statistics.
+  @return            0/-1 success/error
+  @param r           pointer to the statistics
+  */
+  int ghmm_dstats_free (ghmm_dstats ** r);
+
+/** Sets all accumulators to zero. */
+  void ghmm_dstats_clear (ghmm_dstats * r);
+
+/** E-step: adds the expected counts of the sequences under the current
+    parameters of the model to the statistics.
+  @return            0/-1 success/error
+  @param r           statistics shaped like mo
+  @param mo          model
+  @param sq          sequences
+  */
+  int ghmm_dstats_accumulate (ghmm_dstats * r, ghmm_dmodel * mo, ghmm_dseq * sq);
+
+/** Adds other to r. Both must be shaped alike.
+  @return            0/-1 success/error
+  */
+  int ghmm_dstats_merge (ghmm_dstats * r, const ghmm_dstats * other);
+
+/** Packs the statistics into a buffer in host byte order. Doubles are
+    copied bitwise, so merging deserialized statistics is exact.
+  @return            buffer to be freed by the caller, NULL on error
+  @param r           statistics
+  @param size        returns the size of the buffer in bytes
+  */
+  char *ghmm_dstats_serialize (const ghmm_dstats * r, size_t * size);
+
+/** Unpacks statistics written by ghmm_dstats_serialize.
+  @return            statistics or NULL if buf is not valid
+  @param buf         buffer
+  @param size        size of the buffer in bytes
+  */
+  ghmm_dstats *ghmm_dstats_deserialize (const char *buf, size_t size);
+
+/** M-step: sets the parameters of the model from the statistics, which
+    must have been accumulated with the same parameters.
+  @return            0/-1 success/error
+  @param r           statistics
+  @param mo          model
+  */
+  int ghmm_dstats_apply (ghmm_dstats * r, ghmm_dmodel * mo);
+
 #ifdef __cplusplus
 }
 #endif
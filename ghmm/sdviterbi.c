@@ -57,27 +57,30 @@ typedef struct local_store_t {
   double **log_b;
   double *phi;
   double *phi_new;
-  int **psi;
+  ighmm_psi_matrix *psi;
 
   int *topo_order;
   int topo_order_length;
 } local_store_t;
 
 static local_store_t *sdviterbi_alloc (ghmm_dsmodel * mo, int len);
-static int sdviterbi_free (local_store_t ** v, int n, int cos, int len);
+static int sdviterbi_free (local_store_t ** v, int n, int cos);
 
 /*----------------------------------------------------------------------------*/
 static local_store_t *sdviterbi_alloc (ghmm_dsmodel * mo, int len)
 {
 #define CUR_PROC "sdviterbi_alloc"
   local_store_t *v = NULL;
-  int j;
+  int j, max_in_states = 0;
   ARRAY_CALLOC (v, 1);
 
   /* Allocate the log_in_a's -> individal lenghts */
   ARRAY_CALLOC (v->log_in_a, mo->N);
-  for (j = 0; j < mo->N; j++)
+  for (j = 0; j < mo->N; j++) {
     v->log_in_a[j] = ighmm_cmatrix_stat_alloc (mo->cos, mo->s[j].in_states);
+    if (mo->s[j].in_states > max_in_states)
+      max_in_states = mo->s[j].in_states;
+  }
   
   v->log_b = ighmm_cmatrix_stat_alloc (mo->N, len);
   if (!(v->log_b)) {
@@ -86,7 +89,7 @@ static local_store_t *sdviterbi_alloc (ghmm_dsmodel * mo, int len)
   }
   ARRAY_CALLOC (v->phi, mo->N);
   ARRAY_CALLOC (v->phi_new, mo->N);
-  v->psi = ighmm_dmatrix_alloc (len, mo->N);
+  v->psi = ighmm_psi_alloc (len, mo->N, max_in_states);
   if (!(v->psi)) {
     GHMM_LOG_QUEUED(LCONVERTED);
     goto STOP;
@@ -97,14 +100,14 @@ static local_store_t *sdviterbi_alloc (ghmm_dsmodel * mo, int len)
 
   return (v);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-  sdviterbi_free (&v, mo->N, mo->cos, len);
+  sdviterbi_free (&v, mo->N, mo->cos);
   return (NULL);
 #undef CUR_PROC
 }                               /* viterbi_alloc */
 
 
 /*----------------------------------------------------------------------------*/
-static int sdviterbi_free (local_store_t ** v, int n, int cos, int len)
+static int sdviterbi_free (local_store_t ** v, int n, int cos)
 {
 #define CUR_PROC "sdviterbi_free"
   int j;
@@ -117,7 +120,7 @@ static int sdviterbi_free (local_store_t ** v, int n, int cos, int len)
   ighmm_cmatrix_stat_free (&((*v)->log_b));
   m_free ((*v)->phi);
   m_free ((*v)->phi_new);
-  ighmm_dmatrix_free (&((*v)->psi), len);
+  ighmm_psi_free (&((*v)->psi));
   m_free ((*v)->topo_order);
   m_free (*v);
   return (0);
@@ -164,6 +167,13 @@ static void Viterbi_precompute (ghmm_dsmodel * mo, int *o, int len,
 #undef CUR_PROC
 }                               /* viterbi_precompute */
 
+/* state id of the predecessor of state k at time t or -1 */
+static int psi_state (ghmm_dsmodel * mo, local_store_t * v, int t, int k)
+{
+  int i = ighmm_psi_get (v->psi, t, k);
+  return (i < 0) ? -1 : mo->s[k].in_id[i];
+}
+
 /** */
 static void __viterbi_silent (ghmm_dsmodel * mo, int t, local_store_t * v,
                               int *recent_matchcount, int *countstates,
@@ -180,7 +190,7 @@ static void __viterbi_silent (ghmm_dsmodel * mo, int t, local_store_t * v,
       /* Determine the maximum */
       /* max_phi = phi[i] + log_in_a[j][i] ... */
       max_value = -DBL_MAX;
-      v->psi[t][k] = -1;
+      ighmm_psi_set (v->psi, t, k, -1);
       for (i = 0; i < mo->s[k].in_states; i++) {
         /* printf("\nBerrechnung von transclass von Zustand %d", mo->s[k].in_id[i]);*/
         if (mo->cos != 1) {
@@ -190,19 +200,19 @@ static void __viterbi_silent (ghmm_dsmodel * mo, int t, local_store_t * v,
           value = v->phi[mo->s[k].in_id[i]] + v->log_in_a[k][osc][i];
           if (value > max_value) {
             max_value = value;
-            v->psi[t][k] = mo->s[k].in_id[i];
+            ighmm_psi_set (v->psi, t, k, i);
           }
         }
       }
       /*find out, if we are in a delete state unless this state isn't reached anyway */
-      if (v->psi[t][k] != -1) {
+      if (psi_state (mo, v, t, k) != -1) {
         for (i = 0; i < nr_of_countstates; i++) {
           if (k == countstates[i]) {
             recent_matchcount[k] = 1;
             break;
           }
         }
-        recent_matchcount[k] += recent_matchcount[v->psi[t][k]];
+        recent_matchcount[k] += recent_matchcount[psi_state (mo, v, t, k)];
 
         /* No maximum found (that is, state never reached)
            or the output O[t] = 0.0: */
@@ -302,7 +312,7 @@ int *ghmm_dsmodel_viterbi (ghmm_dsmodel * mo, int *o, int len, double *log_p)
     for (j = 0; j < mo->N; j++) {
 /** initialization of phi, psi **/
       v->phi_new[j] = +1;
-      v->psi[t][j] = -1;
+      ighmm_psi_set (v->psi, t, j, -1);
     }
 
     for (k = 0; k < mo->N; k++) {
@@ -313,7 +323,7 @@ int *ghmm_dsmodel_viterbi (ghmm_dsmodel * mo, int *o, int len, double *log_p)
       if (!(mo->model_type & GHMM_kSilentStates) || !mo->silent[k]) {
         St = k;
         max_value = -DBL_MAX;
-        v->psi[t][St] = -1;
+        ighmm_psi_set (v->psi, t, St, -1);
         for (i = 0; i < mo->s[St].in_states; i++) {
           /* get_class of in state*/
           /* printf("\nBerechnung von transclass fuer Zustand %d", mo->s[St].in_id[i]);*/
@@ -325,7 +335,7 @@ int *ghmm_dsmodel_viterbi (ghmm_dsmodel * mo, int *o, int len, double *log_p)
             value = v->phi[mo->s[St].in_id[i]] + v->log_in_a[St][osc][i];
             if (value > max_value) {
               max_value = value;
-              v->psi[t][St] = mo->s[St].in_id[i];
+              ighmm_psi_set (v->psi, t, St, i);
             }
           }
           else {
@@ -343,14 +353,14 @@ int *ghmm_dsmodel_viterbi (ghmm_dsmodel * mo, int *o, int len, double *log_p)
           v->phi_new[St] = max_value + v->log_b[St][t];
 
         /*find out how long we have been staying in the circle unless we didn't reach this state */
-        if (v->psi[t][St] != -1) {
+        if (psi_state (mo, v, t, St) != -1) {
           for (i = 0; i < nr_of_countstates; i++) {
             if (countstates[i] == St) {
               recent_matchcount[St] = 1;
               break;
             }
           }
-          recent_matchcount[St] += former_matchcount[v->psi[t][St]];
+          recent_matchcount[St] += former_matchcount[psi_state (mo, v, t, St)];
         }
 
       }
@@ -398,21 +408,21 @@ int *ghmm_dsmodel_viterbi (ghmm_dsmodel * mo, int *o, int len, double *log_p)
     lastemState = state_seq[len_path - 1];
     for (t = len - 2, i = len_path - 2; t >= 0; t--) {
       if ((mo->model_type & GHMM_kSilentStates) &&
-          mo->silent[v->psi[t + 1][lastemState]]) {
+          mo->silent[psi_state (mo, v, t + 1, lastemState)]) {
 
-        St = v->psi[t + 1][lastemState];
+        St = psi_state (mo, v, t + 1, lastemState);
         /* fprintf(stderr, "t=%d:  DEL St=%d\n", t+1, St ); */
         while (St != -1 && mo->silent[St]) {    /* trace back up to the last emitting state */
           /* fprintf(stderr, "t=%d:  DEL St=%d\n", t, St ); */
           state_seq[i--] = St;
-          St = v->psi[t][St];
+          St = psi_state (mo, v, t, St);
         }
         state_seq[i--] = St;
         lastemState = St;
       }
       else {
-        state_seq[i--] = v->psi[t + 1][lastemState];
-        lastemState = v->psi[t + 1][lastemState];
+        state_seq[i--] = psi_state (mo, v, t + 1, lastemState);
+        lastemState = psi_state (mo, v, t + 1, lastemState);
       }
     }
 
@@ -436,11 +446,11 @@ int *ghmm_dsmodel_viterbi (ghmm_dsmodel * mo, int *o, int len, double *log_p)
   m_free (recent_matchcount);
   m_free (tmp_matchcount);
   m_free (countstates);
-  sdviterbi_free (&v, mo->N, mo->cos, len);
+  sdviterbi_free (&v, mo->N, mo->cos);
   return (state_seq);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   /* Free the memory space */
-  sdviterbi_free (&v, mo->N, mo->cos, len);
+  sdviterbi_free (&v, mo->N, mo->cos);
   m_free (state_seq);
   m_free (former_matchcount);
   m_free (recent_matchcount);
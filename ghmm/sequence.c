@@ -64,6 +64,7 @@
 enum sequence_flags{
     kBlockAllocation = 1<<0,
     kHasLabels       = 1<<1,
+    kExternalData    = 1<<2,
 };
 
 
@@ -513,7 +514,7 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 ghmm_cseq *ghmm_cseq_calloc (long seq_number)
 {
 #define CUR_PROC "ghmm_cseq_calloc"
-  int i;
+  long i;
   ghmm_cseq *sqd = NULL;
 
   if (seq_number > GHMM_MAX_SEQ_NUMBER) {
@@ -552,7 +553,7 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 ghmm_dseq *ghmm_dseq_calloc (long seq_number)
 {
 #define CUR_PROC "ghmm_dseq_calloc"
-  int i;
+  long i;
   ghmm_dseq *sq = NULL;
 
   if (seq_number > GHMM_MAX_SEQ_NUMBER) {
@@ -589,7 +590,7 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 }                               /* ghmm_dseq_calloc */
 
 /*============================================================================*/
-static int ghmm_dseq_realloc(ghmm_dseq *sq, int seq_number) {
+static int ghmm_dseq_realloc(ghmm_dseq *sq, long seq_number) {
 #define CUR_PROC "ghmm_dseq_realloc"
 
   if (seq_number > GHMM_MAX_SEQ_NUMBER) {
@@ -628,6 +629,82 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 #undef CUR_PROC
 }                               /* ghmm_dseq_calloc_state_labels */
 
+/*============================================================================*/
+ghmm_dseq *ghmm_dseq_wrap_block (int *block, const int *seq_len,
+                                 long seq_number)
+{
+#define CUR_PROC "ghmm_dseq_wrap_block"
+  long i;
+  ghmm_dseq *sq;
+
+  if (!(sq = ghmm_dseq_calloc (seq_number))) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return NULL;
+  }
+  sq->flags |= kExternalData;
+  for (i = 0; i < seq_number; i++) {
+    if (seq_len[i] < 0) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "negative length of sequence %ld", i);
+      ghmm_dseq_free (&sq);
+      return NULL;
+    }
+    sq->seq[i] = block;
+    sq->seq_len[i] = seq_len[i];
+    block += seq_len[i];
+  }
+  sq->total_w = seq_number;
+  return sq;
+#undef CUR_PROC
+}                               /* ghmm_dseq_wrap_block */
+
+/*============================================================================*/
+ghmm_cseq *ghmm_cseq_wrap_block (double *block, const int *seq_len,
+                                 long seq_number)
+{
+#define CUR_PROC "ghmm_cseq_wrap_block"
+  long i;
+  ghmm_cseq *sqd;
+
+  if (!(sqd = ghmm_cseq_calloc (seq_number))) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return NULL;
+  }
+  sqd->flags |= kExternalData;
+  for (i = 0; i < seq_number; i++) {
+    if (seq_len[i] < 0) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "negative length of sequence %ld", i);
+      ghmm_cseq_free (&sqd);
+      return NULL;
+    }
+    sqd->seq[i] = block;
+    sqd->seq_len[i] = seq_len[i];
+    block += seq_len[i];
+  }
+  sqd->total_w = seq_number;
+  return sqd;
+#undef CUR_PROC
+}                               /* ghmm_cseq_wrap_block */
+
+/*============================================================================*/
+int ghmm_dseq_is_block (const ghmm_dseq * sq)
+{
+  long i;
+  for (i = 1; i < sq->seq_number; i++)
+    if (sq->seq[i] != sq->seq[i - 1] + sq->seq_len[i - 1])
+      return 0;
+  return 1;
+}                               /* ghmm_dseq_is_block */
+
+/*============================================================================*/
+int ghmm_cseq_is_block (const ghmm_cseq * sqd)
+{
+  long i;
+  for (i = 1; i < sqd->seq_number; i++)
+    if (sqd->seq[i] != sqd->seq[i - 1] + sqd->seq_len[i - 1])
+      return 0;
+  return 1;
+}                               /* ghmm_cseq_is_block */
+
 /*============================================================================*/
 ghmm_cseq *ghmm_cseq_get_singlesequence(ghmm_cseq *sq, int index)
 {
@@ -822,6 +899,11 @@ int ghmm_dseq_add (ghmm_dseq * target, ghmm_dseq * source)
   long old_seq_number = target->seq_number;
   long i;
 
+  if (target->flags & kExternalData) {
+    GHMM_LOG(LERROR, "can not add sequences to wrapped external data");
+    return -1;
+  }
+
   target->seq_number = old_seq_number + source->seq_number;
   target->total_w += source->total_w;
 
@@ -896,6 +978,11 @@ int ghmm_cseq_add (ghmm_cseq * target, ghmm_cseq * source)
   long old_seq_number = target->seq_number;
   long i;
 
+  if (target->flags & kExternalData) {
+    GHMM_LOG(LERROR, "can not add sequences to wrapped external data");
+    return -1;
+  }
+
   target->seq_number = old_seq_number + source->seq_number;
   target->total_w += source->total_w;
 
@@ -1191,7 +1278,7 @@ int ghmm_dseq_free (ghmm_dseq ** sq) {
     return -1;
 
   /* ighmm_dmatrix_free also takes care of (*sq)->seq */
-  if ((*sq)->flags & kBlockAllocation)
+  if ((*sq)->flags & (kBlockAllocation | kExternalData))
     free((*sq)->seq);
   else if (ighmm_dmatrix_free(&(*sq)->seq, (*sq)->seq_number) == -1)
     GHMM_LOG(LWARN, "Error in ghmm_dseq_free!");
@@ -1227,7 +1314,10 @@ int ghmm_cseq_free (ghmm_cseq ** sqd)
   if (!*sqd)
     return -1;
 
-  ighmm_cmatrix_free(&(*sqd)->seq, (*sqd)->seq_number);
+  if ((*sqd)->flags & kExternalData)
+    free((*sqd)->seq);
+  else
+    ighmm_cmatrix_free(&(*sqd)->seq, (*sqd)->seq_number);
   m_free((*sqd)->seq_len);
 #ifdef GHMM_OBSOLETE
   m_free((*sqd)->seq_label);
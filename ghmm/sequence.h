@@ -371,6 +371,48 @@ ghmm_dseq *ghmm_dseq_open_fasta(const char *filename, ghmm_alphabet *alphabet);
 */
   ghmm_cseq *ghmm_cseq_calloc (long seq_number);
 
+/**
+   Wraps integer sequences that are stored one after another in a
+   contiguous block. The sequences are not copied, sq->seq[i] points into
+   the block. The block is not freed by ghmm_dseq_free and has to stay
+   valid as long as the sequence struct is used. Other sequences can not
+   be added with ghmm_dseq_add.
+   @param block       sequences, stored contiguously
+   @param seq_len     lengths of the sequences
+   @param seq_number  number of sequences
+   @return:     pointer of sequence struct or NULL on error
+*/
+  ghmm_dseq *ghmm_dseq_wrap_block (int *block, const int *seq_len,
+                                   long seq_number);
+
+/**
+   Wraps double sequences that are stored one after another in a
+   contiguous block, see ghmm_dseq_wrap_block.
+   @param block       sequences, stored contiguously
+   @param seq_len     lengths of the sequences
+   @param seq_number  number of sequences
+   @return:     pointer of sequence struct or NULL on error
+*/
+  ghmm_cseq *ghmm_cseq_wrap_block (double *block, const int *seq_len,
+                                   long seq_number);
+
+/**
+   Tests whether the sequences are stored one after another in one
+   contiguous block (as allocated by ghmm_dseq_wrap_block or
+   ghmm_dseq_open_fasta).
+   @param sq    sequence struct
+   @return 1 if contiguous, 0 otherwise
+*/
+  int ghmm_dseq_is_block (const ghmm_dseq * sq);
+
+/**
+   Tests whether the sequences are stored one after another in one
+   contiguous block.
+   @param sqd   sequence struct
+   @return 1 if contiguous, 0 otherwise
+*/
+  int ghmm_cseq_is_block (const ghmm_cseq * sqd);
+
 /**
    Copies array of integer sequences to double sequences.
    @return       double sequence struct (target)
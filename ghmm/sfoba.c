@@ -95,10 +95,11 @@ static double sfoba_stepforward (ghmm_cstate * s, double *alpha_t, int osc,
 
 
 /*============================================================================*/
-int ghmm_cmodel_forward (ghmm_cmodel * smo, double *O, int T, double ***b,
-                   double **alpha, double *scale, double *log_p)
+int ghmm_cmodel_forward_classes (ghmm_cmodel * smo, double *O, int T,
+                                 double ***b, double **alpha, double *scale,
+                                 double *log_p, const int *classes)
 {
-# define CUR_PROC "ghmm_cmodel_forward"
+# define CUR_PROC "ghmm_cmodel_forward_classes"
   int res = -1;
   int i, t = 0, osc = 0;
   double c_t;
@@ -119,25 +120,10 @@ int ghmm_cmodel_forward (ghmm_cmodel * smo, double *O, int T, double ***b,
   else {
     *log_p = -log (1 / scale[0]);
 
-    if (smo->cos == 1) {
-      osc = 0;
-    }
-    else {
-      if (!smo->class_change->get_class) {
-        printf ("ERROR: get_class not initialized\n");
-        return (-1);
-      }
-      /* printf("1: cos = %d, k = %d, t = %d\n",smo->cos,smo->class_change->k,t); */
-      osc = smo->class_change->get_class (smo, O, smo->class_change->k, t);
-      if (osc >= smo->cos){
-        printf("ERROR: get_class returned index %d but model has only %d classes !\n",osc,smo->cos);
-        goto STOP;
-      }
-
-    }
-
-
     for (t = 1; t < T; t++) {
+      /* class of the transition from t-1 to t */
+      if (classes)
+        osc = classes[t - 1];
       scale[t] = 0.0;
       pos = t * smo->dim;
       /* b not calculated yet */
@@ -166,25 +152,6 @@ int ghmm_cmodel_forward (ghmm_cmodel * smo, double *O, int T, double ***b,
         alpha[t][i] *= c_t;
       /* summation of log(c[t]) for calculation of log( P(O|lambda) ) */
       *log_p -= log (c_t);
-
-      if (smo->cos == 1) {
-        osc = 0;
-      }
-      else {
-        if (!smo->class_change->get_class) {
-          printf ("ERROR: get_class not initialized\n");
-          return (-1);
-        }
-        /* printf("1: cos = %d, k = %d, t = %d\n",smo->cos,smo->class_change->k,t); */
-        osc = smo->class_change->get_class (smo, O, smo->class_change->k, t);
-        if (osc >= smo->cos){
-          printf("ERROR: get_class returned index %d but model has only %d classes !\n",osc,smo->cos);
-          goto STOP;
-        }		
-      }
-
-
-
     }
   }
   /* log_p should not be smaller than value used for seqs. that 
@@ -197,17 +164,61 @@ STOP:
   *log_p = (double) -DBL_MAX;
   return (res);
 # undef CUR_PROC
+}                               /* ghmm_cmodel_forward_classes */
+
+/*============================================================================*/
+/* transition classes of the current sequence smo->class_change->k,
+   NULL for models with one class */
+static int sfoba_class_sequence (ghmm_cmodel * smo, double *O, int T,
+                                 int **classes)
+{
+# define CUR_PROC "sfoba_class_sequence"
+  *classes = NULL;
+  if (smo->cos == 1)
+    return 0;
+  T /= smo->dim;
+  ARRAY_MALLOC (*classes, T > 1 ? T - 1 : 1);
+  if (ghmm_cmodel_get_class_sequence (smo, O, smo->class_change ?
+                                      smo->class_change->k : -1, T,
+                                      *classes) == -1)
+    goto STOP;
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (*classes)
+    m_free (*classes);
+  return (-1);
+# undef CUR_PROC
+}
+
+/*============================================================================*/
+int ghmm_cmodel_forward (ghmm_cmodel * smo, double *O, int T, double ***b,
+                   double **alpha, double *scale, double *log_p)
+{
+# define CUR_PROC "ghmm_cmodel_forward"
+  int *classes, res;
+
+  if (sfoba_class_sequence (smo, O, T, &classes) == -1) {
+    *log_p = (double) -DBL_MAX;
+    return (-1);
+  }
+  res = ghmm_cmodel_forward_classes (smo, O, T, b, alpha, scale, log_p,
+                                     classes);
+  if (classes)
+    m_free (classes);
+  return (res);
+# undef CUR_PROC
 }                               /* ghmm_cmodel_forward */
 
 #define LOWER_SCALE_BOUND 3.4811068399043105e-57 /* exp(-130) */
 
 /*============================================================================*/
-int ghmm_cmodel_backward (ghmm_cmodel * smo, double *O, int T, double ***b,
-                    double **beta, const double *scale)
+int ghmm_cmodel_backward_classes (ghmm_cmodel * smo, double *O, int T,
+                                  double ***b, double **beta,
+                                  const double *scale, const int *classes)
 {
-# define CUR_PROC "ghmm_cmodel_backward"
+# define CUR_PROC "ghmm_cmodel_backward_classes"
   double *beta_tmp, sum, c_t;
-  int i, j, j_id, t, osc;
+  int i, j, j_id, t, osc = 0;
   int res = -1;
   int pos;
 
@@ -233,24 +244,10 @@ int ghmm_cmodel_backward (ghmm_cmodel * smo, double *O, int T, double ***b,
   /* Backward Step for t = T-2, ..., 0 */
   /* beta_tmp: Vector for storage of scaled beta in one time step */
 
-  if (smo->cos == 1) {
-    osc = 0;
-  }
-  else {
-    if (!smo->class_change->get_class) {
-      printf ("ERROR: get_class not initialized\n");
-      goto STOP;
-    }
-     osc = smo->class_change->get_class (smo, O, smo->class_change->k, T - 2);
-     /* printf("osc(%d) = %d\n",T-2,osc);  */
-    if (osc >= smo->cos){
-      printf("ERROR: get_class returned index %d but model has only %d classes !\n",osc,smo->cos);
-      goto STOP;
-    }     
-  }
-
-
   for (t = T - 2; t >= 0; t--) {
+    /* class of the transition from t to t+1 */
+    if (classes)
+      osc = classes[t];
     pos = t * smo->dim;
     if (b == NULL)
       for (i = 0; i < smo->N; i++) {
@@ -281,31 +278,28 @@ int ghmm_cmodel_backward (ghmm_cmodel * smo, double *O, int T, double ***b,
     c_t = 1 / scale[t];
     for (i = 0; i < smo->N; i++)
       beta_tmp[i] = beta[t][i] * c_t;
-
-    if (smo->cos == 1) {
-      osc = 0;
-    }
-    else {
-      if (!smo->class_change->get_class) {
-        printf ("ERROR: get_class not initialized\n");
-        goto STOP;
-      }
-      /* if t=1 the next iteration will be the last */        
-      if (t >= 1){
-        osc = smo->class_change->get_class (smo, O, smo->class_change->k, t-1);
-        /* printf("osc(%d) = %d\n",t-1,osc);  */
-        if (osc >= smo->cos){
-          printf("ERROR: get_class returned index %d but model has only %d classes !\n",osc,smo->cos);
-          goto STOP;
-        }	
-      }
-    }
   }
   res = 0;
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   m_free (beta_tmp);
   return (res);
 # undef CUR_PROC
+}                               /* ghmm_cmodel_backward_classes */
+
+/*============================================================================*/
+int ghmm_cmodel_backward (ghmm_cmodel * smo, double *O, int T, double ***b,
+                    double **beta, const double *scale)
+{
+# define CUR_PROC "ghmm_cmodel_backward"
+  int *classes, res;
+
+  if (sfoba_class_sequence (smo, O, T, &classes) == -1)
+    return (-1);
+  res = ghmm_cmodel_backward_classes (smo, O, T, b, beta, scale, classes);
+  if (classes)
+    m_free (classes);
+  return (res);
+# undef CUR_PROC
 }                               /* ghmm_cmodel_backward */
 
 /*============================================================================*/
@@ -398,3 +392,129 @@ int ghmm_cmodel_logp_joint(ghmm_cmodel *mo, const double *O, int len,
     return -1;
 # undef CUR_PROC
 }
+
+/*============================================================================*/
+/* posterior of all states, post holds the forward variables first */
+static int sfoba_posterior_matrix (ghmm_cmodel * smo, double *O, int T,
+                                   double **post, double *log_p)
+{
+#define CUR_PROC "sfoba_posterior_matrix"
+  int res = -1;
+  int i, t, *classes = NULL;
+  double **beta = NULL, *scale = NULL, norm;
+
+  ARRAY_CALLOC (scale, T);
+  beta = ighmm_cmatrix_stat_alloc (T, smo->N);
+  if (!beta) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (sfoba_class_sequence (smo, O, T * smo->dim, &classes) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (ghmm_cmodel_forward_classes (smo, O, T * smo->dim, NULL, post, scale,
+                                   log_p, classes) == -1) {
+    GHMM_LOG(LERROR, "sequence can't be generated by the model");
+    goto STOP;
+  }
+  if (ghmm_cmodel_backward_classes (smo, O, T * smo->dim, NULL, beta, scale,
+                                    classes) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  for (t = 0; t < T; t++) {
+    norm = 0.0;
+    for (i = 0; i < smo->N; i++) {
+      post[t][i] *= beta[t][i];
+      norm += post[t][i];
+    }
+    if (norm <= 0.0) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "posterior undefined at position %d", t);
+      goto STOP;
+    }
+    for (i = 0; i < smo->N; i++)
+      post[t][i] /= norm;
+  }
+  res = 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (res)
+    *log_p = -DBL_MAX;
+  ighmm_cmatrix_stat_free (&beta);
+  m_free (scale);
+  if (classes)
+    m_free (classes);
+  return res;
+#undef CUR_PROC
+}                               /* sfoba_posterior_matrix */
+
+/*============================================================================*/
+int ghmm_cmodel_posterior (ghmm_cmodel * smo, double *O, int T, double **post,
+                           double *log_p)
+{
+#define CUR_PROC "ghmm_cmodel_posterior"
+  T /= smo->dim;
+  if (T < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return -1;
+  }
+  return sfoba_posterior_matrix (smo, O, T, post, log_p);
+#undef CUR_PROC
+}                               /* ghmm_cmodel_posterior */
+
+/*============================================================================*/
+int ghmm_cmodel_posterior_sparse (ghmm_cmodel * smo, double *O, int T,
+                                  double threshold, int *row_start, int *state,
+                                  double *prob, int max_entries, double *log_p)
+{
+#define CUR_PROC "ghmm_cmodel_posterior_sparse"
+  int res = -1;
+  double **post = NULL;
+
+  T /= smo->dim;
+  if (T < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return -1;
+  }
+  post = ighmm_cmatrix_stat_alloc (T, smo->N);
+  if (!post) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (sfoba_posterior_matrix (smo, O, T, post, log_p))
+    goto STOP;
+  res = ighmm_posterior_sparse (post, T, smo->N, threshold, row_start, state,
+                                prob, max_entries);
+STOP:
+  ighmm_cmatrix_stat_free (&post);
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_cmodel_posterior_sparse */
+
+/*============================================================================*/
+int ghmm_cmodel_posterior_decoding (ghmm_cmodel * smo, double *O, int T,
+                                    int *path, double *log_p)
+{
+#define CUR_PROC "ghmm_cmodel_posterior_decoding"
+  int res = -1;
+  double **post = NULL;
+
+  T /= smo->dim;
+  if (T < 1) {
+    GHMM_LOG(LERROR, "empty sequence");
+    return -1;
+  }
+  post = ighmm_cmatrix_stat_alloc (T, smo->N);
+  if (!post) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  if (sfoba_posterior_matrix (smo, O, T, post, log_p))
+    goto STOP;
+  ighmm_posterior_decoding (post, T, smo->N, NULL, path);
+  res = 0;
+STOP:
+  ighmm_cmatrix_stat_free (&post);
+  return res;
+#undef CUR_PROC
+}                               /* ghmm_cmodel_posterior_decoding */
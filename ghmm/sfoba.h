@@ -69,6 +69,18 @@ extern "C" {
   int ghmm_cmodel_forward (ghmm_cmodel * smo, double *O, int T, double ***b,
                      double **alpha, double *scale, double *log_p);
 
+/** Forward-Algorithm with precomputed transition classes.
+  Same as ghmm_cmodel_forward, but the classes are not queried from
+  smo->class_change in every time step.
+  @param classes  classes[t] is the class of the transition from t to t+1
+                  (see ghmm_cmodel_get_class_sequence); may be NULL for
+                  models with one class
+  @return 0 for success, -1 for error
+  */
+  int ghmm_cmodel_forward_classes (ghmm_cmodel * smo, double *O, int T,
+                                   double ***b, double **alpha, double *scale,
+                                   double *log_p, const int *classes);
+
 /** 
   Backward-Algorithm. 
   Calculates beta[t][i] given a double sequence and a model. Scale factors 
@@ -84,6 +96,14 @@ extern "C" {
   int ghmm_cmodel_backward (ghmm_cmodel * smo, double *O, int T, double ***b,
                       double **beta, const double *scale);
 
+/** Backward-Algorithm with precomputed transition classes.
+  @param classes  see ghmm_cmodel_forward_classes
+  @return 0 for success, -1 for error
+  */
+  int ghmm_cmodel_backward_classes (ghmm_cmodel * smo, double *O, int T,
+                                    double ***b, double **beta,
+                                    const double *scale, const int *classes);
+
 /**
   Calculation of  log( P(O|lambda) ). 
   Done by calling ghmm_cmodel_forward(). Use this function if only the
@@ -113,6 +133,52 @@ extern "C" {
 int ghmm_cmodel_logp_joint(ghmm_cmodel *mo, const double *O, int len,
                            const int *S, int slen, double *log_p);
 
+/**
+  Posterior probabilities of the states, post[t][i] is the probability
+  that state i emits the t-th observation.
+  @param smo      model
+  @param O        sequence
+  @param T        length of sequence (O is actually T*smo->dim long)
+  @param post     caller allocated (T / smo->dim) x N matrix
+  @param log_p    log likelihood log( P(O|lambda) )
+  @return 0 for success, -1 for error
+  */
+  int ghmm_cmodel_posterior (ghmm_cmodel * smo, double *O, int T,
+                             double **post, double *log_p);
+
+/**
+  Posterior probabilities above a threshold in compressed row format, see
+  ghmm_dmodel_posterior_sparse.
+  @param smo          model
+  @param O            sequence
+  @param T            length of sequence (O is actually T*smo->dim long)
+  @param threshold    only posteriors larger than threshold are returned
+  @param row_start    caller allocated array of T / smo->dim + 1 entries
+  @param state        caller allocated array of max_entries states
+  @param prob         caller allocated array of max_entries posteriors
+  @param max_entries  size of state and prob
+  @param log_p        log likelihood log( P(O|lambda) )
+  @return number of entries (only the first max_entries are written if it
+  is larger), -1 for error
+  */
+  int ghmm_cmodel_posterior_sparse (ghmm_cmodel * smo, double *O, int T,
+                                    double threshold, int *row_start,
+                                    int *state, double *prob, int max_entries,
+                                    double *log_p);
+
+/**
+  Posterior decoding: path[t] is the state with the largest posterior
+  probability for the t-th observation.
+  @param smo      model
+  @param O        sequence
+  @param T        length of sequence (O is actually T*smo->dim long)
+  @param path     caller allocated array of T / smo->dim states
+  @param log_p    log likelihood log( P(O|lambda) )
+  @return 0 for success, -1 for error
+  */
+  int ghmm_cmodel_posterior_decoding (ghmm_cmodel * smo, double *O, int T,
+                                      int *path, double *log_p);
+
 
 #ifdef __cplusplus
 }
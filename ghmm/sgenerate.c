@@ -116,7 +116,7 @@ ghmm_cseq *ghmm_sgenerate_extensions (ghmm_cmodel * smo, ghmm_cseq * sqd_short,
 
   /*---------------main loop over all seqs-------------------------------*/
   for (n = 0; n < sqd_short->seq_number; n++) {
-    ARRAY_CALLOC (sq->seq[n], len*(smo->dim));
+    ARRAY_CALLOC (sq->seq[n], (size_t) len * smo->dim);
     short_len = sqd_short->seq_len[n];
     if (len < short_len) {
       GHMM_LOG(LCONVERTED, "Error: given sequence is too long\n");
@@ -59,6 +59,7 @@
 #include "ghmm_internals.h"
 #include "xmlreader.h"
 #include "xmlwriter.h"
+#include "snapshot.h"
 
 #include "obsolete.h"
 /*----------------------------------------------------------------------------*/
@@ -163,6 +164,7 @@ int ghmm_cmodel_class_change_alloc (ghmm_cmodel * smo)
 
   c->k = -1;
   c->get_class = NULL;
+  c->get_class_sequence = NULL;
 
   smo->class_change = c;
   return (0);
@@ -171,6 +173,43 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 # undef CUR_PROC
 }
 
+/*============================================================================*/
+int ghmm_cmodel_get_class_sequence (ghmm_cmodel * smo, const double *O,
+                                    int k, int T, int *classes)
+{
+# define CUR_PROC "ghmm_cmodel_get_class_sequence"
+  ghmm_cmodel_class_change_context *cc = smo->class_change;
+  int t;
+
+  if (smo->cos == 1) {
+    for (t = 0; t < T - 1; t++)
+      classes[t] = 0;
+    return (0);
+  }
+  if (!cc || (!cc->get_class && !cc->get_class_sequence)) {
+    GHMM_LOG(LERROR, "get_class not initialized");
+    return (-1);
+  }
+  if (cc->get_class_sequence) {
+    if (T > 1 && cc->get_class_sequence (smo, O, k, T, classes) == -1) {
+      GHMM_LOG(LERROR, "get_class_sequence failed");
+      return (-1);
+    }
+  }
+  else
+    for (t = 0; t < T - 1; t++)
+      classes[t] = cc->get_class (smo, O, k, t);
+
+  for (t = 0; t < T - 1; t++)
+    if (classes[t] < 0 || classes[t] >= smo->cos) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "get_class returned index %d at %d but "
+                      "model has only %d classes!", classes[t], t, smo->cos);
+      return (-1);
+    }
+  return (0);
+# undef CUR_PROC
+}
+
 #ifdef GHMM_OBSOLETE
 /*----------------------------------------------------------------------------*/
 static int smodel_copy_vectors (ghmm_cmodel * smo, int index, double *pi, int *fix,
@@ -765,7 +804,7 @@ int ghmm_cmodel_free (ghmm_cmodel ** smo)
   ghmm_cstate *state;
   mes_check_ptr (smo, return (-1));
 
-  for (i = 0; i < (*smo)->N && (*smo)->s; i++) {
+  for (i = 0; i < (*smo)->N && (*smo)->s && !(*smo)->snapshot; i++) {
     state = (*smo)->s + i;
     /* if there are no out_states field was never allocated */ 
     if (state->out_states > 0){
@@ -784,6 +823,8 @@ int ghmm_cmodel_free (ghmm_cmodel ** smo)
         ghmm_c_emission_free(state->e+j);
     m_free (state->e);
   }
+  if ((*smo)->snapshot)
+    ghmm_snapshot_free ((*smo)->snapshot);
   if ((*smo)->s) m_free ((*smo)->s);
 
   if ((*smo)->class_change) {
@@ -851,7 +892,19 @@ ghmm_cmodel *ghmm_cmodel_copy (const ghmm_cmodel * smo)
 
         ARRAY_CALLOC(sm2->s[i].e[j].variance.mat, dim*dim);
         memcpy(sm2->s[i].e[j].variance.mat, smo->s[i].e[j].variance.mat,
-               dim * sizeof(*(sm2->s[i].e[j].variance.mat)));
+               dim * dim * sizeof(*(sm2->s[i].e[j].variance.mat)));
+
+        /* the copy must not share the derived matrices either */
+        if (smo->s[i].e[j].sigmainv) {
+          ARRAY_MALLOC(sm2->s[i].e[j].sigmainv, dim*dim);
+          memcpy(sm2->s[i].e[j].sigmainv, smo->s[i].e[j].sigmainv,
+                 dim * dim * sizeof(*(sm2->s[i].e[j].sigmainv)));
+        }
+        if (smo->s[i].e[j].sigmacd) {
+          ARRAY_MALLOC(sm2->s[i].e[j].sigmacd, dim*dim);
+          memcpy(sm2->s[i].e[j].sigmacd, smo->s[i].e[j].sigmacd,
+                 dim * dim * sizeof(*(sm2->s[i].e[j].sigmacd)));
+        }
       }
 
     sm2->s[i].M = smo->s[i].M;
@@ -861,6 +914,7 @@ ghmm_cmodel *ghmm_cmodel_copy (const ghmm_cmodel * smo)
     sm2->s[i].in_states = vorg;
   }
   sm2->cos = smo->cos;
+  sm2->model_type = smo->model_type;
   sm2->N = smo->N;
   sm2->M = smo->M;
   sm2->prior = smo->prior;
@@ -1088,7 +1142,7 @@ ghmm_cseq *ghmm_cmodel_generate_sequences (ghmm_cmodel * smo, int seed,
     /* Test: A new seed for each sequence */
     /*   ghmm_rng_timeseed(RNG); */
     stillbadseq = badseq = 0;
-    ARRAY_CALLOC (sq->seq[n], len*(smo->dim));
+    ARRAY_CALLOC (sq->seq[n], (size_t) len * smo->dim);
 
     /* Get a random initial state i */
     p = GHMM_RNG_UNIFORM (RNG);
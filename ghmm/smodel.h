@@ -165,6 +165,12 @@ extern "C" {
     /** pointer to class function */
     int (*get_class) (struct ghmm_cmodel *, const double *, int, int);
 
+    /** optional: computes the classes of all T - 1 transitions of a
+        sequence of T time points at once, classes[t] is the class of the
+        transition from t to t + 1. Returns 0 on success, -1 on error.
+        Used instead of get_class if set */
+    int (*get_class_sequence) (struct ghmm_cmodel *, const double *, int, int,
+                               int *);
 
     /* space for any data necessary for class switch, USER is RESPONSIBLE */
     void *user_data;
@@ -204,6 +210,10 @@ extern "C" {
        classes */
     ghmm_cmodel_class_change_context *class_change;
 
+  /** Snapshot file the arrays of the states point into (see snapshot.h),
+      NULL for models allocated by the library */
+    struct ghmm_snapshot *snapshot;
+
   } ghmm_cmodel;
 
 
@@ -213,6 +223,21 @@ extern "C" {
 
   int ghmm_cmodel_class_change_alloc (ghmm_cmodel * smo);
 
+/**
+   Computes the transition classes of a sequence once, so that the
+   algorithms do not have to call back into get_class in every time step.
+   classes[t] is the class of the transition from time t to t + 1.
+   For models with one class all entries are 0.
+   @return 0: success, -1: error (no class function or invalid class)
+   @param smo      model
+   @param O        sequence
+   @param k        index of the sequence in its sequence set
+   @param T        number of time points of O (not the number of values)
+   @param classes  array of at least T - 1 entries
+*/
+  int ghmm_cmodel_get_class_sequence (ghmm_cmodel * smo, const double *O,
+                                      int k, int T, int *classes);
+
 /** Allocates the multivariate arrays of a ghmm_c_emmission struct
     @return 0: success, -1: error
     @param emissions   address of ghmm_c_emission
@@ -438,7 +463,9 @@ extern "C" {
 */
   double ghmm_cmodel_calc_b(ghmm_cstate *state, const double *omega);
 
-/** Computes probabilistic distance of two models
+/** Computes probabilistic distance of two models, serially from one
+    sample. ghmm_cmodel_distance_mc (distance.h) estimates it in parallel
+    with a confidence interval.
     @return the distance
     @param cm0  ghmm_cmodel used for generating random output
     @param cm   ghmm_cmodel to compare with
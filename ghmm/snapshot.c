@@ -0,0 +1,1219 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/snapshot.c
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef HAVE_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+#endif
+
+#include "ghmm.h"
+#include "mes.h"
+#include "model.h"
+#include "smodel.h"
+#include "snapshot.h"
+#include "ghmm_internals.h"
+
+#define SNAPSHOT_MAGIC "GHMMSNAP"
+#define SNAPSHOT_VERSION 1
+/* written in the byte order of the writer, a reader with the other byte
+   order sees 0x04030201 */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+/* every section starts at a multiple of this */
+#define SNAPSHOT_ALIGN 8
+#define SNAPSHOT_MAX_SECTIONS 32
+
+/* Section tags. Per state arrays are indexed by a row array of N + 1
+   entries (compressed sparse rows). Readers skip unknown tags. */
+enum {
+  SEC_NAME = 1,         /* char: model name, one string */
+  SEC_PI,               /* double N */
+  SEC_FIX,              /* int N */
+  SEC_POSITION,         /* int 2N: x and y of every state */
+  SEC_DESC,             /* char: N strings, empty for none */
+  SEC_OUT_PTR,          /* int N + 1: first outgoing transition of a state */
+  SEC_OUT_ID,           /* int E */
+  SEC_OUT_A,            /* double cos * E: per state one row per class */
+  SEC_IN_PTR,           /* same for the incoming transitions */
+  SEC_IN_ID,
+  SEC_IN_A,
+  SEC_B_PTR,            /* int N + 1: first emission of a state */
+  SEC_B,                /* double */
+  SEC_SILENT,           /* int N, the flag arrays exist with their flag */
+  SEC_TIED,
+  SEC_ORDER,
+  SEC_LABEL,
+  SEC_BACKGROUND_ID,
+  SEC_BG_ORDER,         /* int n */
+  SEC_BG_B,             /* double: M^(order + 1) per background */
+  SEC_BG_NAME,          /* char: n strings */
+  SEC_ALPHABET,         /* char: description and size symbols */
+  SEC_LABEL_ALPHABET,
+  SEC_COMP_PTR,         /* int N + 1: first mixture component of a state */
+  SEC_C,                /* double K: component weights */
+  SEC_E_INFO,           /* int 3K: type, dimension, fixed */
+  SEC_E_PARAM,          /* double 5K: mean, variance, min, max, det */
+  SEC_E_MEAN,           /* double dim * K, multivariate models only */
+  SEC_E_VARIANCE,       /* double dim * dim * K, multivariate models only */
+  SEC_E_SIGMAINV,
+  SEC_E_SIGMACD
+};
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  int32_t model_type;
+  int32_t N;
+  int32_t M;
+  int32_t dim;
+  int32_t cos;
+  int32_t maxorder;
+  double prior;
+  uint32_t sections;
+  /* sizeof(int) of the writer, the int arrays are stored as they are */
+  uint32_t int_size;
+  /* size of the whole file */
+  uint64_t size;
+} snapshot_header;
+
+typedef struct {
+  uint32_t tag;
+  /* number of elements (or strings) */
+  uint32_t count;
+  uint64_t offset;
+  uint64_t bytes;
+} snapshot_section;
+
+struct ghmm_snapshot {
+  /* the file, mapped or read into memory */
+  char *base;
+  size_t size;
+  int mapped;
+  /* row pointers of the transition matrices of continuous models */
+  double **rows;
+  /* mixture components of continuous models */
+  ghmm_c_emission *emissions;
+};
+
+/* sections collected before writing */
+typedef struct {
+  snapshot_section table[SNAPSHOT_MAX_SECTIONS];
+  void *data[SNAPSHOT_MAX_SECTIONS];
+  int n;
+} snapshot_out;
+
+
+/*============================================================================*/
+/* adds a section of count elements, returns its zeroed buffer */
+static void *out_section (snapshot_out * out, uint32_t tag, size_t count,
+                          size_t size)
+{
+#define CUR_PROC "out_section"
+  char *data = NULL;
+
+  if (out->n == SNAPSHOT_MAX_SECTIONS || count > UINT32_MAX) {
+    GHMM_LOG(LERROR, "too many sections or elements for a snapshot");
+    return NULL;
+  }
+  ARRAY_CALLOC (data, count * size);
+  out->table[out->n].tag = tag;
+  out->table[out->n].count = count;
+  out->table[out->n].bytes = count * size;
+  out->data[out->n++] = data;
+  return data;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return NULL;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* adds a section of n strings, NULL is stored as empty string */
+static int out_strings (snapshot_out * out, uint32_t tag, char *const *strings,
+                        int n)
+{
+  size_t bytes = 0;
+  char *data;
+  int i;
+
+  for (i = 0; i < n; i++)
+    bytes += (strings[i] ? strlen (strings[i]) : 0) + 1;
+  if (!(data = out_section (out, tag, bytes, 1)))
+    return -1;
+  out->table[out->n - 1].count = n;
+  for (i = 0; i < n; i++) {
+    if (strings[i])
+      strcpy (data, strings[i]);
+    data += strlen (data) + 1;
+  }
+  return 0;
+}
+
+/*============================================================================*/
+/* adds the description and the symbols of an alphabet */
+static int out_alphabet (snapshot_out * out, uint32_t tag, ghmm_alphabet * a)
+{
+#define CUR_PROC "out_alphabet"
+  char **strings = NULL;
+  int res = -1;
+
+  ARRAY_MALLOC (strings, a->size + 1);
+  strings[0] = a->description;
+  memcpy (strings + 1, a->symbols, a->size * sizeof (char *));
+  res = out_strings (out, tag, strings, a->size + 1);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  m_free (strings);
+  return res;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+static int out_write (snapshot_out * out, snapshot_header * header,
+                      const char *filename)
+{
+#define CUR_PROC "out_write"
+  static const char zeros[SNAPSHOT_ALIGN];
+  uint64_t offset;
+  FILE *file;
+  int i, res = 0;
+
+  offset = sizeof (*header) + out->n * sizeof (snapshot_section);
+  for (i = 0; i < out->n; i++) {
+    offset = m_align (offset, SNAPSHOT_ALIGN);
+    out->table[i].offset = offset;
+    offset += out->table[i].bytes;
+  }
+  header->sections = out->n;
+  header->size = offset;
+
+  if (!(file = fopen (filename, "wb"))) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "could not open %s for writing", filename);
+    return -1;
+  }
+  offset = sizeof (*header) + out->n * sizeof (snapshot_section);
+  if (fwrite (header, sizeof (*header), 1, file) != 1
+      || fwrite (out->table, sizeof (snapshot_section), out->n, file)
+      != (size_t) out->n)
+    res = -1;
+  for (i = 0; i < out->n && !res; i++) {
+    if (fwrite (zeros, 1, out->table[i].offset - offset, file)
+        != out->table[i].offset - offset
+        || fwrite (out->data[i], 1, out->table[i].bytes, file)
+        != out->table[i].bytes)
+      res = -1;
+    offset = out->table[i].offset + out->table[i].bytes;
+  }
+  if (fclose (file) || res) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "could not write %s", filename);
+    return -1;
+  }
+  return 0;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+static void out_free (snapshot_out * out)
+{
+#define CUR_PROC "out_free"
+  int i;
+  for (i = 0; i < out->n; i++)
+    m_free (out->data[i]);
+  out->n = 0;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+static void out_header (snapshot_header * header, int model_type, int N, int M,
+                        int dim, int cos, int maxorder, double prior)
+{
+  memset (header, 0, sizeof (*header));
+  memcpy (header->magic, SNAPSHOT_MAGIC, sizeof (header->magic));
+  header->version = SNAPSHOT_VERSION;
+  header->byte_order = SNAPSHOT_BYTE_ORDER;
+  header->model_type = model_type;
+  header->N = N;
+  header->M = M;
+  header->dim = dim;
+  header->cos = cos;
+  header->maxorder = maxorder;
+  header->prior = prior;
+  header->int_size = sizeof (int);
+}
+
+/*============================================================================*/
+/* adds the state fields both model types have in common */
+static int out_states (snapshot_out * out, int N, const double *pi,
+                       const int *fix, const int *pos, char *const *desc)
+{
+  void *data;
+
+  if (!(data = out_section (out, SEC_PI, N, sizeof (double))))
+    return -1;
+  memcpy (data, pi, N * sizeof (double));
+  if (!(data = out_section (out, SEC_FIX, N, sizeof (int))))
+    return -1;
+  memcpy (data, fix, N * sizeof (int));
+  if (!(data = out_section (out, SEC_POSITION, 2 * N, sizeof (int))))
+    return -1;
+  memcpy (data, pos, 2 * N * sizeof (int));
+  return out_strings (out, SEC_DESC, desc, N);
+}
+
+/*============================================================================*/
+/* adds the row array of count entries per state, returns it */
+static int *out_rows (snapshot_out * out, uint32_t tag, int N, const int *count)
+{
+#define CUR_PROC "out_rows"
+  int *ptr;
+  int i;
+
+  if (!(ptr = out_section (out, tag, N + 1, sizeof (int))))
+    return NULL;
+  for (i = 0; i < N; i++) {
+    if (ptr[i] > INT_MAX - count[i]) {
+      GHMM_LOG(LERROR, "too many entries for a snapshot");
+      return NULL;
+    }
+    ptr[i + 1] = ptr[i] + count[i];
+  }
+  return ptr;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+int ghmm_dmodel_snapshot_write (const ghmm_dmodel * mo, const char *filename)
+{
+#define CUR_PROC "ghmm_dmodel_snapshot_write"
+  snapshot_out out;
+  snapshot_header header;
+  int *count = NULL, *pos = NULL, *fix = NULL;
+  double *pi = NULL;
+  char **desc = NULL;
+  int *ptr, *ids, *ints;
+  double *values;
+  int i, j, n, size, res = -1;
+  struct { int flag; uint32_t tag; int *field; } flags[] = {
+    {GHMM_kSilentStates, SEC_SILENT, mo->silent},
+    {GHMM_kTiedEmissions, SEC_TIED, mo->tied_to},
+    {GHMM_kHigherOrderEmissions, SEC_ORDER, mo->order},
+    {GHMM_kLabeledStates, SEC_LABEL, mo->label},
+    {GHMM_kBackgroundDistributions, SEC_BACKGROUND_ID, mo->background_id}
+  };
+
+  out.n = 0;
+  if (mo->model_type & (GHMM_kPairHMM | GHMM_kTransitionClasses)) {
+    GHMM_LOG(LERROR, "no snapshots of pair models or transition classes");
+    return -1;
+  }
+  out_header (&header, mo->model_type, mo->N, mo->M, 1, 1, mo->maxorder,
+              mo->prior);
+
+  ARRAY_MALLOC (count, mo->N);
+  ARRAY_MALLOC (pi, mo->N);
+  ARRAY_MALLOC (fix, mo->N);
+  ARRAY_MALLOC (pos, 2 * mo->N);
+  ARRAY_MALLOC (desc, mo->N);
+  for (i = 0; i < mo->N; i++) {
+    pi[i] = mo->s[i].pi;
+    fix[i] = mo->s[i].fix;
+    pos[2 * i] = mo->s[i].xPosition;
+    pos[2 * i + 1] = mo->s[i].yPosition;
+    desc[i] = mo->s[i].desc;
+  }
+  if (out_strings (&out, SEC_NAME, &mo->name, 1)
+      || out_states (&out, mo->N, pi, fix, pos, desc))
+    goto STOP;
+
+  /* transitions */
+  for (i = 0; i < mo->N; i++)
+    count[i] = mo->s[i].out_states;
+  if (!(ptr = out_rows (&out, SEC_OUT_PTR, mo->N, count))
+      || !(ids = out_section (&out, SEC_OUT_ID, ptr[mo->N], sizeof (int)))
+      || !(values = out_section (&out, SEC_OUT_A, ptr[mo->N], sizeof (double))))
+    goto STOP;
+  for (i = 0; i < mo->N; i++) {
+    memcpy (ids + ptr[i], mo->s[i].out_id, count[i] * sizeof (int));
+    memcpy (values + ptr[i], mo->s[i].out_a, count[i] * sizeof (double));
+  }
+  for (i = 0; i < mo->N; i++)
+    count[i] = mo->s[i].in_states;
+  if (!(ptr = out_rows (&out, SEC_IN_PTR, mo->N, count))
+      || !(ids = out_section (&out, SEC_IN_ID, ptr[mo->N], sizeof (int)))
+      || !(values = out_section (&out, SEC_IN_A, ptr[mo->N], sizeof (double))))
+    goto STOP;
+  for (i = 0; i < mo->N; i++) {
+    memcpy (ids + ptr[i], mo->s[i].in_id, count[i] * sizeof (int));
+    memcpy (values + ptr[i], mo->s[i].in_a, count[i] * sizeof (double));
+  }
+
+  /* emissions, M^(order + 1) per state */
+  for (i = 0; i < mo->N; i++)
+    if (mo->model_type & GHMM_kHigherOrderEmissions)
+      count[i] = ghmm_ipow (mo, mo->M, mo->order[i] + 1);
+    else
+      count[i] = mo->M;
+  if (!(ptr = out_rows (&out, SEC_B_PTR, mo->N, count))
+      || !(values = out_section (&out, SEC_B, ptr[mo->N], sizeof (double))))
+    goto STOP;
+  for (i = 0; i < mo->N; i++)
+    memcpy (values + ptr[i], mo->s[i].b, count[i] * sizeof (double));
+
+  for (j = 0; j < (int) (sizeof (flags) / sizeof (flags[0])); j++)
+    if (mo->model_type & flags[j].flag) {
+      if (!(ints = out_section (&out, flags[j].tag, mo->N, sizeof (int))))
+        goto STOP;
+      memcpy (ints, flags[j].field, mo->N * sizeof (int));
+    }
+
+  if (mo->model_type & GHMM_kBackgroundDistributions) {
+    n = mo->bp->n;
+    if (!(ints = out_section (&out, SEC_BG_ORDER, n, sizeof (int))))
+      goto STOP;
+    memcpy (ints, mo->bp->order, n * sizeof (int));
+    for (i = 0, size = 0; i < n; i++)
+      size += ghmm_ipow (mo, mo->M, mo->bp->order[i] + 1);
+    if (!(values = out_section (&out, SEC_BG_B, size, sizeof (double))))
+      goto STOP;
+    for (i = 0; i < n; i++) {
+      size = ghmm_ipow (mo, mo->M, mo->bp->order[i] + 1);
+      memcpy (values, mo->bp->b[i], size * sizeof (double));
+      values += size;
+    }
+    if (out_strings (&out, SEC_BG_NAME, mo->bp->name, n))
+      goto STOP;
+  }
+
+  if (mo->alphabet && out_alphabet (&out, SEC_ALPHABET, mo->alphabet))
+    goto STOP;
+  if (mo->label_alphabet
+      && out_alphabet (&out, SEC_LABEL_ALPHABET, mo->label_alphabet))
+    goto STOP;
+
+  res = out_write (&out, &header, filename);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  out_free (&out);
+  if (count)
+    m_free (count);
+  if (pi)
+    m_free (pi);
+  if (fix)
+    m_free (fix);
+  if (pos)
+    m_free (pos);
+  if (desc)
+    m_free (desc);
+  return res;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+int ghmm_cmodel_snapshot_write (const ghmm_cmodel * smo, const char *filename)
+{
+#define CUR_PROC "ghmm_cmodel_snapshot_write"
+  snapshot_out out;
+  snapshot_header header;
+  int *count = NULL, *pos = NULL, *fix = NULL;
+  double *pi = NULL;
+  char **desc = NULL;
+  int *ptr, *ids, *info;
+  double *values, *param, *mean = NULL, *var = NULL, *inv = NULL, *cd = NULL;
+  ghmm_c_emission *e;
+  int i, j, c, k, dim, multi, nout, nin, res = -1;
+
+  out.n = 0;
+  multi = smo->model_type & GHMM_kMultivariate;
+  dim = multi ? smo->dim : 1;
+  out_header (&header, smo->model_type, smo->N, smo->M, dim, smo->cos, 0,
+              smo->prior);
+
+  ARRAY_MALLOC (count, smo->N);
+  ARRAY_MALLOC (pi, smo->N);
+  ARRAY_MALLOC (fix, smo->N);
+  ARRAY_MALLOC (pos, 2 * smo->N);
+  ARRAY_MALLOC (desc, smo->N);
+  for (i = 0; i < smo->N; i++) {
+    pi[i] = smo->s[i].pi;
+    fix[i] = smo->s[i].fix;
+    pos[2 * i] = smo->s[i].xPosition;
+    pos[2 * i + 1] = smo->s[i].yPosition;
+    desc[i] = smo->s[i].desc;
+  }
+  if (out_strings (&out, SEC_NAME, &smo->name, 1)
+      || out_states (&out, smo->N, pi, fix, pos, desc))
+    goto STOP;
+
+  /* transitions, the rows of all classes of a state follow each other */
+  for (i = 0; i < smo->N; i++)
+    count[i] = smo->s[i].out_states;
+  if (!(ptr = out_rows (&out, SEC_OUT_PTR, smo->N, count))
+      || !(ids = out_section (&out, SEC_OUT_ID, ptr[smo->N], sizeof (int)))
+      || !(values = out_section (&out, SEC_OUT_A, (size_t) smo->cos * ptr[smo->N],
+                                 sizeof (double))))
+    goto STOP;
+  for (i = 0; i < smo->N; i++) {
+    nout = count[i];
+    memcpy (ids + ptr[i], smo->s[i].out_id, nout * sizeof (int));
+    for (c = 0; c < smo->cos; c++)
+      memcpy (values + (size_t) smo->cos * ptr[i] + c * nout,
+              smo->s[i].out_a[c], nout * sizeof (double));
+  }
+  for (i = 0; i < smo->N; i++)
+    count[i] = smo->s[i].in_states;
+  if (!(ptr = out_rows (&out, SEC_IN_PTR, smo->N, count))
+      || !(ids = out_section (&out, SEC_IN_ID, ptr[smo->N], sizeof (int)))
+      || !(values = out_section (&out, SEC_IN_A, (size_t) smo->cos * ptr[smo->N],
+                                 sizeof (double))))
+    goto STOP;
+  for (i = 0; i < smo->N; i++) {
+    nin = count[i];
+    memcpy (ids + ptr[i], smo->s[i].in_id, nin * sizeof (int));
+    for (c = 0; c < smo->cos; c++)
+      memcpy (values + (size_t) smo->cos * ptr[i] + c * nin,
+              smo->s[i].in_a[c], nin * sizeof (double));
+  }
+
+  /* mixture components */
+  for (i = 0; i < smo->N; i++)
+    count[i] = smo->s[i].M;
+  if (!(ptr = out_rows (&out, SEC_COMP_PTR, smo->N, count))
+      || !(values = out_section (&out, SEC_C, ptr[smo->N], sizeof (double)))
+      || !(info = out_section (&out, SEC_E_INFO, 3 * (size_t) ptr[smo->N],
+                               sizeof (int)))
+      || !(param = out_section (&out, SEC_E_PARAM, 5 * (size_t) ptr[smo->N],
+                                sizeof (double))))
+    goto STOP;
+  if (multi
+      && (!(mean = out_section (&out, SEC_E_MEAN, (size_t) dim * ptr[smo->N],
+                                sizeof (double)))
+          || !(var = out_section (&out, SEC_E_VARIANCE,
+                                  (size_t) dim * dim * ptr[smo->N],
+                                  sizeof (double)))
+          || !(inv = out_section (&out, SEC_E_SIGMAINV,
+                                  (size_t) dim * dim * ptr[smo->N],
+                                  sizeof (double)))
+          || !(cd = out_section (&out, SEC_E_SIGMACD,
+                                 (size_t) dim * dim * ptr[smo->N],
+                                 sizeof (double)))))
+    goto STOP;
+  for (i = 0; i < smo->N; i++)
+    for (j = 0; j < smo->s[i].M; j++) {
+      k = ptr[i] + j;
+      e = smo->s[i].e + j;
+      values[k] = smo->s[i].c[j];
+      info[3 * k] = e->type;
+      info[3 * k + 1] = e->dimension;
+      info[3 * k + 2] = e->fixed;
+      param[5 * k + 2] = e->min;
+      param[5 * k + 3] = e->max;
+      param[5 * k + 4] = e->det;
+      if ((e->type == multinormal || e->type == binormal) && e->dimension > 1) {
+        if (!multi || e->dimension != dim) {
+          GHMM_LOG(LERROR, "multivariate component in a model of other dimension");
+          goto STOP;
+        }
+        memcpy (mean + (size_t) k * dim, e->mean.vec, dim * sizeof (double));
+        memcpy (var + (size_t) k * dim * dim, e->variance.mat,
+                dim * dim * sizeof (double));
+        if (e->sigmainv)
+          memcpy (inv + (size_t) k * dim * dim, e->sigmainv,
+                  dim * dim * sizeof (double));
+        if (e->sigmacd)
+          memcpy (cd + (size_t) k * dim * dim, e->sigmacd,
+                  dim * dim * sizeof (double));
+      }
+      else {
+        param[5 * k] = e->mean.val;
+        param[5 * k + 1] = e->variance.val;
+      }
+    }
+
+  res = out_write (&out, &header, filename);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  out_free (&out);
+  if (count)
+    m_free (count);
+  if (pi)
+    m_free (pi);
+  if (fix)
+    m_free (fix);
+  if (pos)
+    m_free (pos);
+  if (desc)
+    m_free (desc);
+  return res;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+void ghmm_snapshot_free (struct ghmm_snapshot *snapshot)
+{
+#define CUR_PROC "ghmm_snapshot_free"
+  if (!snapshot)
+    return;
+#ifdef HAVE_MMAP
+  if (snapshot->mapped)
+    munmap (snapshot->base, snapshot->size);
+  else
+#endif
+  if (snapshot->base)
+    m_free (snapshot->base);
+  if (snapshot->rows)
+    m_free (snapshot->rows);
+  if (snapshot->emissions)
+    m_free (snapshot->emissions);
+  m_free (snapshot);
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* maps the file (or reads it where mmap is missing) and checks the header
+   and the section table */
+static struct ghmm_snapshot *snapshot_open (const char *filename)
+{
+#define CUR_PROC "snapshot_open"
+  struct ghmm_snapshot *snap = NULL;
+  snapshot_header *header;
+  snapshot_section *table;
+  uint32_t i;
+#ifdef HAVE_MMAP
+  struct stat st;
+  int fd;
+#else
+  FILE *file;
+  long size;
+#endif
+
+  ARRAY_CALLOC (snap, 1);
+#ifdef HAVE_MMAP
+  if ((fd = open (filename, O_RDONLY)) < 0 || fstat (fd, &st)) {
+    if (fd >= 0)
+      close (fd);
+    GHMM_LOG_PRINTF(LERROR, LOC, "could not open %s", filename);
+    goto STOP;
+  }
+  snap->size = st.st_size;
+  /* private and writable: training the model copies the touched pages */
+  if (snap->size >= sizeof (*header))
+    snap->base = mmap (NULL, snap->size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       fd, 0);
+  close (fd);
+  if (snap->size < sizeof (*header) || snap->base == MAP_FAILED) {
+    snap->base = NULL;
+    GHMM_LOG_PRINTF(LERROR, LOC, "could not map %s", filename);
+    goto STOP;
+  }
+  snap->mapped = 1;
+#else
+  if (!(file = fopen (filename, "rb"))) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "could not open %s", filename);
+    goto STOP;
+  }
+  if (fseek (file, 0, SEEK_END) || (size = ftell (file)) < 0
+      || fseek (file, 0, SEEK_SET)) {
+    fclose (file);
+    GHMM_LOG_PRINTF(LERROR, LOC, "could not read %s", filename);
+    goto STOP;
+  }
+  snap->size = size;
+  if (!(snap->base = ighmm_malloc (snap->size))) {
+    fclose (file);
+    goto STOP;
+  }
+  if (fread (snap->base, 1, snap->size, file) != snap->size
+      || snap->size < sizeof (*header)) {
+    fclose (file);
+    GHMM_LOG_PRINTF(LERROR, LOC, "could not read %s", filename);
+    goto STOP;
+  }
+  fclose (file);
+#endif
+
+  header = (snapshot_header *) snap->base;
+  if (memcmp (header->magic, SNAPSHOT_MAGIC, sizeof (header->magic))) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "%s is no model snapshot", filename);
+    goto STOP;
+  }
+  if (header->version != SNAPSHOT_VERSION
+      || header->byte_order != SNAPSHOT_BYTE_ORDER
+      || header->int_size != sizeof (int)) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "%s was written by an incompatible version "
+                    "or machine", filename);
+    goto STOP;
+  }
+  if (header->size != snap->size || header->N < 1
+      || header->sections > (snap->size - sizeof (*header))
+      / sizeof (snapshot_section)) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "%s is truncated or corrupt", filename);
+    goto STOP;
+  }
+  table = (snapshot_section *) (header + 1);
+  for (i = 0; i < header->sections; i++)
+    if (table[i].offset % SNAPSHOT_ALIGN || table[i].offset > snap->size
+        || table[i].bytes > snap->size - table[i].offset) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "%s is truncated or corrupt", filename);
+      goto STOP;
+    }
+  return snap;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ghmm_snapshot_free (snap);
+  return NULL;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* returns the data of a section with count elements of size bytes,
+   NULL if it is missing or has another size */
+static void *snapshot_get (struct ghmm_snapshot *snap, uint32_t tag,
+                           size_t count, size_t size)
+{
+#define CUR_PROC "snapshot_get"
+  snapshot_header *header = (snapshot_header *) snap->base;
+  snapshot_section *table = (snapshot_section *) (header + 1);
+  uint32_t i;
+
+  for (i = 0; i < header->sections; i++)
+    if (table[i].tag == tag) {
+      if (table[i].count != count || table[i].bytes != count * size)
+        break;
+      return snap->base + table[i].offset;
+    }
+  GHMM_LOG_PRINTF(LERROR, LOC, "section %u of the snapshot is missing or "
+                  "has the wrong size", tag);
+  return NULL;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* returns the first of count strings, NULL if they are not terminated */
+static char *snapshot_strings (struct ghmm_snapshot *snap, uint32_t tag,
+                               uint32_t count)
+{
+#define CUR_PROC "snapshot_strings"
+  snapshot_header *header = (snapshot_header *) snap->base;
+  snapshot_section *table = (snapshot_section *) (header + 1);
+  uint32_t i, n = 0;
+  uint64_t j;
+  char *data;
+
+  for (i = 0; i < header->sections; i++)
+    if (table[i].tag == tag) {
+      data = snap->base + table[i].offset;
+      for (j = 0; j < table[i].bytes; j++)
+        n += !data[j];
+      if (table[i].count != count || n != count || !table[i].bytes
+          || data[table[i].bytes - 1])
+        break;
+      return data;
+    }
+  GHMM_LOG_PRINTF(LERROR, LOC, "section %u of the snapshot is missing or "
+                  "corrupt", tag);
+  return NULL;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* returns the number of elements of a section, -1 if it is missing */
+static long snapshot_count (struct ghmm_snapshot *snap, uint32_t tag)
+{
+  snapshot_header *header = (snapshot_header *) snap->base;
+  snapshot_section *table = (snapshot_section *) (header + 1);
+  uint32_t i;
+
+  for (i = 0; i < header->sections; i++)
+    if (table[i].tag == tag)
+      return table[i].count;
+  return -1;
+}
+
+/*============================================================================*/
+/* M^n, -1 if it does not fit into an int */
+static int snapshot_pow (int M, int n)
+{
+  int i, res = 1;
+
+  for (i = 0; i < n; i++) {
+    if (res > INT_MAX / M)
+      return -1;
+    res *= M;
+  }
+  return res;
+}
+
+/*============================================================================*/
+/* copies a string of the snapshot, NULL for the empty string */
+static int snapshot_strdup (char **dest, const char *src)
+{
+#define CUR_PROC "snapshot_strdup"
+  *dest = NULL;
+  if (!*src)
+    return 0;
+  ARRAY_MALLOC (*dest, strlen (src) + 1);
+  strcpy (*dest, src);
+  return 0;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return -1;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* returns the row array of a section, checks that it runs from 0 upwards */
+static int *snapshot_rows (struct ghmm_snapshot *snap, uint32_t tag, int N)
+{
+#define CUR_PROC "snapshot_rows"
+  int *ptr;
+  int i;
+
+  if (!(ptr = snapshot_get (snap, tag, N + 1, sizeof (int))))
+    return NULL;
+  for (i = 0; i < N; i++)
+    if (ptr[i] > ptr[i + 1])
+      break;
+  if (ptr[0] || i < N) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "section %u of the snapshot is corrupt", tag);
+    return NULL;
+  }
+  return ptr;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* finds the transitions of one direction and checks the state ids */
+static int snapshot_transitions (struct ghmm_snapshot *snap, uint32_t tag,
+                                 int N, int cos, int **ptr, int **id,
+                                 double **a)
+{
+#define CUR_PROC "snapshot_transitions"
+  int i;
+
+  if (!(*ptr = snapshot_rows (snap, tag, N))
+      || !(*id = snapshot_get (snap, tag + 1, (*ptr)[N], sizeof (int)))
+      || !(*a = snapshot_get (snap, tag + 2, (size_t) cos * (*ptr)[N],
+                              sizeof (double))))
+    return -1;
+  for (i = 0; i < (*ptr)[N]; i++)
+    if ((*id)[i] < 0 || (*id)[i] >= N) {
+      GHMM_LOG(LERROR, "transition to a state that does not exist");
+      return -1;
+    }
+  return 0;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* reads an alphabet stored by out_alphabet */
+static ghmm_alphabet *snapshot_alphabet (struct ghmm_snapshot *snap,
+                                         uint32_t tag)
+{
+#define CUR_PROC "snapshot_alphabet"
+  ghmm_alphabet *a = NULL;
+  long count;
+  char *str;
+  unsigned int i;
+
+  if ((count = snapshot_count (snap, tag)) < 1
+      || !(str = snapshot_strings (snap, tag, count)))
+    return NULL;
+  ARRAY_CALLOC (a, 1);
+  a->size = count - 1;
+  ARRAY_CALLOC (a->symbols, a->size);
+  if (snapshot_strdup (&a->description, str))
+    goto STOP;
+  for (i = 0; i < a->size; i++) {
+    str += strlen (str) + 1;
+    /* symbols are never NULL */
+    ARRAY_MALLOC (a->symbols[i], strlen (str) + 1);
+    strcpy (a->symbols[i], str);
+  }
+  return a;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (a) {
+    for (i = 0; a->symbols && i < a->size; i++)
+      if (a->symbols[i])
+        m_free (a->symbols[i]);
+    if (a->symbols)
+      m_free (a->symbols);
+    if (a->description)
+      m_free (a->description);
+    m_free (a);
+  }
+  return NULL;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* copies an int array of N entries, checks that the values are in [min, max) */
+static int *snapshot_ints (struct ghmm_snapshot *snap, uint32_t tag, int N,
+                           int min, int max)
+{
+#define CUR_PROC "snapshot_ints"
+  int *src, *dest = NULL;
+  int i;
+
+  if (!(src = snapshot_get (snap, tag, N, sizeof (int))))
+    return NULL;
+  for (i = 0; i < N; i++)
+    if (src[i] < min || src[i] >= max) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "value %d of section %u of the snapshot "
+                      "is out of range", src[i], tag);
+      return NULL;
+    }
+  ARRAY_MALLOC (dest, N);
+  memcpy (dest, src, N * sizeof (int));
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  return dest;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+/* sets the state fields both model types have in common, the strings of the
+   descriptions are returned for the states one after the other */
+static int snapshot_states (struct ghmm_snapshot *snap, int N, double **pi,
+                            int **fix, int **pos, char **desc)
+{
+  if (!(*pi = snapshot_get (snap, SEC_PI, N, sizeof (double)))
+      || !(*fix = snapshot_get (snap, SEC_FIX, N, sizeof (int)))
+      || !(*pos = snapshot_get (snap, SEC_POSITION, 2 * N, sizeof (int)))
+      || !(*desc = snapshot_strings (snap, SEC_DESC, N)))
+    return -1;
+  return 0;
+}
+
+/*============================================================================*/
+/* the model name, NULL if it has none */
+static int snapshot_name (struct ghmm_snapshot *snap, char **name)
+{
+  char *str;
+
+  if (!(str = snapshot_strings (snap, SEC_NAME, 1)))
+    return -1;
+  return snapshot_strdup (name, str);
+}
+
+/*============================================================================*/
+ghmm_dmodel *ghmm_dmodel_snapshot_read (const char *filename)
+{
+#define CUR_PROC "ghmm_dmodel_snapshot_read"
+  struct ghmm_snapshot *snap;
+  snapshot_header *header;
+  ghmm_dmodel *mo = NULL;
+  ghmm_dstate *state;
+  int *out_ptr, *out_id, *in_ptr, *in_id, *b_ptr, *fix, *pos, *orders;
+  double *out_a, *in_a, *b, *pi;
+  char *desc, *str;
+  long n;
+  size_t size;
+  int i, j;
+
+  if (!(snap = snapshot_open (filename)))
+    return NULL;
+  header = (snapshot_header *) snap->base;
+  if (!(header->model_type & GHMM_kDiscreteHMM)
+      || (header->model_type & (GHMM_kPairHMM | GHMM_kTransitionClasses))
+      || header->M < 1 || header->maxorder < 0
+      || snapshot_pow (header->M, header->maxorder + 1) < 0) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "%s is no discrete model snapshot", filename);
+    ghmm_snapshot_free (snap);
+    return NULL;
+  }
+  if (!(mo = ighmm_calloc (sizeof (*mo)))) {
+    ghmm_snapshot_free (snap);
+    return NULL;
+  }
+  /* from here on freeing the model releases the snapshot */
+  mo->snapshot = snap;
+  mo->N = header->N;
+  mo->M = header->M;
+  mo->prior = header->prior;
+  mo->maxorder = header->maxorder;
+  mo->model_type = GHMM_kDiscreteHMM;
+  ARRAY_CALLOC (mo->s, mo->N);
+  if (snapshot_name (snap, &mo->name))
+    goto STOP;
+  ARRAY_MALLOC (mo->pow_lookup, mo->maxorder + 2);
+  for (i = 0; i < mo->maxorder + 2; i++)
+    mo->pow_lookup[i] = snapshot_pow (mo->M, i);
+
+  /* backgrounds are copied, like the other per model arrays below */
+  if (header->model_type & GHMM_kBackgroundDistributions) {
+    if ((n = snapshot_count (snap, SEC_BG_ORDER)) < 0
+        || !(orders = snapshot_get (snap, SEC_BG_ORDER, n, sizeof (int))))
+      goto STOP;
+    for (i = 0, size = 0; i < n; i++) {
+      if (orders[i] < 0 || snapshot_pow (mo->M, orders[i] + 1) < 0) {
+        GHMM_LOG(LERROR, "order of a background distribution is out of range");
+        goto STOP;
+      }
+      size += snapshot_pow (mo->M, orders[i] + 1);
+    }
+    if (!(b = snapshot_get (snap, SEC_BG_B, size, sizeof (double)))
+        || !(str = snapshot_strings (snap, SEC_BG_NAME, n))
+        || !(mo->bp = ghmm_dbackground_alloc (n, mo->M, NULL, NULL)))
+      goto STOP;
+    ARRAY_MALLOC (mo->bp->order, n);
+    memcpy (mo->bp->order, orders, n * sizeof (int));
+    ARRAY_CALLOC (mo->bp->b, n);
+    for (i = 0; i < n; i++) {
+      size = snapshot_pow (mo->M, orders[i] + 1);
+      ARRAY_MALLOC (mo->bp->b[i], size);
+      memcpy (mo->bp->b[i], b, size * sizeof (double));
+      b += size;
+      if (snapshot_strdup (mo->bp->name + i, str))
+        goto STOP;
+      str += strlen (str) + 1;
+    }
+    if (!(mo->background_id = snapshot_ints (snap, SEC_BACKGROUND_ID, mo->N,
+                                             GHMM_kNoBackgroundDistribution, n)))
+      goto STOP;
+    mo->model_type |= GHMM_kBackgroundDistributions;
+  }
+  /* each flag is set as soon as its array exists */
+  if (header->model_type & GHMM_kSilentStates) {
+    if (!(mo->silent = snapshot_ints (snap, SEC_SILENT, mo->N, 0, 2)))
+      goto STOP;
+    mo->model_type |= GHMM_kSilentStates;
+  }
+  if (header->model_type & GHMM_kTiedEmissions) {
+    if (!(mo->tied_to = snapshot_ints (snap, SEC_TIED, mo->N, GHMM_kUntied,
+                                       mo->N)))
+      goto STOP;
+    mo->model_type |= GHMM_kTiedEmissions;
+  }
+  if (header->model_type & GHMM_kHigherOrderEmissions) {
+    if (!(mo->order = snapshot_ints (snap, SEC_ORDER, mo->N, 0,
+                                     mo->maxorder + 1)))
+      goto STOP;
+    mo->model_type |= GHMM_kHigherOrderEmissions;
+  }
+  if (header->model_type & GHMM_kLabeledStates) {
+    if (!(mo->label = snapshot_ints (snap, SEC_LABEL, mo->N, INT_MIN, INT_MAX)))
+      goto STOP;
+    mo->model_type |= GHMM_kLabeledStates;
+  }
+  if (snapshot_count (snap, SEC_ALPHABET) >= 0
+      && !(mo->alphabet = snapshot_alphabet (snap, SEC_ALPHABET)))
+    goto STOP;
+  if (snapshot_count (snap, SEC_LABEL_ALPHABET) >= 0
+      && !(mo->label_alphabet = snapshot_alphabet (snap, SEC_LABEL_ALPHABET)))
+    goto STOP;
+
+  /* the arrays of the states point into the snapshot */
+  if (snapshot_states (snap, mo->N, &pi, &fix, &pos, &desc)
+      || snapshot_transitions (snap, SEC_OUT_PTR, mo->N, 1, &out_ptr, &out_id,
+                               &out_a)
+      || snapshot_transitions (snap, SEC_IN_PTR, mo->N, 1, &in_ptr, &in_id,
+                               &in_a)
+      || !(b_ptr = snapshot_rows (snap, SEC_B_PTR, mo->N))
+      || !(b = snapshot_get (snap, SEC_B, b_ptr[mo->N], sizeof (double))))
+    goto STOP;
+  for (i = 0; i < mo->N; i++) {
+    j = (mo->model_type & GHMM_kHigherOrderEmissions) ? mo->order[i] : 0;
+    if (b_ptr[i + 1] - b_ptr[i] != mo->pow_lookup[j + 1]) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "state %d has the wrong number of emissions",
+                      i);
+      goto STOP;
+    }
+    state = mo->s + i;
+    state->pi = pi[i];
+    state->b = b + b_ptr[i];
+    state->out_id = out_id + out_ptr[i];
+    state->out_a = out_a + out_ptr[i];
+    state->out_states = out_ptr[i + 1] - out_ptr[i];
+    state->in_id = in_id + in_ptr[i];
+    state->in_a = in_a + in_ptr[i];
+    state->in_states = in_ptr[i + 1] - in_ptr[i];
+    state->fix = fix[i];
+    state->xPosition = pos[2 * i];
+    state->yPosition = pos[2 * i + 1];
+    state->desc = *desc ? desc : NULL;
+    desc += strlen (desc) + 1;
+  }
+
+  mo->model_type = header->model_type & ~GHMM_kTransitionIndex;
+  if ((header->model_type & GHMM_kTransitionIndex)
+      && ghmm_dmodel_transition_index_build (mo))
+    goto STOP;
+  return mo;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (mo->bp && !(mo->model_type & GHMM_kBackgroundDistributions))
+    ghmm_dbackground_free (mo->bp);
+  ghmm_dmodel_free (&mo);
+  return NULL;
+#undef CUR_PROC
+}
+
+/*============================================================================*/
+ghmm_cmodel *ghmm_cmodel_snapshot_read (const char *filename)
+{
+#define CUR_PROC "ghmm_cmodel_snapshot_read"
+  struct ghmm_snapshot *snap;
+  snapshot_header *header;
+  ghmm_cmodel *smo = NULL;
+  ghmm_cstate *state;
+  ghmm_c_emission *e;
+  int *out_ptr, *out_id, *in_ptr, *in_id, *comp_ptr, *fix, *pos, *info;
+  double *out_a, *in_a, *c, *param, *pi, **rows;
+  double *mean = NULL, *var = NULL, *inv = NULL, *cd = NULL;
+  char *desc;
+  size_t dim, dim2, K;
+  int i, j, k, cls;
+
+  if (!(snap = snapshot_open (filename)))
+    return NULL;
+  header = (snapshot_header *) snap->base;
+  if (!(header->model_type & GHMM_kContinuousHMM) || header->M < 1
+      || header->cos < 1 || header->dim < 1
+      || (header->dim > 1 && !(header->model_type & GHMM_kMultivariate))) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "%s is no continuous model snapshot",
+                    filename);
+    ghmm_snapshot_free (snap);
+    return NULL;
+  }
+  if (!(smo = ighmm_calloc (sizeof (*smo)))) {
+    ghmm_snapshot_free (snap);
+    return NULL;
+  }
+  /* from here on freeing the model releases the snapshot */
+  smo->snapshot = snap;
+  smo->N = header->N;
+  smo->M = header->M;
+  smo->dim = header->dim;
+  smo->cos = header->cos;
+  smo->prior = header->prior;
+  smo->model_type = header->model_type;
+  ARRAY_CALLOC (smo->s, smo->N);
+  if (snapshot_name (snap, &smo->name)
+      || snapshot_states (snap, smo->N, &pi, &fix, &pos, &desc)
+      || snapshot_transitions (snap, SEC_OUT_PTR, smo->N, smo->cos, &out_ptr,
+                               &out_id, &out_a)
+      || snapshot_transitions (snap, SEC_IN_PTR, smo->N, smo->cos, &in_ptr,
+                               &in_id, &in_a)
+      || !(comp_ptr = snapshot_rows (snap, SEC_COMP_PTR, smo->N)))
+    goto STOP;
+  K = comp_ptr[smo->N];
+  dim = smo->dim;
+  dim2 = dim * dim;
+  if (!(c = snapshot_get (snap, SEC_C, K, sizeof (double)))
+      || !(info = snapshot_get (snap, SEC_E_INFO, 3 * K, sizeof (int)))
+      || !(param = snapshot_get (snap, SEC_E_PARAM, 5 * K, sizeof (double))))
+    goto STOP;
+  if ((smo->model_type & GHMM_kMultivariate)
+      && (!(mean = snapshot_get (snap, SEC_E_MEAN, dim * K, sizeof (double)))
+          || !(var = snapshot_get (snap, SEC_E_VARIANCE, dim2 * K,
+                                   sizeof (double)))
+          || !(inv = snapshot_get (snap, SEC_E_SIGMAINV, dim2 * K,
+                                   sizeof (double)))
+          || !(cd = snapshot_get (snap, SEC_E_SIGMACD, dim2 * K,
+                                  sizeof (double)))))
+    goto STOP;
+
+  /* row pointers of the transition classes and the mixture components are
+     the only arrays of the states not in the file */
+  ARRAY_MALLOC (snap->rows, 2 * (size_t) smo->N * smo->cos);
+  ARRAY_CALLOC (snap->emissions, K);
+  rows = snap->rows;
+  for (i = 0; i < smo->N; i++) {
+    state = smo->s + i;
+    state->pi = pi[i];
+    state->out_states = out_ptr[i + 1] - out_ptr[i];
+    state->out_id = out_id + out_ptr[i];
+    state->out_a = rows;
+    for (cls = 0; cls < smo->cos; cls++)
+      *rows++ = out_a + (size_t) smo->cos * out_ptr[i] + cls * state->out_states;
+    state->in_states = in_ptr[i + 1] - in_ptr[i];
+    state->in_id = in_id + in_ptr[i];
+    state->in_a = rows;
+    for (cls = 0; cls < smo->cos; cls++)
+      *rows++ = in_a + (size_t) smo->cos * in_ptr[i] + cls * state->in_states;
+    state->M = comp_ptr[i + 1] - comp_ptr[i];
+    if (state->M < 1 || state->M > smo->M) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "state %d has %d components", i, state->M);
+      goto STOP;
+    }
+    state->c = c + comp_ptr[i];
+    state->e = snap->emissions + comp_ptr[i];
+    for (j = 0; j < state->M; j++) {
+      k = comp_ptr[i] + j;
+      e = state->e + j;
+      if (info[3 * k] < 0 || info[3 * k] >= density_number) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "unknown density type %d", info[3 * k]);
+        goto STOP;
+      }
+      e->type = info[3 * k];
+      e->dimension = info[3 * k + 1];
+      e->fixed = info[3 * k + 2];
+      e->min = param[5 * k + 2];
+      e->max = param[5 * k + 3];
+      e->det = param[5 * k + 4];
+      if ((e->type == multinormal || e->type == binormal) && e->dimension > 1) {
+        if (!mean || e->dimension != smo->dim) {
+          GHMM_LOG(LERROR, "multivariate component in a model of other dimension");
+          goto STOP;
+        }
+        e->mean.vec = mean + k * dim;
+        e->variance.mat = var + k * dim2;
+        if (e->type == multinormal) {
+          e->sigmainv = inv + k * dim2;
+          e->sigmacd = cd + k * dim2;
+        }
+      }
+      else {
+        e->mean.val = param[5 * k];
+        e->variance.val = param[5 * k + 1];
+      }
+    }
+    state->fix = fix[i];
+    state->xPosition = pos[2 * i];
+    state->yPosition = pos[2 * i + 1];
+    state->desc = *desc ? desc : NULL;
+    desc += strlen (desc) + 1;
+  }
+  return smo;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  ghmm_cmodel_free (&smo);
+  return NULL;
+#undef CUR_PROC
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+*
+*       This file is part of the General Hidden Markov Model Library,
+*       GHMM version __VERSION__, see http://ghmm.org
+*
+*       Filename: ghmm/ghmm/snapshot.h
+*
+*       Copyright (C) 1998-2004 Alexander Schliep
+*       Copyright (C) 1998-2001 ZAIK/ZPR, Universitaet zu Koeln
+*       Copyright (C) 2002-2004 Max-Planck-Institut fuer Molekulare Genetik,
+*                               Berlin
+*
+*       Contact: schliep@ghmm.org
+*
+*       This library is free software; you can redistribute it and/or
+*       modify it under the terms of the GNU Library General Public
+*       License as published by the Free Software Foundation; either
+*       version 2 of the License, or (at your option) any later version.
+*
+*       This library is distributed in the hope that it will be useful,
+*       but WITHOUT ANY WARRANTY; without even the implied warranty of
+*       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*       Library General Public License for more details.
+*
+*       You should have received a copy of the GNU Library General Public
+*       License along with this library; if not, write to the Free
+*       Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+*
+*       This file is version $Revision$
+*                       from $Date$
+*             last change by $Author$.
+*
+*******************************************************************************/
+
+
+#ifndef GHMM_SNAPSHOT_H
+#define GHMM_SNAPSHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+
+/**@name Binary model snapshots */
+/*@{ (Doc++-Group: snapshot) */
+
+/**
+  A snapshot is a versioned binary image of one model in the byte order
+  of the machine that wrote it. All numbers are kept in flat arrays:
+  initial probabilities, the transitions in compressed sparse rows (in
+  both directions), emissions, mixture parameters, the per state flags
+  (silent, tied, order, label, background) and the alphabets.
+
+  Reading a snapshot maps the file and lets the arrays of the states
+  point into the mapping (copy on write, so the parameters can still be
+  trained). Only the state structs, the small per model arrays and the
+  strings are allocated. A mapped model can not change its number of
+  states or transitions (ghmm_dmodel_duration_apply refuses it), copy it
+  with ghmm_dmodel_copy / ghmm_cmodel_copy first. The mapping is released
+  by ghmm_dmodel_free / ghmm_cmodel_free.
+
+  The function pointers of the class change context of a continuous
+  model are not part of the snapshot and have to be set again.
+  */
+  struct ghmm_snapshot;
+
+/**
+   Writes a discrete model as snapshot. Pair models and models with
+   transition classes are not supported.
+   @return           0 on success, -1 on error
+   @param mo         model
+   @param filename   name of the snapshot file
+*/
+  int ghmm_dmodel_snapshot_write (const ghmm_dmodel * mo, const char *filename);
+
+/**
+   Maps a discrete model snapshot written by ghmm_dmodel_snapshot_write.
+   A transition index is built again if the model had one.
+   @return           the model, NULL on error
+   @param filename   name of the snapshot file
+*/
+  ghmm_dmodel *ghmm_dmodel_snapshot_read (const char *filename);
+
+/**
+   Writes a continuous model as snapshot.
+   @return           0 on success, -1 on error
+   @param smo        model
+   @param filename   name of the snapshot file
+*/
+  int ghmm_cmodel_snapshot_write (const ghmm_cmodel * smo, const char *filename);
+
+/**
+   Maps a continuous model snapshot written by ghmm_cmodel_snapshot_write.
+   @return           the model, NULL on error
+   @param filename   name of the snapshot file
+*/
+  ghmm_cmodel *ghmm_cmodel_snapshot_read (const char *filename);
+
+/**
+   Releases the mapping of a snapshot and the arrays allocated for it.
+   Called by the free functions of the models.
+   @param snapshot   snapshot of a model
+*/
+  void ghmm_snapshot_free (struct ghmm_snapshot *snapshot);
+
+/*@} (Doc++-Group: snapshot) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GHMM_SNAPSHOT_H */
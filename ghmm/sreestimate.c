@@ -40,6 +40,8 @@
 
 #include <math.h>
 #include <float.h>
+#include <stdint.h>
+#include <string.h>
 #include "ghmm.h"
 #include "mprintf.h"
 #include "mes.h"
@@ -59,29 +61,35 @@
 /* set info output  (logP, ...) */
 #define MESINFO MES_FILE
 
-typedef struct local_store_t {
-  int cos;
-  double *pi_num;
+/* the Baum-Welch accumulators are the public sufficient statistics */
+typedef ghmm_cstats local_store_t;
+
+#define CSTATS_MAGIC      "GHMMCSTA"
+#define CSTATS_BYTE_ORDER 0x01020304u
+
+/* fixed part of a serialized ghmm_cstats, followed by out_states[N],
+   comps[N] and data[size] */
+typedef struct {
+  char magic[8];
+  uint32_t byte_order;
+  int32_t N;
+  int32_t M;
+  int32_t dim;
+  int32_t cos;
+  int32_t valid;
+  int32_t size;
+  int32_t pad;
+  double log_p;
   double pi_denom;
-  double ***a_num;
-  double **a_denom;
-  double **c_num;
-  double *c_denom;
-  double ***mue_num;
-  double ***u_num;
-  double **mue_u_denom;       /* mue-denom. = u-denom. for sym. normal density */
-  double **sum_gt_otot;       /* for truncated normal density */
-} local_store_t;
+} cstats_header;
 
 /** needed for normaldensitypos (truncated normal density) */
 #define ACC 1E-8
-static double C_PHI;
-static double CC_PHI;
 /***/
 
 static local_store_t *sreestimate_alloc (const ghmm_cmodel * smo);
 static int sreestimate_free (local_store_t ** r, int N);
-static int sreestimate_init (local_store_t * r, const ghmm_cmodel * smo);
+static int sreestimate_init (local_store_t * r);
 static int sreestimate_alloc_matvek (double ***alpha, double ***beta,
                                      double **scale, double ****b,
                                      int T, int N, int M);
@@ -90,79 +98,143 @@ static int sreestimate_precompute_b (ghmm_cmodel * smo, double *O, int T,
 static int sreestimate_free_matvec (double **alpha, double **beta,
                                     double *scale, double ***b, int T, int N);
 static int sreestimate_setlambda (local_store_t * r, ghmm_cmodel * smo);
+static int sreestimate_accumulate (ghmm_cmodel * smo, local_store_t * r,
+                                   int seq_number, int *T, double **O,
+                                   double *log_p, double *seq_w, int *valid);
 static int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r,
                                  int seq_number, int *T, double **O,
                                  double *log_p, double *seq_w);
 /*----------------------------------------------------------------------------*/
-/* various allocations */
-static local_store_t *sreestimate_alloc (const ghmm_cmodel * smo)
+/* Allocates zeroed statistics for N states with dim dimensional emissions,
+   cos transition classes and at most M components. State i has out_states[i]
+   transitions and comps[i] components. */
+static local_store_t *cstats_alloc (int N, int M, int dim, int cos,
+                                    const int *out_states, const int *comps)
 {
-# define CUR_PROC "sreestimate_alloc"
-  int i;
+# define CUR_PROC "cstats_alloc"
+  int i, m, osc;
+  double *p;
   local_store_t *r = NULL;
+
   ARRAY_CALLOC (r, 1);
-  r->cos = smo->cos;
-  ARRAY_CALLOC (r->pi_num, smo->N);
-  ARRAY_CALLOC (r->a_num, smo->N);
-  for (i = 0; i < smo->N; i++) {
-    r->a_num[i] = ighmm_cmatrix_stat_alloc (smo->cos, smo->s[i].out_states);
-    if (!r->a_num[i]) {
-      GHMM_LOG_QUEUED(LCONVERTED);
-      goto STOP;
+  r->N = N;
+  r->M = M;
+  r->dim = dim;
+  r->cos = cos;
+  ARRAY_MALLOC (r->out_states, N);
+  ARRAY_MALLOC (r->comps, N);
+  memcpy (r->out_states, out_states, N * sizeof (int));
+  memcpy (r->comps, comps, N * sizeof (int));
+
+  /* pi_num and c_denom, N x cos a_denom, N x M c_num, mue_u_denom and
+     sum_gt_otot, then per state a_num, mue_num and u_num */
+  r->size = N * (2 + cos + 3 * M);
+  for (i = 0; i < N; i++)
+    r->size += cos * out_states[i] + comps[i] * (dim + dim * dim);
+
+  ARRAY_CALLOC (r->data, r->size);
+  ARRAY_CALLOC (r->a_num, N);
+  ARRAY_CALLOC (r->a_denom, N);
+  ARRAY_CALLOC (r->c_num, N);
+  ARRAY_CALLOC (r->mue_num, N);
+  ARRAY_CALLOC (r->u_num, N);
+  ARRAY_CALLOC (r->mue_u_denom, N);
+  ARRAY_CALLOC (r->sum_gt_otot, N);
+
+  p = r->data;
+  r->pi_num = p;
+  p += N;
+  r->c_denom = p;
+  p += N;
+  for (i = 0; i < N; i++) {
+    r->a_denom[i] = p;
+    p += cos;
+    r->c_num[i] = p;
+    p += M;
+    r->mue_u_denom[i] = p;
+    p += M;
+    r->sum_gt_otot[i] = p;
+    p += M;
+    ARRAY_CALLOC (r->a_num[i], cos);
+    for (osc = 0; osc < cos; osc++) {
+      r->a_num[i][osc] = p;
+      p += out_states[i];
     }
-  }
-  r->a_denom = ighmm_cmatrix_stat_alloc (smo->N, smo->cos);
-  if (!r->a_denom) {
-    GHMM_LOG_QUEUED(LCONVERTED);
-    goto STOP;
-  }
-  /* For sacke of simplicity, a NXmax(M) is being allocated,
-  even though not all emissins components are of size max(M) */
-  ARRAY_CALLOC (r->c_denom, smo->N);  
-  r->c_num = ighmm_cmatrix_stat_alloc (smo->N, smo->M);
-  if (!(r->c_num)) {
-    GHMM_LOG_QUEUED(LCONVERTED);
-    goto STOP;
-  }
-  ARRAY_CALLOC(r->mue_num, smo->N);
-  if (!(r->mue_num)) {
-    GHMM_LOG_QUEUED(LCONVERTED);
-    goto STOP;
-  }
-  for (i = 0; i < smo->N; i++) {
-    r->mue_num[i] = ighmm_cmatrix_stat_alloc(smo->s[i].M, smo->dim);
-    if (!(r->mue_num[i])) {
-      GHMM_LOG_QUEUED(LCONVERTED);
-      goto STOP;
+    ARRAY_CALLOC (r->mue_num[i], comps[i]);
+    ARRAY_CALLOC (r->u_num[i], comps[i]);
+    for (m = 0; m < comps[i]; m++) {
+      r->mue_num[i][m] = p;
+      p += dim;
+      r->u_num[i][m] = p;
+      p += dim * dim;
     }
   }
-  ARRAY_CALLOC (r->u_num, smo->N);
-  if (!(r->u_num)) {
-    GHMM_LOG_QUEUED(LCONVERTED);
-    goto STOP;
-  }
+
+  return (r);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  sreestimate_free (&r, N);
+  return (NULL);
+# undef CUR_PROC
+}                               /* cstats_alloc */
+
+/*----------------------------------------------------------------------------*/
+/* adds n * k accumulators to *total, fails if that exceeds limit */
+static int cstats_add_size (size_t * total, size_t n, size_t k, size_t limit)
+{
+  if (k && n > (limit - *total) / k)
+    return 0;
+  *total += n * k;
+  return 1;
+}
+
+/*----------------------------------------------------------------------------*/
+/* checks the shape in the header and in out_states and comps of serialized
+   statistics before anything is allocated, it has to give exactly size
+   accumulators */
+static int cstats_valid_shape (const cstats_header * h, const int *out_states,
+                               const int *comps)
+{
+  size_t total = 0, limit = h->size;
+  int i;
+
+  if ((size_t) h->dim > limit / h->dim
+      || !cstats_add_size (&total, h->N, 2 + (size_t) h->cos, limit)
+      || !cstats_add_size (&total, h->N, h->M, limit)
+      || !cstats_add_size (&total, h->N, 2 * (size_t) h->M, limit))
+    return 0;
+  for (i = 0; i < h->N; i++)
+    if (out_states[i] < 0 || out_states[i] > h->N || comps[i] < 1
+        || comps[i] > h->M
+        || !cstats_add_size (&total, h->cos, out_states[i], limit)
+        || !cstats_add_size (&total, comps[i], h->dim, limit)
+        || !cstats_add_size (&total, comps[i], h->dim * h->dim, limit))
+      return 0;
+  return total == limit;
+}
+
+/*----------------------------------------------------------------------------*/
+/* various allocations */
+static local_store_t *sreestimate_alloc (const ghmm_cmodel * smo)
+{
+# define CUR_PROC "sreestimate_alloc"
+  int i;
+  int *out_states = NULL, *comps = NULL;
+  local_store_t *r = NULL;
+
+  ARRAY_MALLOC (out_states, smo->N);
+  ARRAY_MALLOC (comps, smo->N);
   for (i = 0; i < smo->N; i++) {
-    r->u_num[i] = ighmm_cmatrix_stat_alloc(smo->s[i].M, smo->dim * smo->dim);
-    if (!(r->u_num[i])) {
-      GHMM_LOG_QUEUED(LCONVERTED);
-      goto STOP;
-    }
-  }
-  r->mue_u_denom = ighmm_cmatrix_stat_alloc (smo->N, smo->M);
-  if (!(r->mue_u_denom)) {
-    GHMM_LOG_QUEUED(LCONVERTED);
-    goto STOP;
-  }
-  r->sum_gt_otot = ighmm_cmatrix_stat_alloc (smo->N, smo->M);
-  if (!(r->sum_gt_otot)) {
-    GHMM_LOG_QUEUED(LCONVERTED);
-    goto STOP;
+    out_states[i] = smo->s[i].out_states;
+    comps[i] = smo->s[i].M;
   }
+  r = cstats_alloc (smo->N, smo->M, smo->dim, smo->cos, out_states, comps);
 
-  return (r);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-  sreestimate_free (&r, smo->N);
-  return 0;
+  if (out_states)
+    m_free (out_states);
+  if (comps)
+    m_free (comps);
+  return (r);
 # undef CUR_PROC
 }                               /* sreestimate_alloc */
 
@@ -174,62 +246,66 @@ static int sreestimate_free (local_store_t ** r, int N)
   mes_check_ptr (r, return (-1));
   if (!*r)
     return (0);
-  m_free ((*r)->pi_num);
-  for (i = 0; i < N; i++)
-    ighmm_cmatrix_stat_free (&((*r)->a_num[i]));
-  m_free ((*r)->a_num);
-  ighmm_cmatrix_stat_free (&((*r)->a_denom));
-  /***/
-  m_free ((*r)->c_denom);
-  ighmm_cmatrix_stat_free (&((*r)->c_num));
-  if ((*r)->mue_num) {
-    for (i = 0; i < N; i++)
-      ighmm_cmatrix_stat_free (&((*r)->mue_num[i]));
-    m_free ((*r)->mue_num);
+  /* all accumulators live in data, the rest are row pointers */
+  for (i = 0; i < N; i++) {
+    if ((*r)->a_num && (*r)->a_num[i])
+      m_free ((*r)->a_num[i]);
+    if ((*r)->mue_num && (*r)->mue_num[i])
+      m_free ((*r)->mue_num[i]);
+    if ((*r)->u_num && (*r)->u_num[i])
+      m_free ((*r)->u_num[i]);
   }
-  if ((*r)->u_num) {
-    for (i = 0; i < N; i++)
-      ighmm_cmatrix_stat_free (&((*r)->u_num[i]));
+  if ((*r)->a_num)
+    m_free ((*r)->a_num);
+  if ((*r)->mue_num)
+    m_free ((*r)->mue_num);
+  if ((*r)->u_num)
     m_free ((*r)->u_num);
-  }
-  ighmm_cmatrix_stat_free (&((*r)->mue_u_denom));
-  ighmm_cmatrix_stat_free (&((*r)->sum_gt_otot));
+  if ((*r)->a_denom)
+    m_free ((*r)->a_denom);
+  if ((*r)->c_num)
+    m_free ((*r)->c_num);
+  if ((*r)->mue_u_denom)
+    m_free ((*r)->mue_u_denom);
+  if ((*r)->sum_gt_otot)
+    m_free ((*r)->sum_gt_otot);
+  if ((*r)->data)
+    m_free ((*r)->data);
+  if ((*r)->out_states)
+    m_free ((*r)->out_states);
+  if ((*r)->comps)
+    m_free ((*r)->comps);
   m_free (*r);
   return (0);
 # undef CUR_PROC
 }                               /* sreestimate_free */
 
 /*----------------------------------------------------------------------------*/
-static int sreestimate_init (local_store_t * r, const ghmm_cmodel * smo)
+static int sreestimate_init (local_store_t * r)
 {
 # define CUR_PROC "sreestimate_init"
-  int i, j, m, osc;
-  int dim_2 = smo->dim * smo->dim;
   r->pi_denom = 0.0;
-  for (i = 0; i < smo->N; i++) {
-    r->pi_num[i] = 0.0;
-    for (osc = 0; osc < smo->cos; osc++) {
-      r->a_denom[i][osc] = 0.0;
-      for (j = 0; j < smo->s[i].out_states; j++)
-        r->a_num[i][osc][j] = 0.0;
-    }
-    r->c_denom[i] = 0.0;
-    for (m = 0; m < smo->s[i].M; m++) {
-      for (j = 0; j < smo->dim; j++)
-        r->mue_num[i][m][j] = 0.0;
-
-      for (j = 0; j < dim_2; j++)
-        r->u_num[i][m][j] = 0.0;
-
-      r->c_num[i][m] = 0.0;
-      r->mue_u_denom[i][m] = 0.0;
-      r->sum_gt_otot[i][m] = 0.0;
-    }
-  }
+  r->log_p = 0.0;
+  r->valid = 0;
+  memset (r->data, 0, r->size * sizeof (double));
   return (0);
 # undef CUR_PROC
 }                               /* sreestimate_init */
 
+/*----------------------------------------------------------------------------*/
+/* checks that the statistics have the shape of the model */
+static int cstats_matches (const local_store_t * r, const ghmm_cmodel * smo)
+{
+  int i;
+
+  if (r->N != smo->N || r->M != smo->M || r->dim != smo->dim || r->cos != smo->cos)
+    return 0;
+  for (i = 0; i < smo->N; i++)
+    if (r->out_states[i] != smo->s[i].out_states || r->comps[i] != smo->s[i].M)
+      return 0;
+  return 1;
+}
+
 /*----------------------------------------------------------------------------*/
 static int sreestimate_alloc_matvek (double ***alpha, double ***beta,
                                      double **scale, double ****b,
@@ -313,6 +389,7 @@ static int sreestimate_setlambda (local_store_t * r, ghmm_cmodel * smo)
   int res = -1;
   int i, j, m, l, j_id, osc, fix_flag, d;
   double pi_factor, a_factor_i = 0.0, c_factor_i = 0.0, u_im, mue_im, mue_left, mue_right, A, B, Atil, Btil, fix_w, unfix_w;    /* Q; */
+  double c_phi, cc_phi;
   int a_num_pos, a_denom_pos, c_denom_pos, c_num_pos;
 
   if (r->pi_denom <= DBL_MIN) {
@@ -537,9 +614,11 @@ static int sreestimate_setlambda (local_store_t * r, ghmm_cmodel * smo)
         else {
           Atil = A + GHMM_EPS_NDT;
           Btil = B + GHMM_EPS_NDT * A;
-          mue_left = (-C_PHI * sqrt (Btil + GHMM_EPS_NDT * Atil
-                                     + CC_PHI * m_sqr (Atil) / 4.0)
-                      - CC_PHI * Atil / 2.0 - GHMM_EPS_NDT) * 0.99;
+          c_phi = ighmm_rand_get_xPHIless1 ();
+          cc_phi = m_sqr (c_phi);
+          mue_left = (-c_phi * sqrt (Btil + GHMM_EPS_NDT * Atil
+                                     + cc_phi * m_sqr (Atil) / 4.0)
+                      - cc_phi * Atil / 2.0 - GHMM_EPS_NDT) * 0.99;
           mue_right = A;
           if (A < Btil * ighmm_rand_normal_density_pos (-GHMM_EPS_NDT, 0, Btil))
             mue_right = m_min (GHMM_EPS_NDT, mue_right);
@@ -581,10 +660,15 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 
 
 /*----------------------------------------------------------------------------*/
-int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
-                          int *T, double **O, double *log_p, double *seq_w)
+/* E-step: adds the expected counts of all sequences to r. Returns the number
+   of sequences used for log_p (with penalties for those the model can't
+   generate) and in valid the number used for the parameters, or -1 on
+   errors. */
+static int sreestimate_accumulate (ghmm_cmodel * smo, local_store_t * r,
+                                   int seq_number, int *T, double **O,
+                                   double *log_p, double *seq_w, int *valid)
 {
-# define CUR_PROC "sreestimate_one_step"
+# define CUR_PROC "sreestimate_accumulate"
   int res = -1;
   int k, i, j, m, t, j_id, valid_parameter, valid_logp, osc, d, di, dj, pos;
   ghmm_cstate *state;
@@ -596,6 +680,7 @@ int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
   double c_t, sum_alpha_a_ji, gamma, gamma_ct, f_im;
   double log_p_k;
   double contrib_t;
+  int *classes = NULL;
   
   *log_p = 0.0;
   valid_parameter = valid_logp = 0;
@@ -610,6 +695,9 @@ int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
     GHMM_LOG_QUEUED(LCONVERTED);
     goto STOP;
   }
+  /* transition classes, computed once per sequence */
+  if (smo->cos > 1)
+    ARRAY_MALLOC (classes, T_k_max);
 
   /* loop over all sequences */
   for (k = 0; k < seq_number; k++) {
@@ -625,11 +713,17 @@ int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
 
     if (smo->cos > 1) {
       smo->class_change->k = k;
+      if (ghmm_cmodel_get_class_sequence (smo, O[k], k, T_k, classes) == -1) {
+        GHMM_LOG_QUEUED(LCONVERTED);
+        goto STOP;
+      }
     }
 
 
-    if ((ghmm_cmodel_forward (smo, O[k], T[k], b, alpha, scale, &log_p_k) == -1) ||
-        (ghmm_cmodel_backward (smo, O[k], T[k], b, beta, scale) == -1)) {
+    if ((ghmm_cmodel_forward_classes (smo, O[k], T[k], b, alpha, scale,
+                                      &log_p_k, classes) == -1) ||
+        (ghmm_cmodel_backward_classes (smo, O[k], T[k], b, beta, scale,
+                                       classes) == -1)) {
 #if MCI
       ighmm_mes (MESCONTR, "O(%2d) can't be build from smodel smo!\n", k);
 #endif
@@ -666,23 +760,7 @@ int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
         c_t = 1 / scale[t];
         if (t > 0) {
 
-          if (smo->cos == 1) {
-            osc = 0;
-          }
-          else {
-            if (!smo->class_change->get_class) {
-              GHMM_LOG(LERROR, "get_class not initialized");
-              goto STOP;
-            }
-
-            osc = smo->class_change->get_class (smo, O[k], k, t - 1);
-            /*printf("osc=%d : cos = %d, k = %d, t = %d, state=%d\n",osc,smo->cos,smo->class_change->k,t,i); */
-            if (osc >= smo->cos) {
-              GHMM_LOG_PRINTF(LERROR, LOC, "get_class returned index %d "
-                              "but model has only %d classes!", osc, smo->cos);
-              goto STOP;
-            }
-          }
+          osc = classes ? classes[t - 1] : 0;
 
           /* A: starts at t=1 !!! */
           for (j = 0; j < state->out_states; j++) {
@@ -775,8 +853,34 @@ int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
   /* reset class_change->k to default value */
   if (smo->cos > 1) {
     smo->class_change->k = -1;
+    m_free (classes);
   }
 
+  sreestimate_free_matvec (alpha, beta, scale, b, T_k_max, smo->N);
+  *valid = valid_parameter;
+  return (valid_logp);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (classes)
+    m_free (classes);
+  sreestimate_free_matvec (alpha, beta, scale, b, T_k_max, smo->N);
+  return (res);
+# undef CUR_PROC
+}                               /* sreestimate_accumulate */
+
+
+/*----------------------------------------------------------------------------*/
+static int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
+                                 int *T, double **O, double *log_p, double *seq_w)
+{
+# define CUR_PROC "sreestimate_one_step"
+  int valid_parameter, valid_logp;
+
+  valid_logp = sreestimate_accumulate (smo, r, seq_number, T, O, log_p, seq_w,
+                                       &valid_parameter);
+  if (valid_logp == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return (-1);
+  }
 
   if (valid_parameter) {
     /* new parameter lambda: set directly in model */
@@ -784,33 +888,11 @@ int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
       GHMM_LOG_QUEUED(LCONVERTED);
       return (-1);
     }
-    /* only test : */
-
-    
-    /* printf("scale:\n");
-     for(t=0;t<T[0];t++){
-         printf("%f, ",scale[t]);
-     }
-     printf("\n\n"); 
-
-     for(osc =0;osc<smo->cos;osc++) {
-         for(i=0;i<smo->N;i++){
-           for(j=0;j<smo->N;j++){
-              printf("osc= %d, i = %d, j= %d : %f / %f = %f\n",osc,i,j,r->a_num[i][osc][j],
-                      r->a_denom[i][osc],(r->a_num[i][osc][j] / r->a_denom[i][osc]));
-           }
-         }
-     }  
-   
-    ghmm_cmodel_print(stdout,smo); */
-
-    
-    if (ghmm_cmodel_check(smo) == -1) { 
-        GHMM_LOG_QUEUED(LCONVERTED); 
+    if (ghmm_cmodel_check(smo) == -1) {
+        GHMM_LOG_QUEUED(LCONVERTED);
         GHMM_LOG(LERROR, "Model invalid!");
-        goto STOP;
+        return (-1);
     }
-
   }
   else {                        /* NO sequence can be build from smodel smo! */
     /* diskret:  *log_p = +1; */
@@ -818,14 +900,8 @@ int sreestimate_one_step (ghmm_cmodel * smo, local_store_t * r, int seq_number,
     return (-1);
   }
 
-  sreestimate_free_matvec (alpha, beta, scale, b, T_k_max, smo->N);
-
   return (valid_logp);
   /*  return(valid_parameter); */
-STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-
-  sreestimate_free_matvec (alpha, beta, scale, b, T_k, smo->N);
-  return (res);
 # undef CUR_PROC
 }                               /* sreestimate_one_step */
 
@@ -835,29 +911,17 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 int ghmm_cmodel_baum_welch (ghmm_cmodel_baum_welch_context * cs)
 {
 # define CUR_PROC "ghmm_cmodel_baum_welch"
-  int i, j, n, valid, valid_old, max_iter_bw;
+  int n, valid, valid_old, max_iter_bw;
   double log_p, log_p_old, diff, eps_iter_bw;
   local_store_t *r = NULL;
 
-  /* truncated normal density needs static varialbles C_PHI and
-     CC_PHI */
-  for (i = 0; i < cs->smo->N; i++){
-    for (j = 0; j < cs->smo->s[i].M; j++){
-      if (cs->smo->s[i].e[j].type == normal_right) {
-        C_PHI = ighmm_rand_get_xPHIless1 ();
-        CC_PHI = m_sqr (C_PHI);
-        break;
-      }
-    }
-  }
-
   /* local store for all iterations */
   r = sreestimate_alloc (cs->smo);
   if (!r) {
     GHMM_LOG_QUEUED(LCONVERTED);
     goto STOP;
   };
-  sreestimate_init (r, cs->smo);
+  sreestimate_init (r);
 
   log_p_old = -DBL_MAX;
   valid_old = cs->sqd->seq_number;
@@ -913,7 +977,7 @@ int ghmm_cmodel_baum_welch (ghmm_cmodel_baum_welch_context * cs)
       valid_old = valid;
       log_p_old = log_p;
       /* set values to zero */
-      sreestimate_init (r, cs->smo);
+      sreestimate_init (r);
       n++;
     }
 
@@ -935,6 +999,207 @@ STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
 # undef CUR_PROC
 }                               /* ghmm_cmodel_baum_welch */
 
+
+/*============================================================================*/
+ghmm_cstats *ghmm_cstats_alloc (const ghmm_cmodel * smo)
+{
+# define CUR_PROC "ghmm_cstats_alloc"
+  ghmm_cstats *r = sreestimate_alloc (smo);
+  if (!r)
+    GHMM_LOG_QUEUED(LCONVERTED);
+  return r;
+# undef CUR_PROC
+}                               /* ghmm_cstats_alloc */
+
+/*============================================================================*/
+int ghmm_cstats_free (ghmm_cstats ** r)
+{
+# define CUR_PROC "ghmm_cstats_free"
+  mes_check_ptr (r, return (-1));
+  if (!*r)
+    return (0);
+  return sreestimate_free (r, (*r)->N);
+# undef CUR_PROC
+}                               /* ghmm_cstats_free */
+
+/*============================================================================*/
+void ghmm_cstats_clear (ghmm_cstats * r)
+{
+  sreestimate_init (r);
+}                               /* ghmm_cstats_clear */
+
+/*============================================================================*/
+int ghmm_cstats_accumulate (ghmm_cstats * r, ghmm_cmodel * smo, ghmm_cseq * sqd)
+{
+# define CUR_PROC "ghmm_cstats_accumulate"
+  int valid;
+  double log_p;
+
+  if (!cstats_matches (r, smo)) {
+    GHMM_LOG(LERROR, "statistics do not match the model");
+    return (-1);
+  }
+  if (sqd->seq_number == 0)
+    return (0);
+  if (sreestimate_accumulate (smo, r, sqd->seq_number, sqd->seq_len, sqd->seq,
+                              &log_p, sqd->seq_w, &valid) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return (-1);
+  }
+  r->valid += valid;
+  r->log_p += log_p;
+  return (0);
+# undef CUR_PROC
+}                               /* ghmm_cstats_accumulate */
+
+/*============================================================================*/
+int ghmm_cstats_merge (ghmm_cstats * r, const ghmm_cstats * other)
+{
+# define CUR_PROC "ghmm_cstats_merge"
+  int i;
+
+  if (r->N != other->N || r->M != other->M || r->dim != other->dim
+      || r->cos != other->cos || r->size != other->size
+      || memcmp (r->out_states, other->out_states, r->N * sizeof (int))
+      || memcmp (r->comps, other->comps, r->N * sizeof (int))) {
+    GHMM_LOG(LERROR, "can not merge statistics of different models");
+    return (-1);
+  }
+  for (i = 0; i < r->size; i++)
+    r->data[i] += other->data[i];
+  r->pi_denom += other->pi_denom;
+  r->log_p += other->log_p;
+  r->valid += other->valid;
+  return (0);
+# undef CUR_PROC
+}                               /* ghmm_cstats_merge */
+
+/*============================================================================*/
+char *ghmm_cstats_serialize (const ghmm_cstats * r, size_t * size)
+{
+# define CUR_PROC "ghmm_cstats_serialize"
+  cstats_header header;
+  char *buf = NULL, *p;
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, CSTATS_MAGIC, sizeof (header.magic));
+  header.byte_order = CSTATS_BYTE_ORDER;
+  header.N = r->N;
+  header.M = r->M;
+  header.dim = r->dim;
+  header.cos = r->cos;
+  header.valid = r->valid;
+  header.size = r->size;
+  header.log_p = r->log_p;
+  header.pi_denom = r->pi_denom;
+
+  *size = sizeof (header) + 2 * r->N * sizeof (int) + r->size * sizeof (double);
+  ARRAY_MALLOC (buf, *size);
+
+  p = buf;
+  memcpy (p, &header, sizeof (header));
+  p += sizeof (header);
+  memcpy (p, r->out_states, r->N * sizeof (int));
+  p += r->N * sizeof (int);
+  memcpy (p, r->comps, r->N * sizeof (int));
+  p += r->N * sizeof (int);
+  memcpy (p, r->data, r->size * sizeof (double));
+
+  return buf;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  *size = 0;
+  return NULL;
+# undef CUR_PROC
+}                               /* ghmm_cstats_serialize */
+
+/*============================================================================*/
+ghmm_cstats *ghmm_cstats_deserialize (const char *buf, size_t size)
+{
+# define CUR_PROC "ghmm_cstats_deserialize"
+  cstats_header header;
+  size_t data;
+  int *shape = NULL;
+  ghmm_cstats *r = NULL;
+
+  if (size < sizeof (header)) {
+    GHMM_LOG(LERROR, "serialized statistics are truncated");
+    return NULL;
+  }
+  memcpy (&header, buf, sizeof (header));
+  if (memcmp (header.magic, CSTATS_MAGIC, sizeof (header.magic))) {
+    GHMM_LOG(LERROR, "not serialized statistics of a continuous model");
+    return NULL;
+  }
+  if (header.byte_order != CSTATS_BYTE_ORDER) {
+    GHMM_LOG(LERROR, "serialized statistics have a different byte order");
+    return NULL;
+  }
+  if (header.N <= 0 || header.M <= 0 || header.dim <= 0 || header.cos <= 0
+      || header.size < 0
+      || (size - sizeof (header)) / (2 * sizeof (int)) < (size_t) header.N) {
+    GHMM_LOG(LERROR, "serialized statistics are corrupt");
+    return NULL;
+  }
+  /* the header fixes the length of the buffer */
+  data = size - sizeof (header) - 2 * (size_t) header.N * sizeof (int);
+  if (data % sizeof (double) || data / sizeof (double) != (size_t) header.size) {
+    GHMM_LOG(LERROR, "size of serialized statistics does not match their shape");
+    return NULL;
+  }
+
+  ARRAY_MALLOC (shape, 2 * header.N);
+  memcpy (shape, buf + sizeof (header), 2 * header.N * sizeof (int));
+  if (!cstats_valid_shape (&header, shape, shape + header.N)) {
+    GHMM_LOG(LERROR, "shape of serialized statistics is corrupt");
+    goto STOP;
+  }
+  r = cstats_alloc (header.N, header.M, header.dim, header.cos, shape,
+                    shape + header.N);
+  if (!r) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    goto STOP;
+  }
+  memcpy (r->data, buf + sizeof (header) + 2 * header.N * sizeof (int),
+          r->size * sizeof (double));
+  r->pi_denom = header.pi_denom;
+  r->log_p = header.log_p;
+  r->valid = header.valid;
+
+  m_free (shape);
+  return r;
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (shape)
+    m_free (shape);
+  sreestimate_free (&r, header.N);
+  return NULL;
+# undef CUR_PROC
+}                               /* ghmm_cstats_deserialize */
+
+/*============================================================================*/
+int ghmm_cstats_apply (ghmm_cstats * r, ghmm_cmodel * smo)
+{
+# define CUR_PROC "ghmm_cstats_apply"
+  if (!cstats_matches (r, smo)) {
+    GHMM_LOG(LERROR, "statistics do not match the model");
+    return (-1);
+  }
+  if (!r->valid) {
+    GHMM_LOG(LERROR, "no sequence can be built from the model");
+    return (-1);
+  }
+  if (sreestimate_setlambda (r, smo) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    return (-1);
+  }
+  if (ghmm_cmodel_check (smo) == -1) {
+    GHMM_LOG_QUEUED(LCONVERTED);
+    GHMM_LOG(LERROR, "Model invalid!");
+    return (-1);
+  }
+  return (0);
+# undef CUR_PROC
+}                               /* ghmm_cstats_apply */
+
 #undef ACC
 #undef MCI
 #undef MESCONTR
@@ -83,6 +83,98 @@ extern "C" {
   */
   int ghmm_cmodel_baum_welch (ghmm_cmodel_baum_welch_context * cs);
 
+/**
+   Sufficient statistics of the Baum-Welch E-step for a continuous HMM.
+   Statistics of disjoint sets of sequences can be accumulated
+   independently, merged and then applied to the model they were computed
+   with. The variance numerators are taken around the current means, so
+   the statistics only fit the parameters they were accumulated with.
+ */
+  typedef struct ghmm_cstats {
+  /** number of states, maximal number of components, dimension of the
+      emissions and number of transition classes */
+    int N;
+    int M;
+    int dim;
+    int cos;
+  /** number of outgoing transitions of each state */
+    int *out_states;
+  /** number of mixture components of each state */
+    int *comps;
+  /** number of sequences used for the parameters */
+    int valid;
+  /** weighted log likelihood of all sequences, with a penalty for each
+      sequence the model can not generate */
+    double log_p;
+  /** denominator of the initial probabilities */
+    double pi_denom;
+  /** all accumulators below are rows of data, which holds size doubles */
+    double *data;
+    int size;
+    double *pi_num;
+    double ***a_num;
+    double **a_denom;
+    double **c_num;
+    double *c_denom;
+    double ***mue_num;
+    double ***u_num;
+  /** mue-denom. = u-denom. for sym. normal density */
+    double **mue_u_denom;
+  /** for truncated normal density */
+    double **sum_gt_otot;
+  } ghmm_cstats;
+
+/** Allocates zeroed statistics shaped like the model.
+  @return            statistics or NULL on error
+  @param smo         model
+  */
+  ghmm_cstats *ghmm_cstats_alloc (const ghmm_cmodel * smo);
+
+/** Frees statistics.
+  @return            0/-1 success/error
+  @param r           pointer to the statistics
+  */
+  int ghmm_cstats_free (ghmm_cstats ** r);
+
+/** Sets all accumulators to zero. */
+  void ghmm_cstats_clear (ghmm_cstats * r);
+
+/** E-step: adds the expected counts of the sequences under the current
+    parameters of the model to the statistics. With transition classes the
+    class change function sees the index of a sequence within sqd.
+  @return            0/-1 success/error
+  @param r           statistics shaped like smo
+  @param smo         model
+  @param sqd         sequences
+  */
+  int ghmm_cstats_accumulate (ghmm_cstats * r, ghmm_cmodel * smo, ghmm_cseq * sqd);
+
+/** Adds other to r. Both must be shaped alike.
+  @return            0/-1 success/error
+  */
+  int ghmm_cstats_merge (ghmm_cstats * r, const ghmm_cstats * other);
+
+/** Packs the statistics into a buffer in host byte order.
+  @return            buffer to be freed by the caller, NULL on error
+  @param r           statistics
+  @param size        returns the size of the buffer in bytes
+  */
+  char *ghmm_cstats_serialize (const ghmm_cstats * r, size_t * size);
+
+/** Unpacks statistics written by ghmm_cstats_serialize.
+  @return            statistics or NULL if buf is not valid
+  @param buf         buffer
+  @param size        size of the buffer in bytes
+  */
+  ghmm_cstats *ghmm_cstats_deserialize (const char *buf, size_t size);
+
+/** M-step: sets the parameters of the model from the statistics, which
+    must have been accumulated with the same parameters.
+  @return            0/-1 success/error
+  @param r           statistics
+  @param smo         model
+  */
+  int ghmm_cstats_apply (ghmm_cstats * r, ghmm_cmodel * smo);
 
 #ifdef __cplusplus
 }
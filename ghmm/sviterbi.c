@@ -50,18 +50,22 @@ typedef struct local_store_t {
   double **log_b;
   double *phi;
   double *phi_new;
-  int **psi;
+  ighmm_psi_matrix *psi;
 } local_store_t;
 
 static local_store_t *sviterbi_alloc (ghmm_cmodel * smo, int T);
-static int sviterbi_free (local_store_t ** v, int n, int T);
+static int sviterbi_free (local_store_t ** v, int n);
 
 /*----------------------------------------------------------------------------*/
 static local_store_t *sviterbi_alloc (ghmm_cmodel * smo, int T)
 {
 #define CUR_PROC "sviterbi_alloc"
   local_store_t *v = NULL;
+  int j, max_in_states = 0;
   ARRAY_CALLOC (v, 1);
+  for (j = 0; j < smo->N; j++)
+    if (smo->s[j].in_states > max_in_states)
+      max_in_states = smo->s[j].in_states;
   v->log_b = ighmm_cmatrix_stat_alloc (smo->N, T);
   if (!(v->log_b)) {
     GHMM_LOG_QUEUED(LCONVERTED);
@@ -69,21 +73,21 @@ static local_store_t *sviterbi_alloc (ghmm_cmodel * smo, int T)
   }
   ARRAY_CALLOC (v->phi, smo->N);
   ARRAY_CALLOC (v->phi_new, smo->N);
-  v->psi = ighmm_dmatrix_alloc (T, smo->N);
+  v->psi = ighmm_psi_alloc (T, smo->N, max_in_states);
   if (!(v->psi)) {
     GHMM_LOG_QUEUED(LCONVERTED);
     goto STOP;
   }
   return (v);
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
-  sviterbi_free (&v, smo->N, T);
+  sviterbi_free (&v, smo->N);
   return (NULL);
 #undef CUR_PROC
 }                               /* sviterbi_alloc */
 
 
 /*----------------------------------------------------------------------------*/
-static int sviterbi_free (local_store_t ** v, int n, int T)
+static int sviterbi_free (local_store_t ** v, int n)
 {
 #define CUR_PROC "sviterbi_free"
   mes_check_ptr (v, return (-1));
@@ -92,7 +96,7 @@ static int sviterbi_free (local_store_t ** v, int n, int T)
   ighmm_cmatrix_stat_free (&((*v)->log_b));
   m_free ((*v)->phi);
   m_free ((*v)->phi_new);
-  ighmm_dmatrix_free (&((*v)->psi), T);
+  ighmm_psi_free (&((*v)->psi));
   m_free (*v);
   return (0);
 #undef CUR_PROC
@@ -126,11 +130,12 @@ static void sviterbi_precompute (ghmm_cmodel * smo, double *O, int T,
 
 
 /*============================================================================*/
-int *ghmm_cmodel_viterbi (ghmm_cmodel * smo, double *O, int T, double *log_p)
+int *ghmm_cmodel_viterbi_classes (ghmm_cmodel * smo, double *O, int T,
+                                  const int *classes, double *log_p)
 {
-#define CUR_PROC "ghmm_cmodel_viterbi"
+#define CUR_PROC "ghmm_cmodel_viterbi_classes"
   int *state_seq = NULL;
-  int t, j, i, osc;
+  int t, j, i, osc = 0;
   double value, max_value;
   local_store_t *v;
   
@@ -156,35 +161,22 @@ int *ghmm_cmodel_viterbi (ghmm_cmodel * smo, double *O, int T, double *log_p)
 
   /* Recursion */
   for (t = 1; t < T; t++) {
-    if (smo->cos == 1) {
-      osc = 0;
-    }
-    else {
-      if (!smo->class_change->get_class) {
-        printf ("ERROR: get_class not initialized\n");
-        goto STOP;
-      }
-      /*printf("1: cos = %d, k = %d, t = %d\n",smo->cos,smo->class_change->k,t);*/
-      osc =  smo->class_change->get_class (smo, O, smo->class_change->k, t - 1);
-      if (osc >= smo->cos){
-        printf("ERROR: get_class returned index %d but model has only %d classes !\n",osc,smo->cos);
-        goto STOP;
-      }
-    }
-
+    /* class of the transition from t-1 to t */
+    if (classes)
+      osc = classes[t - 1];
 
     for (j = 0; j < smo->N; j++) {
       /* find maximum */
       /* max_phi = phi[i] + log_in_a[j][i] ... */
       max_value = -DBL_MAX;
-      v->psi[t][j] = -1;
+      ighmm_psi_set (v->psi, t, j, -1);
       for (i = 0; i < smo->s[j].in_states; i++) {
         if (v->phi[smo->s[j].in_id[i]] > -DBL_MAX &&
             log (smo->s[j].in_a[osc][i]) > -DBL_MAX) {
           value = v->phi[smo->s[j].in_id[i]] + log (smo->s[j].in_a[osc][i]);
           if (value > max_value) {
             max_value = value;
-            v->psi[t][j] = smo->s[j].in_id[i];
+            ighmm_psi_set (v->psi, t, j, i);
           }
         }
       }
@@ -222,16 +214,42 @@ int *ghmm_cmodel_viterbi (ghmm_cmodel * smo, double *O, int T, double *log_p)
   else {
     *log_p = max_value;
     /* Backtracking */
-    for (t = T - 2; t >= 0; t--)
-      state_seq[t] = v->psi[t + 1][state_seq[t + 1]];
+    for (t = T - 2; t >= 0; t--) {
+      j = state_seq[t + 1];
+      state_seq[t] = smo->s[j].in_id[ighmm_psi_get (v->psi, t + 1, j)];
+    }
   }
-  sviterbi_free (&v, smo->N, T);
+  sviterbi_free (&v, smo->N);
   return (state_seq);
 
 STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
   /* Free the memory space... */
-  sviterbi_free (&v, smo->N, T);
+  sviterbi_free (&v, smo->N);
   m_free (state_seq);
   return NULL;
 #undef CUR_PROC
+}                               /* ghmm_cmodel_viterbi_classes */
+
+/*============================================================================*/
+int *ghmm_cmodel_viterbi (ghmm_cmodel * smo, double *O, int T, double *log_p)
+{
+#define CUR_PROC "ghmm_cmodel_viterbi"
+  int *state_seq = NULL, *classes = NULL;
+  int n = T / smo->dim;
+
+  if (smo->cos > 1) {
+    ARRAY_MALLOC (classes, n > 1 ? n - 1 : 1);
+    if (ghmm_cmodel_get_class_sequence (smo, O, smo->class_change ?
+                                        smo->class_change->k : -1, n,
+                                        classes) == -1) {
+      GHMM_LOG_QUEUED(LCONVERTED);
+      goto STOP;
+    }
+  }
+  state_seq = ghmm_cmodel_viterbi_classes (smo, O, T, classes, log_p);
+STOP:     /* Label STOP from ARRAY_[CM]ALLOC */
+  if (classes)
+    m_free (classes);
+  return (state_seq);
+#undef CUR_PROC
 }                               /* ghmm_cmodel_viterbi */
@@ -65,6 +65,21 @@ extern "C" {
   */
   int *ghmm_cmodel_viterbi (ghmm_cmodel * smo, double *o, int T, double *log_p);
 
+/**
+   Viterbi algorithm with precomputed transition classes, see
+   ghmm_cmodel_viterbi.
+  @return        Viterbi-path 
+  @param smo     model
+  @param o       double-sequence
+  @param T       sequence length (number of samples for multidemsional)
+  @param classes classes[t] is the class of the transition from t to t+1
+                 (see ghmm_cmodel_get_class_sequence); may be NULL for
+                 models with one class
+  @param log_p   log(p) of the sequence using the vitberbi path
+  */
+  int *ghmm_cmodel_viterbi_classes (ghmm_cmodel * smo, double *o, int T,
+                                    const int *classes, double *log_p);
+
 /* #endif *//* __EXPERIMENTAL__ == 3 */
 
 #ifdef __cplusplus
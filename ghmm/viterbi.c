@@ -39,6 +39,8 @@
 #endif
 
 #include <float.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 
@@ -49,12 +51,20 @@
 #include "sdmodel.h"
 #include "ghmm_internals.h"
 
+/* alphabets up to this size always get the full table of log emissions */
+#define VITERBI_DENSE_ALPHABET 256
+
 typedef struct local_store_t {
     double **log_in_a;
+    /* log(b) for the symbols symbols[0..n_symbols): log_b[j][c] for the
+       symbol symbols[c], symbol m is in column col_of[m] (-1 if unused) */
     double **log_b;
+    int *symbols;
+    int n_symbols;
+    int *col_of;
     double *phi;
     double *phi_new;
-    int **psi;
+    ighmm_psi_matrix *psi;
 
     int *path_len;
 
@@ -77,11 +87,13 @@ static int viterbi_free(local_store_t **v, int n, int len)
         m_free((*v)->log_in_a[j]);
 
     m_free((*v)->log_in_a);
-    ighmm_cmatrix_free(&((*v)->log_b), n);
+    if ((*v)->log_b)
+        ighmm_cmatrix_free(&((*v)->log_b), n);
+    m_free((*v)->symbols);
+    m_free((*v)->col_of);
     m_free((*v)->phi);
     m_free((*v)->phi_new);
-    /*ighmm_dmatrix_free( &((*v)->psi), len ); */
-    ighmm_dmatrix_stat_free(&((*v)->psi));
+    ighmm_psi_free(&((*v)->psi));
 
     m_free((*v)->path_len);
     m_free((*v)->topo_order);
@@ -93,27 +105,59 @@ static int viterbi_free(local_store_t **v, int n, int len)
 }                               /* viterbi_free */
 
 /*----------------------------------------------------------------------------*/
-static local_store_t *viterbi_alloc(ghmm_dmodel *mo, int len)
+/* Maps the symbols to the columns of log_b. Small alphabets (or alphabets
+   not larger than the sequence) keep the dense table with all M symbols,
+   larger ones get a column for each symbol occuring in o, in the order of
+   their first occurence. */
+static int viterbi_symbol_columns(ghmm_dmodel *mo, int *o, int len,
+                                  local_store_t *v)
+{
+#define CUR_PROC "viterbi_symbol_columns"
+    int t, m, n = 0;
+    int dense = mo->M <= VITERBI_DENSE_ALPHABET || mo->M <= len;
+
+    for (m = 0; m < mo->M; m++)
+        v->col_of[m] = -1;
+    if (dense)
+        for (; n < mo->M; n++)
+            v->symbols[n] = v->col_of[n] = n;
+
+    for (t = 0; t < len; t++) {
+        if (o[t] < 0 || o[t] >= mo->M) {
+            GHMM_LOG_PRINTF(LERROR, LOC, "symbol %d at position %d is not in "
+                            "the alphabet of size %d", o[t], t, mo->M);
+            return -1;
+        }
+        if (v->col_of[o[t]] < 0) {
+            v->col_of[o[t]] = n;
+            v->symbols[n++] = o[t];
+        }
+    }
+    v->n_symbols = n;
+    return 0;
+#undef CUR_PROC
+}                               /* viterbi_symbol_columns */
+
+/*----------------------------------------------------------------------------*/
+static local_store_t *viterbi_alloc(ghmm_dmodel *mo, int *o, int len)
 {
 #define CUR_PROC "sdviterbi_alloc"
     local_store_t *v = NULL;
-    int j;
+    int j, max_in_states = 0;
     ARRAY_CALLOC(v, 1);
 
     /* Allocate the log_in_a's -> individal lenghts */
     ARRAY_CALLOC(v->log_in_a, mo->N);
     for (j = 0; j < mo->N; j++) {
         ARRAY_CALLOC(v->log_in_a[j], mo->s[j].in_states);
+        if (mo->s[j].in_states > max_in_states)
+            max_in_states = mo->s[j].in_states;
     }
 
-    v->log_b = ighmm_cmatrix_alloc(mo->N, mo->M);
-    if (!(v->log_b)) {
-        GHMM_LOG_QUEUED(LCONVERTED);
-        goto STOP;
-    }
     ARRAY_CALLOC(v->phi, mo->N);
     ARRAY_CALLOC(v->phi_new, mo->N);
-    v->psi = ighmm_dmatrix_stat_alloc(len, mo->N);
+    /* psi stores the position in in_id, mostly one byte per entry */
+    v->psi = ighmm_psi_alloc(len, mo->N, max_in_states);
     if (!(v->psi)) {
         GHMM_LOG_QUEUED(LCONVERTED);
         goto STOP;
@@ -124,6 +168,17 @@ static local_store_t *viterbi_alloc(ghmm_dmodel *mo, int len)
     v->topo_order_length = 0;
     ARRAY_CALLOC(v->topo_order, mo->N);
 
+    /* the log emissions are only needed for the symbols of o */
+    ARRAY_MALLOC(v->symbols, mo->M);
+    ARRAY_MALLOC(v->col_of, mo->M);
+    if (viterbi_symbol_columns(mo, o, len, v) == -1)
+        goto STOP;
+    v->log_b = ighmm_cmatrix_alloc(mo->N, v->n_symbols > 0 ? v->n_symbols : 1);
+    if (!(v->log_b)) {
+        GHMM_LOG_QUEUED(LCONVERTED);
+        goto STOP;
+    }
+
     return v;
   STOP:                        /* Label STOP from ARRAY_[CM]ALLOC */
     viterbi_free(&v, mo->N, len);
@@ -132,10 +187,11 @@ static local_store_t *viterbi_alloc(ghmm_dmodel *mo, int len)
 }                               /* viterbi_alloc */
 
 /*----------------------------------------------------------------------------*/
-static void Viterbi_precompute(ghmm_dmodel *mo, int *o, int len, local_store_t *v)
+static void Viterbi_precompute(ghmm_dmodel *mo, const ghmm_dsparse_emission *se,
+                               local_store_t *v)
 {
 #define CUR_PROC "viterbi_precompute"
-    int i, j, t;
+    int i, j, k, c, m;
 
     /* Precomputing the log(a_ij) */
     for (j = 0; j < mo->N; j++) {
@@ -147,13 +203,26 @@ static void Viterbi_precompute(ghmm_dmodel *mo, int *o, int len, local_store_t *
         }
     }
 
-    /* Precomputing the log(bj(ot)) */
-    for (j = 0; j < mo->N; j++) {
-        for (t = 0; t < mo->M; t++) {
-            if (mo->s[j].b[t] == 0.0)    /* DBL_EPSILON ? */
-                v->log_b[j][t] = +1;
-            else
-                v->log_b[j][t] = log(mo->s[j].b[t]);
+    /* Precomputing the log(bj(ot)) for the symbols of the sequence */
+    if (se) {
+        for (j = 0; j < mo->N; j++)
+            for (c = 0; c < v->n_symbols; c++)
+                v->log_b[j][c] = +1;
+        for (c = 0; c < v->n_symbols; c++) {
+            m = v->symbols[c];
+            for (k = se->start[m]; k < se->start[m + 1]; k++)
+                v->log_b[se->state[k]][c] = log(se->b[k]);
+        }
+    }
+    else {
+        for (j = 0; j < mo->N; j++) {
+            for (c = 0; c < v->n_symbols; c++) {
+                m = v->symbols[c];
+                if (mo->s[j].b[m] == 0.0)    /* DBL_EPSILON ? */
+                    v->log_b[j][c] = +1;
+                else
+                    v->log_b[j][c] = log(mo->s[j].b[m]);
+            }
         }
     }
 #undef CUR_PROC
@@ -164,7 +233,7 @@ static void viterbi_silent(ghmm_dmodel *mo, int t, local_store_t *v)
 {
 #define CUR_PROC "viterbi_silent"
     int topocount;
-    int i, St, i_id, max_id;
+    int i, St, i_id, max_id, max_i;
     double max_value, value;
 
     for (topocount=0; topocount < mo->topo_order_length; topocount++) {
@@ -174,6 +243,7 @@ static void viterbi_silent(ghmm_dmodel *mo, int t, local_store_t *v)
             /* max_phi = phi[i] + log_in_a[j][i] ... */
             max_value = -DBL_MAX;
             max_id = -1;
+            max_i = -1;
             for (i = 0; i < mo->s[St].in_states; i++) {
                 i_id = mo->s[St].in_id[i];
                 if (v->phi[i_id] != +1 && v->log_in_a[St][i] != +1) {
@@ -181,6 +251,7 @@ static void viterbi_silent(ghmm_dmodel *mo, int t, local_store_t *v)
                     if (value > max_value) {
                         max_value = value;
                         max_id = i_id;
+                        max_i = i;
                     }
                 }
             }
@@ -190,7 +261,7 @@ static void viterbi_silent(ghmm_dmodel *mo, int t, local_store_t *v)
                 v->phi[St] = +1;
             } else {
                 v->phi[St] = max_value;
-                v->psi[t][St] = max_id;
+                ighmm_psi_set(v->psi, t, St, max_i);
                 v->path_len[St] = v->path_len[max_id] + 1;
             }
         }
@@ -198,29 +269,82 @@ static void viterbi_silent(ghmm_dmodel *mo, int t, local_store_t *v)
 #undef CUR_PROC
 }
 
+/*----------------------------------------------------------------------------*/
+/* NAME (mo, v, t, col, emitting, n_emitting, plen): one time step for the
+   emitting states (all states if emitting is NULL), col is the column of
+   o[t] in log_b. Instantiated with and
+   without silent states (SILENT is a compile time constant), so plain
+   models do not test the silent flags in the inner loop. */
+#define VITERBI_EMITTING_STEP(NAME, SILENT)                                   \
+static void NAME(ghmm_dmodel *mo, local_store_t *v, int t, int col,           \
+                 const int *emitting, int n_emitting, int *plen)              \
+{                                                                             \
+    int i, i_id, k, St, max_id, max_i;                                        \
+    double value, max_value;                                                  \
+                                                                              \
+    for (k = 0; k < n_emitting; k++) {                                        \
+        St = emitting ? emitting[k] : k;                                      \
+        if (SILENT && mo->silent[St])                                         \
+            continue;                                                         \
+        /* max_phi = phi[i] + log_in_a[j][i] ... */                           \
+        max_value = -DBL_MAX;                                                 \
+        max_id = -1;                                                          \
+        max_i = -1;                                                           \
+        for (i = 0; i < mo->s[St].in_states; i++) {                           \
+            i_id = mo->s[St].in_id[i];                                        \
+            if (v->phi[i_id] != +1 && v->log_in_a[St][i] != +1) {             \
+                value = v->phi[i_id] + v->log_in_a[St][i];                    \
+                if (value > max_value) {                                      \
+                    max_value = value;                                        \
+                    max_id = i_id;                                            \
+                    max_i = i;                                                \
+                }                                                             \
+            }                                                                 \
+        }                                                                     \
+        /* No maximum found (that is, state never reached)                    \
+           or the output O[t] = 0.0: */                                       \
+        if (max_id >= 0 && v->log_b[St][col] != +1) {                         \
+            v->phi_new[St] = max_value + v->log_b[St][col];                   \
+            ighmm_psi_set(v->psi, t, St, max_i);                              \
+            plen[St] = v->path_len[max_id] + 1;                               \
+        }                                                                     \
+    }                                                                         \
+}
+
+VITERBI_EMITTING_STEP(viterbi_emitting_step, 0)
+VITERBI_EMITTING_STEP(viterbi_emitting_step_silent, 1)
+
 /*============================================================================*/
-/** Return the viterbi path of the sequence.  */
-int *ghmm_dmodel_viterbi(ghmm_dmodel * mo, int *o, int len, int *pathlen, double *log_p)
+/** Return the viterbi path of the sequence. With sparse emissions only the
+    states emitting o[t] are considered at time t. */
+static int *viterbi(ghmm_dmodel * mo, const ghmm_dsparse_emission *se, int *o,
+                    int len, int *pathlen, double *log_p)
 {
-#define CUR_PROC "ghmm_dmodel_viterbi"
+#define CUR_PROC "viterbi"
 
     int *state_seq = NULL;
-    int t, j, i, i_id, St, max_id;
+    int t, j, n_emitting;
+    const int *emitting;
     int end_state, next_state, prev_state;
     int len_path, state_seq_index;
-    int *plen, *exchange;
-    double value, max_value, *temp;
+    int *plen = NULL, *exchange;
+    double max_value, *temp;
     local_store_t *v;
+    void (*emitting_step)(ghmm_dmodel *, local_store_t *, int, int,
+                          const int *, int, int *);
 
     /* for silent states: initializing path length with a multiple
        of the sequence length
        and sort the silent states topological */
     if (mo->model_type & GHMM_kSilentStates) {
         ghmm_dmodel_order_topological(mo);
+        emitting_step = viterbi_emitting_step_silent;
     }
+    else
+        emitting_step = viterbi_emitting_step;
 
     /* Allocate the matrices log_in_a, log_b,Vektor phi, phi_new, Matrix psi */
-    v = viterbi_alloc(mo, len);
+    v = viterbi_alloc(mo, o, len);
     if (!v) {
         GHMM_LOG_QUEUED(LCONVERTED);
         goto STOP;
@@ -229,14 +353,14 @@ int *ghmm_dmodel_viterbi(ghmm_dmodel * mo, int *o, int len, int *pathlen, double
     ARRAY_CALLOC(plen, mo->N);
 
     /* Precomputing the log(a_ij) and log(bj(ot)) */
-    Viterbi_precompute(mo, o, len, v);
+    Viterbi_precompute(mo, se, v);
 
     /* Initialization, that is t = 0 */
     for (j = 0; j < mo->N; j++) {
-        if (mo->s[j].pi == 0.0 || v->log_b[j][o[0]] == +1) /* instead of 0, DBL_EPS.? */
+        if (mo->s[j].pi == 0.0 || v->log_b[j][v->col_of[o[0]]] == +1) /* instead of 0, DBL_EPS.? */
             v->phi[j] = +1;
         else {
-            v->phi[j] = log(mo->s[j].pi) + v->log_b[j][o[0]];
+            v->phi[j] = log(mo->s[j].pi) + v->log_b[j][v->col_of[o[0]]];
             v->path_len[j] = 1;
         }
     }
@@ -247,37 +371,21 @@ int *ghmm_dmodel_viterbi(ghmm_dmodel * mo, int *o, int len, int *pathlen, double
     /* t > 0 */
     for (t = 1; t < len; t++) {
         for (j = 0; j < mo->N; j++) {
-            /* initialization of phi, psi */
+            /* initialization of phi, psi is allocated without predecessors */
             v->phi_new[j] = +1;
-            v->psi[t][j] = -1;
         }
 
-        for (St=0; St < mo->N; St++) {
-            /* Determine the maximum */
-            /* max_phi = phi[i] + log_in_a[j][i] ... */
-            if (!(mo->model_type & GHMM_kSilentStates) || !mo->silent[St]) {
-                max_value = -DBL_MAX;
-                max_id = -1;
-                for (i = 0; i < mo->s[St].in_states; i++) {
-                    i_id = mo->s[St].in_id[i];
-                    if (v->phi[i_id] != +1 && v->log_in_a[St][i] != +1) {
-                        value = v->phi[i_id] + v->log_in_a[St][i];
-                        if (value > max_value) {
-                            max_value = value;
-                            max_id = i_id;
-                        }
-                    }
-                }
+        /* all states or only the states emitting o[t] */
+        if (se) {
+            emitting = se->state + se->start[o[t]];
+            n_emitting = se->start[o[t] + 1] - se->start[o[t]];
+        }
+        else {
+            emitting = NULL;
+            n_emitting = mo->N;
+        }
 
-                /* No maximum found (that is, state never reached)
-                   or the output O[t] = 0.0: */
-                if (max_id >= 0 && v->log_b[St][o[t]] != +1) {
-                    v->phi_new[St] = max_value + v->log_b[St][o[t]];
-                    v->psi[t][St]  = max_id;
-                    plen[St] = v->path_len[max_id] + 1;
-                }
-            }
-        }                       /* complete time step for emitting states */
+        emitting_step(mo, v, t, v->col_of[o[t]], emitting, n_emitting, plen);
 
         /* Exchange pointers */
         temp = v->phi; v->phi = v->phi_new; v->phi_new = temp;
@@ -318,7 +426,7 @@ int *ghmm_dmodel_viterbi(ghmm_dmodel * mo, int *o, int len, int *pathlen, double
 
     /* backtrace is simple if the path length is known */
     for (; state_seq_index >= 0;  state_seq_index--) {
-        next_state = v->psi[t][prev_state];
+        next_state = mo->s[prev_state].in_id[ighmm_psi_get(v->psi, t, prev_state)];
         state_seq[state_seq_index] = prev_state = next_state;
         if (!(mo->model_type & GHMM_kSilentStates) || !mo->silent[next_state])
             t--;
@@ -335,12 +443,34 @@ int *ghmm_dmodel_viterbi(ghmm_dmodel * mo, int *o, int len, int *pathlen, double
     /* Free the memory space */
     *pathlen = -1;
     viterbi_free(&v, mo->N, len);
-    m_free(plen);
-    m_free(state_seq);
+    if (plen)
+        m_free(plen);
+    if (state_seq)
+        m_free(state_seq);
     return NULL;
 #undef CUR_PROC
+}                               /* viterbi */
+
+/*============================================================================*/
+int *ghmm_dmodel_viterbi(ghmm_dmodel * mo, int *o, int len, int *pathlen, double *log_p)
+{
+    return viterbi(mo, NULL, o, len, pathlen, log_p);
 }                               /* ghmm_dmodel_viterbi */
 
+/*============================================================================*/
+int *ghmm_dmodel_viterbi_sparse(ghmm_dmodel * mo, const ghmm_dsparse_emission *se,
+                                int *o, int len, int *pathlen, double *log_p)
+{
+#define CUR_PROC "ghmm_dmodel_viterbi_sparse"
+    if (se->M != mo->M) {
+        GHMM_LOG(LERROR, "sparse emissions do not belong to the model");
+        *pathlen = -1;
+        return NULL;
+    }
+    return viterbi(mo, se, o, len, pathlen, log_p);
+#undef CUR_PROC
+}                               /* ghmm_dmodel_viterbi_sparse */
+
 /*============================================================================*/
 double ghmm_dmodel_viterbi_logp(ghmm_dmodel * mo, int *o, int len, int *state_seq)
 {
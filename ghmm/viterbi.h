@@ -62,6 +62,23 @@ extern "C" {
   */
     int * ghmm_dmodel_viterbi (ghmm_dmodel * mo, int *o, int len, int *pathlen, double *log_p);
 
+/**
+  Viterbi algorithm for models with mostly zero emission probabilities.
+  Same as ghmm_dmodel_viterbi, but the emissions are taken from the sparse
+  table and in every time step only the states emitting the observed symbol
+  are considered.
+  @return Viterbi path
+  @param mo:    model
+  @param se:    sparse emissions of mo, see ghmm_dmodel_sparse_emission_alloc
+  @param o:     sequence
+  @param len:   length of the sequence
+  @param pathlen: length of the viterbi path excluding the final "-1"
+  @param log_p: probability of the sequence in the Viterbi path
+  */
+    int * ghmm_dmodel_viterbi_sparse (ghmm_dmodel * mo,
+                                      const ghmm_dsparse_emission * se, int *o,
+                                      int len, int *pathlen, double *log_p);
+
 /**
   Calculates the logarithmic probability to a given path through the 
   states (does not have to be the Viterbi path), given sequence and
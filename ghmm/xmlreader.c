@@ -45,10 +45,14 @@
 #include <math.h>
 #include <assert.h>
 #include <limits.h>
+#include <float.h>
+#include <ctype.h>
+#include <stdint.h>
 
 #include <libxml/xmlmemory.h>
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 
 #include "ghmm.h"
 #include "ghmm_internals.h"
@@ -155,37 +159,190 @@ static char * getXMLCharAttribute(xmlNodePtr node, const char *name,
 
 
 /*===========================================================================*/
+/* powers of ten that are exactly representable as double */
+static const double exactPowersOfTen[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*===========================================================================*/
+/* Converts the decimal number at data and returns a pointer behind it or NULL
+   if there is no number. A mantissa of at most 2^53 scaled by at most 10^22
+   is converted by one multiplication or division of exact operands, which is
+   rounded correctly. Longer mantissas, larger exponents, inf, nan and
+   hexadecimal numbers are left to strtod. */
+static const char * parseDouble(const char * data, double * value) {
+
+  const char * p = data, * first;
+  unsigned long long mantissa = 0;
+  int negative = 0, exponent = 0, digits = 0, expDigits, expValue, expSign;
+  char * end;
+  double v;
+
+  while (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r')
+    p++;
+  if (*p == '-' || *p == '+')
+    negative = (*p++ == '-');
+
+  first = p;
+  for (; *p >= '0' && *p <= '9'; p++)
+    if (mantissa || *p != '0') {
+      mantissa = 10 * mantissa + (*p - '0');
+      if (++digits > 19)
+        goto SLOW;
+    }
+  if (*p == '.')
+    for (p++; *p >= '0' && *p <= '9'; p++) {
+      if (mantissa || *p != '0') {
+        mantissa = 10 * mantissa + (*p - '0');
+        if (++digits > 19)
+          goto SLOW;
+      }
+      exponent--;
+    }
+  if (p == first || (p == first + 1 && *first == '.'))
+    goto SLOW;
+
+  if (*p == 'e' || *p == 'E') {
+    const char * q = p + 1;
+    expSign = 1;
+    if (*q == '-' || *q == '+')
+      expSign = (*q++ == '-') ? -1 : 1;
+    for (expDigits = 0, expValue = 0; *q >= '0' && *q <= '9'; q++, expDigits++)
+      if (expValue < 10000)
+        expValue = 10 * expValue + (*q - '0');
+    if (expDigits) {
+      exponent += expSign * expValue;
+      p = q;
+    }
+  }
+  if (*p == 'x' || *p == 'X')
+    goto SLOW;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+    v = (double)mantissa;
+    if (exponent < 0)
+      v /= exactPowersOfTen[-exponent];
+    else
+      v *= exactPowersOfTen[exponent];
+    *value = negative ? -v : v;
+    return p;
+  }
+#endif
+
+SLOW:
+  *value = strtod(data, &end);
+  return (end == data) ? NULL : end;
+}
+
+/*===========================================================================*/
+/* Reads size numbers separated by one character and optional white space. */
 static int parseCSVList(const char * data, unsigned int size, double * array, int reverse) {
 #define CUR_PROC "parseCSVList"
 
-  int retval=0;
   int i;
-  char * * next, * estr;
+  const char * next;
   double tmp;
 
-  ARRAY_CALLOC(next, 1);
+  if (!data) {
+    GHMM_LOG(LERROR, "error in parsing CSV. no data");
+    return -1;
+  }
 
   for (i=0; i<size; i++) {
-    array[i] = strtod(data, next);
-    if (data == *next) {
-      estr = ighmm_mprintf(NULL, 0, "error in parsing CSV. entry %d of %d. (%s)", i, size, *next);
-      GHMM_LOG(LERROR, estr);
-      m_free(estr);
-      retval=-1;
-      break;
+    next = parseDouble(data, array+i);
+    if (!next) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "error in parsing CSV. entry %d of %d. (%.20s)",
+                      i, size, data);
+      return -1;
     }
-    if (next)
-      data = *next+1;
-    else
+    if (*next == '\0') {
+      i++;
       break;
+    }
+    data = next+1;
   }
 
   if (i != size) {
-    retval=-1;
-    estr = ighmm_mprintf(NULL, 0, "error in parsing CSV. sizes do not match (%d != %d)", i, size);
-    GHMM_LOG(LERROR, estr);
-    m_free(estr);
+    GHMM_LOG_PRINTF(LERROR, LOC, "error in parsing CSV. sizes do not match (%d != %d)",
+                    i, size);
+    return -1;
+  }
+
+  if (reverse) {
+    for (i=0; i<size/2; i++) {
+      tmp = array[i];
+      array[i] = array[size-i-1];
+      array[size-i-1] = tmp;
+    }
+  }
+
+  return 0;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+/* Reads size little endian IEEE 754 doubles from base64 data (RFC 4648),
+   ignoring white space. */
+static int parseBase64List(const char * data, unsigned int size, double * array, int reverse) {
+#define CUR_PROC "parseBase64List"
+
+  unsigned int i, nbytes=0, quad=0, pad=0;
+  uint32_t acc=0;
+  uint64_t bits;
+  unsigned char *bytes=NULL;
+  int c, v;
+  double tmp;
+
+  if (!data) {
+    GHMM_LOG(LERROR, "error in parsing base64. no data");
+    return -1;
+  }
+
+  ARRAY_MALLOC(bytes, size*8 + 3);
+
+  for (; (c = (unsigned char)*data); data++) {
+    if (c >= 'A' && c <= 'Z')      v = c - 'A';
+    else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+    else if (c >= '0' && c <= '9') v = c - '0' + 52;
+    else if (c == '+')             v = 62;
+    else if (c == '/')             v = 63;
+    else if (c == '=')           { v = 0; pad++; }
+    else if (isspace(c))           continue;
+    else {
+      GHMM_LOG_PRINTF(LERROR, LOC, "invalid character '%c' in base64 data", c);
+      goto STOP;
+    }
+    if (pad && c != '=') {
+      GHMM_LOG(LERROR, "base64 data continues after padding");
+      goto STOP;
+    }
+    acc = (acc << 6) | v;
+    if (++quad == 4) {
+      if (nbytes + 3 > size*8 + 3) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "error in parsing base64. more than %d entries", size);
+        goto STOP;
+      }
+      bytes[nbytes++] = (acc >> 16) & 0xFF;
+      bytes[nbytes++] = (acc >> 8) & 0xFF;
+      bytes[nbytes++] = acc & 0xFF;
+      acc = quad = 0;
+    }
+  }
+  if (quad || pad > 2 || nbytes - pad != size*8) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "error in parsing base64. sizes do not match (%d != %d)",
+                    (nbytes - pad) / 8, size);
+    goto STOP;
+  }
+
+  for (i=0; i<size; i++) {
+    bits = 0;
+    for (c=7; c>=0; c--)
+      bits = (bits << 8) | bytes[8*i + c];
+    memcpy(array+i, &bits, 8);
   }
+  free(bytes);
 
   if (reverse) {
     for (i=0; i<size/2; i++) {
@@ -195,9 +352,27 @@ static int parseCSVList(const char * data, unsigned int size, double * array, in
     }
   }
 
+  return 0;
 STOP:
-  m_free(next);
-  return retval;
+  free(bytes);
+  return -1;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+/* Reads an emission list written as CSV or, if encoding is "base64", as
+   base64 encoded doubles. */
+static int parseEmissionList(const char * data, const xmlChar * encoding,
+                             unsigned int size, double * array, int reverse) {
+#define CUR_PROC "parseEmissionList"
+
+  if (!encoding || !xmlStrcmp(encoding, BAD_CAST "csv"))
+    return parseCSVList(data, size, array, reverse);
+  if (!xmlStrcmp(encoding, BAD_CAST "base64"))
+    return parseBase64List(data, size, array, reverse);
+
+  GHMM_LOG_PRINTF(LERROR, LOC, "unknown encoding %s", (const char *)encoding);
+  return -1;
 #undef CUR_PROC
 }
 
@@ -328,10 +503,11 @@ STOP:
 static int parseBackground(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int modelNo) {
 #define CUR_PROC "parseBackground"
 
-  int error, order;
+  int error, order, rc;
   int bgNr, rev;
   double *b = NULL;
   char   *s = NULL;
+  xmlChar *enc;
 
   assert(f->modelType & GHMM_kDiscreteHMM);
 
@@ -359,7 +535,11 @@ static int parseBackground(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int m
   s = (char *)xmlNodeGetContent(cur);
 
   ARRAY_MALLOC(b, pow(f->model.d[modelNo]->bp->m, order+1));
-  if (-1 !=  parseCSVList(s, pow(f->model.d[modelNo]->bp->m, order+1), b, rev))
+  enc = xmlGetProp(cur, BAD_CAST "encoding");
+  rc = parseEmissionList(s, enc, pow(f->model.d[modelNo]->bp->m, order+1), b, rev);
+  if (enc)
+    xmlFree(enc);
+  if (-1 != rc)
     f->model.d[modelNo]->bp->b[bgNr] = b;
   else {
     GHMM_LOG(LERROR, "Can not parse background CSV list.");
@@ -385,6 +565,7 @@ static int parseState(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int * inDe
   double *emissions = NULL;
   char *desc = NULL;
   char *s = NULL, *estr;
+  xmlChar *enc = NULL;
   int rev, stateFixed=1;
   ghmm_cstate *newcstate;
   ghmm_c_emission *emission;
@@ -409,9 +590,13 @@ static int parseState(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int * inDe
       switch (f->modelType & PTR_TYPE_MASK) {
       case (GHMM_kDiscreteHMM):
         f->model.d[modelNo]->silent[state] = 1;
+        f->model.d[modelNo]->s[state].desc = desc;
+        f->model.d[modelNo]->s[state].pi = pi;
         break;
       case (GHMM_kDiscreteHMM+GHMM_kTransitionClasses):
         f->model.ds[modelNo]->silent[state] = 1;
+        f->model.ds[modelNo]->s[state].desc = desc;
+        f->model.ds[modelNo]->s[state].pi = pi;
         break;
       case (GHMM_kDiscreteHMM+GHMM_kPairHMM):
       case (GHMM_kDiscreteHMM+GHMM_kPairHMM+GHMM_kTransitionClasses):
@@ -445,6 +630,7 @@ static int parseState(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int * inDe
 
       /* parsing emission probabilities */
       s = (char *)xmlNodeGetContent(elem);
+      enc = xmlGetProp(elem, BAD_CAST "encoding");
 
       switch (f->modelType & PTR_TYPE_MASK) {
 
@@ -463,7 +649,7 @@ static int parseState(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int * inDe
           }
         }
         ARRAY_MALLOC(emissions, pow(f->model.d[modelNo]->M, order+1));
-        parseCSVList(s, pow(f->model.d[modelNo]->M, order+1), emissions, rev);
+        parseEmissionList(s, enc, pow(f->model.d[modelNo]->M, order+1), emissions, rev);
         free(f->model.d[modelNo]->s[state].b);
         f->model.d[modelNo]->s[state].b = emissions;
         break;
@@ -475,7 +661,7 @@ static int parseState(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int * inDe
         if (f->modelType & GHMM_kHigherOrderEmissions)
           f->model.ds[modelNo]->order[state] = order;
         ARRAY_MALLOC(emissions, pow(f->model.ds[modelNo]->M, order+1));
-        parseCSVList(s, pow(f->model.ds[modelNo]->M, order+1), emissions, rev);
+        parseEmissionList(s, enc, pow(f->model.ds[modelNo]->M, order+1), emissions, rev);
         f->model.ds[modelNo]->s[state].b = emissions;
         break;
 
@@ -484,6 +670,10 @@ static int parseState(xmlDocPtr doc, xmlNodePtr cur, ghmm_xmlfile* f, int * inDe
         goto STOP;
       }
       m_free(s);
+      if (enc) {
+        xmlFree(enc);
+        enc = NULL;
+      }
     }
 
     /* ======== continuous state ========================================== */
@@ -766,6 +956,8 @@ STOP:
   m_free(s);
   m_free(desc);
   m_free(emissions)
+  if (enc)
+    xmlFree(enc);
   return -1;
 #undef CUR_PROC
 }
@@ -1270,6 +1462,1009 @@ STOP:
 }
 
 
+/*===========================================================================*/
+/* Streaming reader
+
+   ghmm_xmlfile_parse_stream reads the file twice with a libxml2 text reader
+   instead of building the document tree. The first pass counts the states,
+   transitions and backgrounds of every HMM, the second one allocates the
+   models with these sizes and fills them while the elements pass by. Only
+   the element being read is held in memory. */
+
+/* sizes of one HMM found by the first pass */
+typedef struct {
+  int modelType;
+  int N;
+  int M;
+  int nrBackgrounds;
+  int * inDegree;
+  int * outDegree;
+} streamCounts;
+
+/*===========================================================================*/
+static int readerIntAttribute(xmlTextReaderPtr reader, const char *name,
+                              int *error) {
+  xmlChar *attr;
+  int value = -3894;
+
+  if ((attr = xmlTextReaderGetAttribute(reader, BAD_CAST name)) != NULL) {
+    value = atoi((char *)attr);
+    xmlFree(attr);
+    *error = 0;
+  } else {
+    *error = 1;
+  }
+  return value;
+}
+
+/*===========================================================================*/
+static double readerDoubleAttribute(xmlTextReaderPtr reader, const char *name,
+                                    int *error) {
+  xmlChar *attr;
+  double value = 0.0;
+
+  if ((attr = xmlTextReaderGetAttribute(reader, BAD_CAST name)) != NULL) {
+    value = atof((char *)attr);
+    xmlFree(attr);
+    *error = 0;
+  } else {
+    *error = 1;
+  }
+  return value;
+}
+
+/*===========================================================================*/
+/* Moves to the next element below the element at depth. Returns 1 on an
+   element, 0 at the end of the element at depth and -1 on errors. */
+static int nextChild(xmlTextReaderPtr reader, int depth) {
+  int ret;
+
+  if (xmlTextReaderDepth(reader) == depth
+      && xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT
+      && xmlTextReaderIsEmptyElement(reader))
+    return 0;
+
+  while ((ret = xmlTextReaderRead(reader)) == 1) {
+    if (xmlTextReaderDepth(reader) <= depth)
+      return 0;
+    if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT)
+      return 1;
+  }
+  return ret ? -1 : 0;
+}
+
+/*===========================================================================*/
+static int isElement(xmlTextReaderPtr reader, const char *name) {
+  return !xmlStrcmp(xmlTextReaderConstName(reader), BAD_CAST name);
+}
+
+/*===========================================================================*/
+static void freeCounts(streamCounts * counts, int n) {
+  int i;
+
+  for (i=0; i<n; i++) {
+    free(counts[i].inDegree);
+    free(counts[i].outDegree);
+  }
+  free(counts);
+}
+
+/*===========================================================================*/
+/* first pass, counts everything the allocation of the models needs */
+static streamCounts * streamCount(const char *filename, int *noModels,
+                                  int *nrHMMs) {
+#define CUR_PROC "streamCount"
+
+  xmlTextReaderPtr reader;
+  streamCounts * counts = NULL, * cur = NULL;
+  int * symbols = NULL;
+  int n = 0, size = 0, depth, hmmDepth = 0, nrAlphabets = 0;
+  int ret, skip, error, value, source, target;
+  char * mt;
+
+  *noModels = -1;
+  reader = xmlReaderForFile(filename, NULL, XML_PARSE_NONET);
+  if (!reader) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "can not open %s", filename);
+    return NULL;
+  }
+
+  ret = xmlTextReaderRead(reader);
+  while (ret == 1) {
+    skip = 0;
+    depth = xmlTextReaderDepth(reader);
+
+    if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+      ;
+    /* ========== ROOT AND MODELS ========================================== */
+    else if (depth == 0 && isElement(reader, "mixture")) {
+      *noModels = readerIntAttribute(reader, "noComponents", &error);
+      if (error || *noModels < 1) {
+        GHMM_LOG(LERROR, "invalid number of mixture components");
+        goto STOP;
+      }
+    }
+    else if (depth <= 1 && isElement(reader, "HMM")) {
+      if (depth == 0)
+        *noModels = 1;
+      if (n == size) {
+        size = size ? 2 * size : 4;
+        ARRAY_REALLOC(counts, size);
+      }
+      cur = counts + n++;
+      memset(cur, 0, sizeof(*cur));
+      hmmDepth = depth;
+      nrAlphabets = 0;
+      symbols = NULL;
+
+      mt = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "type");
+      if (!mt) {
+        GHMM_LOG(LERROR, "HMM without type");
+        goto STOP;
+      }
+      cur->modelType = parseModelType(mt, strlen(mt));
+      xmlFree(mt);
+      if (cur->modelType == -1)
+        goto STOP;
+    }
+    else if (!cur)
+      ;
+    /* ========== ALPHABETS ================================================ */
+    else if (depth == hmmDepth+1 && isElement(reader, "alphabet"))
+      symbols = (nrAlphabets++ == 0) ? &cur->M : NULL;
+    else if (depth == hmmDepth+1 && isElement(reader, "classAlphabet"))
+      symbols = NULL;
+    else if (depth == hmmDepth+2 && symbols && isElement(reader, "symbol")) {
+      value = readerIntAttribute(reader, "code", &error);
+      if (error || value != *symbols) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "non consecutive code %d == %d", value,
+                        *symbols);
+        goto STOP;
+      }
+      (*symbols)++;
+    }
+    /* ========== NODES ==================================================== */
+    else if (depth == hmmDepth+1 && isElement(reader, "state")) {
+      value = readerIntAttribute(reader, "id", &error);
+      if (error || value != cur->N) {
+        GHMM_LOG(LERROR, "non consecutive node ids");
+        goto STOP;
+      }
+      cur->N++;
+      skip = 1;
+    }
+    /* ========== EDGES ==================================================== */
+    else if (depth == hmmDepth+1 && isElement(reader, "transition")) {
+      if (!cur->inDegree) {
+        ARRAY_CALLOC(cur->inDegree, cur->N);
+        ARRAY_CALLOC(cur->outDegree, cur->N);
+      }
+      source = readerIntAttribute(reader, "source", &error);
+      if (error || source < 0 || source >= cur->N) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "source (%d) node not existing (%d)",
+                        source, error);
+        goto STOP;
+      }
+      target = readerIntAttribute(reader, "target", &error);
+      if (error || target < 0 || target >= cur->N) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "target (%d) node not existing (%d)",
+                        target, error);
+        goto STOP;
+      }
+      cur->inDegree[target]++;
+      cur->outDegree[source]++;
+      skip = 1;
+    }
+    /* ========== BACKGROUND DISTRIBUTIONS ================================= */
+    else if (depth == hmmDepth+1 && isElement(reader, "background")) {
+      cur->nrBackgrounds++;
+      skip = 1;
+    }
+
+    ret = skip ? xmlTextReaderNext(reader) : xmlTextReaderRead(reader);
+  }
+  if (ret == -1) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "Failed to parse %s", filename);
+    goto STOP;
+  }
+  if (*noModels < 0) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "The file does not contains the appropriate root %s",
+                    filename);
+    goto STOP;
+  }
+
+  /* zero degree counts in the case of a HMM without transitions */
+  for (cur=counts; cur<counts+n; cur++)
+    if (!cur->inDegree) {
+      ARRAY_CALLOC(cur->inDegree, cur->N);
+      ARRAY_CALLOC(cur->outDegree, cur->N);
+    }
+
+  xmlFreeTextReader(reader);
+  *nrHMMs = n;
+  return counts;
+STOP:
+  xmlFreeTextReader(reader);
+  if (counts)
+    freeCounts(counts, n);
+  return NULL;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+static void freeAlphabet(ghmm_alphabet * alfa) {
+  int i;
+
+  for (i=0; i<alfa->size; i++)
+    free(alfa->symbols[i]);
+  free(alfa->symbols);
+  free(alfa);
+}
+
+/*===========================================================================*/
+static ghmm_alphabet * streamAlphabet(xmlTextReaderPtr reader) {
+#define CUR_PROC "streamAlphabet"
+
+  ghmm_alphabet * alfa;
+  int depth = xmlTextReaderDepth(reader);
+  int ret, error, code, size = 0;
+  char * s;
+
+  ARRAY_CALLOC(alfa, 1);
+  alfa->id = readerIntAttribute(reader, "id", &error);
+  if (error)
+    alfa->id = 0;
+
+  while ((ret = nextChild(reader, depth)) == 1) {
+    if (xmlTextReaderDepth(reader) != depth+1 || !isElement(reader, "symbol"))
+      continue;
+    code = readerIntAttribute(reader, "code", &error);
+    if (error || code != alfa->size) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "non consecutive code %d == %d", code,
+                      alfa->size);
+      goto STOP;
+    }
+    if (alfa->size == size) {
+      size = size ? 2 * size : 16;
+      ARRAY_REALLOC(alfa->symbols, size);
+    }
+    s = (char *)xmlTextReaderReadString(reader);
+    if (!s)
+      s = (char *)xmlStrdup(BAD_CAST "");
+    alfa->symbols[alfa->size++] = s;
+  }
+  if (ret == -1 || alfa->size == 0)
+    goto STOP;
+
+  return alfa;
+STOP:
+  freeAlphabet(alfa);
+  return NULL;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+static int streamBackground(xmlTextReaderPtr reader, ghmm_dmodel * mo,
+                            const streamCounts * cnt) {
+#define CUR_PROC "streamBackground"
+
+  int error, order, bgNr, rev, size, rc;
+  double *b = NULL;
+  char *s = NULL;
+  xmlChar *enc;
+
+  bgNr = mo->bp->n;
+  if (bgNr >= cnt->nrBackgrounds) {
+    GHMM_LOG(LERROR, "more background distributions than counted");
+    goto STOP;
+  }
+
+  /* get order */
+  order = readerIntAttribute(reader, "order", &error);
+  if (error)
+    order = 0;
+  else if (order < 0 || (order && !(mo->model_type & GHMM_kHigherOrderEmissions))) {
+    GHMM_LOG(LERROR, "background distribution has order > 0, but model is not higher order");
+    goto STOP;
+  }
+
+  rev = readerIntAttribute(reader, "rev", &error);
+  if (error)
+    rev = 0;
+
+  /* get distribution */
+  size = ghmm_ipow(mo, mo->M, order+1);
+  ARRAY_MALLOC(b, size);
+  s = (char *)xmlTextReaderReadString(reader);
+  enc = xmlTextReaderGetAttribute(reader, BAD_CAST "encoding");
+  rc = parseEmissionList(s, enc, size, b, rev);
+  if (enc)
+    xmlFree(enc);
+  if (rc) {
+    GHMM_LOG(LERROR, "Can not parse background CSV list.");
+    goto STOP;
+  }
+  xmlFree(s);
+
+  mo->bp->order[bgNr] = order;
+  mo->bp->b[bgNr] = b;
+  mo->bp->name[bgNr] = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "key");
+  mo->bp->n++;
+  return 0;
+STOP:
+  if (b)
+    m_free(b);
+  if (s)
+    xmlFree(s);
+  return -1;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+static int streamDiscreteState(xmlTextReaderPtr reader, ghmm_dmodel * mo) {
+#define CUR_PROC "streamDiscreteState"
+
+  int depth = xmlTextReaderDepth(reader);
+  int i, ret, error, state, order = 0, rev, size, value, rc;
+  double *emissions = NULL;
+  char *s = NULL;
+  xmlChar *enc;
+
+  state = readerIntAttribute(reader, "id", &error);
+  if (error || state < 0 || state >= mo->N) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "invalid state id %d", state);
+    goto STOP;
+  }
+  mo->s[state].pi = readerDoubleAttribute(reader, "initial", &error);
+  if (error) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "can't read required intial probability for"
+                    " state %d", state);
+    goto STOP;
+  }
+  mo->s[state].desc = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "desc");
+  rev = readerIntAttribute(reader, "rev", &error);
+  if (error)
+    rev = 0;
+
+  while ((ret = nextChild(reader, depth)) == 1) {
+    if (xmlTextReaderDepth(reader) != depth+1)
+      continue;
+
+    /* ======== silent state ============================================== */
+    if (isElement(reader, "silent")) {
+      if (!(mo->model_type & GHMM_kSilentStates)) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "silent state %d in a model without silent"
+                        " states", state);
+        goto STOP;
+      }
+      mo->silent[state] = 1;
+    }
+
+    /* ======== discrete state (possible higher order) ==================== */
+    else if (isElement(reader, "discrete")) {
+      /* fixed is a propety of the distribution and optional */
+      mo->s[state].fix = readerIntAttribute(reader, "fixed", &error);
+      if (error)
+        mo->s[state].fix = 0;
+
+      /* order is optional for discrete */
+      if (mo->model_type & GHMM_kHigherOrderEmissions) {
+        order = readerIntAttribute(reader, "order", &error);
+        if (error)
+          order = 0;
+        if (order < 0) {
+          GHMM_LOG_PRINTF(LERROR, LOC, "invalid order %d of state %d", order, state);
+          goto STOP;
+        }
+        mo->order[state] = order;
+        if (mo->maxorder < order)
+          mo->maxorder = order;
+      }
+
+      /* parsing emission probabilities */
+      size = ghmm_ipow(mo, mo->M, order+1);
+      ARRAY_MALLOC(emissions, size);
+      s = (char *)xmlTextReaderReadString(reader);
+      enc = xmlTextReaderGetAttribute(reader, BAD_CAST "encoding");
+      rc = parseEmissionList(s, enc, size, emissions, rev);
+      if (enc)
+        xmlFree(enc);
+      if (rc) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "Can not parse emissions of state %d", state);
+        goto STOP;
+      }
+      xmlFree(s);
+      s = NULL;
+      free(mo->s[state].b);
+      mo->s[state].b = emissions;
+      emissions = NULL;
+    }
+
+    /* -------- background name  ------------------------------------------ */
+    else if (isElement(reader, "backgroundKey")) {
+      if (!(mo->model_type & GHMM_kBackgroundDistributions))
+        continue;
+      s = (char *)xmlTextReaderReadString(reader);
+      for (i=0; i<mo->bp->n; i++)
+        if (s && mo->bp->name[i] && 0 == strcmp(s, mo->bp->name[i]))
+          break;
+      if (i == mo->bp->n) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "can't find background with name %s in"
+                        " state %d", s, state);
+        goto STOP;
+      }
+      if (order != mo->bp->order[i]) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "order of background %s and state %d"
+                        " does not match", mo->bp->name[i], state);
+        goto STOP;
+      }
+      mo->background_id[state] = i;
+      xmlFree(s);
+      s = NULL;
+    }
+
+    /* -------- class label ----------------------------------------------- */
+    else if (isElement(reader, "class")) {
+      if (!(mo->model_type & GHMM_kLabeledStates))
+        continue;
+      s = (char *)xmlTextReaderReadString(reader);
+      value = s ? atoi(s) : -1;
+      xmlFree(s);
+      s = NULL;
+      if (mo->label_alphabet && value >= 0 && mo->label_alphabet->size > value)
+        mo->label[state] = value;
+      else
+        GHMM_LOG(LWARN, "Invalid label");
+    }
+
+    /* -------- tied to --------------------------------------------------- */
+    else if (isElement(reader, "tiedTo")) {
+      if (!(mo->model_type & GHMM_kTiedEmissions))
+        continue;
+      s = (char *)xmlTextReaderReadString(reader);
+      value = s ? atoi(s) : -1;
+      xmlFree(s);
+      s = NULL;
+      if (value < 0 || state < value) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "state %d tiedTo (%d) is invalid", state, value);
+        goto STOP;
+      }
+      mo->tied_to[state] = value;
+      if (mo->tied_to[value] != value) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "state %d not tied to tie group leader", state);
+        goto STOP;
+      }
+    }
+
+    /* -------- position for graphical editing ---------------------------- */
+    else if (isElement(reader, "position")) {
+      mo->s[state].xPosition = readerIntAttribute(reader, "x", &error);
+      if (error)
+        GHMM_LOG(LWARN, "failed to read x position");
+      mo->s[state].yPosition = readerIntAttribute(reader, "y", &error);
+      if (error)
+        GHMM_LOG(LWARN, "failed to read y position");
+    }
+  }
+  if (ret == -1)
+    goto STOP;
+
+  return 0;
+STOP:
+  if (s)
+    xmlFree(s);
+  if (emissions)
+    m_free(emissions);
+  return -1;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+/* reads the densities of a mixture element into state */
+static int streamMixture(xmlTextReaderPtr reader, ghmm_cmodel * mo,
+                         ghmm_cstate * state, const streamCounts * cnt,
+                         int stateNo) {
+#define CUR_PROC "streamMixture"
+
+  int depth = xmlTextReaderDepth(reader);
+  int i = 0, size = 1, ret, mret, error, approx, fixed, stateFixed = 1;
+  char * s = NULL;
+  ghmm_c_emission * emission;
+
+  if (ghmm_cstate_alloc(state, size, cnt->inDegree[stateNo],
+                        cnt->outDegree[stateNo], mo->cos))
+    goto STOP;
+
+  while ((ret = nextChild(reader, depth)) == 1) {
+    if (xmlTextReaderDepth(reader) != depth+1)
+      continue;
+    if (!isElement(reader, "normal") && !isElement(reader, "normalLeftTail")
+        && !isElement(reader, "normalRightTail") && !isElement(reader, "uniform")
+        && !isElement(reader, "multinormal"))
+      continue;
+
+    if (i == size) {
+      size *= 2;
+      ARRAY_REALLOC(state->c, size);
+      ARRAY_REALLOC(state->e, size);
+      memset(state->e + i, 0, (size - i) * sizeof(*state->e));
+    }
+    emission = state->e + i;
+    /* the density counts as read once its arrays are allocated */
+    state->M = ++i;
+
+    /* common attributes */
+    fixed = readerIntAttribute(reader, "fixed", &error);
+    if (error)
+      fixed = 0;
+    stateFixed = fixed && stateFixed;
+    emission->fixed = fixed;
+    state->c[i-1] = readerDoubleAttribute(reader, "prior", &error);
+    if (error)
+      state->c[i-1] = 1.0;
+
+    /* density type dependent attributes */
+    if (isElement(reader, "multinormal")) {
+      emission->type = multinormal;
+      emission->dimension = readerIntAttribute(reader, "dimension", &error);
+      if (error || emission->dimension < 2) {
+        GHMM_LOG(LERROR, "invalid dimension of multinormal density");
+        goto STOP;
+      }
+
+      /* check that all emissions in all states have same dimension or
+         set when first emission is read*/
+      if (mo->dim <= 1)
+        mo->dim = emission->dimension;
+      else if (mo->dim != emission->dimension) {
+        GHMM_LOG(LERROR, "All emissions must have same dimension.");
+        goto STOP;
+      }
+      if (0 != ghmm_c_emission_alloc(emission, emission->dimension)) {
+        GHMM_LOG(LERROR, "Can not allocate multinormal emission.");
+        goto STOP;
+      }
+
+      while ((mret = nextChild(reader, depth+1)) == 1) {
+        if (isElement(reader, "mean")) {
+          s = (char *)xmlTextReaderReadString(reader);
+          if (parseCSVList(s, emission->dimension, emission->mean.vec, 0)) {
+            GHMM_LOG(LERROR, "Can not parse mean CSV list.");
+            goto STOP;
+          }
+        }
+        else if (isElement(reader, "variance")) {
+          s = (char *)xmlTextReaderReadString(reader);
+          if (parseCSVList(s, emission->dimension * emission->dimension,
+                           emission->variance.mat, 0)) {
+            GHMM_LOG(LERROR, "Can not parse variance CSV list.");
+            goto STOP;
+          }
+          if (0 != ighmm_invert_det(emission->sigmainv, &emission->det,
+                                    emission->dimension, emission->variance.mat)) {
+            GHMM_LOG(LERROR, "Can not calculate inverse of covariance matrix.");
+            goto STOP;
+          }
+          if (0 != ighmm_cholesky_decomposition(emission->sigmacd,
+                                                emission->dimension,
+                                                emission->variance.mat)) {
+            GHMM_LOG(LERROR, "Can not calculate cholesky decomposition of covariance matrix.");
+            goto STOP;
+          }
+        }
+        if (s) {
+          xmlFree(s);
+          s = NULL;
+        }
+      }
+      if (mret == -1)
+        goto STOP;
+      continue;
+    }
+
+    if (mo->dim > 1) {
+      GHMM_LOG(LERROR, "All emissions must have same dimension.");
+      goto STOP;
+    }
+    emission->dimension = 1;
+    if (isElement(reader, "normal")) {
+      emission->mean.val     = readerDoubleAttribute(reader, "mean", &error);
+      emission->variance.val = readerDoubleAttribute(reader, "variance", &error);
+      /* should the normal distribution be approximated? */
+      approx = readerIntAttribute(reader, "approx", &error);
+      emission->type = (!error && approx) ? normal_approx : normal;
+    }
+    else if (isElement(reader, "normalLeftTail")) {
+      emission->mean.val     = readerDoubleAttribute(reader, "mean", &error);
+      emission->variance.val = readerDoubleAttribute(reader, "variance", &error);
+      emission->min          = readerDoubleAttribute(reader, "max", &error);
+      emission->type         = normal_left;
+    }
+    else if (isElement(reader, "normalRightTail")) {
+      emission->mean.val     = readerDoubleAttribute(reader, "mean", &error);
+      emission->variance.val = readerDoubleAttribute(reader, "variance", &error);
+      emission->max          = readerDoubleAttribute(reader, "min", &error);
+      emission->type         = normal_right;
+    }
+    else {
+      emission->max  = readerDoubleAttribute(reader, "max", &error);
+      emission->min  = readerDoubleAttribute(reader, "min", &error);
+      emission->type = uniform;
+    }
+  }
+  if (ret == -1 || i == 0) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "no densities in state %d", stateNo);
+    goto STOP;
+  }
+
+  state->fix = stateFixed;
+  if (mo->M < i)
+    mo->M = i;
+  return 0;
+STOP:
+  if (s)
+    xmlFree(s);
+  return -1;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+static int streamContinuousState(xmlTextReaderPtr reader, ghmm_cmodel * mo,
+                                 const streamCounts * cnt) {
+#define CUR_PROC "streamContinuousState"
+
+  int depth = xmlTextReaderDepth(reader);
+  int ret, error, state, mixtures = 0;
+  double pi;
+  char * desc;
+
+  state = readerIntAttribute(reader, "id", &error);
+  if (error || state < 0 || state >= mo->N) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "invalid state id %d", state);
+    return -1;
+  }
+  pi = readerDoubleAttribute(reader, "initial", &error);
+  if (error) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "can't read required intial probability for"
+                    " state %d", state);
+    return -1;
+  }
+  desc = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "desc");
+
+  while ((ret = nextChild(reader, depth)) == 1) {
+    if (xmlTextReaderDepth(reader) != depth+1)
+      continue;
+
+    if (isElement(reader, "mixture")) {
+      if (mixtures++ || streamMixture(reader, mo, mo->s + state, cnt, state)) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "invalid mixture in state %d", state);
+        goto STOP;
+      }
+    }
+    else if (isElement(reader, "position")) {
+      mo->s[state].xPosition = readerIntAttribute(reader, "x", &error);
+      if (error)
+        GHMM_LOG(LWARN, "failed to read x position");
+      mo->s[state].yPosition = readerIntAttribute(reader, "y", &error);
+      if (error)
+        GHMM_LOG(LWARN, "failed to read y position");
+    }
+  }
+  if (ret == -1 || !mixtures) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "state %d has no mixture", state);
+    goto STOP;
+  }
+
+  mo->s[state].pi = pi;
+  mo->s[state].desc = desc;
+  return 0;
+STOP:
+  if (desc)
+    xmlFree(desc);
+  return -1;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+static int streamTransition(xmlTextReaderPtr reader, ghmm_xmlfile* f,
+                            int modelNo, const streamCounts * cnt,
+                            double * probs, int cos) {
+#define CUR_PROC "streamTransition"
+
+  int depth = xmlTextReaderDepth(reader);
+  int i, error, source, target, in_state, out_state, found = 0;
+  char * s;
+  ghmm_cstate * cstates = NULL;
+
+  source = readerIntAttribute(reader, "source", &error);
+  target = readerIntAttribute(reader, "target", &error);
+  if (source < 0 || source >= cnt->N || target < 0 || target >= cnt->N) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "transition %d -> %d between non existing"
+                    " nodes", source, target);
+    return -1;
+  }
+
+  while (!found && nextChild(reader, depth) == 1) {
+    if (!isElement(reader, "probability"))
+      continue;
+    s = (char *)xmlTextReaderReadString(reader);
+    if (parseCSVList(s, cos, probs, 0)) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "can not parse probability of transition"
+                      " %d -> %d", source, target);
+      if (s)
+        xmlFree(s);
+      return -1;
+    }
+    xmlFree(s);
+    found = 1;
+  }
+  if (!found) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "transition %d -> %d without probability",
+                    source, target);
+    return -1;
+  }
+
+  if ((f->modelType & PTR_TYPE_MASK) == GHMM_kDiscreteHMM) {
+    out_state = f->model.d[modelNo]->s[source].out_states;
+    in_state  = f->model.d[modelNo]->s[target].in_states;
+  }
+  else {
+    cstates = f->model.c[modelNo]->s;
+    out_state = cstates[source].out_states;
+    in_state  = cstates[target].in_states;
+  }
+  if (out_state >= cnt->outDegree[source] || in_state >= cnt->inDegree[target]) {
+    GHMM_LOG(LERROR, "more transitions than counted");
+    return -1;
+  }
+
+  if (!cstates) {
+    f->model.d[modelNo]->s[source].out_id[out_state] = target;
+    f->model.d[modelNo]->s[source].out_a[out_state]  = probs[0];
+    f->model.d[modelNo]->s[target].in_id[in_state]   = source;
+    f->model.d[modelNo]->s[target].in_a[in_state]    = probs[0];
+    f->model.d[modelNo]->s[source].out_states++;
+    f->model.d[modelNo]->s[target].in_states++;
+  }
+  else {
+    if (!cstates[source].out_id || !cstates[target].in_id) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "transition %d -> %d to a state without"
+                      " mixture", source, target);
+      return -1;
+    }
+    cstates[source].out_id[out_state] = target;
+    cstates[target].in_id[in_state]   = source;
+    for (i=0; i<cos; i++) {
+      cstates[source].out_a[i][out_state] = probs[i];
+      cstates[target].in_a[i][in_state]   = probs[i];
+    }
+    cstates[source].out_states++;
+    cstates[target].in_states++;
+  }
+  return 0;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+static int streamHMM(ghmm_xmlfile* f, xmlTextReaderPtr reader,
+                     const streamCounts * cnt, int modelNo) {
+#define CUR_PROC "streamHMM"
+
+  int depth = xmlTextReaderDepth(reader);
+  int i, ret, error, cos, nrAlphabets = 0;
+  double prior;
+  double * probs = NULL;
+  int * bg_orders = NULL;
+  double * * bg_ptr = NULL;
+  char * modelname;
+  ghmm_dmodel * mo = NULL;
+  ghmm_cmodel * smo = NULL;
+  ghmm_alphabet * alfa;
+
+  modelname = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "name");
+  /* reading common optional atribute prior, 1.0 if not defined */
+  prior = readerDoubleAttribute(reader, "prior", &error);
+  if (error)
+    prior = 1.0;
+  /* reading common optional atribute cos, 1 if not defined */
+  cos = readerIntAttribute(reader, "transitionClasses", &error);
+  if (error)
+    cos = 1;
+  if (cos < 1 || (cos > 1 && !(cnt->modelType & GHMM_kTransitionClasses))) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "invalid number of transition classes %d", cos);
+    goto STOP;
+  }
+
+  /* allocating the model with the sizes of the first pass */
+  if ((cnt->modelType & PTR_TYPE_MASK) == GHMM_kDiscreteHMM) {
+    if (cnt->M < 1) {
+      GHMM_LOG(LERROR, "discrete HMM without alphabet");
+      goto STOP;
+    }
+    mo = ghmm_dmodel_calloc(cnt->M, cnt->N, cnt->modelType, cnt->inDegree,
+                            cnt->outDegree);
+    if (!mo)
+      goto STOP;
+    f->model.d[modelNo] = mo;
+    mo->prior = prior;
+    mo->name = modelname;
+    modelname = NULL;
+
+    if (mo->model_type & GHMM_kBackgroundDistributions) {
+      ARRAY_CALLOC(bg_orders, cnt->nrBackgrounds);
+      ARRAY_CALLOC(bg_ptr, cnt->nrBackgrounds);
+      mo->bp = ghmm_dbackground_alloc(cnt->nrBackgrounds, cnt->M, bg_orders,
+                                      bg_ptr);
+      if (!mo->bp)
+        goto STOP;
+      bg_orders = NULL;
+      bg_ptr = NULL;
+      mo->bp->n = 0;
+    }
+  }
+  else {
+    smo = ghmm_cmodel_calloc(cnt->N, cnt->modelType, 1);
+    if (!smo)
+      goto STOP;
+    f->model.c[modelNo] = smo;
+    smo->prior = prior;
+    smo->name = modelname;
+    modelname = NULL;
+    smo->cos = cos;
+  }
+  ARRAY_MALLOC(probs, cos);
+
+  while ((ret = nextChild(reader, depth)) == 1) {
+    if (xmlTextReaderDepth(reader) != depth+1)
+      continue;
+
+    /* ========== ALPHABETS ================================================ */
+    if (isElement(reader, "alphabet") || isElement(reader, "classAlphabet")) {
+      alfa = streamAlphabet(reader);
+      if (!alfa) {
+        GHMM_LOG(LERROR, "Error in parsing alphabets.");
+        goto STOP;
+      }
+      if (mo && isElement(reader, "alphabet") && nrAlphabets++ == 0)
+        mo->alphabet = alfa;
+      else if (mo && isElement(reader, "classAlphabet") && !mo->label_alphabet)
+        mo->label_alphabet = alfa;
+      else
+        freeAlphabet(alfa);
+    }
+
+    /* ========== BACKGROUND DISTRIBUTIONS ================================= */
+    else if (isElement(reader, "background")) {
+      if (mo && (mo->model_type & GHMM_kBackgroundDistributions)) {
+        if (streamBackground(reader, mo, cnt))
+          goto STOP;
+      } else
+        GHMM_LOG(LWARN, "Ignoring background distribution.");
+    }
+
+    /* ========== NODES ==================================================== */
+    else if (isElement(reader, "state")) {
+      if (mo ? streamDiscreteState(reader, mo) : streamContinuousState(reader, smo, cnt))
+        goto STOP;
+    }
+
+    /* ========== EDGES ==================================================== */
+    else if (isElement(reader, "transition")) {
+      if (streamTransition(reader, f, modelNo, cnt, probs, cos))
+        goto STOP;
+    }
+  }
+  if (ret == -1)
+    goto STOP;
+
+  if (mo && (mo->model_type & GHMM_kHigherOrderEmissions)) {
+    ARRAY_MALLOC(mo->pow_lookup, mo->maxorder+2);
+    mo->pow_lookup[0] = 1;
+    for (i=1; i < mo->maxorder+2; ++i)
+      mo->pow_lookup[i] = mo->M * mo->pow_lookup[i-1];
+  }
+
+  m_free(probs);
+  return 0;
+STOP:
+  if (modelname)
+    xmlFree(modelname);
+  if (probs)
+    m_free(probs);
+  if (bg_orders)
+    m_free(bg_orders);
+  if (bg_ptr)
+    m_free(bg_ptr);
+  return -1;
+#undef CUR_PROC
+}
+
+/*===========================================================================*/
+ghmm_xmlfile* ghmm_xmlfile_parse_stream(const char *filename) {
+#define CUR_PROC "ghmm_xmlfile_parse_stream"
+
+  xmlTextReaderPtr reader = NULL;
+  streamCounts * counts;
+  ghmm_xmlfile* f = NULL;
+  int i, ret, type = 0, noModels, nrHMMs, modelNo = 0;
+
+  counts = streamCount(filename, &noModels, &nrHMMs);
+  if (!counts)
+    return NULL;
+  if (nrHMMs < noModels) {
+    GHMM_LOG(LERROR, "The mixture has less models than defined");
+    goto STOP;
+  }
+
+  /* only plain discrete and continuous models are filled while streaming */
+  type = counts[0].modelType & PTR_TYPE_MASK;
+  for (i=0; i<noModels; i++)
+    if ((counts[i].modelType & PTR_TYPE_MASK) != type)
+      break;
+  if (i < noModels || ((type & (GHMM_kPairHMM + GHMM_kTransitionClasses))
+                       && !(type & GHMM_kContinuousHMM))) {
+    GHMM_LOG(LINFO, "no streaming support for the models, reading the document");
+    freeCounts(counts, nrHMMs);
+    return ghmm_xmlfile_parse(filename);
+  }
+
+  ARRAY_CALLOC(f, 1);
+  f->noModels  = noModels;
+  f->modelType = counts[0].modelType;
+  if (type == GHMM_kDiscreteHMM) {
+    ARRAY_CALLOC(f->model.d, noModels);
+  } else {
+    ARRAY_CALLOC(f->model.c, noModels);
+  }
+
+  reader = xmlReaderForFile(filename, NULL, XML_PARSE_NONET);
+  if (!reader) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "can not open %s", filename);
+    goto STOP;
+  }
+  ret = xmlTextReaderRead(reader);
+  while (ret == 1 && modelNo < noModels) {
+    if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT
+        && xmlTextReaderDepth(reader) <= 1 && isElement(reader, "HMM")) {
+      if (streamHMM(f, reader, counts + modelNo, modelNo)) {
+        GHMM_LOG_PRINTF(LERROR, LOC, "could not parse model no. %d", modelNo);
+        goto STOP;
+      }
+      modelNo++;
+    }
+    ret = xmlTextReaderRead(reader);
+  }
+  if (ret == -1 || modelNo < noModels) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "Failed to parse %s", filename);
+    goto STOP;
+  }
+  if (nrHMMs > noModels)
+    GHMM_LOG_PRINTF(LWARN, LOC, "The mixture has more models than defined,"
+                    " ignoring all following HMMs (%d/%d)", nrHMMs, noModels);
+
+  xmlFreeTextReader(reader);
+  freeCounts(counts, nrHMMs);
+  return f;
+STOP:
+  if (reader)
+    xmlFreeTextReader(reader);
+  if (f) {
+    for (i=0; i<noModels && f->model.d; i++) {
+      if (type == GHMM_kDiscreteHMM && f->model.d[i])
+        ghmm_dmodel_free(&f->model.d[i]);
+      else if (type != GHMM_kDiscreteHMM && f->model.c[i])
+        ghmm_cmodel_free(&f->model.c[i]);
+    }
+    if (f->model.d)
+      free(f->model.d);
+    free(f);
+  }
+  freeCounts(counts, nrHMMs);
+  return NULL;
+#undef CUR_PROC
+}
+
+
 /*===========================================================================*/
 static void silence(void* x, const char* y, ...) {return;}
 
@@ -67,6 +67,17 @@ extern "C" {
 
   ghmm_xmlfile* ghmm_xmlfile_parse(const char *filename);
 
+  /** Reads the models of an XML file with a streaming reader, without
+      building the document tree and without validating it against the DTD.
+      The file is read twice, once for the sizes of the models and once for
+      their contents, and only the current element is held in memory. Files
+      with models other than plain discrete or continuous ones are read with
+      ghmm_xmlfile_parse.
+      @return the models of the file or NULL on errors
+      @param filename  name of the XML file
+  */
+  ghmm_xmlfile* ghmm_xmlfile_parse_stream(const char *filename);
+
   int ghmm_xmlfile_validate(const char *filename);
 
 #ifdef __cplusplus
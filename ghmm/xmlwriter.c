@@ -38,7 +38,9 @@
 #endif
 
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <libxml/encoding.h>
 #include <libxml/xmlwriter.h>
@@ -62,14 +64,290 @@
 
 #define DTD_VERSION "1.0"
 
+/* size of the stdio buffer in front of the output file */
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+/* longest string formatDouble produces, including sign and terminator */
+#define DOUBLE_STRLEN 32
+
 #define WRITE_DOUBLE_ATTRIBUTE(XMLW, NAME, VALUE)                       \
-    if (0 > xmlTextWriterWriteFormatAttribute(XMLW, BAD_CAST (NAME),    \
-                                              "%.8f", (VALUE))) {       \
-      GHMM_LOG_PRINTF(LERROR, LOC, "failed to write attribute %s (%.8f)", \
+    if (0 > writeDoubleAttribute(XMLW, (NAME), (VALUE))) {              \
+      GHMM_LOG_PRINTF(LERROR, LOC, "failed to write attribute %s (%.17g)", \
                       (NAME), (VALUE));                                 \
       goto STOP;} else
 
 
+/* ========================================================================= */
+/* Shortest round trip formatting of doubles (Grisu2, Florian Loitsch,
+   "Printing Floating-Point Numbers Quickly and Accurately with Integers",
+   PLDI 2010). The digits always read back to the same double and are the
+   shortest such digits for all but a tiny fraction of the inputs. */
+
+typedef struct {
+  uint64_t f;
+  int e;
+} diyFp;
+
+/* normalized 10^k for k = -348, -340, ..., 340 */
+static const uint64_t cachedPowersF[] = {
+  UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76),
+  UINT64_C(0xcf42894a5dce35ea), UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+  UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f), UINT64_C(0xbe5691ef416bd60c),
+  UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+  UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57),
+  UINT64_C(0xc21094364dfb5637), UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+  UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5), UINT64_C(0xb23867fb2a35b28e),
+  UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+  UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126),
+  UINT64_C(0xb5b5ada8aaff80b8), UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+  UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd), UINT64_C(0xa6dfbd9fb8e5b88f),
+  UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+  UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06),
+  UINT64_C(0xaa242499697392d3), UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+  UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c), UINT64_C(0x9c40000000000000),
+  UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+  UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068),
+  UINT64_C(0x9f4f2726179a2245), UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+  UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a), UINT64_C(0x924d692ca61be758),
+  UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+  UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d),
+  UINT64_C(0x952ab45cfa97a0b3), UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+  UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece), UINT64_C(0x88fcf317f22241e2),
+  UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+  UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410),
+  UINT64_C(0x8bab8eefb6409c1a), UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+  UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429), UINT64_C(0x80444b5e7aa7cf85),
+  UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+  UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b)
+};
+
+static const int16_t cachedPowersE[] = {
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+  -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+  -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+  -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+  -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+  109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+  641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+  907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint32_t pow10U32[] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+#define DP_SIGNIFICAND_MASK UINT64_C(0x000FFFFFFFFFFFFF)
+#define DP_HIDDEN_BIT       UINT64_C(0x0010000000000000)
+
+/* ========================================================================= */
+static diyFp diyFpMultiply(diyFp x, diyFp y) {
+  const uint64_t M32 = 0xFFFFFFFFu;
+  uint64_t a = x.f >> 32, b = x.f & M32, c = y.f >> 32, d = y.f & M32;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+  diyFp r;
+
+  tmp += 1u << 31; /* round */
+  r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+/* ========================================================================= */
+static void diyFpNormalizedBoundaries(double x, diyFp *w, diyFp *minus, diyFp *plus) {
+  uint64_t bits, significand;
+  int biasedExp;
+  diyFp v;
+
+  memcpy(&bits, &x, sizeof(bits));
+  biasedExp = (int)((bits >> 52) & 0x7FF);
+  significand = bits & DP_SIGNIFICAND_MASK;
+  if (biasedExp) {
+    v.f = significand + DP_HIDDEN_BIT;
+    v.e = biasedExp - 1075;
+  } else {
+    v.f = significand;
+    v.e = -1074;
+  }
+
+  /* upper boundary m+ = (2f+1) 2^(e-1), normalized */
+  plus->f = (v.f << 1) + 1;
+  plus->e = v.e - 1;
+  while (!(plus->f & (DP_HIDDEN_BIT << 1))) {
+    plus->f <<= 1;
+    plus->e--;
+  }
+  plus->f <<= 10;
+  plus->e -= 10;
+
+  /* lower boundary is closer if f is a power of two */
+  if (v.f == DP_HIDDEN_BIT) {
+    minus->f = (v.f << 2) - 1;
+    minus->e = v.e - 2;
+  } else {
+    minus->f = (v.f << 1) - 1;
+    minus->e = v.e - 1;
+  }
+  minus->f <<= minus->e - plus->e;
+  minus->e = plus->e;
+
+  /* normalized value */
+  while (!(v.f & DP_HIDDEN_BIT)) {
+    v.f <<= 1;
+    v.e--;
+  }
+  w->f = v.f << 11;
+  w->e = v.e - 11;
+}
+
+/* ========================================================================= */
+static void grisuRound(char *buffer, int len, uint64_t delta, uint64_t rest,
+                       uint64_t tenKappa, uint64_t wpw) {
+  while (rest < wpw && delta - rest >= tenKappa
+         && (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw)) {
+    buffer[len - 1]--;
+    rest += tenKappa;
+  }
+}
+
+/* ========================================================================= */
+static int grisu2(double x, char *buffer, int *K) {
+  diyFp w, wm, wp, cmk, one, W, Wm, Wp;
+  uint64_t delta, wpw, p2, tmp;
+  uint32_t p1, d;
+  double dk;
+  int k, idx, kappa, len = 0;
+
+  diyFpNormalizedBoundaries(x, &w, &wm, &wp);
+
+  /* pick a cached power of ten that brings wp into [2^-60, 2^-32) */
+  dk = (-61 - wp.e) * 0.30102999566398114 + 347;
+  k = (int)dk;
+  if (dk - k > 0.0)
+    k++;
+  idx = (k >> 3) + 1;
+  *K = -(-348 + (idx << 3));
+  cmk.f = cachedPowersF[idx];
+  cmk.e = cachedPowersE[idx];
+
+  W  = diyFpMultiply(w, cmk);
+  Wp = diyFpMultiply(wp, cmk);
+  Wm = diyFpMultiply(wm, cmk);
+  Wm.f++;
+  Wp.f--;
+  delta = Wp.f - Wm.f;
+
+  one.f = UINT64_C(1) << -Wp.e;
+  one.e = Wp.e;
+  wpw = Wp.f - W.f;
+  p1 = (uint32_t)(Wp.f >> -one.e);
+  p2 = Wp.f & (one.f - 1);
+
+  for (kappa = 1; kappa < 10 && p1 >= pow10U32[kappa]; kappa++)
+    ;
+
+  /* integral part */
+  while (kappa > 0) {
+    d = p1 / pow10U32[kappa - 1];
+    p1 %= pow10U32[kappa - 1];
+    if (d || len)
+      buffer[len++] = (char)('0' + d);
+    kappa--;
+    tmp = ((uint64_t)p1 << -one.e) + p2;
+    if (tmp <= delta) {
+      *K += kappa;
+      grisuRound(buffer, len, delta, tmp, (uint64_t)pow10U32[kappa] << -one.e, wpw);
+      return len;
+    }
+  }
+
+  /* fractional part */
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    d = (uint32_t)(p2 >> -one.e);
+    if (d || len)
+      buffer[len++] = (char)('0' + d);
+    p2 &= one.f - 1;
+    kappa--;
+    if (p2 < delta) {
+      *K += kappa;
+      grisuRound(buffer, len, delta, p2, one.f,
+                 -kappa < 10 ? wpw * pow10U32[-kappa] : 0);
+      return len;
+    }
+  }
+}
+
+/* ========================================================================= */
+/* Writes x into buf (at least DOUBLE_STRLEN bytes) with the shortest digits
+   that read back to x. Returns the number of characters written. */
+static int formatDouble(double x, char *buf) {
+  char digits[DOUBLE_STRLEN];
+  char *p = buf;
+  int len, K, kk, i;
+
+  if (isnan(x) || isinf(x))
+    return sprintf(buf, "%g", x);
+
+  if (signbit(x)) {
+    *p++ = '-';
+    x = -x;
+  }
+  if (x == 0.0) {
+    *p++ = '0';
+    *p = '\0';
+    return p - buf;
+  }
+
+  len = grisu2(x, digits, &K);
+  /* decimal exponent of the first digit, value = 0.digits * 10^kk */
+  kk = len + K;
+
+  if (len <= kk && kk <= 21) {
+    /* 1234e7 -> 12340000000 */
+    memcpy(p, digits, len);
+    for (i = len; i < kk; i++)
+      p[i] = '0';
+    p += kk;
+  } else if (0 < kk && kk <= 21) {
+    /* 1234e-2 -> 12.34 */
+    memcpy(p, digits, kk);
+    p[kk] = '.';
+    memcpy(p + kk + 1, digits + kk, len - kk);
+    p += len + 1;
+  } else if (-6 < kk && kk <= 0) {
+    /* 1234e-6 -> 0.001234 */
+    *p++ = '0';
+    *p++ = '.';
+    for (i = kk; i < 0; i++)
+      *p++ = '0';
+    memcpy(p, digits, len);
+    p += len;
+  } else {
+    /* 1234e30 -> 1.234e33 */
+    *p++ = digits[0];
+    if (len > 1) {
+      *p++ = '.';
+      memcpy(p, digits + 1, len - 1);
+      p += len - 1;
+    }
+    p += sprintf(p, "e%d", kk - 1);
+  }
+  *p = '\0';
+  return p - buf;
+}
+
+/* ========================================================================= */
+static int writeDoubleAttribute(xmlTextWriterPtr writer, const char *name, double value) {
+  char buf[DOUBLE_STRLEN];
+
+  formatDouble(value, buf);
+  return xmlTextWriterWriteAttribute(writer, BAD_CAST name, BAD_CAST buf);
+}
+
+
 /* ========================================================================= */
 static char *replaceXMLEntity(char *str) {
 #define CUR_PROC "replaceXMLEntity"
@@ -150,25 +428,19 @@ static char * doubleArrayToCSV(double * array, int size) {
 
   int i, pos=0;
   char *csv=NULL;
-  int singlelength = (2 + /* comma and space */
-                      8 + /* 8 signifcant digits */
-                      1 + /* sign */
-                      5 + /* 'E' and signed mantissa */
-                      3);   /* safety */
+  int singlelength = (2 +              /* comma and space */
+                      DOUBLE_STRLEN);  /* shortest round trip digits */
   int maxlength = size * singlelength;
 
   ARRAY_MALLOC(csv, maxlength);
 
-  for (i=0; i < size-1 && pos + singlelength < maxlength; i++) {
-    pos += sprintf(csv+pos, "%.8g, ", array[i]);
-  }
-  if (i < size-1 || pos + singlelength > maxlength) {
-    GHMM_LOG(LERROR, "writing CSV failed");
-    goto STOP;
-  } else {
-    pos += sprintf(csv+pos, "%.8g", array[i]);
+  for (i=0; i < size-1; i++) {
+    pos += formatDouble(array[i], csv+pos);
+    csv[pos++] = ',';
+    csv[pos++] = ' ';
   }
-  /*printf("%d bytes of %d written\n", pos, maxlength);*/
+  formatDouble(array[i], csv+pos);
+
   return csv;
 STOP:
   free(csv);
@@ -176,6 +448,89 @@ STOP:
 #undef  CUR_PROC
 }
 
+/* ========================================================================= */
+/* Encodes size doubles as little endian IEEE 754 in base64 (RFC 4648). */
+static char * doubleArrayToBase64(double * array, int size) {
+#define CUR_PROC "doubleArrayToBase64"
+
+  static const char alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  unsigned char *bytes=NULL;
+  char *b64=NULL, *p;
+  int i, j, n = size * 8;
+  uint64_t bits;
+  uint32_t triple;
+
+  ARRAY_MALLOC(bytes, n);
+  ARRAY_MALLOC(b64, 4 * ((n + 2) / 3) + 1);
+
+  for (i=0; i < size; i++) {
+    memcpy(&bits, array+i, 8);
+    for (j=0; j < 8; j++)
+      bytes[8*i + j] = (unsigned char)(bits >> (8*j));
+  }
+
+  p = b64;
+  for (i=0; i+2 < n; i+=3) {
+    triple = (bytes[i] << 16) | (bytes[i+1] << 8) | bytes[i+2];
+    *p++ = alphabet[(triple >> 18) & 0x3F];
+    *p++ = alphabet[(triple >> 12) & 0x3F];
+    *p++ = alphabet[(triple >> 6) & 0x3F];
+    *p++ = alphabet[triple & 0x3F];
+  }
+  if (i < n) {
+    triple = bytes[i] << 16;
+    if (i+1 < n)
+      triple |= bytes[i+1] << 8;
+    *p++ = alphabet[(triple >> 18) & 0x3F];
+    *p++ = alphabet[(triple >> 12) & 0x3F];
+    *p++ = (i+1 < n) ? alphabet[(triple >> 6) & 0x3F] : '=';
+    *p++ = '=';
+  }
+  *p = '\0';
+
+  free(bytes);
+  return b64;
+STOP:
+  free(bytes);
+  free(b64);
+  return NULL;
+#undef CUR_PROC
+}
+
+/* ========================================================================= */
+/* Writes an emission array either as CSV or, with GHMM_kXMLBase64Emissions,
+   as a base64 block preceded by the encoding attribute. */
+static int writeEmissionArray(xmlTextWriterPtr writer, double * array, int size,
+                              int options) {
+#define CUR_PROC "writeEmissionArray"
+
+  char * tmp;
+
+  if (options & GHMM_kXMLBase64Emissions) {
+    if (0 > xmlTextWriterWriteAttribute(writer, BAD_CAST "encoding", BAD_CAST "base64")) {
+      GHMM_LOG(LERROR, "failed to write encoding attribute");
+      return -1;
+    }
+    tmp = doubleArrayToBase64(array, size);
+  }
+  else
+    tmp = doubleArrayToCSV(array, size);
+
+  if (!tmp) {
+    GHMM_LOG(LERROR, "converting emission array failed");
+    return -1;
+  }
+  if (0 > xmlTextWriterWriteRaw(writer, BAD_CAST tmp)) {
+    GHMM_LOG(LERROR, "Error at xmlTextWriterWriteRaw while writing emissions");
+    m_free(tmp);
+    return -1;
+  }
+  m_free(tmp);
+  return 0;
+#undef CUR_PROC
+}
+
 
 /* ========================================================================= */
 static int writeAlphabet(xmlTextWriterPtr writer, ghmm_alphabet * alfa, int type) {
@@ -228,11 +583,11 @@ static int writeAlphabet(xmlTextWriterPtr writer, ghmm_alphabet * alfa, int type
 }
 
 /* ========================================================================= */
-static int writeBackground(xmlTextWriterPtr writer, ghmm_dbackground* bg) {
+static int writeBackground(xmlTextWriterPtr writer, ghmm_dbackground* bg,
+                           int options) {
 #define CUR_PROC "writeBackground"
 
   int i;
-  char * tmp=NULL;
 
   for (i=0; i<bg->n; i++) {
 
@@ -254,17 +609,8 @@ static int writeBackground(xmlTextWriterPtr writer, ghmm_dbackground* bg) {
       if (0 > xmlTextWriterWriteFormatAttribute(writer, BAD_CAST "order", "%d", bg->order[i]))
         GHMM_LOG(LERROR, "can't write background order attribute");
 
-    tmp = doubleArrayToCSV(bg->b[i], pow(bg->m, bg->order[i]+1));
-    if (tmp) {
-      if (0 > xmlTextWriterWriteRaw(writer, BAD_CAST tmp)) {
-        GHMM_LOG(LERROR, "Error at xmlTextWriterWriteRaw while writing"
-                 "background distribution CSV");
-        m_free(tmp);
-        return -1;
-      }
-      m_free(tmp);
-    } else {
-      GHMM_LOG(LERROR, "converting array to CSV failed for background distribution");
+    if (writeEmissionArray(writer, bg->b[i], pow(bg->m, bg->order[i]+1), options)) {
+      GHMM_LOG(LERROR, "writing background distribution failed");
       return -1;
     }
 
@@ -280,11 +626,10 @@ static int writeBackground(xmlTextWriterPtr writer, ghmm_dbackground* bg) {
 
 /* ========================================================================= */
 static int writeDiscreteStateContents(xmlTextWriterPtr writer, ghmm_xmlfile* f,
-                                      int moNo, int sNo) {
+                                      int moNo, int sNo, int options) {
 #define CUR_PROC "writeDiscreteStateContents"
 
   int bgId, cLabel, rc, order, tied;
-  char * tmp=NULL;
 
   if (f->model.d[moNo]->model_type & GHMM_kSilentStates && f->model.d[moNo]->silent[sNo])
   {
@@ -327,17 +672,9 @@ static int writeDiscreteStateContents(xmlTextWriterPtr writer, ghmm_xmlfile* f,
     } else
       order = 0;
 
-    tmp = doubleArrayToCSV(f->model.d[moNo]->s[sNo].b, pow(f->model.d[moNo]->M, order+1));
-    if (tmp) {
-      if (0 > xmlTextWriterWriteRaw(writer, BAD_CAST tmp)) {
-        GHMM_LOG(LERROR, "Error at xmlTextWriterWriteRaw while writing"
-                 "discrete distribution CSV");
-        m_free(tmp);
-        goto STOP;
-      }
-      m_free(tmp);
-    } else {
-      GHMM_LOG(LERROR, "converting array to CSV failed for discrete distribution");
+    if (writeEmissionArray(writer, f->model.d[moNo]->s[sNo].b,
+                           pow(f->model.d[moNo]->M, order+1), options)) {
+      GHMM_LOG(LERROR, "writing discrete distribution failed");
       goto STOP;
     }
 
@@ -756,7 +1093,8 @@ STOP:
 
 
 /* ========================================================================= */
-static int writeState(xmlTextWriterPtr writer, ghmm_xmlfile* f, int moNo, int sNo) {
+static int writeState(xmlTextWriterPtr writer, ghmm_xmlfile* f, int moNo, int sNo,
+                      int options) {
 #define CUR_PROC "writeState"
 
   int rc;
@@ -812,7 +1150,7 @@ static int writeState(xmlTextWriterPtr writer, ghmm_xmlfile* f, int moNo, int sN
   /* write state contents for different model types */
   switch (f->modelType & PTR_TYPE_MASK) {
   case GHMM_kDiscreteHMM:
-    rc = writeDiscreteStateContents(writer, f, moNo, sNo);
+    rc = writeDiscreteStateContents(writer, f, moNo, sNo, options);
     break;
   case (GHMM_kDiscreteHMM+GHMM_kTransitionClasses):
     rc = writeDiscreteSwitchingStateContents(writer, f, moNo, sNo);
@@ -947,7 +1285,8 @@ STOP:
 
 
 /* ========================================================================= */
-static int writeHMM(xmlTextWriterPtr writer, ghmm_xmlfile* f, int number) {
+static int writeHMM(xmlTextWriterPtr writer, ghmm_xmlfile* f, int number,
+                    int options) {
 #define CUR_PROC "writeHMM"
   int rc=0, i, N;
   int w_cos;
@@ -1057,13 +1396,13 @@ static int writeHMM(xmlTextWriterPtr writer, ghmm_xmlfile* f, int number) {
   /* write background distributions if applicable */
   if ((f->modelType & PTR_TYPE_MASK) == GHMM_kDiscreteHMM
       && f->modelType & GHMM_kBackgroundDistributions) {
-    if (writeBackground(writer, f->model.d[number]->bp))
+    if (writeBackground(writer, f->model.d[number]->bp, options))
       GHMM_LOG(LERROR, "writing of background distributions failed");
   }
 
   /* write all states */
   for (i=0; i<N; i++)
-    if (writeState(writer, f, number, i)) {
+    if (writeState(writer, f, number, i, options)) {
       GHMM_LOG_PRINTF(LERROR, LOC, "writing of state %d in HMM %d failed", i, number);
       goto STOP;
     }
@@ -1089,11 +1428,13 @@ STOP:
 }
 
 /* ========================================================================= */
-void ghmm_xmlfile_write(ghmm_xmlfile* f, const char *file) {
-#define CUR_PROC "ghmm_xmlfile_write"
-  int rc, i;
-  xmlTextWriterPtr writer;
-  xmlDocPtr doc;
+int ghmm_xmlfile_write_options(ghmm_xmlfile* f, const char *file, int options) {
+#define CUR_PROC "ghmm_xmlfile_write_options"
+  int rc, i, res=-1;
+  FILE *fp=NULL;
+  char *iobuf=NULL;
+  xmlOutputBufferPtr out;
+  xmlTextWriterPtr writer=NULL;
 
   /*
    * this initialize the library and check potential ABI mismatches
@@ -1104,10 +1445,28 @@ void ghmm_xmlfile_write(ghmm_xmlfile* f, const char *file) {
 
     xmlSubstituteEntitiesDefault(1);
 
-  /* Create a new XmlWriter for DOM, with no compression. */
-  writer = xmlNewTextWriterDoc(&doc, 0);
+  /* Write straight to the file through a large stdio buffer instead of
+     building the whole document tree in memory first. */
+  fp = fopen(file, "w");
+  if (!fp) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "can not open %s for writing", file);
+    goto STOP;
+  }
+  ARRAY_MALLOC(iobuf, OUTPUT_BUFFER_SIZE);
+  setvbuf(fp, iobuf, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+  /* the encoder is set by xmlTextWriterStartDocument */
+  out = xmlOutputBufferCreateFile(fp, NULL);
+  if (out == NULL) {
+    GHMM_LOG(LERROR, "can not create the xml output buffer");
+    goto STOP;
+  }
+
+  /* takes ownership of the output buffer, fp stays ours */
+  writer = xmlNewTextWriter(out);
   if (writer == NULL) {
     GHMM_LOG(LERROR, "can not create the xml writer");
+    xmlOutputBufferClose(out);
     goto STOP;
   }
 
@@ -1145,7 +1504,10 @@ void ghmm_xmlfile_write(ghmm_xmlfile* f, const char *file) {
 
   /* write all models */
   for (i=0; i<f->noModels; i++)
-    writeHMM(writer, f, i);
+    if (writeHMM(writer, f, i, options)) {
+      GHMM_LOG_PRINTF(LERROR, LOC, "writing HMM %d failed", i);
+      goto STOP;
+    }
 
   /* end mixture */
   if (0 > xmlTextWriterEndDocument(writer)) {
@@ -1153,12 +1515,16 @@ void ghmm_xmlfile_write(ghmm_xmlfile* f, const char *file) {
     goto STOP;
   }
 
-  xmlFreeTextWriter(writer);
-
-  xmlSaveFormatFileEnc(file, doc, MY_ENCODING, 1);
-
+  res = 0;
 STOP:
-  xmlFreeDoc(doc);
+  /* flushes the remaining output into fp */
+  if (writer)
+    xmlFreeTextWriter(writer);
+  if (fp && fclose(fp)) {
+    GHMM_LOG_PRINTF(LERROR, LOC, "error while writing %s", file);
+    res = -1;
+  }
+  free(iobuf);
 
   /*
    * Cleanup function for the XML library.
@@ -1168,7 +1534,13 @@ STOP:
    * this is to debug memory for regression tests
    */
   xmlMemoryDump();
+  return res;
 #undef CUR_PROC
 }
 
+/* ========================================================================= */
+void ghmm_xmlfile_write(ghmm_xmlfile* f, const char *file) {
+  ghmm_xmlfile_write_options(f, file, 0);
+}
+
 #endif
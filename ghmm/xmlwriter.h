@@ -49,8 +49,23 @@ extern "C" {
 /**@name HMM-Modell */
 /*@{ (Doc++-Group: xmlwriter) */
 
+/** Option for ghmm_xmlfile_write_options: write the emission
+    probabilities of discrete states and the background distributions as
+    base64 encoded little endian IEEE 754 doubles instead of decimal CSV. */
+#define GHMM_kXMLBase64Emissions (1 << 0)
+
 void ghmm_xmlfile_write(ghmm_xmlfile* f, const char *file);
 
+/**
+   Writes the models in f to file. All numbers are written with the
+   shortest digits that read back to the same double.
+   @return 0 on success, -1 on error
+   @param f       models to write
+   @param file    name of the output file
+   @param options bitwise or of GHMM_kXML* options, 0 for plain CSV
+ */
+int ghmm_xmlfile_write_options(ghmm_xmlfile* f, const char *file, int options);
+
 #ifdef __cplusplus
 }
 #endif
@@ -89,3 +89,17 @@ def getClass( seq, k,t):
          return 1 
 
      # or some combination thereof for any number of classes.
+
+
+def getClassSequence(seq, k):
+     """ Example of a vectorized class change function, see
+     setPythonSequenceCallback. It is called once per sequence instead of
+     once per time step.
+
+     @param seq list of observations of the whole sequence
+     @param k   sequence index of seq in the sequence collection seq came from
+     @return    list of the classes of the len(seq) - 1 transitions, the
+                t-th entry is the class of the transition from t to t+1
+     """
+     # same switch as getClass: class 1 from time step 6 on
+     return [int(t >= 6) for t in range(len(seq) - 1)]
@@ -1086,11 +1086,11 @@ class SequenceSet(object):
         """
         @returns the index-th sequence in internal representation
         """
-        seq = []
         if self.cseq.seq_number > index:
-            for j in range(self.cseq.getLength(index)):
-                seq.append(self.cseq.getSymbol(index, j))
-            return seq
+            if self.emissionDomain.CDataType == "int":
+                return ghmmwrapper.int_array2list(self.cseq.getSequence(index), self.cseq.getLength(index))
+            else:
+                return ghmmwrapper.double_array2list(self.cseq.getSequence(index), self.cseq.getLength(index))
         else:
             raise IndexError(str(index) + " is out of bounds, only " + str(self.cseq.seq_number) + "sequences")
 
@@ -1162,6 +1162,22 @@ class SequenceSet(object):
         """convenience function, returns only self"""
         return self
 
+    def asArray(self):
+        """ numpy view of all sequences in internal representation without
+        copying. The sequences have to be stored in one contiguous block,
+        e.g. read from a FastA file or created by SequenceSetFromArray.
+
+        @returns the concatenated sequences and the list of lengths
+        """
+        if ghmmhelper.numpy is None:
+            raise UnsupportedFeature("asArray requires numpy")
+        buf = self.cseq.getBlockBuffer()
+        if self.emissionDomain.CDataType == "int":
+            data = ghmmhelper.numpy.frombuffer(buf, dtype=ghmmhelper.numpy.intc)
+        else:
+            data = ghmmhelper.numpy.frombuffer(buf, dtype=ghmmhelper.numpy.float64)
+        return data, [self.cseq.getLength(i) for i in range(len(self))]
+
 class SequenceSetSubset(SequenceSet):
     """
     SequenceSetSubset contains a subset of the sequences from a SequenceSet
@@ -1223,6 +1239,31 @@ def SequenceSetOpen(emissionDomain, fileName):
     return sequenceSets
 
 
+def SequenceSetFromArray(emissionDomain, data, lengths):
+    """ Creates a SequenceSet from the concatenated sequences in @p data
+    without copying them.
+
+    @p data has to be a contiguous array in internal representation that
+    supports the buffer protocol, e.g. a numpy array of dtype intc for
+    discrete and float64 for continuous emission domains. The SequenceSet
+    keeps a reference to @p data, changes of @p data are visible in the
+    SequenceSet.
+
+    @p lengths is the list of the lengths of the sequences.
+    """
+    if emissionDomain.CDataType == "int":
+        cseq = ghmmwrapper.dseq_from_buffer(data, lengths)
+    elif emissionDomain.CDataType == "double":
+        cseq = ghmmwrapper.cseq_from_buffer(data, lengths)
+    else:
+        raise TypeError("Invalid c data type " + str(emissionDomain.CDataType))
+
+    sequenceSet = SequenceSet(emissionDomain, cseq)
+    # the C struct points into data
+    sequenceSet.arrayData = data
+    return sequenceSet
+
+
 def writeToFasta(seqSet,fn):
     """
     Writes a SequenceSet into a fasta file.
@@ -1232,11 +1273,7 @@ def writeToFasta(seqSet,fn):
     f = open(fn,'w')
 
     for i in range(len(seqSet)):
-        rseq = []
-        for j in range(seqSet.sequenceLength(i)):
-            rseq.append(str(seqSet.emissionDomain.external(
-                ghmmwrapper.int_matrix_getitem(seqSet.cseq.seq, i, j)
-                )))
+        rseq = [str(seqSet.emissionDomain.external(e)) for e in seqSet.getSequence(i)]
 
         f.write('>seq'+str(i)+'\n')
         f.write(fill(join(rseq,'') ))
@@ -2239,22 +2276,71 @@ class HMM(object):
         return post[time][state]
 
 
-    def posterior(self, sequence):
+    def posterior(self, sequence, asArray=False):
         """ Posterior distribution matrix for 'sequence'.
 
-        @todo for silent states things are more complicated -> to be done
-        """
-        # XXX TODO for silent states things are more complicated -> to be done
-        if self.hasFlags(kSilentStates):
-            raise NotImplementedError("Models with silent states not yet supported.")
+        For a silent state the entry of time t is the probability to pass
+        the state between the emissions t and t+1.
 
+        If @p asArray is set, a numpy array is returned, which is filled by
+        the C code directly.
+        """
         if not isinstance(sequence, EmissionSequence):
             raise TypeError("Input to posterior must be EmissionSequence object")
 
-        (alpha,scale)  = self.forward(sequence)
-        beta = self.backward(sequence,scale)
+        seq = sequence.cseq.getSequence(0)
+        t = len(sequence)
+        rows = t / self._sequenceDimension(sequence)
 
-        return map(lambda v,w : map(lambda x,y : x*y, v, w), alpha, beta)
+        if asArray:
+            post = ghmmhelper.numpy.empty((rows, self.N))
+            cpost = ghmmwrapper.buffer2double_matrix(post, rows)
+            try:
+                error, unused = self.cmodel.posterior(seq, t, cpost)
+            finally:
+                ghmmwrapper.free(cpost)
+            if error == -1:
+                log.error("posterior finished with -1: EmissionSequence cannot be build.")
+            return post
+
+        cpost = ghmmwrapper.double_matrix_alloc_block(rows, self.N)
+        try:
+            error, unused = self.cmodel.posterior(seq, t, cpost)
+            if error == -1:
+                log.error("posterior finished with -1: EmissionSequence cannot be build.")
+            return ghmmhelper.double_block2list(cpost, rows, self.N)
+        finally:
+            ghmmwrapper.double_matrix_free_block(cpost)
+
+
+    def posteriorDecoding(self, sequence):
+        """ State with the largest posterior probability for every emission
+        of 'sequence' (maximum posterior marginals).
+
+        @returns the path and log P[sequence| m]
+        """
+        if not isinstance(sequence, EmissionSequence):
+            raise TypeError("Input to posteriorDecoding must be EmissionSequence object")
+
+        seq = sequence.cseq.getSequence(0)
+        t = len(sequence)
+        rows = t / self._sequenceDimension(sequence)
+
+        cpath = ghmmwrapper.int_array_alloc(rows)
+        try:
+            error, logp = self.cmodel.posterior_decoding(seq, t, cpath)
+            if error == -1:
+                log.error("posteriorDecoding finished with -1: EmissionSequence cannot be build.")
+            return ghmmwrapper.int_array2list(cpath, rows), logp
+        finally:
+            ghmmwrapper.free(cpath)
+
+
+    def _sequenceDimension(self, sequence):
+        """ number of values per emission of 'sequence' """
+        if sequence.emissionDomain == Float() and sequence.cseq.dim > 1:
+            return sequence.cseq.dim
+        return 1
 
 
     def joined(self, emissionSequence, stateSequence):
@@ -2310,69 +2396,99 @@ class HMM(object):
         return self.cmodel.prob_distance(model.cmodel, seqLength, 0, 0)
 
 
-    def forward(self, emissionSequence):
+    def forward(self, emissionSequence, asArray=False):
         """
         @returns the (N x T)-matrix containing the forward-variables
         and the scaling vector
+
+        If @p asArray is set, numpy arrays are returned, which are filled by
+        the C code directly.
         """
         log.debug("HMM.forward -- begin")
-        # XXX Allocations should be in try, except, finally blocks
-        # to assure deallocation even in the case of errrors.
-        # This will leak otherwise.
         seq = emissionSequence.cseq.getSequence(0)
-
         t = len(emissionSequence)
-        calpha = ghmmwrapper.double_matrix_alloc(t, self.N)
-        cscale = ghmmwrapper.double_array_alloc(t)
 
-        error, unused = self.cmodel.forward(seq, t, calpha, cscale)
-        if error == -1:
-            log.error( "forward finished with -1: EmissionSequence cannot be build.")
-
-        # translate alpha / scale to python lists
-        pyscale = ghmmwrapper.double_array2list(cscale, t)
-        pyalpha = ghmmhelper.double_matrix2list(calpha, t, self.N)
+        if asArray:
+            alpha = ghmmhelper.numpy.empty((t, self.N))
+            scale = ghmmhelper.numpy.empty(t)
+            calpha = ghmmwrapper.buffer2double_matrix(alpha, t)
+            try:
+                error, unused = self.cmodel.forward(seq, t, calpha, ghmmwrapper.buffer2double_array(scale))
+            finally:
+                ghmmwrapper.free(calpha)
+            if error == -1:
+                log.error( "forward finished with -1: EmissionSequence cannot be build.")
+            log.debug("HMM.forward -- end")
+            return alpha, scale
+
+        calpha = ghmmwrapper.double_matrix_alloc_block(t, self.N)
+        cscale = ghmmwrapper.double_array_alloc(t)
+        try:
+            error, unused = self.cmodel.forward(seq, t, calpha, cscale)
+            if error == -1:
+                log.error( "forward finished with -1: EmissionSequence cannot be build.")
 
-        # deallocation
-        ghmmwrapper.free(cscale)
-        ghmmwrapper.double_matrix_free(calpha, t)
+            # translate alpha / scale to python lists
+            pyscale = ghmmwrapper.double_array2list(cscale, t)
+            pyalpha = ghmmhelper.double_block2list(calpha, t, self.N)
+        finally:
+            ghmmwrapper.free(cscale)
+            ghmmwrapper.double_matrix_free_block(calpha)
 
         log.debug("HMM.forward -- end")
         return pyalpha, pyscale
 
 
-    def backward(self, emissionSequence, scalingVector):
+    def backward(self, emissionSequence, scalingVector, asArray=False):
         """
         @returns the (N x T)-matrix containing the backward-variables
+
+        If @p asArray is set, a numpy array is returned, which is filled by
+        the C code directly.
         """
         log.debug("HMM.backward -- begin")
         seq = emissionSequence.cseq.getSequence(0)
+        t = len(emissionSequence)
+
+        if asArray:
+            beta = ghmmhelper.numpy.empty((t, self.N))
+            scale = ghmmhelper.numpy.ascontiguousarray(scalingVector, dtype=ghmmhelper.numpy.float64)
+            cbeta = ghmmwrapper.buffer2double_matrix(beta, t)
+            try:
+                error = self.cmodel.backward(seq, t, cbeta, ghmmwrapper.buffer2double_array(scale))
+            finally:
+                ghmmwrapper.free(cbeta)
+            if error == -1:
+                log.error( "backward finished with -1: EmissionSequence cannot be build.")
+            log.debug("HMM.backward -- end")
+            return beta
 
         # parsing 'scalingVector' to C double array.
         cscale = ghmmwrapper.list2double_array(scalingVector)
 
         # alllocating beta matrix
-        t = len(emissionSequence)
-        cbeta = ghmmwrapper.double_matrix_alloc(t, self.N)
-
-        error = self.cmodel.backward(seq,t,cbeta,cscale)
-        if error == -1:
-            log.error( "backward finished with -1: EmissionSequence cannot be build.")
-
-        pybeta = ghmmhelper.double_matrix2list(cbeta,t,self.N)
+        cbeta = ghmmwrapper.double_matrix_alloc_block(t, self.N)
+        try:
+            error = self.cmodel.backward(seq,t,cbeta,cscale)
+            if error == -1:
+                log.error( "backward finished with -1: EmissionSequence cannot be build.")
 
-        # deallocation
-        ghmmwrapper.free(cscale)
-        ghmmwrapper.double_matrix_free(cbeta,t)
+            pybeta = ghmmhelper.double_block2list(cbeta,t,self.N)
+        finally:
+            ghmmwrapper.free(cscale)
+            ghmmwrapper.double_matrix_free_block(cbeta)
 
         log.debug("HMM.backward -- end")
         return pybeta
 
 
-    def viterbi(self, eseqs):
+    def viterbi(self, eseqs, sparse=False):
         """ Compute the Viterbi-path for each sequence in emissionSequences
 
         @param eseqs can either be a SequenceSet or an EmissionSequence
+        @param sparse if True, the emissions are converted to a sparse table
+        once and only the states emitting the observed symbol are considered
+        in each time step (for large alphabets with mostly zero emissions)
 
         @returns [q_0, ..., q_T] the viterbi-path of \p eseqs is an
         EmmissionSequence object,
@@ -2383,6 +2499,8 @@ class HMM(object):
         emissionSequences = eseqs.asSequenceSet()
 
         seqNumber = len(emissionSequences)
+        if sparse:
+            sparseEmissions = ghmmwrapper.ghmm_dsparse_emission(self.cmodel)
 
         allLogs = []
         allPaths = []
@@ -2390,7 +2508,9 @@ class HMM(object):
             seq = emissionSequences.cseq.getSequence(i)
             seq_len = emissionSequences.cseq.getLength(i)
 
-            if seq_len > 0:
+            if seq_len > 0 and sparse:
+                viterbiPath, pathlen, log_p = self.cmodel.viterbi_sparse(sparseEmissions, seq, seq_len)
+            elif seq_len > 0:
                 viterbiPath, pathlen, log_p = self.cmodel.viterbi(seq, seq_len)
             else:
                 viterbiPath = None
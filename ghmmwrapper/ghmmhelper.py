@@ -34,11 +34,17 @@
 #*
 #*******************************************************************************/
 import ghmmwrapper
+import array
 import math
 import os.path
 from modhmmer import *
 from random import *
 
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
 
 def double_matrix2list(cmatrix, row, col):
     llist = []
@@ -47,6 +53,39 @@ def double_matrix2list(cmatrix, row, col):
     return llist
 
 
+def double_block2list(cmatrix, row, col):
+    """ Converts a matrix allocated with double_matrix_alloc_block with a
+    single copy instead of one call per entry.
+    """
+    values = array.array('d')
+    values.fromstring(str(ghmmwrapper.double_matrix2buffer(cmatrix, row, col)))
+    return [values[i*col:(i+1)*col].tolist() for i in range(row)]
+
+
+def int_array2numpy(carray, length):
+    """ numpy view of a C int array without copying.
+
+    The view is only valid as long as the C array is not freed.
+    """
+    return numpy.frombuffer(ghmmwrapper.int_array2buffer(carray, length), dtype=numpy.intc)
+
+
+def double_array2numpy(carray, length):
+    """ numpy view of a C double array without copying.
+
+    The view is only valid as long as the C array is not freed.
+    """
+    return numpy.frombuffer(ghmmwrapper.double_array2buffer(carray, length), dtype=numpy.float64)
+
+
+def double_matrix2numpy(cmatrix, row, col):
+    """ numpy view of a matrix allocated with double_matrix_alloc_block
+    (or any matrix with contiguous rows) without copying.
+    """
+    buf = ghmmwrapper.double_matrix2buffer(cmatrix, row, col)
+    return numpy.frombuffer(buf, dtype=numpy.float64).reshape(row, col)
+
+
 def list2double_matrix(matrix):
     """ Allocation and initialization of a double** based on a
     two dimensional Python list (list of lists).
@@ -129,6 +129,8 @@
 
 #define kMultivariate (1 << 11)
 
+#define kTransitionIndex (1 << 12)
+
 
 /* ============== constants ================================================= */
 /**
@@ -162,16 +164,21 @@
 
     static void PythonCallBack(int level, const char *message, void *clientdata)
     {
-        PyObject *func, *arglist;
+        PyObject *func, *arglist, *result;
+        // the library may log from calls that released the GIL
+        PyGILState_STATE gstate = PyGILState_Ensure();
 
         // Get Python function
         func = (PyObject *) clientdata;
         // Build Python arguments
         arglist = Py_BuildValue("(is)", level, message);
         // Call Python
-        PyEval_CallObject(func, arglist);
+        result = PyEval_CallObject(func, arglist);
+        Py_XDECREF(result);
         // Trash arguments
         Py_DECREF(arglist);
+
+        PyGILState_Release(gstate);
     }
 %}
 
@@ -222,10 +229,85 @@ extern double ighmm_rand_normal_density_trunc(double x, double mean, double u, d
 %}
 %enddef
 
+/*==========================================================================
+  ===== release the GIL for compute bound calls ============================ */
+/* Calls on distinct models run concurrently. All functions drawing random
+   numbers share the global RNG and are serialised with ghmm_rng_lock. The
+   arguments must not be used by other threads during a call. */
+%{
+#include <pythread.h>
+static PyThread_type_lock ghmm_rng_lock = NULL;
+%}
+
+%init %{
+#if PY_VERSION_HEX < 0x03070000
+  PyEval_InitThreads();
+#endif
+  ghmm_rng_lock = PyThread_allocate_lock();
+%}
+
+%define RELEASE_GIL(function)
+%exception function {
+  Py_BEGIN_ALLOW_THREADS
+  $action
+  Py_END_ALLOW_THREADS
+}
+%enddef
+
+%define RELEASE_GIL_RNG(function)
+%exception function {
+  Py_BEGIN_ALLOW_THREADS
+  PyThread_acquire_lock(ghmm_rng_lock, WAIT_LOCK);
+  $action
+  PyThread_release_lock(ghmm_rng_lock);
+  Py_END_ALLOW_THREADS
+}
+%enddef
+
+RELEASE_GIL(ghmm_dmodel::forward)
+RELEASE_GIL(ghmm_dmodel::backward)
+RELEASE_GIL(ghmm_dmodel::logp)
+RELEASE_GIL(ghmm_dmodel::forward_lean)
+RELEASE_GIL(ghmm_dmodel::posterior)
+RELEASE_GIL(ghmm_dmodel::posterior_decoding)
+RELEASE_GIL(ghmm_dmodel::likelihood)
+RELEASE_GIL(ghmm_dmodel::baum_welch)
+RELEASE_GIL(ghmm_dmodel::baum_welch_nstep)
+RELEASE_GIL(ghmm_dmodel::viterbi)
+RELEASE_GIL(ghmm_dmodel::label_forward)
+RELEASE_GIL(ghmm_dmodel::label_logp)
+RELEASE_GIL(ghmm_dmodel::label_backward)
+RELEASE_GIL(ghmm_dmodel::label_kbest)
+RELEASE_GIL(ghmm_dmodel::label_baum_welch)
+RELEASE_GIL(ghmm_dmodel::label_baum_welch_nstep)
+RELEASE_GIL(ghmm_dmodel::label_gradient_descent)
+RELEASE_GIL_RNG(ghmm_dmodel::generate_sequences)
+RELEASE_GIL_RNG(ghmm_dmodel::label_generate_sequences)
+RELEASE_GIL_RNG(ghmm_dmodel::prob_distance)
+RELEASE_GIL_RNG(ghmm_dmodel::fbgibbs)
+RELEASE_GIL_RNG(ghmm_dmodel::cfbgibbs)
+
+RELEASE_GIL(ghmm_cmodel::forward)
+RELEASE_GIL(ghmm_cmodel::backward)
+RELEASE_GIL(ghmm_cmodel::logp)
+RELEASE_GIL(ghmm_cmodel::posterior)
+RELEASE_GIL(ghmm_cmodel::posterior_decoding)
+RELEASE_GIL(ghmm_cmodel::likelihood)
+RELEASE_GIL(ghmm_cmodel::individual_likelihoods)
+RELEASE_GIL(ghmm_cmodel::viterbi)
+RELEASE_GIL(ghmm_cmodel_baum_welch)
+RELEASE_GIL_RNG(ghmm_cmodel::generate_sequences)
+RELEASE_GIL_RNG(ghmm_cmodel::prob_distance)
+
+RELEASE_GIL(ghmm_dpmodel::viterbi_logp)
+RELEASE_GIL(ghmm_dpmodel::viterbi_propagate)
+RELEASE_GIL(ghmm_dpmodel::viterbi_propagate_segment)
+
 // double *log_p is used as additional return value
 %apply double* OUTPUT {double *log_p};
 %apply int*    OUTPUT {int *pathlen};
 
+%include wrapper_buffer.i
 %include wrapper_alphabet.i
 
 %include wrapper_cseq.i
@@ -79,7 +79,7 @@ void setSwitchingFunction(ghmm_cmodel *smd) {
    Arguments ( which are analogue to cp_class_change (s.a.)) are parsed into Python data structures
    before the call-back.
 */
-int python_class_change( ghmm_cmodel* smo, const double *seq, int k, int t ){
+static int python_class_change_call( ghmm_cmodel* smo, const double *seq, int k, int t ){
    char* ModuleName = smo->class_change->python_module;
    char* FunctionName = smo->class_change->python_function;
    int class,i;
@@ -151,6 +151,15 @@ int python_class_change( ghmm_cmodel* smo, const double *seq, int k, int t ){
  
 }
 
+int python_class_change( ghmm_cmodel* smo, const double *seq, int k, int t ){
+   int class;
+   /* the calling C function may run without the GIL */
+   PyGILState_STATE gstate = PyGILState_Ensure();
+   class = python_class_change_call(smo, seq, k, t);
+   PyGILState_Release(gstate);
+   return class;
+}
+
 /* Assignment of Python module and function for class change. The values are stored in smo->class_change.
    
    smo: ghmm_cmodel struct with multiple transition classes
@@ -195,7 +204,7 @@ static PyObject *pyCallback = NULL;
      t:   current time step (e.q seq[t] is the current observation)
    
 */
-int executePythonCallback(ghmm_cmodel* smo, const double *seq, int k, int t){
+static int executePythonCallback_call(ghmm_cmodel* smo, const double *seq, int k, int t){
    int class,i;
 
    /*printf("k=%d, t=%d\n",k,t); */
@@ -237,6 +246,15 @@ int executePythonCallback(ghmm_cmodel* smo, const double *seq, int k, int t){
  
 }
 
+int executePythonCallback(ghmm_cmodel* smo, const double *seq, int k, int t){
+   int class;
+   /* the calling C function may run without the GIL */
+   PyGILState_STATE gstate = PyGILState_Ensure();
+   class = executePythonCallback_call(smo, seq, k, t);
+   PyGILState_Release(gstate);
+   return class;
+}
+
 /* setPythonCallback assigns the arguement py_cb to the global
    callback variable and sets the corresponding switching function executePythonCallback 
    in the smodel-class_change context.
@@ -248,3 +266,82 @@ void setPythonCallback(ghmm_cmodel *smo, PyObject *py_cb){
 }
 
 
+
+/* --------------------------------------------------------------------------------------- */
+/* Vectorized class switch: the Python object is called once per sequence as
+        def switchFun(seq,k)
+   with the whole sequence and has to return a sequence of the classes of
+   all len(seq)/dim - 1 transitions (classes[t] is the class of the
+   transition from t to t+1). This avoids one interpreter call and one list
+   copy per time step.
+*/
+
+/* pySequenceCallback holds the global vectorized Python callback */
+static PyObject *pySequenceCallback = NULL;
+
+static int executePythonSequenceCallback_call(ghmm_cmodel* smo, const double *seq,
+                                              int k, int T, int *classes){
+   int i, n = T * smo->dim;
+   long class;
+   PyObject *pArgs, *pValue, *pList, *pItem;
+
+   pList = PyList_New(n);
+   if (!pList)
+     return -1;
+   for(i=0;i<n;i++)
+     PyList_SET_ITEM(pList, i, PyFloat_FromDouble(seq[i]));
+
+   pArgs = Py_BuildValue("(Ni)", pList, k);
+   if (!pArgs)
+     return -1;
+   pValue = PyObject_CallObject(pySequenceCallback, pArgs); // Calling Python
+   Py_DECREF(pArgs);
+   if (!pValue) {
+     PyErr_Print();
+     return -1;
+   }
+
+   /* parsing the result from Python to C data type */
+   if (!PySequence_Check(pValue) || PySequence_Size(pValue) < T - 1) {
+     printf("ERROR: class sequence call-back has to return %d classes\n", T - 1);
+     Py_DECREF(pValue);
+     return -1;
+   }
+   for(i=0;i<T-1;i++) {
+     pItem = PySequence_GetItem(pValue, i);
+     class = pItem ? PyInt_AsLong(pItem) : -1;
+     Py_XDECREF(pItem);
+     if (class == -1 && PyErr_Occurred()) {
+       PyErr_Print();
+       Py_DECREF(pValue);
+       return -1;
+     }
+     classes[i] = (int)class;
+   }
+   Py_DECREF(pValue);
+   return 0;
+}
+
+int executePythonSequenceCallback(ghmm_cmodel* smo, const double *seq, int k,
+                                  int T, int *classes){
+   int res;
+   /* the calling C function may run without the GIL */
+   PyGILState_STATE gstate = PyGILState_Ensure();
+   res = executePythonSequenceCallback_call(smo, seq, k, T, classes);
+   PyGILState_Release(gstate);
+   return res;
+}
+
+/* setPythonSequenceCallback assigns py_cb as vectorized class switch
+   function; it takes precedence over get_class.
+*/
+void setPythonSequenceCallback(ghmm_cmodel *smo, PyObject *py_cb){
+  if(!smo->class_change) {
+    printf("setPythonSequenceCallback ERROR: class_change struct not initialized.\n");
+    return;
+  }
+  Py_XINCREF(py_cb);
+  Py_XDECREF(pySequenceCallback);
+  pySequenceCallback = py_cb;
+  smo->class_change->get_class_sequence = executePythonSequenceCallback;
+}
@@ -79,4 +79,12 @@ int python_class_change( ghmm_cmodel* smo, int* seq, int k, int t );
 */
 void setPythonSwitching( ghmm_cmodel *smd, char* python_module, char* python_function);
 
+
+/* Assignment of a vectorized Python class switch function, which is called
+   once per sequence as py_cb(seq, k) and returns the classes of all
+   transitions of the sequence (classes[t] for the transition from t to t+1).
+   It is used instead of the per time step function.
+*/
+void setPythonSequenceCallback( ghmm_cmodel *smo, PyObject *py_cb );
+
 #endif
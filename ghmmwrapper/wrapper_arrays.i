@@ -154,6 +154,24 @@ ARRAY(double)
                 for (i=0; i<rows; ++i) free(mat[i]);
                 free(mat);
             }
+        /* rows stored in one block, see double_matrix2buffer */
+        type** type ## _matrix_alloc_block(size_t rows, size_t cols)
+            {
+                int i;
+                type** mat = malloc((rows ? rows : 1) * sizeof(type*));
+                if (!mat) return NULL;
+                if (!(mat[0] = malloc(rows * cols * sizeof(type)))) {
+                    free(mat);
+                    return NULL;
+                }
+                for (i=1; i<rows; ++i) mat[i] = mat[0] + i*cols;
+                return mat;
+            }
+        void   type ## _matrix_free_block(type** mat)
+            {
+                if (mat) free(mat[0]);
+                free(mat);
+            }
         type*  type ## _matrix_get_col(type** self, size_t index) { return self[index]; }
         void   type ## _matrix_set_col(type** self, size_t index, type* col) { self[index] = col; }
         type   type ## _matrix_getitem(type** self, size_t row, size_t col) { return self[row][col]; }
@@ -0,0 +1,153 @@
+/*==========================================================================
+  ===== buffer protocol: zero-copy access to contiguous arrays ============= */
+
+/* Arrays exported by numpy, array.array and other objects implementing the
+   buffer protocol are passed to C without copying. The C side only keeps a
+   pointer, the caller has to keep the Python object alive. */
+%{
+  static int ghmm_get_buffer(PyObject *obj, Py_buffer *view,
+                             Py_ssize_t itemsize, const char *kinds)
+  {
+    const char *fmt;
+    unsigned int one = 1;
+    int little = *(unsigned char *) &one;
+
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT
+                                      | PyBUF_WRITABLE) == -1)
+      return -1;
+    fmt = view->format ? view->format : "B";
+    if ((*fmt == '<' && !little) || ((*fmt == '>' || *fmt == '!') && little)) {
+      PyErr_SetString(PyExc_ValueError, "buffer has non-native byte order");
+      PyBuffer_Release(view);
+      return -1;
+    }
+    if (*fmt == '@' || *fmt == '=' || *fmt == '<' || *fmt == '>' || *fmt == '!')
+      fmt++;
+    if (view->itemsize != itemsize || !*fmt || fmt[1] || !strchr(kinds, *fmt)) {
+      PyErr_Format(PyExc_TypeError, "buffer of format '%s' has the wrong type",
+                   view->format ? view->format : "B");
+      PyBuffer_Release(view);
+      return -1;
+    }
+    return 0;
+  }
+
+  /* writable buffer object over C memory, valid while the memory lives */
+  static PyObject *ghmm_memory_buffer(void *data, Py_ssize_t size)
+  {
+    if (!data) {
+      PyErr_SetString(PyExc_ValueError, "got a null pointer");
+      return NULL;
+    }
+#if PY_VERSION_HEX >= 0x03030000
+    return PyMemoryView_FromMemory((char *) data, size, PyBUF_WRITE);
+#else
+    return PyBuffer_FromReadWriteMemory(data, size);
+#endif
+  }
+%}
+
+// contiguous array of C ints, e.g. a numpy array of dtype intc
+%typemap(in) (int *buffer, size_t length) (Py_buffer view, int has_view = 0) {
+  if (ghmm_get_buffer($input, &view, sizeof(int), "ilq") == -1)
+    SWIG_fail;
+  has_view = 1;
+  $1 = (int *) view.buf;
+  $2 = (size_t) (view.len / sizeof(int));
+}
+%typemap(freearg) (int *buffer, size_t length) {
+  if (has_view$argnum)
+    PyBuffer_Release(&view$argnum);
+}
+
+// contiguous array of C doubles, e.g. a numpy array of dtype float64
+%typemap(in) (double *buffer, size_t length) (Py_buffer view, int has_view = 0) {
+  if (ghmm_get_buffer($input, &view, sizeof(double), "d") == -1)
+    SWIG_fail;
+  has_view = 1;
+  $1 = (double *) view.buf;
+  $2 = (size_t) (view.len / sizeof(double));
+}
+%typemap(freearg) (double *buffer, size_t length) {
+  if (has_view$argnum)
+    PyBuffer_Release(&view$argnum);
+}
+
+// python sequence of sequence lengths, copied to a temporary array
+%typemap(in) (int *seq_len, long seq_number) {
+  long i;
+  if (!PySequence_Check($input)) {
+    PyErr_SetString(PyExc_TypeError, "Expecting a sequence");
+    SWIG_fail;
+  }
+  $2 = PySequence_Size($input);
+  $1 = malloc(($2 > 0 ? $2 : 1) * sizeof(int));
+  if (!$1) {
+    PyErr_NoMemory();
+    SWIG_fail;
+  }
+  for (i = 0; i < $2; i++) {
+    PyObject *o = PySequence_GetItem($input, i);
+    long value = o ? PyInt_AsLong(o) : -1;
+    Py_XDECREF(o);
+    if (value == -1 && PyErr_Occurred()) {
+      PyErr_SetString(PyExc_ValueError, "Expecting a sequence of integers");
+      SWIG_fail;
+    }
+    $1[i] = (int) value;
+  }
+}
+%typemap(freearg) (int *seq_len, long seq_number) {
+  free($1);
+}
+
+%exception buffer2double_matrix {
+  $action
+  if (!result)
+    SWIG_fail;
+}
+
+%inline %{
+  /* pointer into a contiguous buffer, the buffer is not copied */
+  int *buffer2int_array(int *buffer, size_t length) { return buffer; }
+  double *buffer2double_array(double *buffer, size_t length) { return buffer; }
+
+  /* row pointers into a contiguous buffer of rows * (length / rows)
+     entries; only the row pointers have to be freed (with free) */
+  double **buffer2double_matrix(double *buffer, size_t length, size_t rows)
+    {
+      size_t i;
+      double **mat;
+      if (!rows || length % rows) {
+        PyErr_SetString(PyExc_ValueError, "buffer length is no multiple of rows");
+        return NULL;
+      }
+      mat = malloc(rows * sizeof(double *));
+      if (!mat)
+        return (double **) PyErr_NoMemory();
+      for (i = 0; i < rows; i++)
+        mat[i] = buffer + i * (length / rows);
+      return mat;
+    }
+
+  /* writable buffers over C arrays without copying */
+  PyObject *int_array2buffer(int *array, size_t length)
+    {
+      return ghmm_memory_buffer(array, length * sizeof(int));
+    }
+  PyObject *double_array2buffer(double *array, size_t length)
+    {
+      return ghmm_memory_buffer(array, length * sizeof(double));
+    }
+  /* only for matrices with contiguous rows, e.g. double_matrix_alloc_block */
+  PyObject *double_matrix2buffer(double **matrix, size_t rows, size_t cols)
+    {
+      size_t i;
+      for (i = 1; i < rows; i++)
+        if (matrix[i] != matrix[0] + i * cols) {
+          PyErr_SetString(PyExc_ValueError, "matrix rows are not contiguous");
+          return NULL;
+        }
+      return ghmm_memory_buffer(matrix[0], rows * cols * sizeof(double));
+    }
+%}
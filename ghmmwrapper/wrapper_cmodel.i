@@ -5,6 +5,7 @@
 #include "ghmm/sreestimate.h"
 #include "ghmm/randvar.h"
 #include "ghmm/matrixop.h"
+#include "ghmm/snapshot.h"
 %}
 /*==========================================================================
   ===== continous emission density types =================================== */
@@ -185,6 +186,10 @@ typedef struct ghmm_cmodel_class_change_context {
   /** pointer to class function */
   int (*get_class) (struct ghmm_cmodel *, const double *, int, int);
 
+  /** optional: classes of all T - 1 transitions of a sequence at once */
+  int (*get_class_sequence) (struct ghmm_cmodel *, const double *, int, int,
+                             int *);
+
   /* space for any data necessary for class switch, USER is RESPONSIBLE */
   void *user_data;
   } ghmm_cmodel_class_change_context;
@@ -283,6 +288,7 @@ extern int ghmm_cmodel_free(ghmm_cmodel **smo);
         ~ghmm_cmodel() { ghmm_cmodel_free(&self); }
 
         int write_xml(char* filename) { return ghmm_cmodel_xml_write(&self, filename, 1); }
+        int write_snapshot(char* filename) { return ghmm_cmodel_snapshot_write(self, filename); }
 
         int forward(double *O, int T, double ***b, double **alpha, double *scale, double *log_p);
 
@@ -292,6 +298,10 @@ extern int ghmm_cmodel_free(ghmm_cmodel **smo);
 
         int logp_joint(const double *O, int len, const int *S, int slen, double *log_p);
 
+        int posterior(double *O, int T, double **post, double *log_p);
+
+        int posterior_decoding(double *O, int T, int *path, double *log_p);
+
         int class_change_alloc(void);
 
         //int check_compatibility(ghmm_cmodel **smo, int smodel_number);
@@ -334,6 +344,8 @@ extern int ghmm_cmodel_free(ghmm_cmodel **smo);
 }
 
 extern int ghmm_cmodel_xml_write(ghmm_cmodel** smo, const char* file, int smo_number);
+%newobject ghmm_cmodel_snapshot_read;
+extern ghmm_cmodel *ghmm_cmodel_snapshot_read(const char *filename);
 extern int ghmm_cmodel_baum_welch(ghmm_cmodel_baum_welch_context* cs);
 
 STRUCT_ARRAY(ghmm_cmodel, cmodel)
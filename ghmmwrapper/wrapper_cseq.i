@@ -36,6 +36,32 @@ typedef struct ghmm_cseq {
 
 extern int ghmm_cseq_free(ghmm_cseq **csq);
 extern ghmm_cseq* ghmm_cseq_calloc(long number);
+extern int ghmm_cseq_is_block(const ghmm_cseq *sq);
+
+// wraps the contiguous buffer without copying, see ghmm_cseq_wrap_block
+%newobject cseq_from_buffer;
+%exception cseq_from_buffer {
+    $action
+    if (!result) {
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "could not wrap the buffer");
+        SWIG_fail;
+    }
+}
+%inline %{
+        ghmm_cseq *cseq_from_buffer(double *buffer, size_t length, int *seq_len, long seq_number)
+            {
+                long i;
+                size_t total = 0;
+                for (i = 0; i < seq_number; i++)
+                    total += seq_len[i] > 0 ? seq_len[i] : 0;
+                if (total > length) {
+                    PyErr_SetString(PyExc_ValueError, "sequence lengths exceed the buffer");
+                    return NULL;
+                }
+                return ghmm_cseq_wrap_block(buffer, seq_len, seq_number);
+            }
+%}
 
 %extend ghmm_cseq {
 %apply SWIGTYPE* DISOWN {ghmm_cseq* seq};
@@ -75,6 +101,19 @@ extern ghmm_cseq* ghmm_cseq_calloc(long number);
         void copy_all(long t_num, ghmm_cseq *source, long s_num);
 
         double* getSequence(int index) { return self->seq[index]; }
+        // all sequences without copying, if stored in one contiguous block
+        PyObject* getBlockBuffer()
+            {
+                long i;
+                size_t total = 0;
+                if (!ghmm_cseq_is_block(self)) {
+                    PyErr_SetString(PyExc_ValueError, "sequences are not stored contiguously");
+                    return NULL;
+                }
+                for (i = 0; i < self->seq_number; i++)
+                    total += self->seq_len[i];
+                return double_array2buffer(self->seq_number ? self->seq[0] : NULL, total);
+            }
         void setSequence(int seqno, double *O) { self->seq[seqno] = O; }
         double getSymbol(int seqno, int index) { return self->seq[seqno][index]; }
         void setSymbol(int seqno, int index, double value) { self->seq[seqno][index] = value; }
@@ -8,6 +8,7 @@
 #include <ghmm/discrime.h>
 #include <ghmm/fbgibbs.h>
 #include <ghmm/cfbgibbs.h>
+#include <ghmm/snapshot.h>
 %}
 
 /*==========================================================================
@@ -193,6 +194,8 @@ typedef struct {
 } ghmm_dmodel;
 
 extern int ghmm_dmodel_free(ghmm_dmodel **mo);
+%newobject ghmm_dmodel_snapshot_read;
+extern ghmm_dmodel *ghmm_dmodel_snapshot_read(const char *filename);
 
 %extend ghmm_dmodel {
         ghmm_dmodel() { return calloc(1, sizeof(ghmm_dmodel)); }
@@ -207,6 +210,7 @@ extern int ghmm_dmodel_free(ghmm_dmodel **mo);
         ~ghmm_dmodel() { ghmm_dmodel_free(&self); }
 
         int write_xml(char* filename) { return ghmm_dmodel_xml_write(&self, filename, 1); }
+        int write_snapshot(char* filename) { return ghmm_dmodel_snapshot_write(self, filename); }
 
         int forward_init(double *alpha_1, int symb, double *scale);
 
@@ -224,6 +228,10 @@ extern int ghmm_dmodel_free(ghmm_dmodel **mo);
 
         int forward_lean(const int *O, int len, double *log_p);
 
+        int posterior(const int *O, int len, double **post, double *log_p);
+
+        int posterior_decoding(const int *O, int len, int *path, double *log_p);
+
         //int check_compatibility(ghmm_dmodel **mo, int model_number);
 
         ghmm_dseq* generate_sequences(int seed, int global_len, long seq_number,
@@ -261,6 +269,8 @@ extern int ghmm_dmodel_free(ghmm_dmodel **mo);
 
         int* viterbi(int *o, int len, int *pathlen, double *log_p);
 
+        int* viterbi_sparse(ghmm_dsparse_emission *se, int *o, int len, int *pathlen, double *log_p);
+
         double viterbi_logp(int *o, int len, int *state_seq);
 
         ghmm_dstate* getState(size_t index) { return self->s + index; }
@@ -299,6 +309,27 @@ extern int ghmm_dmodel_free(ghmm_dmodel **mo);
 STRUCT_ARRAY(ghmm_dmodel, dmodel)
 REFERENCE_ARRAY(ghmm_dmodel, dmodel_ptr)
 
+/*==========================================================================
+  ===== sparse emissions of discrete models ================================ */
+typedef struct ghmm_dsparse_emission {
+  /** alphabet size */
+  int M;
+  /** number of nonzero emission probabilities */
+  int nonzero;
+  /** M + 1 offsets into state and b */
+  int *start;
+  /** emitting states in increasing order */
+  int *state;
+  /** emission probabilities */
+  double *b;
+} ghmm_dsparse_emission;
+
+%extend ghmm_dsparse_emission {
+        ghmm_dsparse_emission(ghmm_dmodel *mo)
+            { return ghmm_dmodel_sparse_emission_alloc(mo); }
+        ~ghmm_dsparse_emission() { ghmm_dsparse_emission_free(&self); }
+}
+
 %newobject ghmm_dmodel::label_generate_sequences;
 
 /* ====== labeled =========================================================== */
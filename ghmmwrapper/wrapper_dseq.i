@@ -45,6 +45,32 @@ typedef struct ghmm_dseq {
 
 extern int ghmm_dseq_free(ghmm_dseq **sq);
 extern ghmm_dseq* ghmm_dseq_calloc(long number);
+extern int ghmm_dseq_is_block(const ghmm_dseq *sq);
+
+// wraps the contiguous buffer without copying, see ghmm_dseq_wrap_block
+%newobject dseq_from_buffer;
+%exception dseq_from_buffer {
+    $action
+    if (!result) {
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "could not wrap the buffer");
+        SWIG_fail;
+    }
+}
+%inline %{
+        ghmm_dseq *dseq_from_buffer(int *buffer, size_t length, int *seq_len, long seq_number)
+            {
+                long i;
+                size_t total = 0;
+                for (i = 0; i < seq_number; i++)
+                    total += seq_len[i] > 0 ? seq_len[i] : 0;
+                if (total > length) {
+                    PyErr_SetString(PyExc_ValueError, "sequence lengths exceed the buffer");
+                    return NULL;
+                }
+                return ghmm_dseq_wrap_block(buffer, seq_len, seq_number);
+            }
+%}
 
 %extend ghmm_dseq {
 %apply SWIGTYPE* DISOWN {ghmm_dseq* seq};
@@ -99,6 +125,19 @@ extern ghmm_dseq* ghmm_dseq_calloc(long number);
         void clean();
 
         int* getSequence(int index) { return self->seq[index]; }
+        // all sequences without copying, if stored in one contiguous block
+        PyObject* getBlockBuffer()
+            {
+                long i;
+                size_t total = 0;
+                if (!ghmm_dseq_is_block(self)) {
+                    PyErr_SetString(PyExc_ValueError, "sequences are not stored contiguously");
+                    return NULL;
+                }
+                for (i = 0; i < self->seq_number; i++)
+                    total += self->seq_len[i];
+                return int_array2buffer(self->seq_number ? self->seq[0] : NULL, total);
+            }
         void setSequence(int seqno, int *O) { self->seq[seqno] = O; }
         int getSymbol(int seqno, int index) { return self->seq[seqno][index]; }
         void setSymbol(int seqno, int index, int value) { self->seq[seqno][index] = value; }
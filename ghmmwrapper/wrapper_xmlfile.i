@@ -33,7 +33,13 @@ typedef struct {
 %newobject ghmm_xmlfile_parse;
 extern ghmm_xmlfile* ghmm_xmlfile_parse(const char *filename);
 
+%newobject ghmm_xmlfile_parse_stream;
+extern ghmm_xmlfile* ghmm_xmlfile_parse_stream(const char *filename);
+
 extern int           ghmm_xmlfile_validate(const char *filename);
 
 extern void          ghmm_xmlfile_write(ghmm_xmlfile* f, const char *file);
 
+#define GHMM_kXMLBase64Emissions (1 << 0)
+extern int           ghmm_xmlfile_write_options(ghmm_xmlfile* f, const char *file, int options);
+
@@ -0,0 +1,186 @@
+/*******************************************************************************
+  filename     : ghmm/tests/alloc_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#if defined(HAVE_MADVISE)
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+#include <ghmm/ghmm.h>
+#include <ghmm/mes.h>
+#include <ghmm/matrix.h>
+#include <ghmm/ghmm_internals.h>
+
+#define SIZE_MAXIMUM ((size_t) -1)
+
+/* ARRAY_MALLOC of entries doubles, the way the library allocates
+   return: 0 or -1 if the allocation failed */
+static int array_malloc(int entries) {
+#define CUR_PROC "array_malloc"
+  double *a = NULL;
+  ARRAY_MALLOC(a, entries);
+  m_free(a);
+  return 0;
+STOP:
+  return -1;
+#undef CUR_PROC
+}
+
+static int test_array_bytes() {
+  if (ighmm_array_bytes(SIZE_MAXIMUM / 2 + 1, 2) != SIZE_MAXIMUM
+      || ighmm_array_bytes(SIZE_MAXIMUM / 3, 4) != SIZE_MAXIMUM
+      || ighmm_array_bytes(SIZE_MAXIMUM / 8, 8) != SIZE_MAXIMUM / 8 * 8
+      || ighmm_array_bytes(1000, 8) != 8000) {
+    fprintf(stderr, "overflowing size does not saturate\n");
+    return 1;
+  }
+  /* a negative int count converts to a huge size_t */
+  if (ighmm_array_bytes((size_t) -1, sizeof(double)) != SIZE_MAXIMUM
+      || ighmm_array_bytes((size_t) -1, 1) != SIZE_MAXIMUM) {
+    fprintf(stderr, "negative count does not saturate\n");
+    return 1;
+  }
+  if (ighmm_array_bytes(0, sizeof(double)) != 0
+      || ighmm_array_bytes(5, 0) != 0) {
+    fprintf(stderr, "empty array has a size\n");
+    return 1;
+  }
+  if (!array_malloc(-1) || !array_malloc(INT_MIN) || array_malloc(0)
+      || array_malloc(3)) {
+    fprintf(stderr, "ARRAY_MALLOC of a negative or zero count wrong\n");
+    return 1;
+  }
+  return 0;
+}
+
+/* the stat matrices hold the row pointers and the entries in one block */
+static int test_stat_matrix() {
+  double **a;
+  int **d, i, j;
+
+  if (ighmm_cmatrix_stat_alloc(INT_MAX, INT_MAX)
+      || ighmm_dmatrix_stat_alloc(INT_MAX, INT_MAX)) {
+    fprintf(stderr, "overflowing matrix allocated\n");
+    return 1;
+  }
+  if (ighmm_cmatrix_stat_alloc(-1, 3) || ighmm_cmatrix_stat_alloc(3, -1)
+      || ighmm_dmatrix_stat_alloc(-1, 3) || ighmm_dmatrix_stat_alloc(3, -1)) {
+    fprintf(stderr, "matrix of negative dimension allocated\n");
+    return 1;
+  }
+  a = ighmm_cmatrix_stat_alloc(3, 0);
+  if (!a || a[0] != (double *) (a + 3) || a[2] != a[0]) {
+    fprintf(stderr, "matrix without columns wrong\n");
+    return 1;
+  }
+  ighmm_cmatrix_stat_free(&a);
+  a = ighmm_cmatrix_stat_alloc(0, 5);
+  if (!a) {
+    fprintf(stderr, "matrix without rows not allocated\n");
+    return 1;
+  }
+  ighmm_cmatrix_stat_free(&a);
+  /* all entries are inside the block and zeroed */
+  a = ighmm_cmatrix_stat_alloc(7, 5);
+  d = ighmm_dmatrix_stat_alloc(7, 5);
+  if (!a || !d) {
+    fprintf(stderr, "matrix not allocated\n");
+    return 1;
+  }
+  for (i = 0; i < 7; i++)
+    for (j = 0; j < 5; j++)
+      if (a[i][j] != 0 || d[i][j] != 0 || a[i] != (double *) (a + 7) + i * 5) {
+        fprintf(stderr, "matrix entry %d, %d wrong\n", i, j);
+        return 1;
+      }
+  ighmm_cmatrix_stat_free(&a);
+  ighmm_dmatrix_stat_free(&d);
+  return 0;
+}
+
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE) && defined(__linux__)
+/* whether the mapping containing addr has the VmFlags flag
+   return: 1, 0 or -1 if the mappings can not be read */
+static int vma_flag(void *addr, const char *flag) {
+  FILE *fp = fopen("/proc/self/smaps", "r");
+  char line[512];
+  unsigned long start, end, a = (unsigned long) addr;
+  int inside = 0, res = -1;
+
+  if (!fp)
+    return -1;
+  while (fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+      inside = start <= a && a < end;
+    else if (inside && !strncmp(line, "VmFlags:", 8)) {
+      res = strstr(line, flag) != NULL;
+      break;
+    }
+  }
+  fclose(fp);
+  return res;
+}
+
+/* blocks of GHMM_HUGE_PAGE_MIN bytes are advised, but only the pages lying
+   completely inside the block */
+static int test_huge_pages() {
+  size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  char *large, *small, *first;
+  int res = 1;
+
+  large = ighmm_calloc(GHMM_HUGE_PAGE_MIN);
+  small = ighmm_malloc(GHMM_HUGE_PAGE_MIN - 1);
+  if (!large || !small) {
+    fprintf(stderr, "large blocks not allocated\n");
+    goto STOP;
+  }
+  memset(large, 1, GHMM_HUGE_PAGE_MIN);
+  memset(small, 1, GHMM_HUGE_PAGE_MIN - 1);
+  first = (char *) (((size_t) large + page - 1) / page * page);
+  /* no transparent huge pages in the kernel, nothing to advise */
+  if (vma_flag(first, " hg") == -1
+      || access("/sys/kernel/mm/transparent_hugepage", F_OK)) {
+    res = 0;
+    goto STOP;
+  }
+  if (vma_flag(first, " hg") != 1
+      || vma_flag(large + GHMM_HUGE_PAGE_MIN - page - 1, " hg") != 1) {
+    fprintf(stderr, "large block is not advised\n");
+    goto STOP;
+  }
+  if ((first != large && vma_flag(large, " hg") != 0)
+      || vma_flag(small + page, " hg") != 0) {
+    fprintf(stderr, "memory outside of a large block is advised\n");
+    goto STOP;
+  }
+  res = 0;
+STOP:
+  free(large);
+  free(small);
+  return res;
+}
+#else
+static int test_huge_pages() {
+  return 0;
+}
+#endif
+
+int main() {
+  int res;
+
+  res = test_array_bytes() || test_stat_matrix() || test_huge_pages();
+
+  printf("alloc_test: %s\n", res ? "failed" : "ok");
+  return res;
+}
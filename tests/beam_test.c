@@ -0,0 +1,207 @@
+/*******************************************************************************
+  filename     : ghmm/tests/beam_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+
+#include <ghmm/rng.h>
+#include <ghmm/sequence.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/foba.h>
+#include <ghmm/sfoba.h>
+#include <ghmm/viterbi.h>
+#include <ghmm/sviterbi.h>
+#include <ghmm/beam.h>
+
+#define STATES 24
+#define SYMBOLS 6
+#define OUT 4
+#define SEQ_LEN 60
+#define SEQ_NUMBER 5
+
+/* compares a beam search result with the exact one */
+static int check(const char *name, int *bpath, int *vpath, int len,
+                 double log_p_beam, double log_p, int exact,
+                 ghmm_beam_stats *stats) {
+  int t;
+  printf("%s: log_p = %f, exact %f, %ld pruned, mean active %.1f, "
+         "pruned mass %f\n", name,
+         log_p_beam, log_p, stats->pruned, (double)stats->active / stats->steps,
+         stats->pruned_mass);
+  if (stats->steps != len)
+    return 1;
+  if (exact) {
+    if (stats->pruned || fabs(log_p_beam - log_p) > 1e-9)
+      return 1;
+    for (t = 0; bpath && t < len; t++)
+      if (bpath[t] != vpath[t])
+        return 1;
+  }
+  /* pruning can only lose paths */
+  else if (log_p_beam > log_p + 1e-9)
+    return 1;
+  return 0;
+}
+
+/* every state goes to itself and the next OUT - 1 states */
+static int discrete_test() {
+  ghmm_dmodel mo;
+  ghmm_dstate s[STATES];
+  double b[STATES][SYMBOLS], out_a[STATES][OUT], in_a[STATES][OUT];
+  int out_id[STATES][OUT], in_id[STATES][OUT], pow_look[2] = {1, SYMBOLS};
+  ghmm_dseq *sq;
+  ghmm_beam_stats stats;
+  int *vpath, *bpath, vlen, i, j, k, result = 0;
+  double log_p, log_v, log_p_beam, log_p_path, sum;
+
+  for (i = 0; i < STATES; i++) {
+    sum = 0;
+    for (j = 0; j < SYMBOLS; j++)
+      sum += b[i][j] = 0.1 + GHMM_RNG_UNIFORM(RNG);
+    for (j = 0; j < SYMBOLS; j++)
+      b[i][j] /= sum;
+    for (k = 0; k < OUT; k++) {
+      out_id[i][k] = (i + k) % STATES;
+      out_a[i][k] = k ? 0.5 / (OUT - 1) : 0.5;
+      in_id[i][k] = (i - OUT + 1 + k + STATES) % STATES;
+      in_a[i][k] = k == OUT - 1 ? 0.5 : 0.5 / (OUT - 1);
+    }
+    s[i].pi = 1.0 / STATES;
+    s[i].b = b[i];
+    s[i].out_states = s[i].in_states = OUT;
+    s[i].out_id = out_id[i];
+    s[i].in_id = in_id[i];
+    s[i].out_a = out_a[i];
+    s[i].in_a = in_a[i];
+    s[i].fix = 0;
+  }
+  mo.N = STATES;
+  mo.M = SYMBOLS;
+  mo.s = s;
+  mo.prior = -1;
+  mo.pow_lookup = pow_look;
+  mo.maxorder = 0;
+  mo.model_type = 0;
+
+  sq = ghmm_dmodel_generate_sequences(&mo, 0, SEQ_LEN, SEQ_NUMBER, SEQ_LEN);
+  if (!sq)
+    return 1;
+  for (i = 0; i < SEQ_NUMBER && !result; i++) {
+    vpath = ghmm_dmodel_viterbi(&mo, sq->seq[i], SEQ_LEN, &vlen, &log_v);
+    ghmm_dmodel_logp(&mo, sq->seq[i], SEQ_LEN, &log_p);
+
+    /* without pruning the results are exact */
+    bpath = ghmm_dmodel_viterbi_beam(&mo, sq->seq[i], SEQ_LEN, 0, 0,
+                                     &log_p_beam, &stats);
+    result = !bpath || check("discrete viterbi", bpath, vpath, SEQ_LEN,
+                             log_p_beam, log_v, 1, &stats);
+    free(bpath);
+    result = result
+      || ghmm_dmodel_forward_beam(&mo, sq->seq[i], SEQ_LEN, 0, 0,
+                                  &log_p_beam, &stats)
+      || check("discrete forward", NULL, NULL, SEQ_LEN, log_p_beam, log_p, 1,
+               &stats);
+
+    /* narrow beams prune and lose probability */
+    bpath = ghmm_dmodel_viterbi_beam(&mo, sq->seq[i], SEQ_LEN, 3.0, 4,
+                                     &log_p_beam, &stats);
+    result = result || !bpath
+      || check("pruned discrete viterbi", bpath, vpath, SEQ_LEN, log_p_beam,
+               log_v, 0, &stats)
+      || stats.max_active > 4 || !stats.pruned
+      /* log_p is the probability of the returned path */
+      || ghmm_dmodel_logp_joint(&mo, sq->seq[i], SEQ_LEN, bpath, SEQ_LEN,
+                                &log_p_path)
+      || fabs(log_p_path - log_p_beam) > 1e-9;
+    free(bpath);
+    result = result
+      || ghmm_dmodel_forward_beam(&mo, sq->seq[i], SEQ_LEN, 3.0, 4,
+                                  &log_p_beam, &stats)
+      || check("pruned discrete forward", NULL, NULL, SEQ_LEN, log_p_beam,
+               log_p, 0, &stats)
+      || stats.pruned_mass <= 0.0;
+    free(vpath);
+  }
+  ghmm_dseq_free(&sq);
+  return result;
+}
+
+/* two normal distributed states with one transition class */
+static int continuous_test() {
+  ghmm_cmodel smo;
+  ghmm_cstate states[2];
+  ghmm_c_emission e[2];
+  double c[1] = {1.0};
+  int id[2] = {0, 1};
+  double a[2][2] = {{0.95, 0.05}, {0.1, 0.9}};
+  double a_rev[2][2] = {{0.95, 0.1}, {0.05, 0.9}};
+  double *out_a[2], *in_a[2];
+  ghmm_cseq *sq;
+  ghmm_beam_stats stats;
+  int *vpath, *bpath, i, result = 0;
+  double log_p, log_v, log_p_beam;
+
+  for (i = 0; i < 2; i++) {
+    e[i].type = normal;
+    e[i].dimension = 1;
+    e[i].mean.val = 2.0 * i;
+    e[i].variance.val = 1.0;
+    e[i].fixed = 0;
+    out_a[i] = a[i];
+    in_a[i] = a_rev[i];
+    states[i].pi = 0.5;
+    states[i].M = 1;
+    states[i].c = c;
+    states[i].e = &e[i];
+    states[i].out_states = states[i].in_states = 2;
+    states[i].out_id = states[i].in_id = id;
+    states[i].out_a = &out_a[i];
+    states[i].in_a = &in_a[i];
+    states[i].fix = 0;
+  }
+  smo.N = 2;
+  smo.M = 1;
+  smo.dim = 1;
+  smo.cos = 1;
+  smo.prior = -1;
+  smo.s = states;
+
+  sq = ghmm_cmodel_generate_sequences(&smo, 1, SEQ_LEN, SEQ_NUMBER, 0);
+  if (!sq)
+    return 1;
+  for (i = 0; i < SEQ_NUMBER && !result; i++) {
+    vpath = ghmm_cmodel_viterbi(&smo, sq->seq[i], sq->seq_len[i], &log_v);
+    ghmm_cmodel_logp(&smo, sq->seq[i], sq->seq_len[i], &log_p);
+    bpath = ghmm_cmodel_viterbi_beam(&smo, sq->seq[i], sq->seq_len[i], 0, 0,
+                                     &log_p_beam, &stats);
+    result = !vpath || !bpath
+      || check("continuous viterbi", bpath, vpath, sq->seq_len[i], log_p_beam,
+               log_v, 1, &stats)
+      || ghmm_cmodel_forward_beam(&smo, sq->seq[i], sq->seq_len[i], 0, 0,
+                                  &log_p_beam, &stats)
+      || check("continuous forward", NULL, NULL, sq->seq_len[i], log_p_beam,
+               log_p, 1, &stats);
+    free(bpath);
+    free(vpath);
+  }
+  ghmm_cseq_free(&sq);
+  return result;
+}
+
+int main() {
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  return discrete_test() || continuous_test();
+}
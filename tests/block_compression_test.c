@@ -0,0 +1,189 @@
+/*******************************************************************************
+  filename     : ghmm/tests/block_compression_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* precompute_block_emission is internal to continuous_fbgibbs.c */
+#include "../ghmm/continuous_fbgibbs.c"
+
+#include <ghmm/block_compression.h>
+
+#define NSTATES 3
+#define LONG_LEN 600
+
+/* blocks [0, 3), [3, 5), [5, 7) and [7, 8) with width 1 and delta 2:
+   the median 5.1 splits off the runs of the small and the large values,
+   the largest gap splits the large values once more */
+static double known[] = {1.0, 1.1, 1.2, 9.0, 9.1, 9.4, 9.45, 1.05};
+static int known_bounds[] = {0, 3, 5, 7, 8};
+
+static ghmm_cmodel *normal_model() {
+  ghmm_cmodel *smo;
+  double self[NSTATES] = {0.98, 0.5, 0.1};
+  int i, j;
+
+  smo = ghmm_cmodel_calloc(NSTATES, GHMM_kContinuousHMM, 1);
+  smo->M = 1;
+  smo->cos = 1;
+  smo->prior = -1;
+  for (i = 0; i < NSTATES; i++) {
+    ghmm_cstate_alloc(smo->s + i, 1, NSTATES, NSTATES, 1);
+    smo->s[i].M = 1;
+    smo->s[i].pi = 1.0 / NSTATES;
+    smo->s[i].out_states = smo->s[i].in_states = NSTATES;
+    smo->s[i].e->type = normal;
+    smo->s[i].e->dimension = 1;
+    smo->s[i].e->mean.val = 1.0 + 4 * i;
+    smo->s[i].e->variance.val = 0.25 + i;
+    smo->s[i].c[0] = 1;
+  }
+  for (i = 0; i < NSTATES; i++)
+    for (j = 0; j < NSTATES; j++) {
+      smo->s[i].out_id[j] = smo->s[j].in_id[i] = j;
+      smo->s[i].out_a[0][j] = smo->s[j].in_a[0][i]
+        = i == j ? self[i] : (1 - self[i]) / (NSTATES - 1);
+    }
+  return smo;
+}
+
+/* the blocks have to cover the sequence in order and hold its moments */
+static int check_moments(ghmm_cseq *sq, block_stats *stats) {
+  double m1, m2;
+  int t, k, start = 0;
+
+  for (t = 0; t < stats->total; t++) {
+    if (stats->length[t] < 1 || start + stats->length[t] > sq->seq_len[0]) {
+      fprintf(stderr, "block %d has length %d\n", t, stats->length[t]);
+      return 1;
+    }
+    for (m1 = m2 = 0, k = start; k < start + stats->length[t]; k++) {
+      m1 += sq->seq[0][k];
+      m2 += sq->seq[0][k] * sq->seq[0][k];
+    }
+    if (fabs(stats->moment1[t] - m1) > 1e-12 * fabs(m1)
+        || fabs(stats->moment2[t] - m2) > 1e-12 * m2) {
+      fprintf(stderr, "moments of block %d differ\n", t);
+      return 1;
+    }
+    start += stats->length[t];
+  }
+  if (start != sq->seq_len[0]) {
+    fprintf(stderr, "blocks cover %d of %d observations\n", start, sq->seq_len[0]);
+    return 1;
+  }
+  return 0;
+}
+
+/* the block emission of state i is a_ii^(len-1) prod_k b_i(x_k), divided by
+   the largest state of the block, the reference sums the logs of the
+   per observation densities */
+static int check_emission(ghmm_cmodel *smo, ghmm_cseq *sq, block_stats *stats) {
+  double ***b, logp[NSTATES], max;
+  int t, i, k, start = 0, res = 1;
+
+  b = ighmm_cmatrix_3d_alloc(stats->total, NSTATES, 2);
+  if (precompute_block_emission(smo, stats, b))
+    goto STOP;
+  for (t = 0; t < stats->total; t++) {
+    max = -HUGE_VAL;
+    for (i = 0; i < NSTATES; i++) {
+      logp[i] = (stats->length[t] - 1) * log(ghmm_cmodel_get_transition(smo, i, i, 0));
+      for (k = start; k < start + stats->length[t]; k++)
+        logp[i] += log(ghmm_cmodel_calc_b(smo->s + i, sq->seq[0] + k));
+      if (max < logp[i])
+        max = logp[i];
+    }
+    for (i = 0; i < NSTATES; i++)
+      if (fabs(b[t][i][1] - exp(logp[i] - max)) > 1e-9 * exp(logp[i] - max)) {
+        fprintf(stderr, "emission of state %d in block %d is %g, not %g\n", i, t,
+                b[t][i][1], exp(logp[i] - max));
+        goto STOP;
+      }
+    start += stats->length[t];
+  }
+  res = 0;
+STOP:
+  ighmm_cmatrix_3d_free(&b, stats->total, NSTATES);
+  return res;
+}
+
+static int test_known(ghmm_cmodel *smo) {
+  ghmm_cseq *sq = ghmm_cseq_calloc(1);
+  block_stats *stats;
+  int t, res = 1;
+
+  sq->seq[0] = memcpy(malloc(sizeof(known)), known, sizeof(known));
+  sq->seq_len[0] = sizeof(known) / sizeof(known[0]);
+  stats = compress_observations(sq, 1.0, 2.0);
+  if (!stats)
+    goto STOP;
+  if (stats->total != sizeof(known_bounds) / sizeof(known_bounds[0]) - 1) {
+    fprintf(stderr, "%d blocks instead of %d\n", stats->total,
+            (int) (sizeof(known_bounds) / sizeof(known_bounds[0]) - 1));
+    goto STOP;
+  }
+  for (t = 0; t < stats->total; t++)
+    if (stats->length[t] != known_bounds[t + 1] - known_bounds[t]) {
+      fprintf(stderr, "block %d has length %d\n", t, stats->length[t]);
+      goto STOP;
+    }
+  res = check_moments(sq, stats) || check_emission(smo, sq, stats);
+STOP:
+  if (stats)
+    free_block_stats(&stats);
+  ghmm_cseq_free(&sq);
+  return res;
+}
+
+/* long runs around the means of the states become long blocks */
+static int test_long(ghmm_cmodel *smo) {
+  ghmm_cseq *sq = ghmm_cseq_calloc(1);
+  block_stats *stats;
+  int k, longest = 0, res = 1;
+
+  sq->seq[0] = malloc(LONG_LEN * sizeof(double));
+  sq->seq_len[0] = LONG_LEN;
+  for (k = 0; k < LONG_LEN; k++)
+    sq->seq[0][k] = 1.0 + 4 * (k / 200) + 0.01 * GHMM_RNG_UNIFORM(RNG);
+  stats = compress_observations(sq, 1.0, 2.0);
+  if (!stats)
+    goto STOP;
+  for (k = 0; k < stats->total; k++)
+    if (longest < stats->length[k])
+      longest = stats->length[k];
+  if (longest < 100) {
+    fprintf(stderr, "longest block has %d observations\n", longest);
+    goto STOP;
+  }
+  res = check_moments(sq, stats) || check_emission(smo, sq, stats);
+STOP:
+  if (stats)
+    free_block_stats(&stats);
+  ghmm_cseq_free(&sq);
+  return res;
+}
+
+int main() {
+  ghmm_cmodel *smo;
+  int res;
+
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  smo = normal_model();
+  res = test_known(smo) || test_long(smo);
+  ghmm_cmodel_free(&smo);
+
+  printf("block_compression_test: %s\n", res ? "failed" : "ok");
+  return res;
+}
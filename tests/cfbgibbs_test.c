@@ -0,0 +1,190 @@
+/*******************************************************************************
+  filename     : ghmm/tests/cfbgibbs_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* room for the matrices of 4 tuples of 2 states, but not for 2 tuples of 3
+   states, so the cache evicts after a few tuples */
+#define GHMM_CFBGIBBS_CACHE_SIZE 512
+
+/* the tuple cache is internal to cfbgibbs.c */
+#include "../ghmm/cfbgibbs.c"
+
+#include "test_models.h"
+
+#define NSTATES 2
+#define NSYMBOLS 3
+#define MAXLEN 4
+#define REQUESTS 2000
+
+/* position of the tuple x of length L as stored by storeposition64 */
+static uint64_t tuple_position(uint64_t *off, int *x, int L) {
+  uint64_t r = 0;
+  int i;
+  for (i = L - 1; i >= 0; i--)
+    r = x[i] + NSYMBOLS * r;
+  return off[L] + r;
+}
+
+/* the same chain of tupleproducts the cache runs, but without the cache */
+static void uncached(tuplecache *tc, int *x, int L, double *c, double *cdf) {
+  double m[NSTATES * NSTATES];
+  int i;
+  memcpy(c, tc->single + x[L - 1] * NSTATES * NSTATES, sizeof(m));
+  for (i = L - 2; i >= 0; i--) {
+    memcpy(m, c, sizeof(m));
+    tupleproduct(tc->single + x[i] * NSTATES * NSTATES, m, c, cdf, NSTATES);
+  }
+}
+
+/* M(x_0) ... M(x_L-1) with M(x)_jk = a_jk b_k(x), scaled to sum 1 at the end */
+static void product(ghmm_dmodel *mo, int *x, int L, double *c) {
+  double m[NSTATES * NSTATES], sum = 0;
+  int i, j, k, l;
+  for (j = 0; j < NSTATES; j++)
+    for (k = 0; k < NSTATES; k++)
+      c[j * NSTATES + k] = j == k;
+  for (i = 0; i < L; i++) {
+    memcpy(m, c, sizeof(m));
+    for (j = 0; j < NSTATES; j++)
+      for (k = 0; k < NSTATES; k++) {
+        c[j * NSTATES + k] = 0;
+        for (l = 0; l < NSTATES; l++)
+          c[j * NSTATES + k] += m[j * NSTATES + l]
+            * ghmm_dmodel_get_transition(mo, l, k) * mo->s[k].b[x[i]];
+      }
+  }
+  for (j = 0; j < NSTATES * NSTATES; j++)
+    sum += c[j];
+  for (j = 0; j < NSTATES * NSTATES; j++)
+    c[j] /= sum;
+}
+
+/* compares the cached matrices of x with the uncached and the plain product */
+static int compare(ghmm_dmodel *mo, tuplecache *tc, uint64_t *off, int *x, int L) {
+  double c[NSTATES * NSTATES], cdf[NSTATES * NSTATES * NSTATES], p[NSTATES * NSTATES];
+  double *mats;
+  uint64_t pos = tuple_position(off, x, L);
+  int j;
+
+  uncached(tc, x, L, c, cdf);
+  product(mo, x, L, p);
+  mats = tuplecache_mats(tc, pos);
+  for (j = 0; j < NSTATES * NSTATES; j++)
+    if (mats[j] != c[j] || fabs(mats[j] - p[j]) > 1e-12 * p[j]) {
+      fprintf(stderr, "matrix of tuple %lu differs at %d\n", (unsigned long) pos, j);
+      return 1;
+    }
+  if (L > 1 && memcmp(tuplecache_rmats(tc, pos), cdf, sizeof(cdf))) {
+    fprintf(stderr, "cdfs of tuple %lu differ\n", (unsigned long) pos);
+    return 1;
+  }
+  return 0;
+}
+
+/* entry of the tuple at pos or -1 if it is not cached */
+static int cached(tuplecache *tc, uint64_t pos) {
+  int e;
+  for (e = 0; e < tc->used; e++)
+    if (tc->key[e] == pos)
+      return e;
+  return -1;
+}
+
+static int test_cache(ghmm_dmodel *mo, uint64_t *off) {
+  tuplecache *tc = tuplecache_alloc(NSTATES, NSYMBOLS, 1000);
+  int x[MAXLEN], y[5][2] = {{0, 0}, {0, 1}, {1, 0}, {1, 1}, {2, 2}};
+  int i, k, L, res = 1;
+
+  if (!tc || tc->capacity != 4) {
+    fprintf(stderr, "cache does not hold 4 tuples\n");
+    goto STOP;
+  }
+  tuplecache_reset(tc, mo);
+  /* random tuples of all lengths, far more than fit into the cache */
+  for (i = 0; i < REQUESTS; i++) {
+    L = 1 + (int) (GHMM_RNG_UNIFORM(RNG) * MAXLEN);
+    for (k = 0; k < L; k++)
+      x[k] = (int) (GHMM_RNG_UNIFORM(RNG) * NSYMBOLS);
+    if (compare(mo, tc, off, x, L))
+      goto STOP;
+  }
+  if (tc->used != tc->capacity) {
+    fprintf(stderr, "cache is not full\n");
+    goto STOP;
+  }
+
+  /* pairs have a one symbol suffix and take one entry each, touching the
+     first one again makes the second the least recently used */
+  tuplecache_reset(tc, mo);
+  for (i = 0; i < 4; i++)
+    if (compare(mo, tc, off, y[i], 2))
+      goto STOP;
+  if (compare(mo, tc, off, y[0], 2) || compare(mo, tc, off, y[4], 2))
+    goto STOP;
+  if (cached(tc, tuple_position(off, y[1], 2)) != -1
+      || cached(tc, tuple_position(off, y[0], 2)) == -1
+      || cached(tc, tuple_position(off, y[4], 2)) == -1) {
+    fprintf(stderr, "least recently used tuple was not replaced\n");
+    goto STOP;
+  }
+  /* the replaced tuple is computed again */
+  if (compare(mo, tc, off, y[1], 2))
+    goto STOP;
+  res = 0;
+STOP:
+  tuplecache_free(&tc);
+  return res;
+}
+
+static int test_capacity() {
+  tuplecache *tc;
+  int res = 0;
+
+  /* 3 states need more than GHMM_CFBGIBBS_CACHE_SIZE for 2 tuples */
+  tc = tuplecache_alloc(NSTATES + 1, NSYMBOLS, 1000);
+  if (tc) {
+    fprintf(stderr, "cache for less than 2 tuples allocated\n");
+    tuplecache_free(&tc);
+    res = 1;
+  }
+  /* no more entries than different tuples, but at least 2 */
+  tc = tuplecache_alloc(NSTATES, NSYMBOLS, 3);
+  if (!tc || tc->capacity != 3)
+    res = 1;
+  tuplecache_free(&tc);
+  tc = tuplecache_alloc(NSTATES, NSYMBOLS, 1);
+  if (!tc || tc->capacity != 2)
+    res = 1;
+  tuplecache_free(&tc);
+  if (res)
+    fprintf(stderr, "capacity of the cache is wrong\n");
+  return res;
+}
+
+int main() {
+  ghmm_dmodel *mo;
+  uint64_t off[MAXLEN + 1];
+  int res;
+
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  mo = test_dmodel_connected(NSTATES, NSYMBOLS);
+  tupleoffsets(MAXLEN, NSYMBOLS, off);
+  res = test_cache(mo, off) || test_capacity();
+  ghmm_dmodel_free(&mo);
+
+  printf("cfbgibbs_test: %s\n", res ? "failed" : "ok");
+  return res;
+}
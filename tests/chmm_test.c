@@ -15,6 +15,8 @@
 #include <ghmm/matrix.h>
 #include <ghmm/rng.h>
 #include <ghmm/smodel.h>
+#include <ghmm/sfoba.h>
+#include <ghmm/sviterbi.h>
 #include <ghmm/matrixop.h>
 #include <ghmm/ghmm_internals.h>
 
@@ -210,6 +212,113 @@ int single_state_continuous_multidim()
   return 0;
 }
 
+/*
+  Two states with two transition classes: the class of the transition from
+  t to t+1 depends on the sign of the observation at t. The results with a
+  per time step class function and a class sequence function have to agree
+  and the per time step function must be called only once per time step.
+*/
+static int class_calls = 0;
+
+static int sign_class(ghmm_cmodel *smo, const double *O, int k, int t)
+{
+  (void) smo;
+  (void) k;
+  class_calls++;
+  return O[t] < 0.0 ? 0 : 1;
+}
+
+static int sign_class_sequence(ghmm_cmodel *smo, const double *O, int k,
+                               int T, int *classes)
+{
+  int t;
+  (void) smo;
+  (void) k;
+  for (t = 0; t < T - 1; t++)
+    classes[t] = O[t] < 0.0 ? 0 : 1;
+  return 0;
+}
+
+int two_class_continuous()
+{
+  ghmm_cstate states[2];
+  ghmm_cmodel my_model;
+  ghmm_c_emission e[2];
+  double c[] = {1.0};
+  int id[] = {0, 1};
+  /* a[i][class][j] and the reversed in_a[j][class][i] */
+  double a[2][2][2] = {{{0.9, 0.1}, {0.3, 0.7}}, {{0.2, 0.8}, {0.6, 0.4}}};
+  double a_rev[2][2][2];
+  double *out_a[2][2], *in_a[2][2];
+  double O[] = {-0.3, 0.1, 1.7, 2.2, -0.4, 1.1, 2.5, -1.0, 0.2, 0.9};
+  int T = sizeof(O) / sizeof(O[0]);
+  int *path[2], i, j, l, t, result = 0;
+  double log_p[2], log_v[2];
+
+  for (i = 0; i < 2; i++) {
+    for (l = 0; l < 2; l++) {
+      for (j = 0; j < 2; j++)
+        a_rev[i][l][j] = a[j][l][i];
+      out_a[i][l] = a[i][l];
+      in_a[i][l] = a_rev[i][l];
+    }
+    e[i].type = normal;
+    e[i].dimension = 1;
+    e[i].mean.val = 2.0 * i;
+    e[i].variance.val = 1.0;
+    e[i].fixed = 0;
+    states[i].pi = 0.5;
+    states[i].M = 1;
+    states[i].c = c;
+    states[i].e = &e[i];
+    states[i].out_states = states[i].in_states = 2;
+    states[i].out_id = states[i].in_id = id;
+    states[i].out_a = out_a[i];
+    states[i].in_a = in_a[i];
+    states[i].fix = 0;
+  }
+  my_model.N = 2;
+  my_model.M = 1;
+  my_model.dim = 1;
+  my_model.cos = 2;
+  my_model.prior = -1;
+  my_model.s = states;
+  my_model.class_change = NULL;
+  if (ghmm_cmodel_class_change_alloc(&my_model))
+    return 1;
+
+  for (l = 0; l < 2; l++) {
+    my_model.class_change->get_class = l ? NULL : sign_class;
+    my_model.class_change->get_class_sequence = l ? sign_class_sequence : NULL;
+    class_calls = 0;
+    if (ghmm_cmodel_logp(&my_model, O, T, &log_p[l])) {
+      fprintf(stderr, "forward with two classes failed\n");
+      result = 1;
+    }
+    if (l == 0 && class_calls != T - 1) {
+      fprintf(stderr, "get_class called %d times for %d transitions\n",
+              class_calls, T - 1);
+      result = 1;
+    }
+    path[l] = ghmm_cmodel_viterbi(&my_model, O, T, &log_v[l]);
+    if (!path[l])
+      result = 1;
+  }
+  printf("two classes: log_p = %f, %f, viterbi %f, %f\n", log_p[0], log_p[1],
+         log_v[0], log_v[1]);
+  if (!result && (log_p[0] != log_p[1] || log_v[0] != log_v[1]))
+    result = 1;
+  for (t = 0; t < T && !result; t++)
+    if (path[0][t] != path[1][t])
+      result = 1;
+
+  for (l = 0; l < 2; l++)
+    if (path[l])
+      free(path[l]);
+  free(my_model.class_change);
+  return result;
+}
+
 int main()
 {
   int ret;
@@ -220,6 +329,7 @@ int main()
   printf("\nset up model\n");
 
   ret = single_state_continuous_multidim();
+  ret = ret || two_class_continuous();
 
   return ret;
 }
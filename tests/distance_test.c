@@ -0,0 +1,176 @@
+/*******************************************************************************
+  filename     : ghmm/tests/distance_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include <ghmm/rng.h>
+#include <ghmm/matrix.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/distance.h>
+
+#define MODELS 3
+
+/* estimate within the interval (and a little slack for the normal
+   approximation) */
+static int check_estimate(const char *name, double d, double hw, double exact) {
+  printf("%s: %f +- %f, exact %f\n", name, d, hw, exact);
+  if (fabs(d - exact) > 2 * hw + 1e-12) {
+    fprintf(stderr, "%s is off\n", name);
+    return 1;
+  }
+  return 0;
+}
+
+/* one state models, the divergence rate is the divergence of the emissions */
+static int discrete_test() {
+  ghmm_dmodel mo[MODELS], *models[MODELS];
+  ghmm_dstate s[MODELS];
+  double b[MODELS][2] = {{0.5, 0.5}, {0.8, 0.2}, {1.0, 0.0}};
+  int id[1] = {0}, pow_look[2] = {1, 2};
+  double a[1] = {1.0};
+  double **d, **hw;
+  ghmm_distance_options opt;
+  ghmm_distance_estimate est, again;
+  int i, j, result = 0;
+
+  memset(mo, 0, sizeof(mo));
+  memset(s, 0, sizeof(s));
+  for (i = 0; i < MODELS; i++) {
+    s[i].pi = 1.0;
+    s[i].b = b[i];
+    s[i].out_states = s[i].in_states = 1;
+    s[i].out_id = s[i].in_id = id;
+    s[i].out_a = s[i].in_a = a;
+    mo[i].N = 1;
+    mo[i].M = 2;
+    mo[i].s = s + i;
+    mo[i].prior = -1;
+    mo[i].pow_lookup = pow_look;
+    models[i] = mo + i;
+  }
+
+  ghmm_distance_options_init(&opt);
+  opt.chunk_len = 200;
+  opt.tolerance = 0.01;
+  if (ghmm_dmodel_distance_mc(&mo[0], &mo[1], &opt, &est)
+      || ghmm_dmodel_distance_mc(&mo[0], &mo[1], &opt, &again)) {
+    fprintf(stderr, "discrete distance failed\n");
+    return 1;
+  }
+  printf("%d chunks, %ld symbols\n", est.chunks, est.symbols);
+  result = check_estimate("d(0, 1)", est.distance, est.half_width,
+                          0.5 * log(0.5 / 0.8) + 0.5 * log(0.5 / 0.2));
+  if (est.half_width > opt.tolerance
+      || est.symbols >= opt.max_symbols || est.chunks < opt.min_chunks) {
+    fprintf(stderr, "early stopping failed\n");
+    result = 1;
+  }
+  if (again.distance != est.distance || again.chunks != est.chunks) {
+    fprintf(stderr, "the same seed gives different results\n");
+    result = 1;
+  }
+
+  d = ighmm_cmatrix_stat_alloc(MODELS, MODELS);
+  hw = ighmm_cmatrix_stat_alloc(MODELS, MODELS);
+  if (ghmm_dmodel_distance_matrix(models, MODELS, &opt, d, hw)) {
+    fprintf(stderr, "discrete distance matrix failed\n");
+    return 1;
+  }
+  for (i = 0; i < MODELS; i++)
+    for (j = 0; j < MODELS; j++)
+      printf("%g%c", d[i][j], j < MODELS - 1 ? '\t' : '\n');
+  for (i = 0; i < MODELS; i++)
+    if (d[i][i] != 0.0)
+      result = 1;
+  /* the samples of model 0 are the same as in the pairwise estimation */
+  if (d[0][1] != est.distance || hw[0][1] != est.half_width) {
+    fprintf(stderr, "matrix differs from the pairwise estimation\n");
+    result = 1;
+  }
+  /* model 2 can not emit symbol 1 */
+  if (d[0][2] != DBL_MAX || d[1][2] != DBL_MAX)
+    result = 1;
+  result = result
+    || check_estimate("d(1, 0)", d[1][0], hw[1][0],
+                      0.8 * log(0.8 / 0.5) + 0.2 * log(0.2 / 0.5))
+    || check_estimate("d(2, 0)", d[2][0], hw[2][0], log(2.0))
+    || check_estimate("d(2, 1)", d[2][1], hw[2][1], log(1.0 / 0.8));
+
+  opt.symmetric = 1;
+  if (ghmm_dmodel_distance_matrix(models, MODELS, &opt, d, hw)
+      || d[0][1] != d[1][0] || d[0][2] != DBL_MAX)
+    result = 1;
+
+  ighmm_cmatrix_stat_free(&d);
+  ighmm_cmatrix_stat_free(&hw);
+  return result;
+}
+
+/* N(0, 1) and N(1, 1) have divergence 1/2 in both directions */
+static int continuous_test() {
+  ghmm_cmodel smo[2];
+  ghmm_cstate s[2];
+  ghmm_c_emission e[2];
+  double c[1] = {1.0}, a[1] = {1.0}, *pa[1];
+  int id[1] = {0}, i, result;
+  ghmm_distance_options opt;
+  ghmm_distance_estimate est;
+
+  memset(smo, 0, sizeof(smo));
+  memset(s, 0, sizeof(s));
+  pa[0] = a;
+  for (i = 0; i < 2; i++) {
+    e[i].type = normal;
+    e[i].dimension = 1;
+    e[i].mean.val = i;
+    e[i].variance.val = 1.0;
+    e[i].fixed = 0;
+    s[i].pi = 1.0;
+    s[i].M = 1;
+    s[i].c = c;
+    s[i].e = &e[i];
+    s[i].out_states = s[i].in_states = 1;
+    s[i].out_id = s[i].in_id = id;
+    s[i].out_a = s[i].in_a = pa;
+    smo[i].N = 1;
+    smo[i].M = 1;
+    smo[i].dim = 1;
+    smo[i].cos = 1;
+    smo[i].prior = -1;
+    smo[i].s = s + i;
+  }
+
+  ghmm_distance_options_init(&opt);
+  opt.chunk_len = 200;
+  opt.tolerance = 0.02;
+  opt.symmetric = 1;
+  if (ghmm_cmodel_distance_mc(&smo[0], &smo[1], &opt, &est)) {
+    fprintf(stderr, "continuous distance failed\n");
+    return 1;
+  }
+  printf("%d chunks, %ld symbols\n", est.chunks, est.symbols);
+  result = check_estimate("continuous", est.distance, est.half_width, 0.5);
+  if (est.half_width > opt.tolerance)
+    result = 1;
+  return result;
+}
+
+int main() {
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  return discrete_test() || continuous_test();
+}
@@ -0,0 +1,238 @@
+/*******************************************************************************
+  filename     : ghmm/tests/hsmm_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include <ghmm/rng.h>
+#include <ghmm/sequence.h>
+#include <ghmm/model.h>
+#include <ghmm/hsmm.h>
+
+#define LEN 7
+#define SEQ_NUMBER 30
+#define SEGMENTS 20
+
+/* sums (and maximizes) the probabilities of all segmentations of O[t..] */
+static void brute_force(ghmm_dhsmm *h, const int *O, int t, int prev, double p,
+			int *path, int *best_path, double *total, double *best) {
+  ghmm_dmodel *mo = h->mo;
+  int j, u, v;
+  double p_j, p_u;
+
+  for (j = 0; j < mo->N; j++) {
+    if (j == prev)
+      continue;
+    p_j = p * (prev < 0 ? mo->s[j].pi : ghmm_dmodel_get_transition(mo, prev, j));
+    for (u = 1; u <= h->D && t + u <= LEN; u++) {
+      p_u = p_j * h->d[j][u - 1];
+      for (v = t; v < t + u; v++) {
+	p_u *= mo->s[j].b[O[v]];
+	path[v] = j;
+      }
+      if (p_u <= 0.0)
+	continue;
+      if (t + u < LEN)
+	brute_force(h, O, t + u, j, p_u, path, best_path, total, best);
+      else {
+	*total += p_u;
+	if (p_u > *best) {
+	  *best = p_u;
+	  for (v = 0; v < LEN; v++)
+	    best_path[v] = path[v];
+	}
+      }
+    }
+  }
+}
+
+/* sets up a fully connected discrete model */
+static void model_init(ghmm_dmodel *mo, ghmm_dstate *states, int n, int m,
+		       double *b, double *a, double *a_rev, int *id) {
+  int i, j;
+  memset(mo, 0, sizeof(*mo));
+  memset(states, 0, n * sizeof(*states));
+  for (i = 0; i < n; i++) {
+    id[i] = i;
+    for (j = 0; j < n; j++)
+      a_rev[i * n + j] = a[j * n + i];
+  }
+  for (i = 0; i < n; i++) {
+    states[i].pi = 1.0 / n;
+    states[i].b = b + i * m;
+    states[i].out_states = states[i].in_states = n;
+    states[i].out_id = states[i].in_id = id;
+    states[i].out_a = a + i * n;
+    states[i].in_a = a_rev + i * n;
+  }
+  mo->N = n;
+  mo->M = m;
+  mo->s = states;
+  mo->prior = -1;
+}
+
+/* forward and Viterbi against all segmentations of a short sequence */
+static int brute_force_test() {
+  ghmm_dmodel mo;
+  ghmm_dstate states[3];
+  double b[3 * 2] = {0.9, 0.1, 0.2, 0.8, 0.5, 0.5};
+  double a[3 * 3] = {0.5, 0.3, 0.2, 0.1, 0.6, 0.3, 0.4, 0.4, 0.2};
+  double a_rev[3 * 3];
+  int id[3];
+  int O[LEN] = {0, 0, 1, 1, 1, 0, 1};
+  int path[LEN], best_path[LEN], *vpath, t, result = 0;
+  double total = 0.0, best = 0.0, log_p, log_p_viterbi;
+  ghmm_dhsmm *h;
+
+  model_init(&mo, states, 3, 2, b, a, a_rev, id);
+  h = ghmm_dhsmm_from_dmodel(&mo, 3);
+  if (!h) {
+    fprintf(stderr, "could not build the HSMM\n");
+    return 1;
+  }
+  if (fabs(h->d[0][0] - 0.5 / 0.875) > 1e-12
+      || ghmm_dmodel_get_transition(h->mo, 0, 0) != 0.0
+      || fabs(ghmm_dmodel_get_transition(h->mo, 0, 1) - 0.6) > 1e-12) {
+    fprintf(stderr, "self transitions not converted to durations\n");
+    result = 1;
+  }
+  /* state 0 lasts at least two steps */
+  h->d[0][0] = 0.0;
+  h->d[0][1] = 0.7;
+  h->d[0][2] = 0.3;
+
+  brute_force(h, O, 0, -1, 1.0, path, best_path, &total, &best);
+  vpath = ghmm_dhsmm_viterbi(h, O, LEN, &log_p_viterbi);
+  if (ghmm_dhsmm_logp(h, O, LEN, &log_p) || !vpath) {
+    fprintf(stderr, "HSMM forward or viterbi failed\n");
+    return 1;
+  }
+  printf("log_p = %f, brute force %f\n", log_p, log(total));
+  printf("viterbi log_p = %f, brute force %f\n", log_p_viterbi, log(best));
+  if (fabs(log_p - log(total)) > 1e-10 || fabs(log_p_viterbi - log(best)) > 1e-10)
+    result = 1;
+  for (t = 0; t < LEN; t++)
+    if (vpath[t] != best_path[t]) {
+      fprintf(stderr, "viterbi path differs at %d\n", t);
+      result = 1;
+    }
+  free(vpath);
+  ghmm_dhsmm_free(&h);
+  return result;
+}
+
+/* samples a sequence of complete segments */
+static int *sample(ghmm_dhsmm *h, int segments, int *len) {
+  ghmm_dmodel *mo = h->mo;
+  int *O, i = 0, j, u, t = 0, s;
+  double r;
+
+  O = malloc(sizeof(int) * segments * h->D);
+  for (r = GHMM_RNG_UNIFORM(RNG); i < mo->N - 1 && r >= mo->s[i].pi; i++)
+    r -= mo->s[i].pi;
+  for (s = 0; s < segments; s++) {
+    for (r = GHMM_RNG_UNIFORM(RNG), u = 0; u < h->D - 1 && r >= h->d[i][u]; u++)
+      r -= h->d[i][u];
+    for (; u >= 0; u--, t++) {
+      for (r = GHMM_RNG_UNIFORM(RNG), j = 0; j < mo->M - 1 && r >= mo->s[i].b[j]; j++)
+	r -= mo->s[i].b[j];
+      O[t] = j;
+    }
+    for (r = GHMM_RNG_UNIFORM(RNG), j = 0; j < mo->s[i].out_states - 1
+	   && r >= mo->s[i].out_a[j]; j++)
+      r -= mo->s[i].out_a[j];
+    i = mo->s[i].out_id[j];
+  }
+  *len = t;
+  return O;
+}
+
+/* learns a peaked duration from geometric initial durations */
+static int baum_welch_test() {
+  ghmm_dmodel mo;
+  ghmm_dstate states[2];
+  double b[2 * 2] = {0.85, 0.15, 0.15, 0.85};
+  double a[2 * 2] = {0.5, 0.5, 0.5, 0.5};
+  double a_rev[2 * 2];
+  int id[2];
+  double d0[6] = {0.0, 0.0, 0.1, 0.8, 0.1, 0.0};
+  double d1[6] = {0.5, 0.5, 0.0, 0.0, 0.0, 0.0};
+  ghmm_dhsmm *truth, *h;
+  ghmm_dseq *sq;
+  double log_p, log_p_before = 0.0, log_p_after = 0.0, sum;
+  int i, u, result = 0;
+
+  model_init(&mo, states, 2, 2, b, a, a_rev, id);
+  truth = ghmm_dhsmm_from_dmodel(&mo, 6);
+  b[0] = b[3] = 0.6;
+  b[1] = b[2] = 0.4;
+  h = ghmm_dhsmm_from_dmodel(&mo, 6);
+  sq = ghmm_dseq_calloc(SEQ_NUMBER);
+  if (!truth || !h || !sq) {
+    fprintf(stderr, "could not set up the HSMM training test\n");
+    return 1;
+  }
+  for (u = 0; u < 6; u++) {
+    truth->d[0][u] = d0[u];
+    truth->d[1][u] = d1[u];
+  }
+  for (i = 0; i < SEQ_NUMBER; i++) {
+    sq->seq[i] = sample(truth, SEGMENTS, &sq->seq_len[i]);
+    ghmm_dhsmm_logp(h, sq->seq[i], sq->seq_len[i], &log_p);
+    log_p_before += log_p;
+  }
+
+  if (ghmm_dhsmm_baum_welch(h, sq, 100, 1e-6)) {
+    fprintf(stderr, "HSMM Baum-Welch failed\n");
+    return 1;
+  }
+  for (i = 0; i < SEQ_NUMBER; i++) {
+    ghmm_dhsmm_logp(h, sq->seq[i], sq->seq_len[i], &log_p);
+    log_p_after += log_p;
+  }
+  printf("training: log_p %f -> %f\n", log_p_before, log_p_after);
+  printf("durations of state 0:");
+  for (u = 0; u < 6; u++)
+    printf(" %.3f", h->d[0][u]);
+  printf("\n");
+  if (log_p_after <= log_p_before || h->d[0][3] < 0.5 || h->d[0][0] > 0.1)
+    result = 1;
+  for (i = 0; i < 2; i++) {
+    for (sum = 0.0, u = 0; u < 6; u++)
+      sum += h->d[i][u];
+    if (fabs(sum - 1.0) > 1e-10)
+      result = 1;
+  }
+
+  /* long sequences need the scaling */
+  free(sq->seq[0]);
+  sq->seq[0] = sample(truth, 2000, &sq->seq_len[0]);
+  if (ghmm_dhsmm_logp(truth, sq->seq[0], sq->seq_len[0], &log_p)
+      || log_p == +1 || !(log_p > -DBL_MAX)) {
+    fprintf(stderr, "log_p of a long sequence: %f\n", log_p);
+    result = 1;
+  }
+
+  ghmm_dseq_free(&sq);
+  ghmm_dhsmm_free(&truth);
+  ghmm_dhsmm_free(&h);
+  return result;
+}
+
+int main() {
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  return brute_force_test() || baum_welch_test();
+}
@@ -161,11 +161,11 @@ void testBaumwelch(int seqlen){
   ghmm_dseq * my_output = NULL;
    
 
-  if (!(mo_gen = malloc (sizeof (ghmm_dmodel))))
+  if (!(mo_gen = calloc (1, sizeof (ghmm_dmodel))))
     {printf ("malloc failed in line %d", __LINE__); exit(1);}
-  if (!(mo_time = malloc (sizeof (ghmm_dmodel))))
+  if (!(mo_time = calloc (1, sizeof (ghmm_dmodel))))
     {printf ("malloc failed in line %d", __LINE__); exit(1);}
-  if (!(mo_mem = malloc (sizeof (ghmm_dmodel))))
+  if (!(mo_mem = calloc (1, sizeof (ghmm_dmodel))))
     {printf ("malloc failed in line %d", __LINE__); exit(1);}
       
   /* generate a model with variable number of states*/
@@ -208,10 +208,46 @@ void testBaumwelch(int seqlen){
   ghmm_dseq_free(&my_output);
 }
 
+/* the precomputed context indices equal the emission history indices */
+int testEmissionContext(int seqlen){
+
+  int i, k, t, e_index, result = 0;
+  int **ctx;
+  ghmm_dmodel * mo = NULL;
+  ghmm_dseq * sq = NULL;
+
+  if (!(mo = calloc (1, sizeof (ghmm_dmodel))))
+    {printf ("malloc failed in line %d", __LINE__); exit(1);}
+  generateModel(mo, 6, 4711);
+  sq = ghmm_dmodel_label_generate_sequences(mo, 0, seqlen, 3, seqlen);
+
+  for (k = 0; k < sq->seq_number && !result; k++) {
+    ctx = ghmm_dmodel_emission_context_alloc(mo, sq->seq[k], sq->seq_len[k]);
+    if (!ctx)
+      return 1;
+    mo->emission_history = 0;
+    for (t = 0; t < sq->seq_len[k]; t++) {
+      for (i = 0; i < mo->N; i++) {
+        e_index = get_emission_index(mo, i, sq->seq[k][t], t);
+        if (e_index != ghmm_emission_context_index(mo, ctx, i, sq->seq[k][t], t)) {
+          printf("context index of state %d differs at %d\n", i, t);
+          result = 1;
+        }
+      }
+      update_emission_history(mo, sq->seq[k][t]);
+    }
+    ghmm_dmodel_emission_context_free(&ctx, mo);
+  }
+
+  ghmm_dmodel_free(&mo);
+  ghmm_dseq_free(&sq);
+  return result;
+}
+
 int main(){
 
   ghmm_rng_init();
   testBaumwelch(2700);
 
-  return 0;
+  return testEmissionContext(100);
 }
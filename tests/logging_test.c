@@ -0,0 +1,130 @@
+/*******************************************************************************
+  filename     : ghmm/tests/logging_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <ghmm/ghmm.h>
+#include <ghmm/ghmm_internals.h>
+
+#define THREADS 8
+#define MESSAGES 2000
+#define HANDLERS 16
+
+/* messages a handler received, counted per thread and message */
+typedef struct {
+  int count[THREADS][MESSAGES];
+  int foreign;   /* delivered on another thread or malformed */
+} received;
+
+static int thread_num(void) {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+static void count_message(int level, const char *message, void *clientdata) {
+  received *r = clientdata;
+  const char *text = strstr(message, "thread ");
+  int thread, i;
+
+  (void) level;
+  if (!text || sscanf(text, "thread %d message %d", &thread, &i) != 2
+      || thread < 0 || thread >= THREADS || i < 0 || i >= MESSAGES
+      || thread != thread_num()) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    r->foreign++;
+    return;
+  }
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  r->count[thread][i]++;
+}
+
+/* every message of every thread has to arrive exactly once at the handler
+   of the thread that logged it */
+static int test_threads(received *r) {
+#define CUR_PROC "test_threads"
+  int thread, i, threads = 1;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(THREADS) private(i)
+#endif
+  {
+#ifdef _OPENMP
+#pragma omp single
+    threads = omp_get_num_threads();
+#endif
+    for (i = 0; i < MESSAGES; i++)
+      GHMM_LOG_PRINTF(LCRITIC, LOC, "thread %d message %d", thread_num(), i);
+  }
+  if (r->foreign) {
+    fprintf(stderr, "%d messages arrived mixed up\n", r->foreign);
+    return 1;
+  }
+  for (thread = 0; thread < THREADS; thread++)
+    for (i = 0; i < MESSAGES; i++)
+      if (r->count[thread][i] != (thread < threads)) {
+        fprintf(stderr, "message %d of thread %d arrived %d times\n", i, thread,
+                r->count[thread][i]);
+        return 1;
+      }
+  return 0;
+#undef CUR_PROC
+}
+
+/* slots are never reused, registrations beyond them are refused and keep
+   the last handler */
+static int test_slots(received *r) {
+#define CUR_PROC "test_slots"
+  received *last = r + HANDLERS - 1;
+  int i;
+
+  for (i = 1; i < HANDLERS; i++)
+    if (ghmm_set_logfunc(count_message, r + i)) {
+      fprintf(stderr, "registration %d refused\n", i + 1);
+      return 1;
+    }
+  if (!ghmm_set_logfunc(count_message, r)) {
+    fprintf(stderr, "registration %d accepted\n", HANDLERS + 1);
+    return 1;
+  }
+  GHMM_LOG_PRINTF(LCRITIC, LOC, "thread %d message %d", 0, 0);
+  if (last->count[0][0] != 1 || r->count[0][0] != 1) {
+    fprintf(stderr, "last handler was replaced\n");
+    return 1;
+  }
+  if (ghmm_set_logfunc(NULL, NULL)) {
+    fprintf(stderr, "logging to stderr refused\n");
+    return 1;
+  }
+  return 0;
+#undef CUR_PROC
+}
+
+int main() {
+  received *r = calloc(HANDLERS, sizeof(received));
+  int res;
+
+  res = ghmm_set_logfunc(count_message, r) || test_threads(r) || test_slots(r);
+  free(r);
+
+  printf("logging_test: %s\n", res ? "failed" : "ok");
+  return res;
+}
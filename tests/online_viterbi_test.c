@@ -0,0 +1,217 @@
+/*******************************************************************************
+  filename     : ghmm/tests/online_viterbi_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <ghmm/rng.h>
+#include <ghmm/sequence.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/viterbi.h>
+#include <ghmm/sviterbi.h>
+#include <ghmm/oviterbi.h>
+
+#define SEQ_LEN 200
+#define SEQ_NUMBER 10
+
+/* collects the states fixed by the decoder, checks the bounded delay */
+static int collect(int *path, int *len, int *fixed, int n, int pushed,
+		   int max_delay) {
+  int i;
+  if (n < 0)
+    return 1;
+  for (i = 0; i < n; i++)
+    path[(*len)++] = fixed[i];
+  if (max_delay > 0 && pushed - *len > max_delay) {
+    fprintf(stderr, "%d states are not fixed after %d observations\n",
+	    pushed - *len, pushed);
+    return 1;
+  }
+  return 0;
+}
+
+/* three states, sticky transitions and overlapping emissions */
+static int discrete_test() {
+  ghmm_dmodel mo;
+  ghmm_dstate states[3];
+  double b[3][4] = {{0.7, 0.1, 0.1, 0.1}, {0.1, 0.7, 0.1, 0.1},
+		    {0.25, 0.25, 0.25, 0.25}};
+  int id[3] = {0, 1, 2};
+  double a[3][3] = {{0.9, 0.05, 0.05}, {0.05, 0.9, 0.05}, {0.1, 0.1, 0.8}};
+  double a_rev[3][3];
+  int pow_look[2] = {1, 4};
+  ghmm_dseq *sq;
+  ghmm_oviterbi *ov[2];
+  int max_delay[2] = {0, 5};
+  int *path, *vpath, *fixed, path_len, vlen, i, j, k, t, n, result = 0;
+  double log_p, log_p_online;
+
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < 3; j++)
+      a_rev[i][j] = a[j][i];
+    states[i].pi = 1.0 / 3;
+    states[i].b = b[i];
+    states[i].out_states = states[i].in_states = 3;
+    states[i].out_id = states[i].in_id = id;
+    states[i].out_a = a[i];
+    states[i].in_a = a_rev[i];
+    states[i].fix = 0;
+  }
+  mo.N = 3;
+  mo.M = 4;
+  mo.s = states;
+  mo.prior = -1;
+  mo.pow_lookup = pow_look;
+  mo.maxorder = 0;
+  mo.model_type = 0;
+
+  sq = ghmm_dmodel_generate_sequences(&mo, 0, SEQ_LEN, SEQ_NUMBER, SEQ_LEN);
+  for (k = 0; k < 2; k++)
+    ov[k] = ghmm_dmodel_oviterbi_alloc(&mo, max_delay[k]);
+  path = malloc(sizeof(int) * SEQ_LEN);
+  if (!sq || !ov[0] || !ov[1] || !path) {
+    fprintf(stderr, "could not set up the discrete online viterbi test\n");
+    return 1;
+  }
+
+  for (i = 0; i < SEQ_NUMBER && !result; i++) {
+    vpath = ghmm_dmodel_viterbi(&mo, sq->seq[i], sq->seq_len[i], &vlen, &log_p);
+    for (k = 0; k < 2 && !result; k++) {
+      path_len = 0;
+      for (t = 0; t < sq->seq_len[i] && !result; t++) {
+	n = ghmm_dmodel_oviterbi_push(ov[k], sq->seq[i][t], &fixed);
+	result = collect(path, &path_len, fixed, n, t + 1, max_delay[k]);
+      }
+      /* the survivors of this model merge long before the end */
+      if (!result && path_len < sq->seq_len[i] / 2) {
+	fprintf(stderr, "only %d states fixed before the end\n", path_len);
+	result = 1;
+      }
+      n = ghmm_oviterbi_finish(ov[k], &fixed, &log_p_online);
+      result = result || collect(path, &path_len, fixed, n, t, 0);
+      if (result || path_len != sq->seq_len[i]) {
+	fprintf(stderr, "online viterbi returned %d states for %d symbols\n",
+		path_len, sq->seq_len[i]);
+	result = 1;
+	break;
+      }
+      printf("discrete, max delay %d: log_p = %f, offline %f\n", max_delay[k],
+	     log_p_online, log_p);
+      if (max_delay[k] == 0) {
+	/* without a bound the path is the Viterbi path */
+	if (fabs(log_p - log_p_online) > 1e-10)
+	  result = 1;
+	for (t = 0; t < path_len && !result; t++)
+	  if (path[t] != vpath[t]) {
+	    fprintf(stderr, "online path differs at %d\n", t);
+	    result = 1;
+	  }
+      }
+      else if (log_p_online == +1 || log_p_online > log_p + 1e-10) {
+	fprintf(stderr, "bounded delay path is better than the Viterbi path\n");
+	result = 1;
+      }
+    }
+    free(vpath);
+  }
+
+  for (k = 0; k < 2; k++)
+    ghmm_oviterbi_free(&ov[k]);
+  free(path);
+  ghmm_dseq_free(&sq);
+  return result;
+}
+
+/* two normal distributed states with one transition class */
+static int continuous_test() {
+  ghmm_cmodel smo;
+  ghmm_cstate states[2];
+  ghmm_c_emission e[2];
+  double c[1] = {1.0};
+  int id[2] = {0, 1};
+  double a[2][2] = {{0.95, 0.05}, {0.1, 0.9}};
+  double a_rev[2][2] = {{0.95, 0.1}, {0.05, 0.9}};
+  double *out_a[2], *in_a[2];
+  ghmm_cseq *sq;
+  ghmm_oviterbi *ov;
+  int *path, *vpath, *fixed, path_len, i, j, t, n, result = 0;
+  double log_p, log_p_online;
+
+  for (i = 0; i < 2; i++) {
+    e[i].type = normal;
+    e[i].dimension = 1;
+    e[i].mean.val = 2.0 * i;
+    e[i].variance.val = 1.0;
+    e[i].fixed = 0;
+    out_a[i] = a[i];
+    in_a[i] = a_rev[i];
+    states[i].pi = 0.5;
+    states[i].M = 1;
+    states[i].c = c;
+    states[i].e = &e[i];
+    states[i].out_states = states[i].in_states = 2;
+    states[i].out_id = states[i].in_id = id;
+    states[i].out_a = &out_a[i];
+    states[i].in_a = &in_a[i];
+    states[i].fix = 0;
+  }
+  smo.N = 2;
+  smo.M = 1;
+  smo.dim = 1;
+  smo.cos = 1;
+  smo.prior = -1;
+  smo.s = states;
+
+  sq = ghmm_cmodel_generate_sequences(&smo, 1, SEQ_LEN, SEQ_NUMBER, 0);
+  ov = ghmm_cmodel_oviterbi_alloc(&smo, 0);
+  path = malloc(sizeof(int) * SEQ_LEN);
+  if (!sq || !ov || !path) {
+    fprintf(stderr, "could not set up the continuous online viterbi test\n");
+    return 1;
+  }
+
+  for (i = 0; i < SEQ_NUMBER && !result; i++) {
+    vpath = ghmm_cmodel_viterbi(&smo, sq->seq[i], sq->seq_len[i], &log_p);
+    path_len = 0;
+    for (t = 0; t < sq->seq_len[i] && !result; t++) {
+      n = ghmm_cmodel_oviterbi_push(ov, sq->seq[i] + t, 0, &fixed);
+      result = collect(path, &path_len, fixed, n, t + 1, 0);
+    }
+    n = ghmm_oviterbi_finish(ov, &fixed, &log_p_online);
+    result = result || collect(path, &path_len, fixed, n, t, 0);
+    printf("continuous: log_p = %f, offline %f\n", log_p_online, log_p);
+    if (result || !vpath || path_len != sq->seq_len[i]
+	|| fabs(log_p - log_p_online) > 1e-8) {
+      fprintf(stderr, "continuous online viterbi differs\n");
+      result = 1;
+    }
+    for (j = 0; j < path_len && !result; j++)
+      if (path[j] != vpath[j]) {
+	fprintf(stderr, "continuous online path differs at %d\n", j);
+	result = 1;
+      }
+    free(vpath);
+  }
+
+  ghmm_oviterbi_free(&ov);
+  free(path);
+  ghmm_cseq_free(&sq);
+  return result;
+}
+
+int main() {
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  return discrete_test() || continuous_test();
+}
@@ -0,0 +1,291 @@
+/*******************************************************************************
+  filename     : ghmm/tests/pair_hmm_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <ghmm/rng.h>
+#include <ghmm/pmodel.h>
+#include <ghmm/psequence.h>
+#include <ghmm/pviterbi.h>
+#include <ghmm/pfoba.h>
+#include <ghmm/pviterbi_propagate.h>
+#include <ghmm/matrix.h>
+
+#define ALPHABET 4
+#define LEN_X    80
+
+/*
+  three state alignment model: match, insertion in X and insertion in Y
+*/
+static double b_match[ALPHABET * ALPHABET];
+static double b_insert[ALPHABET] = {0.25, 0.25, 0.25, 0.25};
+
+static int out_id[3][3] = {{0, 1, 2}, {0, 1, -1}, {0, 2, -1}};
+static double out_p[3][3] = {{0.8, 0.1, 0.1}, {0.6, 0.4, 0}, {0.6, 0.4, 0}};
+static int in_id[3][3] = {{0, 1, 2}, {0, 1, -1}, {0, 2, -1}};
+static double in_p[3][3] = {{0.8, 0.6, 0.6}, {0.1, 0.4, 0}, {0.1, 0.4, 0}};
+static double *out_a[3][3];
+static double *in_a[3][3];
+
+static ghmm_dpstate states[3];
+static int alphabet_sizes[1] = {ALPHABET};
+static ghmm_dpmodel_class_change_context class_change;
+
+static void init_model(ghmm_dpmodel * mo) {
+  int i, j;
+  double pi[3] = {0.8, 0.1, 0.1};
+  int offset_x[3] = {1, 1, 0};
+  int offset_y[3] = {1, 0, 1};
+  int n_trans[3] = {3, 2, 2};
+
+  for (i = 0; i < ALPHABET; i++)
+    for (j = 0; j < ALPHABET; j++)
+      b_match[i * ALPHABET + j] = (i == j) ? 0.2 : 0.2 / 12;
+
+  ghmm_dpmodel_set_to_default_transition_class(&class_change);
+  for (i = 0; i < 3; i++) {
+    states[i].pi = pi[i];
+    states[i].log_pi = log(pi[i]);
+    states[i].b = (i == 0) ? b_match : b_insert;
+    states[i].offset_x = offset_x[i];
+    states[i].offset_y = offset_y[i];
+    states[i].alphabet = 0;
+    states[i].kclasses = 1;
+    states[i].class_change = &class_change;
+    states[i].out_states = n_trans[i];
+    states[i].in_states = n_trans[i];
+    states[i].out_id = out_id[i];
+    states[i].in_id = in_id[i];
+    for (j = 0; j < n_trans[i]; j++) {
+      out_a[i][j] = &out_p[i][j];
+      in_a[i][j] = &in_p[i][j];
+    }
+    states[i].out_a = out_a[i];
+    states[i].in_a = in_a[i];
+  }
+
+  mo->N = 3;
+  mo->M = ALPHABET;
+  mo->s = states;
+  mo->prior = -1;
+  mo->model_type = 0;
+  mo->number_of_alphabets = 1;
+  mo->size_of_alphabet = alphabet_sizes;
+  mo->max_offset_x = 1;
+  mo->max_offset_y = 1;
+}
+
+/* X is random, Y is X with some substitutions, insertions and deletions */
+static void init_sequences(ghmm_dpseq ** X, ghmm_dpseq ** Y) {
+  int x[LEN_X], y[2 * LEN_X];
+  int i, len_y = 0;
+  double r;
+
+  for (i = 0; i < LEN_X; i++) {
+    x[i] = (int)(GHMM_RNG_UNIFORM(RNG) * ALPHABET);
+    r = GHMM_RNG_UNIFORM(RNG);
+    if (r < 0.05)
+      continue;
+    if (r < 0.1)
+      y[len_y++] = (int)(GHMM_RNG_UNIFORM(RNG) * ALPHABET);
+    y[len_y++] = (r < 0.2) ? (int)(GHMM_RNG_UNIFORM(RNG) * ALPHABET) : x[i];
+  }
+  *X = ghmm_dpseq_init(LEN_X, 1, 0);
+  *Y = ghmm_dpseq_init(len_y, 1, 0);
+  for (i = 0; i < LEN_X; i++)
+    (*X)->seq[0][i] = x[i];
+  for (i = 0; i < len_y; i++)
+    (*Y)->seq[0][i] = y[i];
+}
+
+/* largest distance of the path to the diagonal used by the banded viterbi */
+static int band_of_path(ghmm_dpmodel * mo, int * path, int len, int len_x, int len_y) {
+  int t, u = -1, v = -1, c, band = 0;
+  for (t = 0; t < len; t++) {
+    u += mo->s[path[t]].offset_x;
+    v += mo->s[path[t]].offset_y;
+    c = (int)floor((double)(u + 1) * len_y / len_x) - 1;
+    if (abs(v - c) > band)
+      band = abs(v - c);
+  }
+  return band;
+}
+
+static int viterbi_variants_test(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y) {
+  int *path, *path_wf, *path_band;
+  int len, len_wf, len_band, band, t;
+  double log_p, log_p_wf, log_p_band;
+  int result = 0;
+
+  path = ghmm_dpmodel_viterbi(mo, X, Y, &log_p, &len);
+  path_wf = ghmm_dpmodel_viterbi_wavefront(mo, X, Y, &log_p_wf, &len_wf);
+  if (!path || !path_wf) {
+    fprintf(stderr, "pair viterbi failed\n");
+    return 1;
+  }
+  printf("viterbi: log_p = %f, path length %d\n", log_p, len);
+  printf("wavefront: log_p = %f, path length %d\n", log_p_wf, len_wf);
+  if (log_p != log_p_wf || len != len_wf) {
+    fprintf(stderr, "wavefront viterbi differs from viterbi\n");
+    result = 1;
+  }
+  for (t = 0; !result && t < len; t++)
+    if (path[t] != path_wf[t]) {
+      fprintf(stderr, "wavefront path differs at %d\n", t);
+      result = 1;
+    }
+
+  /* the smallest band that still covers the optimal path */
+  band = band_of_path(mo, path, len, X->length, Y->length);
+  path_band = ghmm_dpmodel_viterbi_banded(mo, X, Y, &log_p_band, &len_band, band);
+  printf("banded (%d): log_p = %f, path length %d\n", band, log_p_band, len_band);
+  if (!path_band || fabs(log_p - log_p_band) > 1e-10) {
+    fprintf(stderr, "banded viterbi differs from viterbi\n");
+    result = 1;
+  }
+  free(path_band);
+
+  /* a narrower band can not find a better path */
+  if (band > 0) {
+    path_band = ghmm_dpmodel_viterbi_banded(mo, X, Y, &log_p_band, &len_band, band - 1);
+    printf("banded (%d): log_p = %f, path length %d\n", band - 1, log_p_band, len_band);
+    if (!path_band || (log_p_band != +1 && log_p_band > log_p)) {
+      fprintf(stderr, "narrow banded viterbi is better than viterbi\n");
+      result = 1;
+    }
+    free(path_band);
+  }
+
+  free(path);
+  free(path_wf);
+  return result;
+}
+
+static int propagate_test(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y) {
+  int *path, *path_par;
+  int len, len_par, t, result = 0;
+  double log_p, log_p_par;
+
+  /* split until the segments have less than 200 cells */
+  path = ghmm_dpmodel_viterbi_propagate(mo, X, Y, &log_p, &len, 200);
+  path_par = ghmm_dpmodel_viterbi_propagate_parallel(mo, X, Y, &log_p_par,
+						     &len_par, 200);
+  if (!path || !path_par) {
+    fprintf(stderr, "pair viterbi propagate failed\n");
+    return 1;
+  }
+  printf("propagate: log_p = %f, parallel %f\n", log_p, log_p_par);
+  if (log_p != log_p_par || len != len_par) {
+    fprintf(stderr, "parallel propagate differs from propagate\n");
+    result = 1;
+  }
+  for (t = 0; !result && t < len; t++)
+    if (path[t] != path_par[t]) {
+      fprintf(stderr, "parallel propagate path differs at %d\n", t);
+      result = 1;
+    }
+  free(path);
+  free(path_par);
+  return result;
+}
+
+/* emission probability of state i in its initial cell */
+static double first_emission(int i, ghmm_dpseq * X, ghmm_dpseq * Y) {
+  if (i == 0)
+    return b_match[X->seq[0][0] * ALPHABET + Y->seq[0][0]];
+  return b_insert[i == 1 ? X->seq[0][0] : Y->seq[0][0]];
+}
+
+static int foba_test(ghmm_dpmodel * mo, ghmm_dpseq * X, ghmm_dpseq * Y) {
+  double ***alpha, ***beta, **post;
+  double log_p, log_p_fast, log_p_ring, log_p_beta, log_p_viterbi, row;
+  int *path, len, u, v, i, result = 0;
+
+  alpha = ghmm_dpmodel_foba_alloc(mo, X->length, Y->length);
+  beta = ghmm_dpmodel_foba_alloc(mo, X->length, Y->length);
+  post = ighmm_cmatrix_stat_alloc(X->length, Y->length);
+  if (!alpha || !beta || !post) {
+    fprintf(stderr, "could not allocate the forward-backward matrices\n");
+    return 1;
+  }
+
+  if (ghmm_dpmodel_forward(mo, X, Y, alpha, &log_p, 0)
+      || ghmm_dpmodel_backward(mo, X, Y, beta, 0)
+      || ghmm_dpmodel_forward(mo, X, Y, alpha, &log_p_fast, 1)
+      || ghmm_dpmodel_forward_logp(mo, X, Y, &log_p_ring, 0)) {
+    fprintf(stderr, "pair forward-backward failed\n");
+    return 1;
+  }
+  path = ghmm_dpmodel_viterbi(mo, X, Y, &log_p_viterbi, &len);
+  free(path);
+
+  /* P(X, Y) from the backward variables of the initial cells */
+  log_p_beta = 0.0;
+  for (i = 0; i < mo->N; i++) {
+    u = mo->s[i].offset_x - 1;
+    v = mo->s[i].offset_y - 1;
+    if (beta[u + 1][v + mo->max_offset_y][i] != +1)
+      log_p_beta += mo->s[i].pi * first_emission(i, X, Y)
+	* exp(beta[u + 1][v + mo->max_offset_y][i]);
+  }
+  log_p_beta = log(log_p_beta);
+
+  printf("forward: log_p = %f, fast %f, linear memory %f, backward %f\n",
+	 log_p, log_p_fast, log_p_ring, log_p_beta);
+  if (log_p < log_p_viterbi) {
+    fprintf(stderr, "forward smaller than viterbi\n");
+    result = 1;
+  }
+  if (fabs(log_p - log_p_fast) > 1e-4 || log_p != log_p_ring
+      || fabs(log_p - log_p_beta) > 1e-8) {
+    fprintf(stderr, "forward and backward likelihoods differ\n");
+    result = 1;
+  }
+
+  /* every character of X is matched at most once */
+  if (ghmm_dpmodel_posterior_match(mo, X, Y, post, &log_p, 0))
+    result = 1;
+  for (u = 0; u < X->length && !result; u++) {
+    row = 0;
+    for (v = 0; v < Y->length; v++)
+      row += post[u][v];
+    if (row < 0 || row > 1 + 1e-8) {
+      fprintf(stderr, "posterior match probabilities of X[%d] sum to %f\n", u, row);
+      result = 1;
+    }
+  }
+
+  ghmm_dpmodel_foba_free(&alpha, mo, X->length, Y->length);
+  ghmm_dpmodel_foba_free(&beta, mo, X->length, Y->length);
+  ighmm_cmatrix_stat_free(&post);
+  return result;
+}
+
+int main() {
+  ghmm_dpmodel mo;
+  ghmm_dpseq *X, *Y;
+  int i, result = 0;
+
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  init_model(&mo);
+  for (i = 0; i < 5 && !result; i++) {
+    init_sequences(&X, &Y);
+    result = viterbi_variants_test(&mo, X, Y) || foba_test(&mo, X, Y)
+      || propagate_test(&mo, X, Y);
+    ghmm_dpseq_free(X);
+    ghmm_dpseq_free(Y);
+  }
+  return result;
+}
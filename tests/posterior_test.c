@@ -0,0 +1,208 @@
+/*******************************************************************************
+  filename     : ghmm/tests/posterior_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <ghmm/rng.h>
+#include <ghmm/matrix.h>
+#include <ghmm/sequence.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/foba.h>
+#include <ghmm/sfoba.h>
+
+#define LEN 12
+#define C_LEN 8
+
+/* compares the sparse format and the decoding with the dense posterior */
+static int check_outputs(double **post, int len, int N, const int *silent,
+			 int n, int *row_start, int *state, double *prob,
+			 int *path, double threshold) {
+  int t, i, k;
+  for (t = 0; t < len; t++) {
+    k = row_start[t];
+    for (i = 0; i < N; i++) {
+      if (post[t][i] > threshold) {
+	if (k >= row_start[t + 1] || state[k] != i || prob[k] != post[t][i]) {
+	  fprintf(stderr, "sparse posterior differs at %d, %d\n", t, i);
+	  return 1;
+	}
+	k++;
+      }
+      if ((!silent || !silent[i]) && post[t][i] > post[t][path[t]]) {
+	fprintf(stderr, "posterior decoding is not maximal at %d\n", t);
+	return 1;
+      }
+    }
+  }
+  if (row_start[len] != n)
+    return 1;
+  return 0;
+}
+
+/*
+  A emits and either stays or leaves through the silent state S to the
+  absorbing state B, so S is passed between t and t + 1 with probability
+  P(A at t) - P(A at t + 1)
+*/
+static int discrete_silent_test() {
+  ghmm_dmodel mo;
+  ghmm_dstate s[3];
+  double b_a[2] = {0.6, 0.4}, b_s[2] = {1, 1}, b_b[2] = {0.2, 0.8};
+  int out_a_id[2] = {0, 1}, out_s_id[1] = {2}, out_b_id[1] = {2};
+  double out_a_p[2] = {0.8, 0.2}, out_s_p[1] = {1}, out_b_p[1] = {1};
+  int in_a_id[1] = {0}, in_s_id[1] = {0}, in_b_id[2] = {1, 2};
+  double in_a_p[1] = {0.8}, in_s_p[1] = {0.2}, in_b_p[2] = {1, 1};
+  int silent[3] = {0, 1, 0};
+  int O[LEN] = {0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1, 1};
+  int row_start[LEN + 1], state[3 * LEN], path[LEN];
+  double prob[3 * LEN], **post, row, log_p, log_p_forward;
+  int t, n, result = 0;
+
+  memset(&mo, 0, sizeof(mo));
+  memset(s, 0, sizeof(s));
+  s[0].pi = 1.0;
+  s[0].b = b_a;
+  s[0].out_states = 2; s[0].out_id = out_a_id; s[0].out_a = out_a_p;
+  s[0].in_states = 1; s[0].in_id = in_a_id; s[0].in_a = in_a_p;
+  s[1].b = b_s;
+  s[1].out_states = 1; s[1].out_id = out_s_id; s[1].out_a = out_s_p;
+  s[1].in_states = 1; s[1].in_id = in_s_id; s[1].in_a = in_s_p;
+  s[2].b = b_b;
+  s[2].out_states = 1; s[2].out_id = out_b_id; s[2].out_a = out_b_p;
+  s[2].in_states = 2; s[2].in_id = in_b_id; s[2].in_a = in_b_p;
+  mo.N = 3;
+  mo.M = 2;
+  mo.s = s;
+  mo.prior = -1;
+  mo.silent = silent;
+  mo.model_type = GHMM_kSilentStates;
+
+  post = ighmm_cmatrix_stat_alloc(LEN, mo.N);
+  if (ghmm_dmodel_posterior(&mo, O, LEN, post, &log_p)
+      || ghmm_dmodel_logp(&mo, O, LEN, &log_p_forward)) {
+    fprintf(stderr, "posterior of the silent model failed\n");
+    return 1;
+  }
+  printf("silent model: log_p = %f, forward %f\n", log_p, log_p_forward);
+  if (fabs(log_p - log_p_forward) > 1e-12)
+    result = 1;
+  for (t = 0; t < LEN && !result; t++) {
+    row = post[t][0] + post[t][2];
+    printf("t = %2d: A %f, S %f, B %f\n", t, post[t][0], post[t][1], post[t][2]);
+    if (fabs(row - 1) > 1e-10) {
+      fprintf(stderr, "emitting posteriors at %d sum to %f\n", t, row);
+      result = 1;
+    }
+    if (t < LEN - 1 && fabs(post[t][1] - (post[t][0] - post[t + 1][0])) > 1e-10) {
+      fprintf(stderr, "posterior of the silent state wrong at %d\n", t);
+      result = 1;
+    }
+  }
+
+  n = ghmm_dmodel_posterior_sparse(&mo, O, LEN, 0.01, row_start, state, prob,
+				   3 * LEN, &log_p);
+  if (n < 0 || n > 3 * LEN || ghmm_dmodel_posterior_decoding(&mo, O, LEN, path, &log_p)
+      || check_outputs(post, LEN, mo.N, silent, n, row_start, state, prob,
+		       path, 0.01))
+    result = 1;
+
+  ighmm_cmatrix_stat_free(&post);
+  free(mo.topo_order);
+  return result;
+}
+
+/* brute force over all paths of a two state continuous model */
+static int continuous_test() {
+  ghmm_cmodel smo;
+  ghmm_cstate s[2];
+  ghmm_c_emission e[2];
+  double c[1] = {1.0};
+  int id[2] = {0, 1};
+  double a[2][2] = {{0.7, 0.3}, {0.4, 0.6}};
+  double a_rev[2][2] = {{0.7, 0.4}, {0.3, 0.6}};
+  double *out_a[2], *in_a[2];
+  double O[C_LEN] = {-0.3, 0.1, 1.7, 2.2, 0.4, 1.1, 2.5, -1.0};
+  double brute[C_LEN][2], **post, p, total = 0, log_p;
+  int row_start[C_LEN + 1], state[2 * C_LEN], path[C_LEN];
+  double prob[2 * C_LEN];
+  int i, t, q, n, result = 0;
+
+  for (i = 0; i < 2; i++) {
+    e[i].type = normal;
+    e[i].dimension = 1;
+    e[i].mean.val = 2.0 * i;
+    e[i].variance.val = 1.0;
+    e[i].fixed = 0;
+    out_a[i] = a[i];
+    in_a[i] = a_rev[i];
+    s[i].pi = 0.5;
+    s[i].M = 1;
+    s[i].c = c;
+    s[i].e = &e[i];
+    s[i].out_states = s[i].in_states = 2;
+    s[i].out_id = s[i].in_id = id;
+    s[i].out_a = &out_a[i];
+    s[i].in_a = &in_a[i];
+  }
+  smo.N = 2;
+  smo.M = 1;
+  smo.dim = 1;
+  smo.cos = 1;
+  smo.prior = -1;
+  smo.s = s;
+
+  memset(brute, 0, sizeof(brute));
+  for (q = 0; q < (1 << C_LEN); q++) {
+    p = s[q & 1].pi * ghmm_cmodel_calc_b(s + (q & 1), O);
+    for (t = 1; t < C_LEN; t++)
+      p *= a[(q >> (t - 1)) & 1][(q >> t) & 1]
+	* ghmm_cmodel_calc_b(s + ((q >> t) & 1), O + t);
+    for (t = 0; t < C_LEN; t++)
+      brute[t][(q >> t) & 1] += p;
+    total += p;
+  }
+
+  post = ighmm_cmatrix_stat_alloc(C_LEN, smo.N);
+  if (ghmm_cmodel_posterior(&smo, O, C_LEN, post, &log_p)) {
+    fprintf(stderr, "continuous posterior failed\n");
+    return 1;
+  }
+  printf("continuous model: log_p = %f, brute force %f\n", log_p, log(total));
+  if (fabs(log_p - log(total)) > 1e-10)
+    result = 1;
+  for (t = 0; t < C_LEN; t++)
+    for (i = 0; i < 2; i++)
+      if (fabs(post[t][i] - brute[t][i] / total) > 1e-10) {
+	fprintf(stderr, "continuous posterior differs at %d, %d\n", t, i);
+	result = 1;
+      }
+
+  n = ghmm_cmodel_posterior_sparse(&smo, O, C_LEN, 0.1, row_start, state, prob,
+				   2 * C_LEN, &log_p);
+  if (n < 0 || n > 2 * C_LEN
+      || ghmm_cmodel_posterior_decoding(&smo, O, C_LEN, path, &log_p)
+      || check_outputs(post, C_LEN, smo.N, NULL, n, row_start, state, prob,
+		       path, 0.1))
+    result = 1;
+
+  ighmm_cmatrix_stat_free(&post);
+  return result;
+}
+
+int main() {
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+
+  return discrete_silent_test() || continuous_test();
+}
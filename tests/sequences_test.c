@@ -37,8 +37,39 @@ void sequence_alloc_print(void)
   ghmm_dseq_free(&seq_array);
 }
 
+int sequence_wrap_block(void)
+{
+  int block[7] = {0, 1, 2, 3, 4, 5, 6};
+  int seq_len[3] = {2, 0, 5};
+  double cblock[7];
+  ghmm_dseq* seq_array;
+  ghmm_cseq* cseq_array;
+  int i, result = 0;
+
+  for (i=0; i<7; i++)
+    cblock[i] = 0.5 * i;
+
+  seq_array = ghmm_dseq_wrap_block(block, seq_len, 3);
+  cseq_array = ghmm_cseq_wrap_block(cblock, seq_len, 3);
+  if (!seq_array || !cseq_array)
+    return 1;
+  if (!ghmm_dseq_is_block(seq_array) || !ghmm_cseq_is_block(cseq_array)
+      || seq_array->seq[2][4] != 6 || cseq_array->seq[2][0] != 1.0)
+    result = 1;
+  /* the block is shared, not copied */
+  block[2] = 7;
+  if (seq_array->seq[2][0] != 7)
+    result = 1;
+
+  ghmm_dseq_print_xml(seq_array, stdout);
+
+  ghmm_dseq_free(&seq_array);
+  ghmm_cseq_free(&cseq_array);
+  return result;
+}
+
 int main()
 {
   sequence_alloc_print();
-  return 0;
+  return sequence_wrap_block();
 }
@@ -0,0 +1,199 @@
+/*******************************************************************************
+  filename     : ghmm/tests/snapshot_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ghmm/ghmm.h>
+#include <ghmm/rng.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/snapshot.h>
+
+#include "test_models.h"
+
+#define FILENAME "snapshot_test.bin"
+
+static int discrete_test() {
+  ghmm_dmodel *mo, *r;
+  char buf[4096];
+  FILE *file;
+  size_t size;
+  int result;
+
+  mo = test_dmodel_options("snapshot test");
+  if (ghmm_dmodel_transition_index_build(mo)
+      || ghmm_dmodel_snapshot_write(mo, FILENAME)
+      || !(r = ghmm_dmodel_snapshot_read(FILENAME))) {
+    fprintf(stderr, "could not write and map the discrete model\n");
+    return 1;
+  }
+  /* a snapshot keeps every bit and the layout of the transitions */
+  result = test_dmodel_compare(mo, r, 1);
+
+  /* the parameters of a mapped model can be changed, its structure not */
+  r->s[2].b[1] = 0.5;
+  ghmm_dmodel_set_transition(r, 4, 5, 0.125);
+  if (!result && (ghmm_dmodel_get_transition(r, 4, 5) != 0.125
+                  || ghmm_dmodel_duration_apply(r, 0, 2) != -1)) {
+    fprintf(stderr, "the mapped model can not be changed as expected\n");
+    result = 1;
+  }
+  ghmm_dmodel_free(&r);
+
+  /* a truncated file is rejected */
+  file = fopen(FILENAME, "rb");
+  size = fread(buf, 1, sizeof(buf), file);
+  fclose(file);
+  file = fopen(FILENAME, "wb");
+  fwrite(buf, 1, size - 8, file);
+  fclose(file);
+  if (!result && (r = ghmm_dmodel_snapshot_read(FILENAME))) {
+    fprintf(stderr, "the truncated snapshot was mapped\n");
+    ghmm_dmodel_free(&r);
+    result = 1;
+  }
+  printf("discrete model: %s\n", result ? "failed" : "ok");
+  ghmm_dmodel_free(&mo);
+  return result;
+}
+
+/* all univariate densities with two transition classes, or a multivariate
+   model */
+static ghmm_cmodel *continuous_model(int multivariate) {
+  int M[3] = {2, 1, 3};
+  ghmm_density_t types[3][3] = {{normal, uniform}, {normal_left},
+                                {normal, normal_right, normal}};
+  ghmm_cmodel *smo;
+  ghmm_c_emission *e;
+  int i, j, k, c, n = multivariate ? 2 : 3;
+
+  if (multivariate)
+    smo = ghmm_cmodel_calloc(n, GHMM_kContinuousHMM + GHMM_kMultivariate, 2);
+  else
+    smo = ghmm_cmodel_calloc(n, GHMM_kContinuousHMM + GHMM_kTransitionClasses, 1);
+  smo->cos = multivariate ? 1 : 2;
+  smo->prior = -1;
+  smo->M = multivariate ? 1 : 3;
+  for (i = 0; i < n; i++) {
+    if (multivariate)
+      M[i] = 1;
+    ghmm_cstate_alloc(smo->s + i, M[i], n, n, smo->cos);
+    smo->s[i].M = M[i];
+    smo->s[i].out_states = smo->s[i].in_states = n;
+    smo->s[i].pi = 1.0 / n;
+    for (k = 0; k < M[i]; k++) {
+      e = smo->s[i].e + k;
+      smo->s[i].c[k] = 1.0 / M[i];
+      if (multivariate) {
+        e->type = multinormal;
+        e->dimension = 2;
+        ghmm_c_emission_alloc(e, 2);
+        for (j = 0; j < 4; j++)
+          e->variance.mat[j] = e->sigmainv[j] = e->sigmacd[j] = j % 3 + i;
+        e->mean.vec[0] = i;
+        e->mean.vec[1] = -i;
+        e->det = 2 + i;
+        continue;
+      }
+      e->type = types[i][k];
+      e->dimension = 1;
+      e->mean.val = GHMM_RNG_UNIFORM(RNG) * 10 - 5;
+      e->variance.val = GHMM_RNG_UNIFORM(RNG) + 0.5;
+      e->min = e->mean.val - 1;
+      e->max = e->mean.val + 1;
+    }
+    for (j = 0; j < n; j++)
+      for (c = 0; c < smo->cos; c++) {
+        smo->s[i].out_id[j] = smo->s[i].in_id[j] = j;
+        smo->s[i].out_a[c][j] = (1 + c + i + j) / 10.0;
+      }
+  }
+  for (i = 0; i < n; i++)
+    for (j = 0; j < n; j++)
+      for (c = 0; c < smo->cos; c++)
+        smo->s[j].in_a[c][i] = smo->s[i].out_a[c][j];
+  return smo;
+}
+
+static int compare_continuous(ghmm_cmodel *smo, ghmm_cmodel *r) {
+  ghmm_c_emission *e, *re;
+  int i, j, k, c;
+
+  if (r->N != smo->N || r->M != smo->M || r->cos != smo->cos
+      || r->dim != smo->dim || r->model_type != smo->model_type
+      || r->prior != smo->prior)
+    return 1;
+  for (i = 0; i < smo->N; i++) {
+    if (r->s[i].M != smo->s[i].M || r->s[i].pi != smo->s[i].pi)
+      return 1;
+    for (k = 0; k < smo->s[i].M; k++) {
+      e = smo->s[i].e + k;
+      re = r->s[i].e + k;
+      if (re->type != e->type || re->dimension != e->dimension
+          || r->s[i].c[k] != smo->s[i].c[k] || re->min != e->min
+          || re->max != e->max || re->det != e->det)
+        return 1;
+      if (e->dimension > 1) {
+        if (memcmp(re->mean.vec, e->mean.vec, 2 * sizeof(double))
+            || memcmp(re->variance.mat, e->variance.mat, 4 * sizeof(double))
+            || memcmp(re->sigmainv, e->sigmainv, 4 * sizeof(double))
+            || memcmp(re->sigmacd, e->sigmacd, 4 * sizeof(double)))
+          return 1;
+      }
+      else if (re->mean.val != e->mean.val
+               || re->variance.val != e->variance.val)
+        return 1;
+    }
+    for (j = 0; j < smo->s[i].out_states; j++)
+      for (c = 0; c < smo->cos; c++)
+        if (r->s[i].out_id[j] != smo->s[i].out_id[j]
+            || r->s[i].out_a[c][j] != smo->s[i].out_a[c][j]
+            || r->s[i].in_id[j] != smo->s[i].in_id[j]
+            || r->s[i].in_a[c][j] != smo->s[i].in_a[c][j])
+          return 1;
+  }
+  return 0;
+}
+
+static int continuous_test(int multivariate) {
+  ghmm_cmodel *smo, *r, *copy;
+  int result;
+
+  smo = continuous_model(multivariate);
+  if (ghmm_cmodel_snapshot_write(smo, FILENAME)
+      || !(r = ghmm_cmodel_snapshot_read(FILENAME))) {
+    fprintf(stderr, "could not write and map the continuous model\n");
+    return 1;
+  }
+  result = compare_continuous(smo, r);
+  copy = ghmm_cmodel_copy(r);
+  if (!result && (!copy || compare_continuous(smo, copy)))
+    result = 1;
+  printf("%s model: %s\n", multivariate ? "multivariate" : "continuous",
+         result ? "failed" : "ok");
+  ghmm_cmodel_free(&copy);
+  ghmm_cmodel_free(&r);
+  ghmm_cmodel_free(&smo);
+  return result;
+}
+
+int main() {
+  int result;
+
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  result = discrete_test() || continuous_test(0) || continuous_test(1);
+  remove(FILENAME);
+  return result;
+}
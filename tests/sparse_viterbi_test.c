@@ -0,0 +1,134 @@
+/*******************************************************************************
+  filename     : ghmm/tests/sparse_viterbi_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ghmm/rng.h>
+#include <ghmm/sequence.h>
+#include <ghmm/model.h>
+#include <ghmm/viterbi.h>
+
+#include "test_models.h"
+
+#define SEQ_LEN 200
+#define SEQ_NUMBER 10
+
+/* the table has to list exactly the emitting states of every symbol */
+static int check_table(ghmm_dmodel *mo, ghmm_dsparse_emission *se) {
+  int i, k, e;
+
+  if (se->M != mo->M || se->start[0] != 0 || se->start[mo->M] != se->nonzero) {
+    fprintf(stderr, "sparse table has the wrong size\n");
+    return 1;
+  }
+  for (k = 0; k < mo->M; k++) {
+    e = se->start[k];
+    for (i = 0; i < mo->N; i++)
+      if (mo->s[i].b[k] != 0) {
+        if (e == se->start[k + 1] || se->state[e] != i
+            || se->b[e] != mo->s[i].b[k]) {
+          fprintf(stderr, "emission of state %d for symbol %d is missing\n", i, k);
+          return 1;
+        }
+        e++;
+      }
+    if (e != se->start[k + 1]) {
+      fprintf(stderr, "symbol %d has emissions of other states\n", k);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* the decoder on sparse emissions has to find the Viterbi path */
+static int compare(ghmm_dmodel *mo, const char *name) {
+  ghmm_dsparse_emission *se;
+  ghmm_dseq *sq;
+  int *vpath, *spath, vlen, slen, i, t, bad, result = 0;
+  double log_p, log_p_sparse;
+
+  se = ghmm_dmodel_sparse_emission_alloc(mo);
+  sq = ghmm_dmodel_generate_sequences(mo, 0, SEQ_LEN, SEQ_NUMBER, SEQ_LEN);
+  if (!se || !sq) {
+    fprintf(stderr, "could not set up the %s sparse viterbi test\n", name);
+    return 1;
+  }
+  result = check_table(mo, se);
+  for (i = 0; i < SEQ_NUMBER && !result; i++) {
+    vpath = ghmm_dmodel_viterbi(mo, sq->seq[i], sq->seq_len[i], &vlen, &log_p);
+    spath = ghmm_dmodel_viterbi_sparse(mo, se, sq->seq[i], sq->seq_len[i],
+                                       &slen, &log_p_sparse);
+    if (!vpath || !spath || slen != vlen || log_p_sparse != log_p) {
+      fprintf(stderr, "%s sparse viterbi differs\n", name);
+      result = 1;
+    }
+    for (t = 0; t < vlen && !result; t++)
+      if (spath[t] != vpath[t]) {
+        fprintf(stderr, "%s sparse viterbi path differs at %d\n", name, t);
+        result = 1;
+      }
+    free(vpath);
+    free(spath);
+  }
+  /* symbols outside the alphabet are an error */
+  bad = sq->seq[0][SEQ_LEN / 2];
+  sq->seq[0][SEQ_LEN / 2] = mo->M;
+  spath = ghmm_dmodel_viterbi_sparse(mo, se, sq->seq[0], sq->seq_len[0],
+                                     &slen, &log_p_sparse);
+  sq->seq[0][SEQ_LEN / 2] = bad;
+  if (spath) {
+    fprintf(stderr, "%s sparse viterbi decoded an unknown symbol\n", name);
+    free(spath);
+    result = 1;
+  }
+  if (!result)
+    printf("%s: log_p = %f\n", name, log_p);
+
+  ghmm_dsparse_emission_free(&se);
+  ghmm_dseq_free(&sq);
+  return result;
+}
+
+/* every state emits only 3 of the symbols */
+static ghmm_dmodel *sparse_model(int N, int M) {
+  ghmm_dmodel *mo = test_dmodel_connected(N, M);
+  double sum;
+  int i, k;
+
+  for (i = 0; i < N; i++) {
+    for (sum = 0, k = 0; k < M; k++)
+      if ((k - 2 * i + 2 * M) % M < 3)
+        sum += mo->s[i].b[k];
+      else
+        mo->s[i].b[k] = 0;
+    for (k = 0; k < M; k++)
+      mo->s[i].b[k] /= sum;
+  }
+  return mo;
+}
+
+int main() {
+  ghmm_dmodel *dense, *sparse;
+  int result;
+
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  dense = test_dmodel_connected(3, 4);
+  sparse = sparse_model(6, 12);
+  result = compare(dense, "dense") || compare(sparse, "sparse");
+  ghmm_dmodel_free(&dense);
+  ghmm_dmodel_free(&sparse);
+
+  printf("sparse_viterbi_test: %s\n", result ? "failed" : "ok");
+  return result;
+}
@@ -0,0 +1,259 @@
+/*******************************************************************************
+  filename     : ghmm/tests/stats_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <ghmm/ghmm.h>
+#include <ghmm/rng.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/sequence.h>
+#include <ghmm/reestimate.h>
+#include <ghmm/sreestimate.h>
+
+#include "test_models.h"
+
+#define NSTATES 3
+#define NSYMBOLS 4
+#define NSEQS 30
+#define SHARDS 3
+
+/* the shards add up the statistics in another order than a single E-step,
+   so the models agree up to rounding */
+static int close_to(double x, double y) {
+  return fabs(x - y) <= 1e-9 * (1.0 + fabs(x));
+}
+
+/* sets the first transition count of the shape in buf to -1 and to N + 1,
+   returns 1 if one of them is deserialized */
+static int corrupt_shape(char *buf, size_t size, int N, int stats_size,
+                         int continuous) {
+  char *shape = buf + size - 2 * N * sizeof(int) - stats_size * sizeof(double);
+  int i, value[2] = {-1, N + 1}, saved, accepted = 0;
+  ghmm_dstats *d;
+  ghmm_cstats *c;
+
+  memcpy(&saved, shape, sizeof(int));
+  for (i = 0; i < 2; i++) {
+    memcpy(shape, value + i, sizeof(int));
+    if (continuous && (c = ghmm_cstats_deserialize(buf, size))) {
+      ghmm_cstats_free(&c);
+      accepted = 1;
+    }
+    if (!continuous && (d = ghmm_dstats_deserialize(buf, size))) {
+      ghmm_dstats_free(&d);
+      accepted = 1;
+    }
+  }
+  memcpy(shape, &saved, sizeof(int));
+  return accepted;
+}
+
+/* E-step on shards, merged through the serialized form, gives the model of
+   one Baum-Welch step on all sequences */
+static int discrete_test() {
+  ghmm_dmodel *mo, *ref;
+  ghmm_dseq *sq, shard;
+  ghmm_dstats *total, *part, *copy;
+  char *buf;
+  size_t size;
+  int i, j, k, n, result = 0;
+
+  mo = test_dmodel_connected(NSTATES, NSYMBOLS);
+  ref = ghmm_dmodel_copy(mo);
+  sq = ghmm_dmodel_generate_sequences(mo, 0, 20, NSEQS, 20);
+
+  total = ghmm_dstats_alloc(ref);
+  part = ghmm_dstats_alloc(ref);
+  memset(&shard, 0, sizeof(shard));
+  for (n = 0; n < SHARDS; n++) {
+    k = n * NSEQS / SHARDS;
+    shard.seq = sq->seq + k;
+    shard.seq_len = sq->seq_len + k;
+    shard.seq_w = sq->seq_w + k;
+    shard.seq_number = (n + 1) * NSEQS / SHARDS - k;
+    ghmm_dstats_clear(part);
+    if (ghmm_dstats_accumulate(part, ref, &shard)) {
+      fprintf(stderr, "accumulating shard %d failed\n", n);
+      return 1;
+    }
+    buf = ghmm_dstats_serialize(part, &size);
+    copy = ghmm_dstats_deserialize(buf, size);
+    if (!copy || ghmm_dstats_merge(total, copy)) {
+      fprintf(stderr, "merging shard %d failed\n", n);
+      return 1;
+    }
+    /* corrupt buffers are refused, also a shape that does not fit */
+    if (ghmm_dstats_deserialize(buf, size - 8)
+        || corrupt_shape(buf, size, part->N, part->size, 0)
+        || (buf[0] = 'X', ghmm_dstats_deserialize(buf, size))) {
+      fprintf(stderr, "corrupt statistics were accepted\n");
+      result = 1;
+    }
+    free(buf);
+    ghmm_dstats_free(&copy);
+  }
+  if (total->valid != NSEQS) {
+    fprintf(stderr, "%d of %d sequences valid\n", total->valid, NSEQS);
+    result = 1;
+  }
+  if (ghmm_dstats_apply(total, ref)) {
+    fprintf(stderr, "applying the statistics failed\n");
+    return 1;
+  }
+
+  if (ghmm_dmodel_baum_welch_nstep(mo, sq, 1, 0.0)) {
+    fprintf(stderr, "Baum-Welch failed\n");
+    return 1;
+  }
+  for (i = 0; i < NSTATES; i++) {
+    if (!close_to(mo->s[i].pi, ref->s[i].pi))
+      result = 1;
+    for (j = 0; j < NSTATES; j++)
+      if (!close_to(mo->s[i].out_a[j], ref->s[i].out_a[j]))
+        result = 1;
+    for (k = 0; k < NSYMBOLS; k++)
+      if (!close_to(mo->s[i].b[k], ref->s[i].b[k]))
+        result = 1;
+  }
+  printf("discrete statistics: %s\n", result ? "failed" : "ok");
+
+  ghmm_dstats_free(&total);
+  ghmm_dstats_free(&part);
+  ghmm_dseq_free(&sq);
+  ghmm_dmodel_free(&mo);
+  ghmm_dmodel_free(&ref);
+  return result;
+}
+
+/* two states with two normal components each */
+static ghmm_cmodel *continuous_model() {
+  ghmm_cmodel *smo;
+  ghmm_c_emission *e;
+  int i, j, m;
+
+  smo = ghmm_cmodel_calloc(2, GHMM_kContinuousHMM, 1);
+  smo->M = 2;
+  smo->cos = 1;
+  smo->prior = -1;
+  for (i = 0; i < 2; i++) {
+    ghmm_cstate_alloc(smo->s + i, 2, 2, 2, 1);
+    smo->s[i].M = 2;
+    smo->s[i].pi = 0.5;
+    smo->s[i].out_states = smo->s[i].in_states = 2;
+    for (m = 0; m < 2; m++) {
+      e = smo->s[i].e + m;
+      e->type = normal;
+      e->dimension = 1;
+      e->mean.val = 4 * i + 2 * m + GHMM_RNG_UNIFORM(RNG);
+      e->variance.val = 0.5 + GHMM_RNG_UNIFORM(RNG);
+      smo->s[i].c[m] = 0.5;
+    }
+    for (j = 0; j < 2; j++) {
+      smo->s[i].out_id[j] = smo->s[i].in_id[j] = j;
+      smo->s[i].out_a[0][j] = smo->s[i].in_a[0][j] = i == j ? 0.8 : 0.2;
+    }
+  }
+  return smo;
+}
+
+static int continuous_test() {
+  ghmm_cmodel *smo, *ref;
+  ghmm_cseq *sqd, shard;
+  ghmm_cstats *total, *part, *copy;
+  ghmm_cmodel_baum_welch_context cs;
+  double log_p;
+  char *buf;
+  size_t size;
+  int i, j, k, m, n, result = 0;
+
+  smo = continuous_model();
+  ref = ghmm_cmodel_copy(smo);
+  sqd = ghmm_cmodel_generate_sequences(smo, 0, 20, NSEQS, 20);
+
+  total = ghmm_cstats_alloc(ref);
+  part = ghmm_cstats_alloc(ref);
+  memset(&shard, 0, sizeof(shard));
+  for (n = 0; n < SHARDS; n++) {
+    k = n * NSEQS / SHARDS;
+    shard.seq = sqd->seq + k;
+    shard.seq_len = sqd->seq_len + k;
+    shard.seq_w = sqd->seq_w + k;
+    shard.seq_number = (n + 1) * NSEQS / SHARDS - k;
+    ghmm_cstats_clear(part);
+    if (ghmm_cstats_accumulate(part, ref, &shard)) {
+      fprintf(stderr, "accumulating shard %d failed\n", n);
+      return 1;
+    }
+    buf = ghmm_cstats_serialize(part, &size);
+    copy = ghmm_cstats_deserialize(buf, size);
+    if (!copy || ghmm_cstats_merge(total, copy)) {
+      fprintf(stderr, "merging shard %d failed\n", n);
+      return 1;
+    }
+    if (corrupt_shape(buf, size, part->N, part->size, 1)) {
+      fprintf(stderr, "corrupt statistics were accepted\n");
+      result = 1;
+    }
+    free(buf);
+    ghmm_cstats_free(&copy);
+  }
+  if (ghmm_cstats_apply(total, ref)) {
+    fprintf(stderr, "applying the statistics failed\n");
+    return 1;
+  }
+
+  cs.smo = smo;
+  cs.sqd = sqd;
+  cs.logp = &log_p;
+  cs.eps = 0.0;
+  cs.max_iter = 1;
+  if (ghmm_cmodel_baum_welch(&cs)) {
+    fprintf(stderr, "Baum-Welch failed\n");
+    return 1;
+  }
+  if (total->valid != NSEQS || !close_to(total->log_p, log_p))
+    result = 1;
+
+  for (i = 0; i < 2; i++) {
+    if (!close_to(smo->s[i].pi, ref->s[i].pi))
+      result = 1;
+    for (j = 0; j < 2; j++)
+      if (!close_to(smo->s[i].out_a[0][j], ref->s[i].out_a[0][j]))
+        result = 1;
+    for (m = 0; m < 2; m++)
+      if (!close_to(smo->s[i].c[m], ref->s[i].c[m])
+          || !close_to(smo->s[i].e[m].mean.val, ref->s[i].e[m].mean.val)
+          || !close_to(smo->s[i].e[m].variance.val, ref->s[i].e[m].variance.val))
+        result = 1;
+  }
+  printf("continuous statistics: %s\n", result ? "failed" : "ok");
+
+  ghmm_cstats_free(&total);
+  ghmm_cstats_free(&part);
+  ghmm_cseq_free(&sqd);
+  ghmm_cmodel_free(&smo);
+  ghmm_cmodel_free(&ref);
+  return result;
+}
+
+int main() {
+  int result;
+
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  result = discrete_test() || continuous_test();
+  return result;
+}
@@ -0,0 +1,206 @@
+/*******************************************************************************
+  filename     : ghmm/tests/test_models.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <ghmm/ghmm.h>
+#include <ghmm/rng.h>
+#include <ghmm/model.h>
+
+#include "test_models.h"
+
+#define NSTATES TEST_DMODEL_STATES
+#define NSYMBOLS TEST_DMODEL_SYMBOLS
+
+char *test_string(const char *s) {
+  char *copy = malloc(strlen(s) + 1);
+  return strcpy(copy, s);
+}
+
+static ghmm_alphabet *alphabet(int size, const char **symbols) {
+  ghmm_alphabet *alfa = calloc(1, sizeof(ghmm_alphabet));
+  int i;
+  alfa->size = size;
+  alfa->symbols = malloc(size * sizeof(char *));
+  for (i = 0; i < size; i++)
+    alfa->symbols[i] = test_string(symbols[i]);
+  return alfa;
+}
+
+ghmm_dmodel *test_dmodel_options(const char *name) {
+  const char *symbols[NSYMBOLS] = {"a", "c", "g", "t"};
+  const char *labels[2] = {"exon", "intron"};
+  int in_deg[NSTATES], out_deg[NSTATES], orders[2] = {0, 1};
+  int i, j, k, type = GHMM_kDiscreteHMM + GHMM_kSilentStates
+    + GHMM_kTiedEmissions + GHMM_kHigherOrderEmissions
+    + GHMM_kBackgroundDistributions + GHMM_kLabeledStates;
+  double **b;
+  ghmm_dmodel *mo;
+
+  for (i = 0; i < NSTATES; i++)
+    in_deg[i] = out_deg[i] = 3;
+  mo = ghmm_dmodel_calloc(NSYMBOLS, NSTATES, type, in_deg, out_deg);
+  mo->prior = 0.25;
+  mo->name = test_string(name);
+  mo->alphabet = alphabet(NSYMBOLS, symbols);
+  mo->label_alphabet = alphabet(2, labels);
+  mo->maxorder = 1;
+  mo->pow_lookup = malloc(3 * sizeof(int));
+  mo->pow_lookup[0] = 1;
+  mo->pow_lookup[1] = NSYMBOLS;
+  mo->pow_lookup[2] = NSYMBOLS * NSYMBOLS;
+
+  b = malloc(2 * sizeof(double *));
+  for (i = 0; i < 2; i++) {
+    b[i] = malloc(NSYMBOLS * NSYMBOLS * sizeof(double));
+    for (k = 0; k < NSYMBOLS * NSYMBOLS; k++)
+      b[i][k] = GHMM_RNG_UNIFORM(RNG);
+  }
+  mo->bp = ghmm_dbackground_alloc(2, NSYMBOLS, memcpy(malloc(sizeof(orders)),
+                                                      orders, sizeof(orders)), b);
+  mo->bp->name[0] = test_string("low");
+  mo->bp->name[1] = test_string("high");
+
+  for (i = 0; i < NSTATES; i++) {
+    mo->s[i].pi = GHMM_RNG_UNIFORM(RNG);
+    mo->label[i] = i % 2;
+    mo->s[i].out_states = mo->s[i].in_states = 0;
+  }
+  /* emissions over many orders of magnitude, some only strtod converts */
+  mo->order[1] = 1;
+  free(mo->s[1].b);
+  mo->s[1].b = malloc(NSYMBOLS * NSYMBOLS * sizeof(double));
+  for (i = 0; i < NSTATES; i++)
+    for (k = 0; k < NSYMBOLS * (i == 1 ? NSYMBOLS : 1); k++)
+      mo->s[i].b[k] = GHMM_RNG_UNIFORM(RNG) * pow(10, -((i * 16 + k) * 37 % 320));
+  mo->background_id[0] = 0;
+  mo->background_id[1] = 1;
+  mo->silent[5] = 1;
+  mo->tied_to[2] = mo->tied_to[3] = 2;
+  mo->s[0].fix = 1;
+  mo->s[0].desc = test_string("first");
+  mo->s[0].xPosition = 3;
+  mo->s[0].yPosition = 4;
+
+  for (i = 0; i < NSTATES; i++)
+    for (j = 0; j < NSTATES; j++)
+      if (j == i || j == (i + 1) % NSTATES || j == (i + 3) % NSTATES) {
+        k = mo->s[i].out_states++;
+        mo->s[i].out_id[k] = j;
+        mo->s[i].out_a[k] = GHMM_RNG_UNIFORM(RNG);
+        k = mo->s[j].in_states++;
+        mo->s[j].in_id[k] = i;
+        mo->s[j].in_a[k] = mo->s[i].out_a[mo->s[i].out_states - 1];
+      }
+  return mo;
+}
+
+int test_dmodel_compare(ghmm_dmodel *mo, ghmm_dmodel *r, int layout) {
+  int i, j, k, size;
+
+  if (r->N != mo->N || r->M != mo->M || r->model_type != mo->model_type
+      || r->prior != mo->prior || strcmp(r->name, mo->name)
+      || r->maxorder != mo->maxorder || !r->pow_lookup
+      || r->pow_lookup[2] != mo->pow_lookup[2]
+      || r->alphabet->size != NSYMBOLS || strcmp(r->alphabet->symbols[3], "t")
+      || r->label_alphabet->size != 2
+      || strcmp(r->label_alphabet->symbols[1], "intron")) {
+    fprintf(stderr, "discrete model header differs\n");
+    return 1;
+  }
+  for (i = 0; i < 2; i++) {
+    if (r->bp->n != 2 || r->bp->order[i] != mo->bp->order[i]
+        || strcmp(r->bp->name[i], mo->bp->name[i])) {
+      fprintf(stderr, "background %d differs\n", i);
+      return 1;
+    }
+    for (k = 0; k < mo->pow_lookup[mo->bp->order[i] + 1]; k++)
+      if (r->bp->b[i][k] != mo->bp->b[i][k]) {
+        fprintf(stderr, "background %d differs at %d\n", i, k);
+        return 1;
+      }
+  }
+  for (i = 0; i < mo->N; i++) {
+    if (r->s[i].pi != mo->s[i].pi || r->s[i].fix != mo->s[i].fix
+        || r->order[i] != mo->order[i] || r->silent[i] != mo->silent[i]
+        || r->label[i] != mo->label[i] || r->tied_to[i] != mo->tied_to[i]
+        || r->background_id[i] != mo->background_id[i]
+        || r->s[i].xPosition != mo->s[i].xPosition
+        || r->s[i].yPosition != mo->s[i].yPosition
+        || (mo->s[i].desc ? !r->s[i].desc || strcmp(r->s[i].desc, mo->s[i].desc)
+            : layout && r->s[i].desc != NULL)) {
+      fprintf(stderr, "state %d differs\n", i);
+      return 1;
+    }
+    size = mo->silent[i] && !layout ? 0 : mo->pow_lookup[mo->order[i] + 1];
+    for (k = 0; k < size; k++)
+      if (r->s[i].b[k] != mo->s[i].b[k]) {
+        fprintf(stderr, "emission %d of state %d is %.17g, not %.17g\n", k, i,
+                r->s[i].b[k], mo->s[i].b[k]);
+        return 1;
+      }
+    if (r->s[i].out_states != mo->s[i].out_states
+        || r->s[i].in_states != mo->s[i].in_states) {
+      fprintf(stderr, "degree of state %d differs\n", i);
+      return 1;
+    }
+    for (k = 0; k < mo->s[i].out_states; k++) {
+      j = mo->s[i].out_id[k];
+      if (ghmm_dmodel_get_transition(r, i, j) != mo->s[i].out_a[k]
+          || (layout && (r->s[i].out_id[k] != j
+                         || r->s[i].in_id[k] != mo->s[i].in_id[k]
+                         || r->s[i].in_a[k] != mo->s[i].in_a[k]))) {
+        fprintf(stderr, "transition %d -> %d differs\n", i, j);
+        return 1;
+      }
+    }
+    for (k = 0; k < r->s[i].in_states; k++)
+      if (r->s[i].in_a[k] != ghmm_dmodel_get_transition(r, r->s[i].in_id[k], i)) {
+        fprintf(stderr, "incoming transition %d -> %d differs\n",
+                r->s[i].in_id[k], i);
+        return 1;
+      }
+  }
+  return 0;
+}
+
+ghmm_dmodel *test_dmodel_connected(int N, int M) {
+  int *deg, i, j, k;
+  double sum;
+  ghmm_dmodel *mo;
+
+  deg = malloc(N * sizeof(int));
+  for (i = 0; i < N; i++)
+    deg[i] = N;
+  mo = ghmm_dmodel_calloc(M, N, GHMM_kDiscreteHMM, deg, deg);
+  free(deg);
+  mo->prior = -1;
+  for (i = 0; i < N; i++) {
+    mo->s[i].pi = 1.0 / N;
+    mo->s[i].out_states = mo->s[i].in_states = N;
+    for (sum = 0, k = 0; k < M; k++)
+      sum += mo->s[i].b[k] = GHMM_RNG_UNIFORM(RNG) + 0.1;
+    for (k = 0; k < M; k++)
+      mo->s[i].b[k] /= sum;
+    for (sum = 0, j = 0; j < N; j++)
+      sum += mo->s[i].out_a[j] = GHMM_RNG_UNIFORM(RNG) + 0.1;
+    for (j = 0; j < N; j++) {
+      mo->s[i].out_id[j] = mo->s[i].in_id[j] = j;
+      mo->s[i].out_a[j] /= sum;
+    }
+  }
+  for (i = 0; i < N; i++)
+    for (j = 0; j < N; j++)
+      mo->s[j].in_a[i] = mo->s[i].out_a[j];
+  return mo;
+}
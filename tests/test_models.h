@@ -0,0 +1,32 @@
+/*******************************************************************************
+  filename     : ghmm/tests/test_models.h
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifndef GHMM_TEST_MODELS_H
+#define GHMM_TEST_MODELS_H
+
+#include <ghmm/model.h>
+
+/* size of the model of test_dmodel_options */
+#define TEST_DMODEL_STATES 6
+#define TEST_DMODEL_SYMBOLS 4
+
+/* malloced copy of s */
+char *test_string(const char *s);
+
+/* discrete model with silent, tied, labeled and higher order states and
+   backgrounds, the emissions span many orders of magnitude */
+ghmm_dmodel *test_dmodel_options(const char *name);
+
+/* compares a model read back with the one of test_dmodel_options, all values
+   have to be equal. With layout also the order of the transitions and the
+   emissions of the silent states have to be kept.
+   return: 0 if equal, 1 otherwise */
+int test_dmodel_compare(ghmm_dmodel *mo, ghmm_dmodel *r, int layout);
+
+/* fully connected discrete model with random parameters */
+ghmm_dmodel *test_dmodel_connected(int N, int M);
+
+#endif
@@ -0,0 +1,145 @@
+/*******************************************************************************
+  filename     : ghmm/tests/transition_index_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ghmm/ghmm.h>
+#include <ghmm/rng.h>
+#include <ghmm/model.h>
+
+#define NSTATES 40
+#define NSYMBOLS 3
+
+/* transition probability by scanning out_id, the reference for the index */
+static double scan(ghmm_dmodel *mo, int i, int j) {
+  int k;
+  for (k = 0; k < mo->s[i].out_states; k++)
+    if (mo->s[i].out_id[k] == j)
+      return mo->s[i].out_a[k];
+  return 0.0;
+}
+
+/* compares all pairs and the incoming probabilities with out_id and in_id */
+static int compare(ghmm_dmodel *mo) {
+  int i, j, k;
+  for (i = 0; i < mo->N; i++)
+    for (j = 0; j < mo->N; j++)
+      if (ghmm_dmodel_get_transition(mo, i, j) != scan(mo, i, j)
+          || ghmm_dmodel_check_transition(mo, i, j) != (scan(mo, i, j) > 0)) {
+        fprintf(stderr, "lookup of %d -> %d differs\n", i, j);
+        return 1;
+      }
+  /* unique values through the index have to arrive at both ends */
+  for (i = 0; i < mo->N; i++)
+    for (k = 0; k < mo->s[i].out_states; k++)
+      ghmm_dmodel_set_transition(mo, i, mo->s[i].out_id[k], 1 + i * mo->N + k);
+  for (j = 0; j < mo->N; j++)
+    for (k = 0; k < mo->s[j].in_states; k++)
+      if (mo->s[j].in_a[k] != scan(mo, mo->s[j].in_id[k], j)) {
+        fprintf(stderr, "incoming transition %d -> %d differs\n",
+                mo->s[j].in_id[k], j);
+        return 1;
+      }
+  return 0;
+}
+
+/* sparse random model, the out_id of every second state are not sorted */
+static ghmm_dmodel *random_model() {
+  int a[NSTATES][NSTATES], in_deg[NSTATES], out_deg[NSTATES], i, j, k, t;
+  ghmm_dmodel *mo;
+
+  memset(a, 0, sizeof(a));
+  memset(in_deg, 0, sizeof(in_deg));
+  memset(out_deg, 0, sizeof(out_deg));
+  for (i = 0; i < NSTATES; i++)
+    for (j = 0; j < NSTATES; j++)
+      if (j == (i + 1) % NSTATES || GHMM_RNG_UNIFORM(RNG) < 0.1) {
+        a[i][j] = 1;
+        out_deg[i]++;
+        in_deg[j]++;
+      }
+  mo = ghmm_dmodel_calloc(NSYMBOLS, NSTATES, GHMM_kDiscreteHMM, in_deg, out_deg);
+  if (!mo)
+    return NULL;
+  for (i = 0; i < NSTATES; i++) {
+    mo->s[i].pi = 1.0 / NSTATES;
+    for (k = 0; k < NSYMBOLS; k++)
+      mo->s[i].b[k] = 1.0 / NSYMBOLS;
+    mo->s[i].out_states = mo->s[i].in_states = 0;
+  }
+  for (i = 0; i < NSTATES; i++)
+    for (j = 0; j < NSTATES; j++)
+      if (a[i][j]) {
+        k = mo->s[i].out_states++;
+        mo->s[i].out_id[k] = j;
+        mo->s[i].out_a[k] = 1.0 / out_deg[i];
+        k = mo->s[j].in_states++;
+        mo->s[j].in_id[k] = i;
+        mo->s[j].in_a[k] = 1.0 / out_deg[i];
+      }
+  for (i = 1; i < NSTATES; i += 2)
+    for (k = mo->s[i].out_states - 1; k > 0; k--) {
+      j = GHMM_RNG_UNIFORM(RNG) * (k + 1);
+      t = mo->s[i].out_id[k];
+      mo->s[i].out_id[k] = mo->s[i].out_id[j];
+      mo->s[i].out_id[j] = t;
+    }
+  mo->prior = -1;
+  return mo;
+}
+
+static int index_test() {
+  ghmm_dmodel *mo, *mo2;
+  int result = 0;
+
+  mo = random_model();
+  if (!mo || compare(mo) || ghmm_dmodel_transition_index_build(mo)
+      || !(mo->model_type & GHMM_kTransitionIndex)) {
+    fprintf(stderr, "could not set up the transition index\n");
+    return 1;
+  }
+  result = compare(mo);
+
+  /* the copy gets its own index */
+  mo2 = ghmm_dmodel_copy(mo);
+  if (!result && (!mo2 || !(mo2->model_type & GHMM_kTransitionIndex)
+                  || compare(mo2))) {
+    fprintf(stderr, "the copy has no valid transition index\n");
+    result = 1;
+  }
+  ghmm_dmodel_free(&mo2);
+
+  /* adding and deleting transitions keeps the index up to date */
+  if (!result && (ghmm_dmodel_duration_apply(mo, 3, 4)
+                  || ghmm_dmodel_duration_apply(mo, NSTATES - 2, 2))) {
+    fprintf(stderr, "duration_apply failed\n");
+    result = 1;
+  }
+  if (!result && (mo->N != NSTATES + 4 || compare(mo))) {
+    fprintf(stderr, "the index is out of date after duration_apply\n");
+    result = 1;
+  }
+  ghmm_dmodel_transition_index_free(mo);
+  if (!result && ((mo->model_type & GHMM_kTransitionIndex) || compare(mo)))
+    result = 1;
+  printf("transition index of %d states: %s\n", mo->N, result ? "failed" : "ok");
+  ghmm_dmodel_free(&mo);
+  return result;
+}
+
+int main() {
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  return index_test();
+}
@@ -0,0 +1,248 @@
+/*******************************************************************************
+  filename     : ghmm/tests/xml_stream_test.c
+  created      : DATE: 2026-10-19
+  $Id$
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <ghmm/ghmm.h>
+#include <ghmm/rng.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/xmlreader.h>
+#include <ghmm/xmlwriter.h>
+
+#include "test_models.h"
+
+#define FILENAME "xml_stream_test.xml"
+#define DOMFILE "xml_stream_test_dom.xml"
+
+/* ghmm_xmlfile_parse validates the file first. The DTD the writer refers to
+   is online, so a copy of the file refers to the one of the tree instead */
+static ghmm_xmlfile *parse_dom(const char *filename) {
+  const char *url = "http://ghmm.sourceforge.net/xml/1.0/ghmm.dtd";
+  char *buf, *pos;
+  FILE *file;
+  long size;
+
+  if (!(file = fopen(filename, "rb")))
+    return NULL;
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  rewind(file);
+  buf = malloc(size + 1);
+  buf[fread(buf, 1, size, file)] = '\0';
+  fclose(file);
+  if (!(pos = strstr(buf, url)) || !(file = fopen(DOMFILE, "wb"))) {
+    free(buf);
+    return NULL;
+  }
+  fwrite(buf, 1, pos - buf, file);
+  fputs(GHMM_DTD, file);
+  fputs(pos + strlen(url), file);
+  fclose(file);
+  free(buf);
+  return ghmm_xmlfile_parse(DOMFILE);
+}
+
+/* the emissions round trip exactly both as CSV and as base64, through the
+   streaming and the DOM reader */
+static int discrete_test(int options) {
+  ghmm_dmodel *mo[2];
+  ghmm_xmlfile out, *f;
+  int dom, result = 0;
+
+  mo[0] = mo[1] = test_dmodel_options("stream test");
+  out.noModels = 2;
+  out.modelType = mo[0]->model_type;
+  out.model.d = mo;
+  if (ghmm_xmlfile_write_options(&out, FILENAME, options)) {
+    fprintf(stderr, "could not write the discrete models\n");
+    return 1;
+  }
+  for (dom = 0; dom < 2 && !result; dom++) {
+    f = dom ? parse_dom(FILENAME) : ghmm_xmlfile_parse_stream(FILENAME);
+    if (!f || f->noModels != 2 || f->modelType != mo[0]->model_type) {
+      fprintf(stderr, "could not read the discrete models\n");
+      return 1;
+    }
+    result = test_dmodel_compare(mo[0], f->model.d[0], 0)
+      || test_dmodel_compare(mo[0], f->model.d[1], 0);
+    printf("discrete models%s, %s reader: %s\n",
+           options & GHMM_kXMLBase64Emissions ? " (base64)" : "",
+           dom ? "DOM" : "streaming", result ? "failed" : "ok");
+
+    ghmm_dmodel_free(&f->model.d[0]);
+    ghmm_dmodel_free(&f->model.d[1]);
+    free(f->model.d);
+    free(f);
+  }
+  ghmm_dmodel_free(&mo[0]);
+  return result;
+}
+
+/* all univariate densities and two transition classes */
+static int continuous_test() {
+  int M[3] = {2, 1, 3}, deg[3] = {3, 3, 3};
+  ghmm_density_t types[3][3] = {{normal, uniform}, {normal_left},
+                                {normal, normal_right, normal}};
+  ghmm_cmodel *smo, *r;
+  ghmm_c_emission *e, *re;
+  ghmm_xmlfile *f;
+  int i, j, k, c, result = 0;
+
+  smo = ghmm_cmodel_calloc(3, GHMM_kContinuousHMM + GHMM_kTransitionClasses, 1);
+  smo->cos = 2;
+  smo->prior = -1;
+  for (i = 0; i < 3; i++) {
+    ghmm_cstate_alloc(smo->s + i, M[i], deg[i], deg[i], smo->cos);
+    smo->s[i].M = M[i];
+    smo->s[i].out_states = smo->s[i].in_states = deg[i];
+    smo->s[i].pi = 1.0 / 3;
+    for (k = 0; k < M[i]; k++) {
+      e = smo->s[i].e + k;
+      e->type = types[i][k];
+      e->dimension = 1;
+      e->mean.val = GHMM_RNG_UNIFORM(RNG) * 10 - 5;
+      e->variance.val = GHMM_RNG_UNIFORM(RNG) + 0.5;
+      e->min = e->mean.val - 1;
+      e->max = e->mean.val + 1;
+      smo->s[i].c[k] = 1.0 / M[i];
+    }
+    for (j = 0; j < 3; j++)
+      for (c = 0; c < smo->cos; c++) {
+        smo->s[i].out_id[j] = smo->s[i].in_id[j] = j;
+        smo->s[i].out_a[c][j] = (1 + c + i + j) / 10.0;
+      }
+  }
+  for (i = 0; i < 3; i++)
+    for (j = 0; j < 3; j++)
+      for (c = 0; c < smo->cos; c++)
+        smo->s[j].in_a[c][i] = smo->s[i].out_a[c][j];
+  smo->M = 3;
+
+  ghmm_cmodel_xml_write(&smo, FILENAME, 1);
+  f = ghmm_xmlfile_parse_stream(FILENAME);
+  if (!f || f->noModels != 1) {
+    fprintf(stderr, "could not read the continuous model\n");
+    return 1;
+  }
+  r = f->model.c[0];
+  if (r->N != 3 || r->M != 3 || r->cos != 2 || r->model_type != smo->model_type)
+    result = 1;
+  for (i = 0; i < 3 && !result; i++) {
+    if (r->s[i].M != M[i] || r->s[i].pi != smo->s[i].pi)
+      result = 1;
+    for (k = 0; k < M[i] && !result; k++) {
+      e = smo->s[i].e + k;
+      re = r->s[i].e + k;
+      if (re->type != e->type
+          || (M[i] > 1 && r->s[i].c[k] != smo->s[i].c[k])
+          || (e->type != uniform && (re->mean.val != e->mean.val
+                                     || re->variance.val != e->variance.val))
+          || (e->type != normal_right && e->type != normal
+              && re->min != e->min)
+          || (e->type != normal_left && e->type != normal
+              && re->max != e->max)) {
+        fprintf(stderr, "density %d of state %d differs\n", k, i);
+        result = 1;
+      }
+    }
+    for (j = 0; j < 3 && !result; j++)
+      for (c = 0; c < 2; c++)
+        if (r->s[i].out_id[j] != j
+            || r->s[i].out_a[c][j] != smo->s[i].out_a[c][j]
+            || r->s[j].in_a[c][i] != r->s[i].out_a[c][j]) {
+          fprintf(stderr, "transition %d -> %d differs\n", i, j);
+          result = 1;
+        }
+  }
+  printf("continuous model: %s\n", result ? "failed" : "ok");
+
+  ghmm_cmodel_free(&f->model.c[0]);
+  free(f->model.c);
+  free(f);
+  ghmm_cmodel_free(&smo);
+  return result;
+}
+
+static int multivariate_test() {
+  double mean[2][2] = {{0.5, -1.25}, {3, 2}};
+  double variance[4] = {2, 0.5, 0.5, 1};
+  ghmm_cmodel *smo, *r;
+  ghmm_c_emission *e, *re;
+  ghmm_xmlfile *f;
+  int i, k, result = 0;
+
+  smo = ghmm_cmodel_calloc(2, GHMM_kContinuousHMM + GHMM_kMultivariate, 2);
+  smo->cos = 1;
+  smo->M = 1;
+  smo->prior = -1;
+  for (i = 0; i < 2; i++) {
+    ghmm_cstate_alloc(smo->s + i, 1, 1, 1, 1);
+    smo->s[i].M = 1;
+    smo->s[i].out_states = smo->s[i].in_states = 1;
+    smo->s[i].pi = 0.5;
+    smo->s[i].c[0] = 1;
+    e = smo->s[i].e;
+    e->type = multinormal;
+    e->dimension = 2;
+    ghmm_c_emission_alloc(e, 2);
+    memcpy(e->mean.vec, mean[i], sizeof(mean[i]));
+    memcpy(e->variance.mat, variance, sizeof(variance));
+    smo->s[i].out_id[0] = smo->s[i].in_id[0] = 1 - i;
+    smo->s[i].out_a[0][0] = smo->s[i].in_a[0][0] = 1;
+  }
+
+  ghmm_cmodel_xml_write(&smo, FILENAME, 1);
+  f = ghmm_xmlfile_parse_stream(FILENAME);
+  if (!f || f->noModels != 1) {
+    fprintf(stderr, "could not read the multivariate model\n");
+    return 1;
+  }
+  r = f->model.c[0];
+  if (r->N != 2 || r->dim != 2 || !(r->model_type & GHMM_kMultivariate))
+    result = 1;
+  for (i = 0; i < 2 && !result; i++) {
+    e = smo->s[i].e;
+    re = r->s[i].e;
+    if (r->s[i].M != 1 || re->type != multinormal || re->dimension != 2
+        || fabs(re->det - 1.75) > 1e-12 || r->s[i].out_id[0] != 1 - i)
+      result = 1;
+    for (k = 0; k < 2; k++)
+      if (re->mean.vec[k] != e->mean.vec[k])
+        result = 1;
+    for (k = 0; k < 4; k++)
+      if (re->variance.mat[k] != e->variance.mat[k])
+        result = 1;
+  }
+  printf("multivariate model: %s\n", result ? "failed" : "ok");
+
+  ghmm_cmodel_free(&f->model.c[0]);
+  free(f->model.c);
+  free(f);
+  ghmm_cmodel_free(&smo);
+  return result;
+}
+
+int main() {
+  int result;
+
+  /* Important! initialise rng  */
+  ghmm_rng_init();
+  GHMM_RNG_SET(RNG, 4711);
+
+  result = discrete_test(0) || discrete_test(GHMM_kXMLBase64Emissions)
+    || continuous_test() || multivariate_test();
+  remove(FILENAME);
+  remove(DOMFILE);
+  return result;
+}
@@ -0,0 +1,895 @@
+/*******************************************************************************
+  filename     : ghmm/tools/distbw.c
+  created      : DATE: 2026-10-19
+  $Id$
+
+
+   synopsis:    distbw [options] model.xml [sequences] trained.xml
+
+   options:     -w <int>       number of worker processes (default: number
+                               of online processors, at most one per
+                               sequence)
+                -n <int>       maximal number of Baum-Welch steps (500)
+                -e <double>    convergence threshold on the relative
+                               difference of the log likelihoods (0.0001)
+                -g <int>:<int> generate <n> sequences of length <T> from the
+                               model instead of reading a sequence file
+                -s <int>       seed for -g (4711)
+                -m             use MPI, start with mpirun: rank 0 coordinates,
+                               all other ranks are workers and -w is ignored
+                -c             check the result against serial Baum-Welch
+
+   description: Baum-Welch training of the first model of an XML file with
+                the E-step distributed over worker processes. The sequences
+                (first array of a sequence file in the old format) are split
+                into one shard per worker. In every step the coordinator
+                sends the current parameters of the model to all workers,
+                each worker adds the expected counts of its shard to a
+                ghmm_dstats / ghmm_cstats and sends them back, and the
+                coordinator merges them and sets the new parameters. The
+                updated model is broadcast at the start of the next step.
+
+                The workers are forked and talk to the coordinator over
+                Unix socket pairs; every message is a 64 bit length followed
+                by that many bytes, an empty message stops a worker or tells
+                the coordinator that the worker failed. With -m the same
+                messages are sent between MPI ranks, each rank reads the
+                input files itself. Parameters and statistics are sent in
+                the byte order of the machine, all processes have to run on
+                the same architecture.
+
+                Continuous models with transition classes are not trained:
+                they need a class change function, which an XML file can
+                not give. Code that sets one and shards the sequences like
+                distbw has to keep in mind that get_class is called with
+                the index of a sequence within the shard of its worker, not
+                within all sequences.
+
+__copyright__
+
+*******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#ifdef HAVE_MPI
+#  include <mpi.h>
+#endif
+
+#include <ghmm/ghmm.h>
+#include <ghmm/mes.h>
+#include <ghmm/rng.h>
+#include <ghmm/model.h>
+#include <ghmm/smodel.h>
+#include <ghmm/sequence.h>
+#include <ghmm/matrixop.h>
+#include <ghmm/reestimate.h>
+#include <ghmm/sreestimate.h>
+#include <ghmm/xmlreader.h>
+#include <ghmm/obsolete.h>
+
+#define COORDINATOR 0
+#define MPI_TAG_DISTBW 4711
+
+/* relative tolerance of the check against serial Baum-Welch, the sums
+   of the shards are added in a different order */
+#define CHECK_TOLERANCE 1e-6
+
+/* model to train and its sequences, either mo and sq or smo and sqd */
+typedef struct training {
+  ghmm_dmodel *mo;
+  ghmm_dseq *sq;
+  ghmm_cmodel *smo;
+  ghmm_cseq *sqd;
+} training;
+
+static int use_mpi = 0;
+
+/* sockets: the coordinator talks to worker k over fds[k], a worker to the
+   coordinator over fds[0] */
+static int *fds = NULL;
+
+
+/*----------------------------------------------------------------------------*/
+static int write_all (int fd, const char *buf, size_t size)
+{
+  ssize_t n;
+
+  while (size > 0) {
+    n = write (fd, buf, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    buf += n;
+    size -= n;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+static int read_all (int fd, char *buf, size_t size)
+{
+  ssize_t n;
+
+  while (size > 0) {
+    n = read (fd, buf, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    buf += n;
+    size -= n;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* sends size bytes to peer, an empty message if size is 0 */
+static int send_msg (int peer, const char *buf, size_t size)
+{
+  uint64_t len = size;
+
+#ifdef HAVE_MPI
+  if (use_mpi) {
+    if (size > INT_MAX) {
+      fprintf (stderr, "message of %lu bytes is too large for MPI\n",
+               (unsigned long) size);
+      return -1;
+    }
+    if (MPI_Send ((void *) buf, (int) size, MPI_BYTE, peer, MPI_TAG_DISTBW,
+                  MPI_COMM_WORLD) != MPI_SUCCESS)
+      return -1;
+    return 0;
+  }
+#endif
+  if (write_all (fds[peer], (const char *) &len, sizeof (len))
+      || write_all (fds[peer], buf, size)) {
+    fprintf (stderr, "sending to process %d failed: %s\n", peer,
+             strerror (errno));
+    return -1;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* receives a message from peer, *buf is NULL for an empty message */
+static int recv_msg (int peer, char **buf, size_t * size)
+{
+  uint64_t len;
+
+  *buf = NULL;
+#ifdef HAVE_MPI
+  if (use_mpi) {
+    MPI_Status status;
+    int count;
+
+    if (MPI_Probe (peer, MPI_TAG_DISTBW, MPI_COMM_WORLD, &status) != MPI_SUCCESS
+        || MPI_Get_count (&status, MPI_BYTE, &count) != MPI_SUCCESS)
+      return -1;
+    len = count;
+  }
+  else
+#endif
+  if (read_all (fds[peer], (char *) &len, sizeof (len))) {
+    fprintf (stderr, "receiving from process %d failed\n", peer);
+    return -1;
+  }
+
+  *size = len;
+  if (!(*buf = malloc (len ? len : 1))) {
+    fprintf (stderr, "no memory for a message of %lu bytes\n",
+             (unsigned long) len);
+    return -1;
+  }
+#ifdef HAVE_MPI
+  if (use_mpi) {
+    if (MPI_Recv (*buf, (int) len, MPI_BYTE, peer, MPI_TAG_DISTBW,
+                  MPI_COMM_WORLD, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+      goto STOP;
+  }
+  else
+#endif
+  if (read_all (fds[peer], *buf, len)) {
+    fprintf (stderr, "receiving from process %d failed\n", peer);
+    goto STOP;
+  }
+  if (!len) {
+    free (*buf);
+    *buf = NULL;
+  }
+  return 0;
+STOP:
+  free (*buf);
+  *buf = NULL;
+  return -1;
+}
+
+
+/*----------------------------------------------------------------------------*/
+/* copies the trainable parameters to p (unpack == 0) or from p, returns
+   their number; with p == NULL they are only counted */
+#define PARAM(x) do {                           \
+    if (p) {                                    \
+      if (unpack)                               \
+        (x) = p[n];                             \
+      else                                      \
+        p[n] = (x);                             \
+    }                                           \
+    n++;                                        \
+  } while (0)
+
+static int dmodel_params (ghmm_dmodel * mo, double *p, int unpack)
+{
+  int i, j, k, order, n = 0;
+
+  for (i = 0; i < mo->N; i++) {
+    PARAM (mo->s[i].pi);
+    for (j = 0; j < mo->s[i].out_states; j++)
+      PARAM (mo->s[i].out_a[j]);
+    if (!mo->s[i].b)
+      continue;
+    order = (mo->model_type & GHMM_kHigherOrderEmissions) ? mo->order[i] : 0;
+    for (k = 0; k < ghmm_ipow (mo, mo->M, order + 1); k++)
+      PARAM (mo->s[i].b[k]);
+  }
+
+  /* keep in_a consistent with out_a */
+  if (p && unpack)
+    for (i = 0; i < mo->N; i++)
+      for (j = 0; j < mo->s[i].out_states; j++)
+        ghmm_dmodel_set_transition (mo, i, mo->s[i].out_id[j],
+                                    mo->s[i].out_a[j]);
+  return n;
+}
+
+/*----------------------------------------------------------------------------*/
+static int cmodel_params (ghmm_cmodel * smo, double *p, int unpack)
+{
+  int i, j, c, m, d, n = 0;
+  ghmm_c_emission *e;
+
+  for (i = 0; i < smo->N; i++) {
+    PARAM (smo->s[i].pi);
+    for (c = 0; c < smo->cos; c++)
+      for (j = 0; j < smo->s[i].out_states; j++)
+        PARAM (smo->s[i].out_a[c][j]);
+    for (m = 0; m < smo->s[i].M; m++) {
+      PARAM (smo->s[i].c[m]);
+      e = smo->s[i].e + m;
+      if (smo->model_type & GHMM_kMultivariate) {
+        for (d = 0; d < e->dimension; d++)
+          PARAM (e->mean.vec[d]);
+        for (d = 0; d < e->dimension * e->dimension; d++)
+          PARAM (e->variance.mat[d]);
+      }
+      else {
+        PARAM (e->mean.val);
+        PARAM (e->variance.val);
+      }
+    }
+  }
+
+  if (p && unpack)
+    for (i = 0; i < smo->N; i++) {
+      for (c = 0; c < smo->cos; c++)
+        for (j = 0; j < smo->s[i].out_states; j++)
+          ghmm_cmodel_set_transition (smo, i, smo->s[i].out_id[j], c,
+                                      smo->s[i].out_a[c][j]);
+      if (smo->model_type & GHMM_kMultivariate)
+        for (m = 0; m < smo->s[i].M; m++) {
+          e = smo->s[i].e + m;
+          ighmm_invert_det (e->sigmainv, &e->det, smo->dim, e->variance.mat);
+          ighmm_cholesky_decomposition (e->sigmacd, smo->dim, e->variance.mat);
+        }
+    }
+  return n;
+}
+
+#undef PARAM
+
+/*----------------------------------------------------------------------------*/
+static int training_params (training * t, double *p, int unpack)
+{
+  return t->mo ? dmodel_params (t->mo, p, unpack)
+    : cmodel_params (t->smo, p, unpack);
+}
+
+
+/*----------------------------------------------------------------------------*/
+/* sequences [first, first + n) of worker rank */
+static void shard_bounds (long seq_number, int rank, int workers,
+                          long *first, long *n)
+{
+  *first = seq_number * (rank - 1) / workers;
+  *n = seq_number * rank / workers - *first;
+}
+
+#define SHIFT(x) if (x) (x) += first
+
+/*----------------------------------------------------------------------------*/
+static void dseq_shard (ghmm_dseq * shard, const ghmm_dseq * sq, int rank,
+                        int workers)
+{
+  long first;
+
+  *shard = *sq;
+  shard_bounds (sq->seq_number, rank, workers, &first, &shard->seq_number);
+  SHIFT (shard->seq);
+  SHIFT (shard->seq_len);
+  SHIFT (shard->seq_w);
+  SHIFT (shard->seq_label);
+  SHIFT (shard->seq_id);
+  SHIFT (shard->states);
+  SHIFT (shard->states_len);
+  SHIFT (shard->state_labels);
+  SHIFT (shard->state_labels_len);
+  shard->capacity = shard->seq_number;
+}
+
+/*----------------------------------------------------------------------------*/
+static void cseq_shard (ghmm_cseq * shard, const ghmm_cseq * sqd, int rank,
+                        int workers)
+{
+  long first;
+
+  *shard = *sqd;
+  shard_bounds (sqd->seq_number, rank, workers, &first, &shard->seq_number);
+  SHIFT (shard->seq);
+  SHIFT (shard->seq_len);
+  SHIFT (shard->seq_w);
+  SHIFT (shard->seq_label);
+  SHIFT (shard->seq_id);
+  shard->capacity = shard->seq_number;
+}
+
+#undef SHIFT
+
+
+/*----------------------------------------------------------------------------*/
+/* E-step on the shard of rank for every set of parameters received, until
+   an empty message arrives */
+static int worker (training * t, int rank, int workers)
+{
+  ghmm_dseq shard;
+  ghmm_cseq cshard;
+  ghmm_dstats *r = NULL;
+  ghmm_cstats *cr = NULL;
+  char *buf, *stats;
+  size_t size, stats_size;
+  int res = -1;
+
+  if (t->mo) {
+    dseq_shard (&shard, t->sq, rank, workers);
+    r = ghmm_dstats_alloc (t->mo);
+  }
+  else {
+    cseq_shard (&cshard, t->sqd, rank, workers);
+    cr = ghmm_cstats_alloc (t->smo);
+  }
+  if (!r && !cr)
+    goto STOP;
+
+  for (;;) {
+    if (recv_msg (COORDINATOR, &buf, &size))
+      goto STOP;
+    if (!buf)
+      break;
+    if (size != training_params (t, NULL, 0) * sizeof (double)) {
+      fprintf (stderr, "worker %d: parameters do not match the model\n", rank);
+      free (buf);
+      send_msg (COORDINATOR, NULL, 0);
+      goto STOP;
+    }
+    training_params (t, (double *) buf, 1);
+    free (buf);
+
+    if (t->mo) {
+      ghmm_dstats_clear (r);
+      stats = ghmm_dstats_accumulate (r, t->mo, &shard) ? NULL
+        : ghmm_dstats_serialize (r, &stats_size);
+    }
+    else {
+      ghmm_cstats_clear (cr);
+      stats = ghmm_cstats_accumulate (cr, t->smo, &cshard) ? NULL
+        : ghmm_cstats_serialize (cr, &stats_size);
+    }
+    if (!stats) {
+      fprintf (stderr, "worker %d: E-step failed\n", rank);
+      send_msg (COORDINATOR, NULL, 0);
+      goto STOP;
+    }
+    if (send_msg (COORDINATOR, stats, stats_size)) {
+      free (stats);
+      goto STOP;
+    }
+    free (stats);
+  }
+  res = 0;
+
+STOP:
+  if (r)
+    ghmm_dstats_free (&r);
+  if (cr)
+    ghmm_cstats_free (&cr);
+  return res;
+}
+
+
+/*----------------------------------------------------------------------------*/
+/* sends the parameters to all workers and merges their statistics into
+   r or cr */
+static int distributed_estep (training * t, int workers, ghmm_dstats * r,
+                              ghmm_cstats * cr)
+{
+  ghmm_dstats *part;
+  ghmm_cstats *cpart;
+  double *params;
+  char *buf;
+  size_t size;
+  int k, n, failed;
+
+  n = training_params (t, NULL, 0);
+  if (!(params = malloc (n * sizeof (double)))) {
+    fprintf (stderr, "no memory for %d parameters\n", n);
+    return -1;
+  }
+  training_params (t, params, 0);
+  for (k = 1; k <= workers; k++)
+    if (send_msg (k, (char *) params, n * sizeof (double))) {
+      free (params);
+      return -1;
+    }
+  free (params);
+
+  if (r)
+    ghmm_dstats_clear (r);
+  else
+    ghmm_cstats_clear (cr);
+
+  /* merged in the order of the ranks, so the result does not depend on
+     which worker finishes first */
+  for (failed = 0, k = 1; k <= workers; k++) {
+    if (recv_msg (k, &buf, &size))
+      return -1;
+    if (!buf) {
+      fprintf (stderr, "worker %d failed\n", k);
+      failed = 1;
+      continue;
+    }
+    if (r) {
+      part = ghmm_dstats_deserialize (buf, size);
+      if (!part || ghmm_dstats_merge (r, part))
+        failed = 1;
+      if (part)
+        ghmm_dstats_free (&part);
+    }
+    else {
+      cpart = ghmm_cstats_deserialize (buf, size);
+      if (!cpart || ghmm_cstats_merge (cr, cpart))
+        failed = 1;
+      if (cpart)
+        ghmm_cstats_free (&cpart);
+    }
+    free (buf);
+  }
+  return failed ? -1 : 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Baum-Welch with the E-step done by the workers, stops like
+   ghmm_dmodel_baum_welch_nstep or ghmm_cmodel_baum_welch. Returns the
+   number of steps, -1 on error. Stops all workers. */
+static int coordinator (training * t, int workers, int max_step, double eps)
+{
+  ghmm_dstats *r = NULL;
+  ghmm_cstats *cr = NULL;
+  double log_p, log_p_old = -DBL_MAX, diff;
+  int n, k, valid, valid_old, res = -1;
+
+  if (t->mo) {
+    r = ghmm_dstats_alloc (t->mo);
+    valid_old = t->sq->seq_number;
+  }
+  else {
+    cr = ghmm_cstats_alloc (t->smo);
+    valid_old = t->sqd->seq_number;
+    max_step = m_min (GHMM_MAX_ITER_BW, max_step);
+    eps = m_max (GHMM_EPS_ITER_BW, eps);
+  }
+  if (!r && !cr)
+    goto STOP;
+
+  for (n = 1; n <= max_step; n++) {
+    if (distributed_estep (t, workers, r, cr))
+      goto STOP;
+    log_p = r ? r->log_p : cr->log_p;
+    valid = r ? r->valid : cr->valid;
+    if (!valid) {
+      fprintf (stderr, "no sequence can be built from the model\n");
+      /* like ghmm_cmodel_baum_welch, ghmm_dmodel_baum_welch_nstep stops */
+      if (cr)
+        goto STOP;
+      break;
+    }
+    if (r ? ghmm_dstats_apply (r, t->mo) : ghmm_cstats_apply (cr, t->smo))
+      goto STOP;
+    printf ("step %3d: log P = %f (%d valid sequences)\n", n, log_p, valid);
+
+    diff = log_p - log_p_old;
+    if (diff < -GHMM_EPS_PREC) {
+      fprintf (stderr, "no convergence: log P < log P-old (n = %d)\n", n);
+      if (r)
+        goto STOP;
+      if (valid <= valid_old)
+        break;
+    }
+    else if (r && log_p > GHMM_EPS_PREC) {
+      fprintf (stderr, "no convergence: log P > 0 (n = %d)\n", n);
+      goto STOP;
+    }
+    if ((r || diff >= 0.0) && diff < fabs (eps * log_p)) {
+      printf ("convergence after %d steps\n", n);
+      break;
+    }
+    log_p_old = log_p;
+    valid_old = valid;
+  }
+  res = m_min (n, max_step);
+
+STOP:
+  for (k = 1; k <= workers; k++)
+    send_msg (k, NULL, 0);
+  if (r)
+    ghmm_dstats_free (&r);
+  if (cr)
+    ghmm_cstats_free (&cr);
+  return res;
+}
+
+
+/*----------------------------------------------------------------------------*/
+/* trains a copy of the input model serially and compares the parameters */
+static int check_serial (training * t, training * ref, int max_step, double eps)
+{
+  ghmm_cmodel_baum_welch_context cs;
+  double log_p, *p, *q, err = 0.0;
+  int i, n, res = -1;
+
+  if (ref->mo)
+    res = ghmm_dmodel_baum_welch_nstep (ref->mo, t->sq, max_step, eps);
+  else {
+    cs.smo = ref->smo;
+    cs.sqd = t->sqd;
+    cs.logp = &log_p;
+    cs.eps = eps;
+    cs.max_iter = max_step;
+    res = ghmm_cmodel_baum_welch (&cs);
+  }
+  if (res) {
+    fprintf (stderr, "serial Baum-Welch failed\n");
+    return -1;
+  }
+
+  n = training_params (t, NULL, 0);
+  p = malloc (n * sizeof (double));
+  q = malloc (n * sizeof (double));
+  if (!p || !q) {
+    fprintf (stderr, "no memory for %d parameters\n", n);
+    res = -1;
+  }
+  else {
+    training_params (t, p, 0);
+    training_params (ref, q, 0);
+    for (i = 0; i < n; i++)
+      err = m_max (err, fabs (p[i] - q[i]) / (1.0 + fabs (q[i])));
+    printf ("largest difference to serial Baum-Welch: %g\n", err);
+    res = err > CHECK_TOLERANCE ? -1 : 0;
+  }
+  free (p);
+  free (q);
+  return res;
+}
+
+/*----------------------------------------------------------------------------*/
+/* forks the workers, each with a socket to the coordinator */
+static int spawn_workers (training * t, int workers)
+{
+  int k, l, sv[2];
+
+  fflush (stdout);
+  fflush (stderr);
+  for (k = 1; k <= workers; k++) {
+    if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv)) {
+      fprintf (stderr, "socketpair: %s\n", strerror (errno));
+      return -1;
+    }
+    switch (fork ()) {
+    case -1:
+      fprintf (stderr, "fork: %s\n", strerror (errno));
+      close (sv[0]);
+      close (sv[1]);
+      return -1;
+    case 0:
+      close (sv[0]);
+      for (l = 1; l < k; l++)
+        close (fds[l]);
+      fds[0] = sv[1];
+      _exit (worker (t, k, workers) ? EXIT_FAILURE : EXIT_SUCCESS);
+    default:
+      close (sv[1]);
+      fds[k] = sv[0];
+    }
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* first model of an XML file into t->mo or t->smo */
+static int read_model (training * t, const char *model_file)
+{
+  ghmm_xmlfile *f;
+  int i;
+
+  f = ghmm_xmlfile_parse_stream (model_file);
+  if (!f || f->noModels < 1) {
+    fprintf (stderr, "no model read from %s\n", model_file);
+    return -1;
+  }
+  if (f->modelType & GHMM_kContinuousHMM) {
+    t->smo = f->model.c[0];
+    for (i = 1; i < f->noModels; i++)
+      ghmm_cmodel_free (&f->model.c[i]);
+    free (f->model.c);
+  }
+  else if (!(f->modelType & (GHMM_kPairHMM | GHMM_kTransitionClasses))) {
+    t->mo = f->model.d[0];
+    for (i = 1; i < f->noModels; i++)
+      ghmm_dmodel_free (&f->model.d[i]);
+    free (f->model.d);
+  }
+  free (f);
+  if (!t->mo && !t->smo) {
+    fprintf (stderr, "%s: only discrete and continuous models can be "
+             "trained\n", model_file);
+    return -1;
+  }
+  if (t->smo && t->smo->cos > 1
+      && (!t->smo->class_change || !t->smo->class_change->get_class)) {
+    fprintf (stderr, "%s: the transition classes need a class change "
+             "function\n", model_file);
+    ghmm_cmodel_free (&t->smo);
+    return -1;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+static int read_training (training * t, const char *model_file,
+                          const char *seq_file, long gen_number, int gen_len,
+                          int seed)
+{
+  int i, arrays = 0;
+
+  if (read_model (t, model_file))
+    return -1;
+
+  if (gen_number > 0) {
+    if (t->mo)
+      t->sq = ghmm_dmodel_generate_sequences (t->mo, seed, gen_len,
+                                              gen_number, gen_len);
+    else
+      t->sqd = ghmm_cmodel_generate_sequences (t->smo, seed, gen_len,
+                                               gen_number, gen_len);
+  }
+  else {
+#ifdef GHMM_OBSOLETE
+    if (t->mo) {
+      ghmm_dseq **sq = ghmm_dseq_read (seq_file, &arrays);
+      if (sq) {
+        t->sq = sq[0];
+        for (i = 1; i < arrays; i++)
+          ghmm_dseq_free (&sq[i]);
+        free (sq);
+      }
+    }
+    else {
+      ghmm_cseq **sqd = ghmm_cseq_read (seq_file, &arrays);
+      if (sqd) {
+        t->sqd = sqd[0];
+        for (i = 1; i < arrays; i++)
+          ghmm_cseq_free (&sqd[i]);
+        free (sqd);
+      }
+    }
+#else
+    fprintf (stderr, "reading sequence files needs GHMM_OBSOLETE, "
+             "use -g\n");
+#endif /* GHMM_OBSOLETE */
+  }
+  if (!t->sq && !t->sqd) {
+    fprintf (stderr, "no sequences %s %s\n",
+             gen_number > 0 ? "generated from" : "read from",
+             gen_number > 0 ? model_file : seq_file);
+    return -1;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+static void usage (const char *name)
+{
+  fprintf (stderr, "Usage: %s [-w workers] [-n steps] [-e eps] [-g n:T] "
+           "[-s seed] [-m] [-c] model.xml [sequences] trained.xml\n", name);
+}
+
+/*============================================================================*/
+int main (int argc, char *argv[])
+{
+  training t, ref;
+  char *model_file, *seq_file = NULL, *out_file;
+  long gen_number = 0, seq_number;
+  int opt, workers = 0, max_step = GHMM_MAX_ITER_BW, gen_len = 0;
+  int seed = 4711, check = 0, rank = COORDINATOR, steps, k;
+  int res = EXIT_FAILURE, status;
+  double eps = GHMM_EPS_ITER_BW;
+
+  memset (&t, 0, sizeof (t));
+  memset (&ref, 0, sizeof (ref));
+
+  while ((opt = getopt (argc, argv, "w:n:e:g:s:mc")) != -1) {
+    switch (opt) {
+    case 'w':
+      workers = atoi (optarg);
+      break;
+    case 'n':
+      max_step = atoi (optarg);
+      break;
+    case 'e':
+      eps = atof (optarg);
+      break;
+    case 'g':
+      if (sscanf (optarg, "%ld:%d", &gen_number, &gen_len) != 2
+          || gen_number < 1 || gen_len < 1) {
+        usage (argv[0]);
+        goto STOP;
+      }
+      break;
+    case 's':
+      seed = atoi (optarg);
+      break;
+    case 'm':
+#ifdef HAVE_MPI
+      use_mpi = 1;
+#else
+      fprintf (stderr, "%s was built without MPI\n", argv[0]);
+      goto STOP;
+#endif
+      break;
+    case 'c':
+      check = 1;
+      break;
+    default:
+      usage (argv[0]);
+      goto STOP;
+    }
+  }
+  if (argc - optind != (gen_number > 0 ? 2 : 3)) {
+    usage (argv[0]);
+    goto STOP;
+  }
+  model_file = argv[optind];
+  if (gen_number <= 0)
+    seq_file = argv[optind + 1];
+  out_file = argv[argc - 1];
+
+#ifdef HAVE_MPI
+  if (use_mpi) {
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (MPI_COMM_WORLD, &rank);
+    MPI_Comm_size (MPI_COMM_WORLD, &workers);
+    workers--;
+  }
+#endif
+  ghmm_rng_init ();
+  if (read_training (&t, model_file, seq_file, gen_number, gen_len, seed))
+    goto STOP;
+
+  seq_number = t.mo ? t.sq->seq_number : t.sqd->seq_number;
+  if (workers <= 0 && !use_mpi) {
+    workers = sysconf (_SC_NPROCESSORS_ONLN);
+    if (workers > seq_number)
+      workers = seq_number;
+  }
+  if (workers < 1 || workers > seq_number) {
+    fprintf (stderr, "%d workers for %ld sequences\n", workers, seq_number);
+    goto STOP;
+  }
+
+  if (use_mpi && rank != COORDINATOR) {
+    res = worker (&t, rank, workers) ? EXIT_FAILURE : EXIT_SUCCESS;
+    goto STOP;
+  }
+
+  /* read again, ghmm_dmodel_copy shares the background distributions */
+  if (check && read_model (&ref, model_file))
+    goto STOP;
+
+  if (!use_mpi) {
+    if (!(fds = calloc (workers + 1, sizeof (*fds)))) {
+      fprintf (stderr, "no memory for %d workers\n", workers);
+      goto STOP;
+    }
+    /* a worker that died must not kill the coordinator */
+    signal (SIGPIPE, SIG_IGN);
+    if (spawn_workers (&t, workers)) {
+      /* the workers forked so far see the end of their socket */
+      for (k = 1; k <= workers; k++)
+        if (fds[k] > 0)
+          close (fds[k]);
+      while (wait (&status) > 0);
+      goto STOP;
+    }
+  }
+  printf ("training with %d workers on %ld sequences\n", workers, seq_number);
+
+  steps = coordinator (&t, workers, max_step, eps);
+
+  if (!use_mpi) {
+    for (k = 1; k <= workers; k++)
+      close (fds[k]);
+    while (wait (&status) > 0)
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS)
+        steps = -1;
+  }
+  if (steps < 0)
+    goto STOP;
+
+  if (check && check_serial (&t, &ref, max_step, eps))
+    goto STOP;
+
+  if (t.mo ? ghmm_dmodel_xml_write (&t.mo, out_file, 1)
+      : ghmm_cmodel_xml_write (&t.smo, out_file, 1)) {
+    fprintf (stderr, "writing %s failed\n", out_file);
+    goto STOP;
+  }
+  res = EXIT_SUCCESS;
+
+STOP:
+  if (t.mo)
+    ghmm_dmodel_free (&t.mo);
+  if (t.sq)
+    ghmm_dseq_free (&t.sq);
+  if (t.smo)
+    ghmm_cmodel_free (&t.smo);
+  if (t.sqd)
+    ghmm_cseq_free (&t.sqd);
+  if (ref.mo)
+    ghmm_dmodel_free (&ref.mo);
+  if (ref.smo)
+    ghmm_cmodel_free (&ref.smo);
+  free (fds);
+#ifdef HAVE_MPI
+  if (use_mpi) {
+    MPI_Initialized (&k);
+    if (k)
+      MPI_Finalize ();
+  }
+#endif
+  return res;
+}